@@ -0,0 +1,29 @@
+#import <Foundation/Foundation.h>
+#import "DDBenchmarkSupport.h"
+
+/**
+ * Heap allocations per log statement (see DDAllocationCounter.h).
+ *
+ * For every sink configuration (see DDBenchmarkSinks), and for asynchronous and synchronous statements,
+ * a batch of `statements` info log statements is issued from one thread after a warmup, and the queue is drained.
+ *
+ * Reported per combination, per statement:
+ * - allocations and bytes on the caller thread (the log statement itself, up to the return to the caller)
+ * - allocations and bytes on all other threads (the logging queue and the loggers), until the queue is drained
+**/
+@interface DDAllocationBenchmark : NSObject
+
+@property (nonatomic, copy) NSArray<NSString *> *sinkNames;
+@property (nonatomic, assign) NSUInteger statements;
+
+/**
+ * --sinks null,tty,file,file+tty  --statements 1000
+**/
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options;
+
+/**
+ * Returns nil if allocations can't be counted on this platform.
+**/
+- (DDBenchmarkReport *)run;
+
+@end
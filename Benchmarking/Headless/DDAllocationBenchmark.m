@@ -0,0 +1,106 @@
+#import "DDAllocationBenchmark.h"
+#import "DDAllocationCounter.h"
+#import "DDBenchmarkSinks.h"
+#import "DDLogMacros.h"
+
+static const DDLogLevel ddLogLevel = DDLogLevelInfo;
+
+// Warmup statements, issued before each measured batch (not counted)
+#define WARMUP_COUNT 1000
+
+static void DDAllocationProduce(BOOL async, NSUInteger count)
+{
+	@autoreleasepool {
+
+		for (NSUInteger i = 0; i < count; i++)
+		{
+			LOG_MAYBE(async, ddLogLevel, DDLogFlagInfo, 0, nil, __PRETTY_FUNCTION__,
+			          @"Request %lu finished in %.3f ms: %@", (unsigned long)i, 12.5, @"OK");
+		}
+	}
+}
+
+
+@implementation DDAllocationBenchmark
+
+- (instancetype)init
+{
+	return [self initWithOptions:[[DDBenchmarkOptions alloc] initWithArguments:@[]]];
+}
+
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options
+{
+	if ((self = [super init]))
+	{
+		_sinkNames = [options listForOption:@"sinks" defaultValue:[[DDBenchmarkSinks allSinkNames] componentsJoinedByString:@","]];
+		_statements = MAX([options unsignedIntegerForOption:@"statements" defaultValue:1000], 1);
+	}
+	return self;
+}
+
+- (NSArray *)runAsync:(BOOL)async
+{
+	DDAllocationProduce(async, WARMUP_COUNT);
+	[DDLog flushLog];
+
+	DDAllocationCount caller, other;
+
+	DDAllocationCounterStart();
+
+	DDAllocationProduce(async, _statements);
+
+	// The caller's share ends with the last statement, not with the flush
+	DDAllocationCounterRead(&caller, NULL);
+
+	[DDLog flushLog];
+
+	DDAllocationCounterStop(NULL, &other);
+
+	double count = (double)_statements;
+
+	return @[ async ? @"async" : @"sync",
+	          @(_statements),
+	          @(caller.allocations / count),
+	          @(caller.bytes / count),
+	          @(other.allocations / count),
+	          @(other.bytes / count) ];
+}
+
+- (DDBenchmarkReport *)run
+{
+	if (!DDAllocationCounterIsAvailable())
+	{
+		fprintf(stderr, "Allocations can't be counted on this platform\n");
+		return nil;
+	}
+
+	NSArray *columns = @[ @"sink", @"mode", @"statements",
+	                      @"caller_allocs_per_stmt", @"caller_bytes_per_stmt",
+	                      @"logging_allocs_per_stmt", @"logging_bytes_per_stmt" ];
+
+	DDBenchmarkReport *report = [[DDBenchmarkReport alloc] initWithName:@"alloc" columns:columns];
+	report.keyColumns = @[ @"sink", @"mode" ];
+	report.metricColumn = @"caller_allocs_per_stmt";
+
+	for (NSString *sinkName in _sinkNames)
+	{
+		if (![DDBenchmarkSinks installSinksNamed:sinkName])
+		{
+			fprintf(stderr, "Unknown sink configuration: %s\n", sinkName.UTF8String);
+			continue;
+		}
+
+		for (NSNumber *async in @[ @YES, @NO ])
+		{
+			@autoreleasepool {
+				[report addRow:[@[ sinkName ] arrayByAddingObjectsFromArray:[self runAsync:async.boolValue]]];
+			}
+		}
+
+		[DDBenchmarkSinks uninstallSinks];
+	}
+
+	return report;
+}
+
+@end
@@ -0,0 +1,38 @@
+#import <Foundation/Foundation.h>
+
+/**
+ * Counts heap allocations, split into the allocations of one thread (the "caller", e.g. the thread issuing log
+ * statements) and those of every other thread (the logging queue and the logger queues).
+ *
+ * The functions of the malloc zones are replaced by counting wrappers.
+ * The hooks are installed once and stay installed; outside of a measurement they only check a flag.
+ *
+ * Frees are not counted: the interesting number is how often the hot path goes to the allocator,
+ * and how many bytes it asks for.
+**/
+
+typedef struct
+{
+	uint64_t allocations;
+	uint64_t bytes;
+} DDAllocationCount;
+
+/**
+ * YES if allocations can be counted on this platform.
+**/
+BOOL DDAllocationCounterIsAvailable(void);
+
+/**
+ * Resets the counters and starts counting. The calling thread becomes the caller thread.
+**/
+void DDAllocationCounterStart(void);
+
+/**
+ * Reads the counters so far, without stopping. Either pointer may be NULL.
+**/
+void DDAllocationCounterRead(DDAllocationCount *caller, DDAllocationCount *other);
+
+/**
+ * Stops counting, and returns the final counts. Either pointer may be NULL.
+**/
+void DDAllocationCounterStop(DDAllocationCount *caller, DDAllocationCount *other);
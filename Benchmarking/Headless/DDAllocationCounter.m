@@ -0,0 +1,210 @@
+#import "DDAllocationCounter.h"
+
+#import <pthread.h>
+#if defined(__APPLE__)
+	#import <malloc/malloc.h>
+	#import <mach/mach.h>
+#endif
+
+// Nothing in here may allocate: it all runs inside the allocator
+
+static volatile int32_t counting = 0;
+static pthread_t callerThread;
+
+static DDAllocationCount callerCount;
+static DDAllocationCount otherCount;
+
+static inline void DDAllocationRecord(size_t size)
+{
+	if (__atomic_load_n(&counting, __ATOMIC_RELAXED) == 0) return;
+
+	DDAllocationCount *count = pthread_equal(pthread_self(), callerThread) ? &callerCount : &otherCount;
+
+	__atomic_fetch_add(&count->allocations, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&count->bytes, (uint64_t)size, __ATOMIC_RELAXED);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Apple: malloc zones
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__APPLE__)
+
+#define MAX_ZONES 16
+
+typedef struct
+{
+	malloc_zone_t *zone;
+	void *(*malloc)(struct _malloc_zone_t *zone, size_t size);
+	void *(*calloc)(struct _malloc_zone_t *zone, size_t count, size_t size);
+	void *(*valloc)(struct _malloc_zone_t *zone, size_t size);
+	void *(*realloc)(struct _malloc_zone_t *zone, void *ptr, size_t size);
+	void *(*memalign)(struct _malloc_zone_t *zone, size_t alignment, size_t size);
+} DDAllocationZoneFunctions;
+
+static DDAllocationZoneFunctions zoneFunctions[MAX_ZONES];
+static unsigned zoneCount = 0;
+
+static DDAllocationZoneFunctions *DDAllocationFunctionsForZone(malloc_zone_t *zone)
+{
+	for (unsigned i = 0; i < zoneCount; i++)
+	{
+		if (zoneFunctions[i].zone == zone) return &zoneFunctions[i];
+	}
+
+	// Not reached: only hooked zones call the wrappers
+	abort();
+}
+
+static void *DDAllocationZoneMalloc(malloc_zone_t *zone, size_t size)
+{
+	DDAllocationRecord(size);
+	return DDAllocationFunctionsForZone(zone)->malloc(zone, size);
+}
+
+static void *DDAllocationZoneCalloc(malloc_zone_t *zone, size_t count, size_t size)
+{
+	DDAllocationRecord(count * size);
+	return DDAllocationFunctionsForZone(zone)->calloc(zone, count, size);
+}
+
+static void *DDAllocationZoneValloc(malloc_zone_t *zone, size_t size)
+{
+	DDAllocationRecord(size);
+	return DDAllocationFunctionsForZone(zone)->valloc(zone, size);
+}
+
+static void *DDAllocationZoneRealloc(malloc_zone_t *zone, void *ptr, size_t size)
+{
+	DDAllocationRecord(size);
+	return DDAllocationFunctionsForZone(zone)->realloc(zone, ptr, size);
+}
+
+static void *DDAllocationZoneMemalign(malloc_zone_t *zone, size_t alignment, size_t size)
+{
+	DDAllocationRecord(size);
+	return DDAllocationFunctionsForZone(zone)->memalign(zone, alignment, size);
+}
+
+static void DDAllocationHookZone(malloc_zone_t *zone)
+{
+	if (zone == NULL || zoneCount >= MAX_ZONES) return;
+
+	for (unsigned i = 0; i < zoneCount; i++)
+	{
+		if (zoneFunctions[i].zone == zone) return;
+	}
+
+	DDAllocationZoneFunctions *functions = &zoneFunctions[zoneCount];
+
+	functions->zone = zone;
+	functions->malloc = zone->malloc;
+	functions->calloc = zone->calloc;
+	functions->valloc = zone->valloc;
+	functions->realloc = zone->realloc;
+	functions->memalign = (zone->version >= 5) ? zone->memalign : NULL;
+
+	// Publish the originals before any wrapper can be called
+	__atomic_store_n(&zoneCount, zoneCount + 1, __ATOMIC_RELEASE);
+
+	// Since version 8 the zone structure is write protected
+	if (zone->version >= 8)
+	{
+		vm_protect(mach_task_self(), (vm_address_t)zone, sizeof(malloc_zone_t), 0, VM_PROT_READ | VM_PROT_WRITE);
+	}
+
+	zone->malloc = DDAllocationZoneMalloc;
+	zone->calloc = DDAllocationZoneCalloc;
+	zone->valloc = DDAllocationZoneValloc;
+	zone->realloc = DDAllocationZoneRealloc;
+
+	if (functions->memalign)
+	{
+		zone->memalign = DDAllocationZoneMemalign;
+	}
+
+	if (zone->version >= 8)
+	{
+		vm_protect(mach_task_self(), (vm_address_t)zone, sizeof(malloc_zone_t), 0, VM_PROT_READ);
+	}
+}
+
+static void DDAllocationInstallHooks(void)
+{
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+
+		// malloc() goes to the first registered zone (which may be the nano zone, not malloc_default_zone()),
+		// so every registered zone is hooked
+		vm_address_t *zones = NULL;
+		unsigned count = 0;
+
+		if (malloc_get_all_zones(mach_task_self(), NULL, &zones, &count) == KERN_SUCCESS)
+		{
+			for (unsigned i = 0; i < count; i++)
+			{
+				DDAllocationHookZone((malloc_zone_t *)zones[i]);
+			}
+		}
+
+		DDAllocationHookZone(malloc_default_zone());
+	});
+}
+
+BOOL DDAllocationCounterIsAvailable(void)
+{
+	return YES;
+}
+
+#else
+
+static void DDAllocationInstallHooks(void)
+{
+}
+
+BOOL DDAllocationCounterIsAvailable(void)
+{
+	return NO;
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DDAllocationCounterStart(void)
+{
+	DDAllocationInstallHooks();
+
+	__atomic_store_n(&counting, 0, __ATOMIC_SEQ_CST);
+
+	callerThread = pthread_self();
+	memset(&callerCount, 0, sizeof(callerCount));
+	memset(&otherCount, 0, sizeof(otherCount));
+
+	__atomic_store_n(&counting, 1, __ATOMIC_SEQ_CST);
+}
+
+void DDAllocationCounterRead(DDAllocationCount *caller, DDAllocationCount *other)
+{
+	if (caller)
+	{
+		caller->allocations = __atomic_load_n(&callerCount.allocations, __ATOMIC_RELAXED);
+		caller->bytes = __atomic_load_n(&callerCount.bytes, __ATOMIC_RELAXED);
+	}
+
+	if (other)
+	{
+		other->allocations = __atomic_load_n(&otherCount.allocations, __ATOMIC_RELAXED);
+		other->bytes = __atomic_load_n(&otherCount.bytes, __ATOMIC_RELAXED);
+	}
+}
+
+void DDAllocationCounterStop(DDAllocationCount *caller, DDAllocationCount *other)
+{
+	__atomic_store_n(&counting, 0, __ATOMIC_SEQ_CST);
+
+	DDAllocationCounterRead(caller, other);
+}
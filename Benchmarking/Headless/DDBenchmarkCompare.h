@@ -0,0 +1,42 @@
+#import <Foundation/Foundation.h>
+#import "DDBenchmarkSupport.h"
+
+/**
+ * Compares a candidate run against a baseline run of the same benchmark, both as JSON reports
+ * (`--format json`), and flags regressions.
+ *
+ * Rows are matched on the key columns of the report, and the metric column is compared
+ * (e.g. ns_per_op_median for `micro`, throughput_msgs_per_sec for `throughput`).
+ * A row regresses when the metric got worse by more than `thresholdPercent`, and, if both runs
+ * carry the individual samples, when the difference is also significant: a two-sided Mann-Whitney U test
+ * with a p-value below `alpha`. Without samples only the threshold applies.
+ *
+ * Differences in the environment (CPU, cores, OS, compiler, flags) are reported on stderr:
+ * results from different machines or builds are rarely comparable.
+ *
+ * Reported per row: key, baseline, candidate, change_percent, p_value, verdict
+ * (unchanged, improvement, regression, missing or new).
+**/
+@interface DDBenchmarkCompare : NSObject
+
+@property (nonatomic, copy) NSString *baselinePath;
+@property (nonatomic, copy) NSString *candidatePath;
+@property (nonatomic, assign) double thresholdPercent;
+@property (nonatomic, assign) double alpha;
+
+/**
+ * --baseline baselines/micro.json  --candidate micro.json  --threshold 5  --alpha 0.05
+**/
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options;
+
+/**
+ * Returns nil if the reports can't be read or can't be compared.
+**/
+- (DDBenchmarkReport *)run;
+
+/**
+ * The number of regressions found by the last run.
+**/
+@property (nonatomic, readonly) NSUInteger regressionCount;
+
+@end
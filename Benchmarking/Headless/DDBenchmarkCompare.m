@@ -0,0 +1,227 @@
+#import "DDBenchmarkCompare.h"
+
+// Environment entries that make results incomparable when they differ
+static NSArray *DDBenchmarkCompareEnvironmentKeys(void)
+{
+	return @[ @"cpu", @"cores", @"memory_bytes", @"os", @"compiler", @"compiler_flags" ];
+}
+
+static NSDictionary *DDBenchmarkCompareLoadReport(NSString *path)
+{
+	NSData *data = path ? [NSData dataWithContentsOfFile:path] : nil;
+
+	if (data == nil)
+	{
+		fprintf(stderr, "compare: can't read %s\n", path ? path.UTF8String : "(no path given)");
+		return nil;
+	}
+
+	id object = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+
+	if (![object isKindOfClass:[NSDictionary class]] || ![object[@"results"] isKindOfClass:[NSArray class]])
+	{
+		fprintf(stderr, "compare: %s is not a JSON benchmark report\n", path.UTF8String);
+		return nil;
+	}
+
+	return object;
+}
+
+static NSString *DDBenchmarkCompareRowKey(NSDictionary *row, NSArray *keyColumns)
+{
+	NSMutableArray *values = [NSMutableArray arrayWithCapacity:keyColumns.count];
+
+	for (NSString *column in keyColumns)
+	{
+		[values addObject:[row[column] description] ?: @""];
+	}
+
+	return [values componentsJoinedByString:@"/"];
+}
+
+static double *DDBenchmarkCompareCopySamples(id samples, size_t *count)
+{
+	*count = 0;
+
+	if (![samples isKindOfClass:[NSArray class]] || [samples count] == 0) return NULL;
+
+	double *values = malloc([samples count] * sizeof(double));
+
+	for (id sample in samples)
+	{
+		if ([sample isKindOfClass:[NSNumber class]])
+		{
+			values[(*count)++] = [sample doubleValue];
+		}
+	}
+
+	return values;
+}
+
+
+@implementation DDBenchmarkCompare
+
+- (instancetype)init
+{
+	return [self initWithOptions:[[DDBenchmarkOptions alloc] initWithArguments:@[]]];
+}
+
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options
+{
+	if ((self = [super init]))
+	{
+		_baselinePath = [options stringForOption:@"baseline" defaultValue:nil];
+		_candidatePath = [options stringForOption:@"candidate" defaultValue:nil];
+		_thresholdPercent = [[options stringForOption:@"threshold" defaultValue:@"5"] doubleValue];
+		_alpha = [[options stringForOption:@"alpha" defaultValue:@"0.05"] doubleValue];
+	}
+	return self;
+}
+
+- (void)warnAboutEnvironmentOf:(NSDictionary *)baseline candidate:(NSDictionary *)candidate
+{
+	NSDictionary *baselineEnvironment = baseline[@"environment"];
+	NSDictionary *candidateEnvironment = candidate[@"environment"];
+
+	if (![baselineEnvironment isKindOfClass:[NSDictionary class]] || ![candidateEnvironment isKindOfClass:[NSDictionary class]])
+	{
+		fprintf(stderr, "compare: warning: environment not recorded, results may not be comparable\n");
+		return;
+	}
+
+	for (NSString *key in DDBenchmarkCompareEnvironmentKeys())
+	{
+		id a = baselineEnvironment[key];
+		id b = candidateEnvironment[key];
+
+		if (a && b && ![a isEqual:b])
+		{
+			fprintf(stderr, "compare: warning: %s differs: baseline \"%s\", candidate \"%s\"\n",
+			        key.UTF8String, [a description].UTF8String, [b description].UTF8String);
+		}
+	}
+}
+
+- (DDBenchmarkReport *)run
+{
+	_regressionCount = 0;
+
+	NSDictionary *baseline = DDBenchmarkCompareLoadReport(_baselinePath);
+	NSDictionary *candidate = DDBenchmarkCompareLoadReport(_candidatePath);
+
+	if (baseline == nil || candidate == nil) return nil;
+
+	if (![baseline[@"benchmark"] isEqual:candidate[@"benchmark"]])
+	{
+		fprintf(stderr, "compare: the reports are of different benchmarks\n");
+		return nil;
+	}
+
+	NSString *metric = baseline[@"metric"];
+	NSArray *keyColumns = baseline[@"key_columns"];
+
+	if (![metric isKindOfClass:[NSString class]] || ![keyColumns isKindOfClass:[NSArray class]])
+	{
+		fprintf(stderr, "compare: the %s benchmark has no metric to compare\n", [baseline[@"benchmark"] description].UTF8String);
+		return nil;
+	}
+
+	NSString *samplesColumn = [baseline[@"samples"] isKindOfClass:[NSString class]] ? baseline[@"samples"] : nil;
+	BOOL higherIsBetter = [baseline[@"higher_is_better"] boolValue];
+
+	[self warnAboutEnvironmentOf:baseline candidate:candidate];
+
+	NSMutableDictionary *candidateRows = [NSMutableDictionary dictionary];
+	NSMutableArray *candidateKeys = [NSMutableArray array];
+
+	for (NSDictionary *row in candidate[@"results"])
+	{
+		NSString *key = DDBenchmarkCompareRowKey(row, keyColumns);
+
+		candidateRows[key] = row;
+		[candidateKeys addObject:key];
+	}
+
+	NSArray *columns = @[ @"key", @"baseline", @"candidate", @"change_percent", @"p_value", @"verdict" ];
+	NSString *name = [NSString stringWithFormat:@"compare-%@", baseline[@"benchmark"]];
+
+	DDBenchmarkReport *report = [[DDBenchmarkReport alloc] initWithName:name columns:columns];
+	NSMutableSet *matchedKeys = [NSMutableSet set];
+
+	for (NSDictionary *baselineRow in baseline[@"results"])
+	{
+		NSString *key = DDBenchmarkCompareRowKey(baselineRow, keyColumns);
+		NSDictionary *candidateRow = candidateRows[key];
+
+		id baselineValue = baselineRow[metric];
+		id candidateValue = candidateRow[metric];
+
+		if (![baselineValue isKindOfClass:[NSNumber class]] || ![candidateValue isKindOfClass:[NSNumber class]])
+		{
+			[report addRow:@[ key, baselineValue ?: [NSNull null], candidateValue ?: [NSNull null],
+			                  [NSNull null], [NSNull null], @"missing" ]];
+			[matchedKeys addObject:key];
+			continue;
+		}
+
+		[matchedKeys addObject:key];
+
+		double before = [baselineValue doubleValue];
+		double after = [candidateValue doubleValue];
+		double change = (before != 0.0) ? (after - before) / before * 100.0 : 0.0;
+
+		// Positive: got worse
+		double worsening = higherIsBetter ? -change : change;
+
+		id pValue = [NSNull null];
+		BOOL significant = YES;
+
+		if (samplesColumn)
+		{
+			size_t countA, countB;
+			double *a = DDBenchmarkCompareCopySamples(baselineRow[samplesColumn], &countA);
+			double *b = DDBenchmarkCompareCopySamples(candidateRow[samplesColumn], &countB);
+
+			if (countA > 0 && countB > 0)
+			{
+				double p = DDBenchmarkMannWhitneyPValue(a, countA, b, countB);
+
+				pValue = @(p);
+				significant = (p < _alpha);
+			}
+
+			free(a);
+			free(b);
+		}
+
+		NSString *verdict = @"unchanged";
+
+		if (significant && worsening > _thresholdPercent)
+		{
+			verdict = @"regression";
+			_regressionCount++;
+		}
+		else if (significant && -worsening > _thresholdPercent)
+		{
+			verdict = @"improvement";
+		}
+
+		[report addRow:@[ key, baselineValue, candidateValue, @(change), pValue, verdict ]];
+	}
+
+	for (NSString *key in candidateKeys)
+	{
+		if (![matchedKeys containsObject:key])
+		{
+			[report addRow:@[ key, [NSNull null], candidateRows[key][metric] ?: [NSNull null],
+			                  [NSNull null], [NSNull null], @"new" ]];
+		}
+	}
+
+	fprintf(stderr, "compare: %s: %lu regression(s) (threshold %.1f%%, alpha %.3f)\n",
+	        [baseline[@"benchmark"] description].UTF8String, (unsigned long)_regressionCount, _thresholdPercent, _alpha);
+
+	return report;
+}
+
+@end
@@ -0,0 +1,46 @@
+#import <Foundation/Foundation.h>
+#import "DDLog.h"
+
+/**
+ * A logger that drops every message.
+ * Measures the cost of the framework itself: message creation, queueing and dispatching to loggers.
+**/
+@interface DDBenchmarkNullLogger : DDAbstractLogger <DDLogger>
+@end
+
+
+/**
+ * The sink configurations the benchmarks are run against.
+ *
+ * - "null"     : DDBenchmarkNullLogger
+ * - "tty"      : DDTTYLogger, with stderr redirected to /dev/null
+ * - "file"     : DDFileLogger, writing to a temporary directory (rolling at the default 1 MB)
+ * - "file+tty" : both of the above
+ *
+ * Not part of `allSinkNames` (request them with --sinks):
+ *
+ * - "syslog-udp" : DDRemoteSyslogLogger sending datagrams to a DDLoopbackSyslogServer
+ * - "syslog-tcp" : DDRemoteSyslogLogger sending octet-counted messages to a DDLoopbackSyslogServer
+**/
+@interface DDBenchmarkSinks : NSObject
+
++ (NSArray<NSString *> *)allSinkNames;
+
+/**
+ * Removes all loggers, and adds the loggers of the given configuration.
+ * Returns NO for an unknown configuration.
+**/
++ (BOOL)installSinksNamed:(NSString *)name;
+
+/**
+ * Removes all loggers, restores stderr and deletes temporary log files.
+**/
++ (void)uninstallSinks;
+
+/**
+ * Sends everything written to stderr to /dev/null (so terminal rendering isn't measured), and back.
+**/
++ (void)redirectStderrToDevNull;
++ (void)restoreStderr;
+
+@end
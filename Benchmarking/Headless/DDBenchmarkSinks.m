@@ -0,0 +1,155 @@
+#import "DDBenchmarkSinks.h"
+#import "DDTTYLogger.h"
+#import "DDFileLogger.h"
+#import "DDRemoteSyslogLogger.h"
+
+#import <fcntl.h>
+#import <unistd.h>
+
+
+@implementation DDBenchmarkNullLogger
+
+- (void)logMessage:(DDLogMessage *)logMessage
+{
+	// Intentionally empty
+}
+
+- (NSString *)loggerName
+{
+	return @"cocoa.lumberjack.benchmark.nullLogger";
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@implementation DDBenchmarkSinks
+
+static int savedStderr = -1;
+static NSString *logsDirectory = nil;
+static DDLoopbackSyslogServer *syslogServer = nil;
+
++ (NSArray<NSString *> *)allSinkNames
+{
+	return @[ @"null", @"tty", @"file", @"file+tty" ];
+}
+
++ (void)redirectStderrToDevNull
+{
+	if (savedStderr >= 0) return;
+
+	int devNull = open("/dev/null", O_WRONLY);
+
+	if (devNull < 0) return;
+
+	fflush(stderr);
+
+	savedStderr = dup(STDERR_FILENO);
+	dup2(devNull, STDERR_FILENO);
+	close(devNull);
+}
+
++ (void)restoreStderr
+{
+	if (savedStderr < 0) return;
+
+	fflush(stderr);
+
+	dup2(savedStderr, STDERR_FILENO);
+	close(savedStderr);
+	savedStderr = -1;
+}
+
++ (DDFileLogger *)newFileLogger
+{
+	NSString *name = [NSString stringWithFormat:@"lumberjack-benchmark-%d", getpid()];
+	logsDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:name];
+
+	DDLogFileManagerDefault *logFileManager = [[DDLogFileManagerDefault alloc] initWithLogsDirectory:logsDirectory];
+	logFileManager.maximumNumberOfLogFiles = 4;
+
+	return [[DDFileLogger alloc] initWithLogFileManager:logFileManager];
+}
+
++ (DDRemoteSyslogLogger *)newSyslogLoggerWithTransport:(DDRemoteSyslogTransport)transport
+{
+	syslogServer = [[DDLoopbackSyslogServer alloc] initWithTransport:transport port:0];
+
+	if (![syslogServer startListening:NULL])
+	{
+		syslogServer = nil;
+		return nil;
+	}
+
+	// Nothing is dropped, and flushing (when the queue is drained) waits until everything is sent
+	DDRemoteSyslogLogger *logger = [[DDRemoteSyslogLogger alloc] initWithHost:@"127.0.0.1" port:syslogServer.port transport:transport];
+	logger.retryBufferSize = 16 * 1024 * 1024;
+	logger.flushTimeout = 10.0;
+
+	return logger;
+}
+
++ (BOOL)installSinksNamed:(NSString *)name
+{
+	[self uninstallSinks];
+
+	if ([name isEqualToString:@"null"])
+	{
+		[DDLog addLogger:[[DDBenchmarkNullLogger alloc] init]];
+	}
+	else if ([name isEqualToString:@"tty"])
+	{
+		[self redirectStderrToDevNull];
+		[DDLog addLogger:[DDTTYLogger sharedInstance]];
+	}
+	else if ([name isEqualToString:@"file"])
+	{
+		[DDLog addLogger:[self newFileLogger]];
+	}
+	else if ([name isEqualToString:@"file+tty"])
+	{
+		[self redirectStderrToDevNull];
+		[DDLog addLogger:[DDTTYLogger sharedInstance]];
+		[DDLog addLogger:[self newFileLogger]];
+	}
+	else if ([name isEqualToString:@"syslog-udp"] || [name isEqualToString:@"syslog-tcp"])
+	{
+		BOOL udp = [name isEqualToString:@"syslog-udp"];
+		DDRemoteSyslogLogger *logger = [self newSyslogLoggerWithTransport:udp ? DDRemoteSyslogTransportUDP : DDRemoteSyslogTransportTCP];
+
+		if (logger == nil) return NO;
+
+		[DDLog addLogger:logger];
+	}
+	else
+	{
+		return NO;
+	}
+
+	// Make sure the loggers are in place before the clock starts
+	[DDLog flushLog];
+
+	return YES;
+}
+
++ (void)uninstallSinks
+{
+	[DDLog flushLog];
+	[DDLog removeAllLoggers];
+	[DDLog flushLog];
+
+	[self restoreStderr];
+
+	[syslogServer stopListening];
+	syslogServer = nil;
+
+	if (logsDirectory)
+	{
+		[[NSFileManager defaultManager] removeItemAtPath:logsDirectory error:nil];
+		logsDirectory = nil;
+	}
+}
+
+@end
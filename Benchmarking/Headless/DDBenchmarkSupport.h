@@ -0,0 +1,124 @@
+#import <Foundation/Foundation.h>
+
+/**
+ * Shared plumbing for the headless benchmarks: a monotonic clock, sample statistics and report output.
+ * Only POSIX and Foundation are used, so the harness itself builds wherever the library does.
+**/
+
+/**
+ * Monotonic time in nanoseconds.
+**/
+uint64_t DDBenchmarkNow(void);
+
+/**
+ * Sorts samples in place (ascending).
+**/
+void DDBenchmarkSortSamples(uint64_t *samples, size_t count);
+
+/**
+ * Returns the given percentile (0.0 - 100.0) of sorted samples, using the nearest-rank method.
+**/
+uint64_t DDBenchmarkPercentile(const uint64_t *sortedSamples, size_t count, double percentile);
+
+/**
+ * Median of the values (sorts them in place).
+**/
+double DDBenchmarkMedian(double *values, size_t count);
+
+/**
+ * Median absolute deviation from the given median. A robust measure of spread, unlike the standard deviation
+ * it isn't blown up by the occasional sample hit by a context switch.
+**/
+double DDBenchmarkMedianAbsoluteDeviation(const double *values, size_t count, double median);
+
+/**
+ * Reads the CPU cycle counter, or returns 0 if there is no counter readable from user space
+ * (it is only read on x86, where it counts reference cycles at the nominal frequency).
+**/
+uint64_t DDBenchmarkCycles(void);
+
+/**
+ * YES if DDBenchmarkCycles() returns meaningful values.
+**/
+BOOL DDBenchmarkHasCycleCounter(void);
+
+/**
+ * Two-sided Mann-Whitney U test: the probability of seeing samples this different if both came from
+ * the same distribution. Uses the normal approximation with tie correction (fine from about 8 samples per side).
+ * Makes no assumption about the shape of the distributions, which for timings is usually skewed.
+**/
+double DDBenchmarkMannWhitneyPValue(const double *a, size_t countA, const double *b, size_t countB);
+
+/**
+ * Where and how the results were measured: CPU model, core count, memory, OS, compiler, compiler flags,
+ * source revision and date. Included in every JSON report, so results are only compared knowingly
+ * across machines or builds.
+**/
+NSDictionary<NSString *, id> *DDBenchmarkEnvironment(void);
+
+
+typedef NS_ENUM(NSUInteger, DDBenchmarkOutputFormat)
+{
+	DDBenchmarkOutputFormatCSV,
+	DDBenchmarkOutputFormatJSON
+};
+
+/**
+ * A table of results.
+ *
+ * Every row has a value (NSNumber, NSString, an NSArray of samples, or NSNull for "not available") for each column.
+ * The CSV representation has a header line (samples are joined with ';'). The JSON representation is an object
+ * with the benchmark name, the environment (see DDBenchmarkEnvironment), the comparison metadata and an array of
+ * row objects, so results of different runs can be diffed, loaded side by side and compared (see DDBenchmarkCompare).
+**/
+@interface DDBenchmarkReport : NSObject
+
+- (instancetype)initWithName:(NSString *)name columns:(NSArray<NSString *> *)columns;
+
+@property (nonatomic, readonly) NSString *name;
+@property (nonatomic, readonly) NSArray<NSString *> *columns;
+@property (nonatomic, readonly) NSArray<NSArray *> *rows;
+
+/**
+ * How rows of two runs are matched (e.g. the case name), and which column is compared, for `compare`.
+ * The samples column (optional) holds an array with the individual measurements behind the metric;
+ * with samples, differences are tested for significance.
+**/
+@property (nonatomic, copy) NSArray<NSString *> *keyColumns;
+@property (nonatomic, copy) NSString *metricColumn;
+@property (nonatomic, copy) NSString *samplesColumn;
+@property (nonatomic, assign) BOOL higherIsBetter;
+
+- (void)addRow:(NSArray *)values;
+
+- (NSString *)CSVRepresentation;
+- (NSString *)JSONRepresentation;
+
+/**
+ * Writes the report to the given path, or to stdout if path is nil.
+**/
+- (BOOL)writeToPath:(NSString *)path format:(DDBenchmarkOutputFormat)format;
+
+@end
+
+
+/**
+ * Minimal command line option access: "--name value" pairs.
+**/
+@interface DDBenchmarkOptions : NSObject
+
+- (instancetype)initWithArguments:(NSArray<NSString *> *)arguments;
+
+- (NSString *)stringForOption:(NSString *)name defaultValue:(NSString *)defaultValue;
+- (NSUInteger)unsignedIntegerForOption:(NSString *)name defaultValue:(NSUInteger)defaultValue;
+
+/**
+ * Comma separated list, e.g. "--producers 1,2,4,8"
+**/
+- (NSArray<NSString *> *)listForOption:(NSString *)name defaultValue:(NSString *)defaultValue;
+- (NSArray<NSNumber *> *)numberListForOption:(NSString *)name defaultValue:(NSString *)defaultValue;
+
+- (DDBenchmarkOutputFormat)outputFormat;
+- (NSString *)outputPath;
+
+@end
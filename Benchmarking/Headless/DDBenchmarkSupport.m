@@ -0,0 +1,431 @@
+#import "DDBenchmarkSupport.h"
+
+#import <math.h>
+#import <time.h>
+#if defined(__APPLE__)
+	#import <mach/mach_time.h>
+	#import <sys/sysctl.h>
+#endif
+
+
+uint64_t DDBenchmarkNow(void)
+{
+#if defined(__APPLE__)
+	// clock_gettime only exists since 10.12, mach_absolute_time everywhere
+	static mach_timebase_info_data_t timebase;
+
+	if (timebase.denom == 0)
+	{
+		mach_timebase_info(&timebase);
+	}
+
+	return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static int DDBenchmarkCompareSamples(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+void DDBenchmarkSortSamples(uint64_t *samples, size_t count)
+{
+	qsort(samples, count, sizeof(uint64_t), DDBenchmarkCompareSamples);
+}
+
+uint64_t DDBenchmarkPercentile(const uint64_t *sortedSamples, size_t count, double percentile)
+{
+	if (count == 0) return 0;
+
+	double rank = ceil(percentile / 100.0 * (double)count);
+	size_t index = (rank < 1.0) ? 0 : (size_t)rank - 1;
+
+	return sortedSamples[MIN(index, count - 1)];
+}
+
+static int DDBenchmarkCompareDoubles(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+double DDBenchmarkMedian(double *values, size_t count)
+{
+	if (count == 0) return 0.0;
+
+	qsort(values, count, sizeof(double), DDBenchmarkCompareDoubles);
+
+	return (count % 2) ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+double DDBenchmarkMedianAbsoluteDeviation(const double *values, size_t count, double median)
+{
+	if (count == 0) return 0.0;
+
+	double deviations[count];
+
+	for (size_t i = 0; i < count; i++)
+	{
+		deviations[i] = fabs(values[i] - median);
+	}
+
+	return DDBenchmarkMedian(deviations, count);
+}
+
+uint64_t DDBenchmarkCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_readcyclecounter();
+#else
+	// On ARM the cycle counter isn't accessible from user space (reading it traps)
+	return 0;
+#endif
+}
+
+BOOL DDBenchmarkHasCycleCounter(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return YES;
+#else
+	return NO;
+#endif
+}
+
+typedef struct
+{
+	double value;
+	int group;
+} DDBenchmarkRankedValue;
+
+static int DDBenchmarkCompareRankedValues(const void *a, const void *b)
+{
+	double x = ((const DDBenchmarkRankedValue *)a)->value;
+	double y = ((const DDBenchmarkRankedValue *)b)->value;
+
+	return (x > y) - (x < y);
+}
+
+double DDBenchmarkMannWhitneyPValue(const double *a, size_t countA, const double *b, size_t countB)
+{
+	if (countA == 0 || countB == 0) return 1.0;
+
+	size_t count = countA + countB;
+	DDBenchmarkRankedValue *values = malloc(count * sizeof(DDBenchmarkRankedValue));
+
+	for (size_t i = 0; i < countA; i++) values[i] = (DDBenchmarkRankedValue){ a[i], 0 };
+	for (size_t i = 0; i < countB; i++) values[countA + i] = (DDBenchmarkRankedValue){ b[i], 1 };
+
+	qsort(values, count, sizeof(DDBenchmarkRankedValue), DDBenchmarkCompareRankedValues);
+
+	// Rank sum of the first group, with ties getting the average of their ranks
+	double rankSumA = 0.0;
+	double tieCorrection = 0.0;
+
+	for (size_t i = 0; i < count; )
+	{
+		size_t j = i;
+		while (j + 1 < count && values[j + 1].value == values[i].value) j++;
+
+		double ties = (double)(j - i + 1);
+		double rank = (double)(i + j + 2) / 2.0; // ranks are 1-based
+
+		for (size_t k = i; k <= j; k++)
+		{
+			if (values[k].group == 0) rankSumA += rank;
+		}
+
+		tieCorrection += ties * ties * ties - ties;
+		i = j + 1;
+	}
+
+	free(values);
+
+	double n1 = (double)countA;
+	double n2 = (double)countB;
+	double n = n1 + n2;
+
+	double u = rankSumA - n1 * (n1 + 1.0) / 2.0;
+	double mean = n1 * n2 / 2.0;
+	double variance = n1 * n2 / 12.0 * ((n + 1.0) - tieCorrection / (n * (n - 1.0)));
+
+	if (variance <= 0.0) return 1.0;
+
+	// Continuity corrected
+	double z = MAX(fabs(u - mean) - 0.5, 0.0) / sqrt(variance);
+
+	return erfc(z / M_SQRT2);
+}
+
+static NSString *DDBenchmarkCPUModel(void)
+{
+#if defined(__APPLE__)
+	char brand[256];
+	size_t size = sizeof(brand);
+
+	if (sysctlbyname("machdep.cpu.brand_string", brand, &size, NULL, 0) == 0)
+	{
+		return @(brand);
+	}
+#else
+	NSString *cpuinfo = [NSString stringWithContentsOfFile:@"/proc/cpuinfo" encoding:NSUTF8StringEncoding error:nil];
+
+	for (NSString *line in [cpuinfo componentsSeparatedByString:@"\n"])
+	{
+		if ([line hasPrefix:@"model name"])
+		{
+			NSRange colon = [line rangeOfString:@":"];
+
+			if (colon.location != NSNotFound)
+			{
+				return [[line substringFromIndex:NSMaxRange(colon)] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+			}
+		}
+	}
+#endif
+
+	return @"unknown";
+}
+
+NSDictionary<NSString *, id> *DDBenchmarkEnvironment(void)
+{
+	NSProcessInfo *processInfo = [NSProcessInfo processInfo];
+
+#ifdef DD_BENCHMARK_CFLAGS
+	NSString *flags = @DD_BENCHMARK_CFLAGS;
+#else
+	NSString *flags = @"unknown";
+#endif
+
+#ifdef DD_BENCHMARK_REVISION
+	NSString *revision = @DD_BENCHMARK_REVISION;
+#else
+	NSString *revision = @"unknown";
+#endif
+
+	return @{ @"cpu"            : DDBenchmarkCPUModel(),
+	          @"cores"          : @(processInfo.processorCount),
+	          @"active_cores"   : @(processInfo.activeProcessorCount),
+	          @"memory_bytes"   : @(processInfo.physicalMemory),
+	          @"os"             : processInfo.operatingSystemVersionString,
+	          @"compiler"       : @__VERSION__,
+	          @"compiler_flags" : flags,
+	          @"revision"       : revision,
+	          @"date"           : [[NSDate date] description] };
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@implementation DDBenchmarkReport
+{
+	NSMutableArray *_rows;
+}
+
+- (instancetype)initWithName:(NSString *)name columns:(NSArray<NSString *> *)columns
+{
+	if ((self = [super init]))
+	{
+		_name = [name copy];
+		_columns = [columns copy];
+		_rows = [NSMutableArray array];
+	}
+	return self;
+}
+
+- (NSArray<NSArray *> *)rows
+{
+	return [_rows copy];
+}
+
+- (void)addRow:(NSArray *)values
+{
+	NSAssert(values.count == _columns.count, @"Expected %lu values", (unsigned long)_columns.count);
+
+	[_rows addObject:[values copy]];
+}
+
+static NSString *DDBenchmarkCSVField(id value)
+{
+	if (value == [NSNull null]) return @"";
+
+	NSString *string = [value isKindOfClass:[NSArray class]] ? [value componentsJoinedByString:@";"] : [value description];
+
+	if ([string rangeOfCharacterFromSet:[NSCharacterSet characterSetWithCharactersInString:@",\"\n"]].location != NSNotFound)
+	{
+		string = [NSString stringWithFormat:@"\"%@\"", [string stringByReplacingOccurrencesOfString:@"\"" withString:@"\"\""]];
+	}
+
+	return string;
+}
+
+- (NSString *)CSVRepresentation
+{
+	NSMutableString *csv = [NSMutableString string];
+
+	[csv appendString:[_columns componentsJoinedByString:@","]];
+	[csv appendString:@"\n"];
+
+	for (NSArray *row in _rows)
+	{
+		NSMutableArray *fields = [NSMutableArray arrayWithCapacity:row.count];
+
+		for (id value in row)
+		{
+			[fields addObject:DDBenchmarkCSVField(value)];
+		}
+
+		[csv appendString:[fields componentsJoinedByString:@","]];
+		[csv appendString:@"\n"];
+	}
+
+	return csv;
+}
+
+- (NSDictionary *)JSONObject
+{
+	NSMutableArray *results = [NSMutableArray arrayWithCapacity:_rows.count];
+
+	for (NSArray *row in _rows)
+	{
+		[results addObject:[NSDictionary dictionaryWithObjects:row forKeys:_columns]];
+	}
+
+	NSMutableDictionary *object = [NSMutableDictionary dictionary];
+
+	object[@"benchmark"] = _name;
+	object[@"environment"] = DDBenchmarkEnvironment();
+
+	if (_metricColumn)
+	{
+		object[@"key_columns"] = _keyColumns ?: @[];
+		object[@"metric"] = _metricColumn;
+		object[@"samples"] = _samplesColumn ?: [NSNull null];
+		object[@"higher_is_better"] = @(_higherIsBetter);
+	}
+
+	object[@"results"] = results;
+
+	return object;
+}
+
+- (NSString *)JSONRepresentation
+{
+	NSData *data = [NSJSONSerialization dataWithJSONObject:[self JSONObject]
+	                                               options:NSJSONWritingPrettyPrinted
+	                                                 error:nil];
+
+	return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+}
+
+- (BOOL)writeToPath:(NSString *)path format:(DDBenchmarkOutputFormat)format
+{
+	NSString *output = (format == DDBenchmarkOutputFormatJSON) ? [self JSONRepresentation] : [self CSVRepresentation];
+
+	if (path == nil)
+	{
+		NSData *data = [output dataUsingEncoding:NSUTF8StringEncoding];
+
+		fwrite(data.bytes, 1, data.length, stdout);
+		fflush(stdout);
+
+		return YES;
+	}
+
+	return [output writeToFile:path atomically:YES encoding:NSUTF8StringEncoding error:nil];
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@implementation DDBenchmarkOptions
+{
+	NSMutableDictionary *_values;
+}
+
+- (instancetype)initWithArguments:(NSArray<NSString *> *)arguments
+{
+	if ((self = [super init]))
+	{
+		_values = [NSMutableDictionary dictionary];
+
+		for (NSUInteger i = 0; i < arguments.count; i++)
+		{
+			NSString *argument = arguments[i];
+
+			if (![argument hasPrefix:@"--"]) continue;
+
+			NSString *name = [argument substringFromIndex:2];
+
+			if (i + 1 < arguments.count && ![arguments[i + 1] hasPrefix:@"--"])
+			{
+				_values[name] = arguments[++i];
+			}
+			else
+			{
+				_values[name] = @"";
+			}
+		}
+	}
+	return self;
+}
+
+- (NSString *)stringForOption:(NSString *)name defaultValue:(NSString *)defaultValue
+{
+	return _values[name] ?: defaultValue;
+}
+
+- (NSUInteger)unsignedIntegerForOption:(NSString *)name defaultValue:(NSUInteger)defaultValue
+{
+	NSString *value = _values[name];
+
+	return value.length ? (NSUInteger)[value longLongValue] : defaultValue;
+}
+
+- (NSArray<NSString *> *)listForOption:(NSString *)name defaultValue:(NSString *)defaultValue
+{
+	NSString *value = [self stringForOption:name defaultValue:defaultValue];
+
+	return [value componentsSeparatedByString:@","];
+}
+
+- (NSArray<NSNumber *> *)numberListForOption:(NSString *)name defaultValue:(NSString *)defaultValue
+{
+	NSMutableArray *numbers = [NSMutableArray array];
+
+	for (NSString *value in [self listForOption:name defaultValue:defaultValue])
+	{
+		[numbers addObject:@([value longLongValue])];
+	}
+
+	return numbers;
+}
+
+- (DDBenchmarkOutputFormat)outputFormat
+{
+	NSString *format = [self stringForOption:@"format" defaultValue:@"csv"];
+
+	return [format isEqualToString:@"json"] ? DDBenchmarkOutputFormatJSON : DDBenchmarkOutputFormatCSV;
+}
+
+- (NSString *)outputPath
+{
+	NSString *path = _values[@"output"];
+
+	return path.length ? path : nil;
+}
+
+@end
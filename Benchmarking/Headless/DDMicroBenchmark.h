@@ -0,0 +1,64 @@
+#import <Foundation/Foundation.h>
+#import "DDBenchmarkSupport.h"
+
+/**
+ * A single microbenchmark case.
+ *
+ * The body runs the operation `iterations` times. It is timed as a whole, and the time is divided by `iterations`,
+ * so the clock overhead doesn't end up in the result. setUp and tearDown are not timed.
+**/
+@interface DDMicroBenchmarkCase : NSObject
+
++ (instancetype)caseWithName:(NSString *)name
+                       setUp:(dispatch_block_t)setUp
+                        body:(void (^)(NSUInteger iterations))body
+                    tearDown:(dispatch_block_t)tearDown;
+
+@property (nonatomic, readonly) NSString *name;
+@property (nonatomic, readonly) dispatch_block_t setUp;
+@property (nonatomic, readonly) void (^body)(NSUInteger iterations);
+@property (nonatomic, readonly) dispatch_block_t tearDown;
+
+@end
+
+
+/**
+ * Microbenchmarks of the individual pieces of the logging hot path:
+ * message construction (with and without the thread/queue metadata), initWithFormat:, queueing,
+ * the built-in formatters, both output paths of DDTTYLogger, and DDFileLogger writes.
+ *
+ * Methodology, per case:
+ * - warmup: the body runs until `warmupMilliseconds` have passed (caches, lazy initialization, CPU frequency)
+ * - calibration: the iterations per sample are doubled until a sample takes at least `minSampleMilliseconds`
+ * - measurement: `repetitions` samples are taken
+ *
+ * Reported: median and median absolute deviation (MAD) of the time per operation,
+ * the fastest sample, the median of the cycles per operation (where a cycle counter is available),
+ * and the individual samples, which `compare` uses to test differences between runs for significance.
+**/
+@interface DDMicroBenchmark : NSObject
+
+@property (nonatomic, assign) NSUInteger repetitions;
+@property (nonatomic, assign) NSUInteger warmupMilliseconds;
+@property (nonatomic, assign) NSUInteger minSampleMilliseconds;
+
+/**
+ * Names of the cases to run, nil for all.
+**/
+@property (nonatomic, copy) NSArray<NSString *> *caseNames;
+
+/**
+ * --cases a,b,c  --repetitions 15  --warmup-ms 200  --min-sample-ms 20  --file-directory /dev/shm
+**/
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options;
+
+- (NSArray<DDMicroBenchmarkCase *> *)allCases;
+
+- (DDBenchmarkReport *)run;
+
+/**
+ * Runs additional cases (e.g. from other benchmark files) with the same methodology.
+**/
+- (DDBenchmarkReport *)runCases:(NSArray<DDMicroBenchmarkCase *> *)cases;
+
+@end
@@ -0,0 +1,416 @@
+#import "DDMicroBenchmark.h"
+#import "DDBenchmarkSinks.h"
+#import "DDLog.h"
+#import "DDTTYLogger.h"
+#import "DDFileLogger.h"
+#import "DDDispatchQueueLogFormatter.h"
+#import "DDMultiFormatter.h"
+#import "DDLogFormatCache.h"
+#import "DDLogStringTable.h"
+
+#import <pthread.h>
+#import <unistd.h>
+
+
+@implementation DDMicroBenchmarkCase
+
++ (instancetype)caseWithName:(NSString *)name
+                       setUp:(dispatch_block_t)setUp
+                        body:(void (^)(NSUInteger iterations))body
+                    tearDown:(dispatch_block_t)tearDown
+{
+	DDMicroBenchmarkCase *benchmarkCase = [[self alloc] init];
+
+	benchmarkCase->_name = [name copy];
+	benchmarkCase->_setUp = [setUp copy];
+	benchmarkCase->_body = [body copy];
+	benchmarkCase->_tearDown = [tearDown copy];
+
+	return benchmarkCase;
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Keeps the optimizer from discarding results that are otherwise unused
+static void DDMicroBenchmarkConsume(__unsafe_unretained id object)
+{
+	__asm__ __volatile__("" : : "r"(object) : "memory");
+}
+
+static NSString *const DDMicroBenchmarkText = @"The quick brown fox jumps over the lazy dog, again and again";
+
+// Formats like the log primitives: with DDLogFormatString (the format cache), or with Foundation alone
+static NSString *DDMicroBenchmarkFormat(BOOL cached, NSString *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	NSString *message = cached ? DDLogFormatString(format, args) : [[NSString alloc] initWithFormat:format arguments:args];
+	va_end(args);
+
+	return message;
+}
+
+static DDLogMessage *DDMicroBenchmarkNewMessage(void)
+{
+	return [[DDLogMessage alloc] initWithMessage:DDMicroBenchmarkText
+	                                       level:DDLogLevelAll
+	                                        flag:DDLogFlagInfo
+	                                     context:0
+	                                        file:@(__FILE__)
+	                                    function:@(__PRETTY_FUNCTION__)
+	                                        line:__LINE__
+	                                         tag:nil
+	                                     options:0
+	                                   timestamp:nil];
+}
+
+
+@implementation DDMicroBenchmark
+{
+	NSString *_fileDirectory;
+}
+
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options
+{
+	if ((self = [super init]))
+	{
+		_repetitions = MAX([options unsignedIntegerForOption:@"repetitions" defaultValue:15], 1);
+		_warmupMilliseconds = [options unsignedIntegerForOption:@"warmup-ms" defaultValue:100];
+		_minSampleMilliseconds = MAX([options unsignedIntegerForOption:@"min-sample-ms" defaultValue:20], 1);
+
+		NSString *cases = [options stringForOption:@"cases" defaultValue:nil];
+		_caseNames = cases.length ? [cases componentsSeparatedByString:@","] : nil;
+
+		// Prefer a RAM backed file system, so the file case measures the logger and not the disk
+		BOOL isDirectory = NO;
+		NSString *defaultDirectory = NSTemporaryDirectory();
+
+		if ([[NSFileManager defaultManager] fileExistsAtPath:@"/dev/shm" isDirectory:&isDirectory] && isDirectory)
+		{
+			defaultDirectory = @"/dev/shm";
+		}
+
+		NSString *directory = [options stringForOption:@"file-directory" defaultValue:defaultDirectory];
+		NSString *name = [NSString stringWithFormat:@"lumberjack-microbenchmark-%d", getpid()];
+
+		_fileDirectory = [directory stringByAppendingPathComponent:name];
+	}
+	return self;
+}
+
+- (NSArray<DDMicroBenchmarkCase *> *)allCases
+{
+	NSMutableArray *cases = [NSMutableArray array];
+
+	// Message construction.
+	// message_init includes capturing the thread ID, thread name and queue label;
+	// message_metadata is that capture alone, so (message_init - message_metadata) is the cost without metadata.
+
+	[cases addObject:[DDMicroBenchmarkCase caseWithName:@"message_init" setUp:nil body:^(NSUInteger iterations) {
+		for (NSUInteger i = 0; i < iterations; i++)
+		{
+			@autoreleasepool {
+				DDMicroBenchmarkConsume(DDMicroBenchmarkNewMessage());
+			}
+		}
+	} tearDown:nil]];
+
+	[cases addObject:[DDMicroBenchmarkCase caseWithName:@"message_metadata" setUp:nil body:^(NSUInteger iterations) {
+		for (NSUInteger i = 0; i < iterations; i++)
+		{
+			@autoreleasepool {
+			#if defined(__APPLE__)
+				__uint64_t tid;
+				pthread_threadid_np(NULL, &tid);
+				NSString *threadID = [[NSString alloc] initWithFormat:@"%llu", tid];
+			#else
+				NSString *threadID = [[NSString alloc] initWithFormat:@"%p", (void *)pthread_self()];
+			#endif
+				NSString *threadName = NSThread.currentThread.name;
+				const char *label = dispatch_queue_get_label(DISPATCH_CURRENT_QUEUE_LABEL);
+				NSString *queueLabel = DDLogStringTableString(DDLogStringTableIntern(label, strlen(label)));
+
+				DDMicroBenchmarkConsume(threadID);
+				DDMicroBenchmarkConsume(threadName);
+				DDMicroBenchmarkConsume(queueLabel);
+			}
+		}
+	} tearDown:nil]];
+
+	// Formatting of the message text itself, as done by the log primitives
+
+	[cases addObject:[DDMicroBenchmarkCase caseWithName:@"init_with_format" setUp:nil body:^(NSUInteger iterations) {
+		for (NSUInteger i = 0; i < iterations; i++)
+		{
+			@autoreleasepool {
+				DDMicroBenchmarkConsume([[NSString alloc] initWithFormat:@"Request %lu finished in %.3f ms: %@",
+				                                                         (unsigned long)i, 12.5, @"OK"]);
+			}
+		}
+	} tearDown:nil]];
+
+	// Typical log statement formats with 3 and 6 arguments, through Foundation and through the format cache.
+	// (format_foundation_N - format_cached_N) is the saving per statement.
+
+	for (NSNumber *cached in @[ @NO, @YES ])
+	{
+		NSString *prefix = cached.boolValue ? @"format_cached" : @"format_foundation";
+
+		[cases addObject:[DDMicroBenchmarkCase caseWithName:[prefix stringByAppendingString:@"_3"] setUp:nil body:^(NSUInteger iterations) {
+			for (NSUInteger i = 0; i < iterations; i++)
+			{
+				@autoreleasepool {
+					DDMicroBenchmarkConsume(DDMicroBenchmarkFormat(cached.boolValue, @"Request %lu finished in %.3f ms (%d retries)",
+					                                               (unsigned long)i, 12.5, 2));
+				}
+			}
+		} tearDown:nil]];
+
+		[cases addObject:[DDMicroBenchmarkCase caseWithName:[prefix stringByAppendingString:@"_6"] setUp:nil body:^(NSUInteger iterations) {
+			for (NSUInteger i = 0; i < iterations; i++)
+			{
+				@autoreleasepool {
+					DDMicroBenchmarkConsume(DDMicroBenchmarkFormat(cached.boolValue, @"%s:%d: user %llu uploaded %zu bytes to %s in %.2f s",
+					                                               "Uploader.m", 117, (unsigned long long)i, (size_t)4096, "photos", 0.25));
+				}
+			}
+		} tearDown:nil]];
+	}
+
+	// Queueing: message creation, the trip through the global logging queue and the hand off to a logger.
+	// The flush at the end of each sample makes sure the consumer side is included.
+
+	[cases addObject:[DDMicroBenchmarkCase caseWithName:@"queue_log_message" setUp:^{
+		[DDLog removeAllLoggers];
+		[DDLog addLogger:[[DDBenchmarkNullLogger alloc] init]];
+	} body:^(NSUInteger iterations) {
+		for (NSUInteger i = 0; i < iterations; i++)
+		{
+			@autoreleasepool {
+				[DDLog log:YES message:DDMicroBenchmarkNewMessage()];
+			}
+		}
+		[DDLog flushLog];
+	} tearDown:^{
+		[DDLog removeAllLoggers];
+	}]];
+
+	// Formatters
+
+	__block DDLogMessage *message = nil;
+	dispatch_block_t createMessage = ^{
+		message = DDMicroBenchmarkNewMessage();
+	};
+	dispatch_block_t releaseMessage = ^{
+		message = nil;
+	};
+
+	NSArray *formatters = @[
+		@[ @"formatter_file_default",   [[DDLogFileFormatterDefault alloc] init] ],
+		@[ @"formatter_dispatch_queue", [[DDDispatchQueueLogFormatter alloc] init] ],
+	];
+
+	for (NSUInteger count = 1; count <= 3; count++)
+	{
+		DDMultiFormatter *multiFormatter = [[DDMultiFormatter alloc] init];
+
+		for (NSUInteger i = 0; i < count; i++)
+		{
+			[multiFormatter addFormatter:[[DDLogFileFormatterDefault alloc] init]];
+		}
+
+		NSString *name = [NSString stringWithFormat:@"formatter_multi_%lu", (unsigned long)count];
+		formatters = [formatters arrayByAddingObject:@[ name, multiFormatter ]];
+	}
+
+	for (NSArray *pair in formatters)
+	{
+		id <DDLogFormatter> formatter = pair[1];
+
+		[cases addObject:[DDMicroBenchmarkCase caseWithName:pair[0] setUp:createMessage body:^(NSUInteger iterations) {
+			for (NSUInteger i = 0; i < iterations; i++)
+			{
+				@autoreleasepool {
+					DDMicroBenchmarkConsume([formatter formatLogMessage:message]);
+				}
+			}
+		} tearDown:releaseMessage]];
+	}
+
+	// DDTTYLogger, both output paths. stderr goes to /dev/null, so this is the logger's own work plus writev.
+
+	__block DDTTYLogger *ttyLogger = nil;
+
+	void (^ttyBody)(NSUInteger) = ^(NSUInteger iterations) {
+		DDTTYLogger *logger = ttyLogger;
+		DDLogMessage *logMessage = message;
+
+		dispatch_sync(logger.loggerQueue, ^{
+			for (NSUInteger i = 0; i < iterations; i++)
+			{
+				@autoreleasepool {
+					[logger logMessage:logMessage];
+				}
+			}
+		});
+	};
+
+	dispatch_block_t ttyTearDown = ^{
+		ttyLogger = nil;
+		message = nil;
+		[DDBenchmarkSinks restoreStderr];
+	};
+
+	[cases addObject:[DDMicroBenchmarkCase caseWithName:@"tty_unformatted" setUp:^{
+		[DDBenchmarkSinks redirectStderrToDevNull];
+		ttyLogger = [DDTTYLogger sharedInstance];
+		ttyLogger.logFormatter = nil;
+		message = DDMicroBenchmarkNewMessage();
+	} body:ttyBody tearDown:ttyTearDown]];
+
+	[cases addObject:[DDMicroBenchmarkCase caseWithName:@"tty_formatted" setUp:^{
+		[DDBenchmarkSinks redirectStderrToDevNull];
+		ttyLogger = [DDTTYLogger sharedInstance];
+		ttyLogger.logFormatter = [[DDLogFileFormatterDefault alloc] init];
+		message = DDMicroBenchmarkNewMessage();
+	} body:ttyBody tearDown:^{
+		[DDTTYLogger sharedInstance].logFormatter = nil;
+		ttyTearDown();
+	}]];
+
+	// DDFileLogger, formatting plus the write to a (preferably RAM backed) log file
+
+	__block DDFileLogger *fileLogger = nil;
+	NSString *fileDirectory = _fileDirectory;
+
+	[cases addObject:[DDMicroBenchmarkCase caseWithName:@"file_write" setUp:^{
+		DDLogFileManagerDefault *logFileManager = [[DDLogFileManagerDefault alloc] initWithLogsDirectory:fileDirectory];
+		logFileManager.maximumNumberOfLogFiles = 2;
+
+		fileLogger = [[DDFileLogger alloc] initWithLogFileManager:logFileManager];
+		message = DDMicroBenchmarkNewMessage();
+	} body:^(NSUInteger iterations) {
+		DDFileLogger *logger = fileLogger;
+		DDLogMessage *logMessage = message;
+
+		dispatch_sync(logger.loggerQueue, ^{
+			for (NSUInteger i = 0; i < iterations; i++)
+			{
+				@autoreleasepool {
+					[logger logMessage:logMessage];
+				}
+			}
+		});
+	} tearDown:^{
+		fileLogger = nil;
+		message = nil;
+		[[NSFileManager defaultManager] removeItemAtPath:fileDirectory error:nil];
+	}]];
+
+	return cases;
+}
+
+- (DDBenchmarkReport *)run
+{
+	NSArray *cases = [self allCases];
+
+	if (_caseNames)
+	{
+		cases = [cases filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"name IN %@", _caseNames]];
+	}
+
+	return [self runCases:cases];
+}
+
+- (DDBenchmarkReport *)runCases:(NSArray<DDMicroBenchmarkCase *> *)cases
+{
+	NSArray *columns = @[ @"case", @"iterations_per_sample", @"samples",
+	                      @"ns_per_op_median", @"ns_per_op_mad", @"ns_per_op_min", @"cycles_per_op_median",
+	                      @"ns_per_op_samples" ];
+
+	DDBenchmarkReport *report = [[DDBenchmarkReport alloc] initWithName:@"micro" columns:columns];
+	report.keyColumns = @[ @"case" ];
+	report.metricColumn = @"ns_per_op_median";
+	report.samplesColumn = @"ns_per_op_samples";
+
+	for (DDMicroBenchmarkCase *benchmarkCase in cases)
+	{
+		fprintf(stderr, "micro: %s\n", benchmarkCase.name.UTF8String);
+
+		if (benchmarkCase.setUp) benchmarkCase.setUp();
+
+		NSUInteger iterations = [self calibrateCase:benchmarkCase];
+		NSUInteger count = _repetitions;
+
+		double nanoseconds[count];
+		double cycles[count];
+		double minimum = DBL_MAX;
+
+		for (NSUInteger r = 0; r < count; r++)
+		{
+			uint64_t startCycles = DDBenchmarkCycles();
+			uint64_t start = DDBenchmarkNow();
+
+			benchmarkCase.body(iterations);
+
+			uint64_t end = DDBenchmarkNow();
+			uint64_t endCycles = DDBenchmarkCycles();
+
+			nanoseconds[r] = (double)(end - start) / (double)iterations;
+			cycles[r] = (double)(endCycles - startCycles) / (double)iterations;
+			minimum = MIN(minimum, nanoseconds[r]);
+		}
+
+		if (benchmarkCase.tearDown) benchmarkCase.tearDown();
+
+		double median = DDBenchmarkMedian(nanoseconds, count);
+		double mad = DDBenchmarkMedianAbsoluteDeviation(nanoseconds, count, median);
+		id cyclesMedian = DDBenchmarkHasCycleCounter() ? (id)@(DDBenchmarkMedian(cycles, count)) : [NSNull null];
+
+		NSMutableArray *samples = [NSMutableArray arrayWithCapacity:count];
+
+		for (NSUInteger r = 0; r < count; r++)
+		{
+			[samples addObject:@(nanoseconds[r])];
+		}
+
+		[report addRow:@[ benchmarkCase.name, @(iterations), @(count), @(median), @(mad), @(minimum), cyclesMedian, samples ]];
+	}
+
+	return report;
+}
+
+/**
+ * Runs the warmup, and returns the number of iterations per sample.
+**/
+- (NSUInteger)calibrateCase:(DDMicroBenchmarkCase *)benchmarkCase
+{
+	uint64_t warmupEnd = DDBenchmarkNow() + (uint64_t)_warmupMilliseconds * NSEC_PER_MSEC;
+
+	do
+	{
+		benchmarkCase.body(16);
+	}
+	while (DDBenchmarkNow() < warmupEnd);
+
+	uint64_t minSample = (uint64_t)_minSampleMilliseconds * NSEC_PER_MSEC;
+	NSUInteger iterations = 1;
+
+	while (iterations < (NSUIntegerMax / 2))
+	{
+		uint64_t start = DDBenchmarkNow();
+		benchmarkCase.body(iterations);
+
+		if (DDBenchmarkNow() - start >= minSample) break;
+
+		iterations *= 2;
+	}
+
+	return iterations;
+}
+
+@end
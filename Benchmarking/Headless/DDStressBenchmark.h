@@ -0,0 +1,101 @@
+#import <Foundation/Foundation.h>
+#import "DDLog.h"
+#import "DDBenchmarkSupport.h"
+
+typedef NS_ENUM(NSUInteger, DDStressSinkBehavior)
+{
+	DDStressSinkBehaviorSlow,      // a fixed delay per message (the SlowLogger of the OverflowTestMac demo)
+	DDStressSinkBehaviorBlocking,  // fast, but stalls for a long time every N messages (e.g. a full pipe or disk)
+	DDStressSinkBehaviorJittery,   // exponentially distributed delays, with the same mean as "slow"
+	DDStressSinkBehaviorCrashing   // the write fails every N messages, the message is lost and the sink restarts
+};
+
+/**
+ * A logger that misbehaves in a configurable way, until it is told to become fast.
+ *
+ * The "crashing" sink fails by raising an exception from its write, which it catches itself:
+ * DDLog doesn't isolate loggers from each other's exceptions, so an uncaught exception would end the run.
+**/
+@interface DDStressLogger : DDAbstractLogger <DDLogger>
+
+- (instancetype)initWithBehavior:(DDStressSinkBehavior)behavior;
+
+@property (nonatomic, readonly) DDStressSinkBehavior behavior;
+
+/**
+ * Delay per message (slow), mean delay (jittery).
+**/
+@property (nonatomic, assign) NSUInteger delayMicroseconds;
+
+/**
+ * Messages between stalls (blocking) or failures (crashing).
+**/
+@property (nonatomic, assign) NSUInteger period;
+
+/**
+ * Length of a stall (blocking) or of a restart (crashing).
+**/
+@property (nonatomic, assign) NSUInteger stallMilliseconds;
+
+/**
+ * Set from any thread: when NO the sink handles every message at full speed.
+**/
+@property (atomic, assign) BOOL misbehaving;
+
+/**
+ * Messages are expected in the order their statements were issued (carried as the message tag, in ns).
+ * Deviations up to this tolerance are not counted as inversions.
+**/
+@property (nonatomic, assign) uint64_t inversionToleranceNanoseconds;
+
+@property (nonatomic, readonly) uint64_t consumedCount;
+@property (nonatomic, readonly) uint64_t failureCount;
+@property (nonatomic, readonly) uint64_t orderInversions;
+@property (nonatomic, readonly) uint64_t maxOrderInversionNanoseconds;
+
+@end
+
+
+/**
+ * Backpressure and overload stress suite.
+ *
+ * For each sink behavior, `producers` threads log asynchronously as fast as they can for `duration` milliseconds.
+ * The sink misbehaves for the first `misbehave` milliseconds and is fast afterwards.
+ * A sampler records every `sample` milliseconds:
+ * - the queue depth (statements returned to the producers, minus messages handled by the sink)
+ * - the cumulative time producers spent blocked (statements taking longer than `block-threshold` microseconds)
+ * - the memory high-water mark of the process
+ *
+ * The report is that time series, one row per sample (and scenario), ready to be plotted.
+ * A summary per scenario goes to stderr (or to `--summary-output`):
+ * - producer blocking (total, worst single statement)
+ * - fairness: once the queue is full, blocked producers are admitted in FIFO order (see queueLogMessage:).
+ *   Every message carries the time its statement was issued; a message handled after a message issued
+ *   more than `block-threshold` later is counted as an order inversion.
+ * - recovery: time from the sink becoming fast until the queue depth drops to `recovery-depth` or below
+**/
+@interface DDStressBenchmark : NSObject
+
+@property (nonatomic, copy) NSArray<NSString *> *scenarioNames;
+@property (nonatomic, assign) NSUInteger producers;
+@property (nonatomic, assign) NSUInteger durationMilliseconds;
+@property (nonatomic, assign) NSUInteger misbehaveMilliseconds;
+@property (nonatomic, assign) NSUInteger sampleMilliseconds;
+@property (nonatomic, assign) NSUInteger blockThresholdMicroseconds;
+@property (nonatomic, assign) NSUInteger recoveryDepth;
+
+/**
+ * --scenarios slow,blocking,jittery,crashing  --producers 4  --duration-ms 3000  --misbehave-ms 1500
+ * --sample-ms 10  --block-threshold-us 100  --recovery-depth 10
+ * --delay-us 200  --period 500  --stall-ms 100  --summary-output <path>
+**/
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options;
+
+- (DDBenchmarkReport *)run;
+
+/**
+ * The summary of the last run.
+**/
+@property (nonatomic, readonly) DDBenchmarkReport *summary;
+
+@end
@@ -0,0 +1,402 @@
+#import "DDStressBenchmark.h"
+#import "DDLogMacros.h"
+
+#import <math.h>
+#import <pthread.h>
+#import <sys/resource.h>
+#import <unistd.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelInfo;
+
+static uint64_t DDStressMaxResidentKilobytes(void)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+#if defined(__APPLE__)
+	return (uint64_t)usage.ru_maxrss / 1024; // bytes
+#else
+	return (uint64_t)usage.ru_maxrss;        // kilobytes
+#endif
+}
+
+
+@implementation DDStressLogger
+{
+	uint64_t _consumedCount;
+	uint64_t _failureCount;
+	uint64_t _orderInversions;
+	uint64_t _maxOrderInversionNanoseconds;
+	uint64_t _latestIssued;
+}
+
+- (instancetype)initWithBehavior:(DDStressSinkBehavior)behavior
+{
+	if ((self = [super init]))
+	{
+		_behavior = behavior;
+		_delayMicroseconds = 200;
+		_period = 500;
+		_stallMilliseconds = 100;
+		_inversionToleranceNanoseconds = 100 * NSEC_PER_USEC;
+		self.misbehaving = YES;
+
+		srandom(42);
+	}
+	return self;
+}
+
+- (uint64_t)consumedCount
+{
+	return __atomic_load_n(&_consumedCount, __ATOMIC_RELAXED);
+}
+
+- (uint64_t)failureCount
+{
+	return __atomic_load_n(&_failureCount, __ATOMIC_RELAXED);
+}
+
+- (uint64_t)orderInversions
+{
+	return __atomic_load_n(&_orderInversions, __ATOMIC_RELAXED);
+}
+
+- (uint64_t)maxOrderInversionNanoseconds
+{
+	return __atomic_load_n(&_maxOrderInversionNanoseconds, __ATOMIC_RELAXED);
+}
+
+- (void)write:(DDLogMessage *)logMessage sequence:(uint64_t)sequence
+{
+	switch (_behavior)
+	{
+		case DDStressSinkBehaviorSlow:
+		{
+			usleep((useconds_t)_delayMicroseconds);
+			break;
+		}
+		case DDStressSinkBehaviorBlocking:
+		{
+			if (sequence % _period == 0) usleep((useconds_t)(_stallMilliseconds * USEC_PER_MSEC));
+			break;
+		}
+		case DDStressSinkBehaviorJittery:
+		{
+			double uniform = ((double)random() + 1.0) / ((double)RAND_MAX + 2.0);
+			usleep((useconds_t)(-log(uniform) * _delayMicroseconds));
+			break;
+		}
+		case DDStressSinkBehaviorCrashing:
+		{
+			if (sequence % _period == 0)
+			{
+				[NSException raise:NSInternalInconsistencyException format:@"Simulated sink failure"];
+			}
+			break;
+		}
+	}
+}
+
+- (void)logMessage:(DDLogMessage *)logMessage
+{
+	// Order check, against the latest issue time seen so far
+
+	uint64_t issued = [logMessage.tag unsignedLongLongValue];
+
+	if (issued + _inversionToleranceNanoseconds < _latestIssued)
+	{
+		uint64_t inversion = _latestIssued - issued;
+
+		__atomic_fetch_add(&_orderInversions, 1, __ATOMIC_RELAXED);
+
+		if (inversion > _maxOrderInversionNanoseconds)
+		{
+			__atomic_store_n(&_maxOrderInversionNanoseconds, inversion, __ATOMIC_RELAXED);
+		}
+	}
+
+	_latestIssued = MAX(_latestIssued, issued);
+
+	uint64_t sequence = _consumedCount + 1;
+
+	if (self.misbehaving)
+	{
+		@try
+		{
+			[self write:logMessage sequence:sequence];
+		}
+		@catch (NSException *exception)
+		{
+			// The message is lost, and the sink takes a while to come back (reconnect, reopen, ...)
+			__atomic_fetch_add(&_failureCount, 1, __ATOMIC_RELAXED);
+			usleep((useconds_t)(_stallMilliseconds * USEC_PER_MSEC));
+		}
+	}
+
+	__atomic_store_n(&_consumedCount, sequence, __ATOMIC_RELEASE);
+}
+
+- (NSString *)loggerName
+{
+	return @"cocoa.lumberjack.benchmark.stressLogger";
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+	NSUInteger index;
+	uint64_t blockThreshold;
+	volatile int32_t *stopFlag;
+	uint64_t *produced;
+	uint64_t *blockedNanoseconds;
+	uint64_t blockedStatements;
+	uint64_t worstStatementNanoseconds;
+} DDStressProducerContext;
+
+static void *DDStressProducerMain(void *arg)
+{
+	DDStressProducerContext *context = (DDStressProducerContext *)arg;
+	uint64_t i = 0;
+
+	while (__atomic_load_n(context->stopFlag, __ATOMIC_ACQUIRE) == 0)
+	{
+		@autoreleasepool {
+
+			for (NSUInteger batch = 0; batch < 100; batch++, i++)
+			{
+				uint64_t start = DDBenchmarkNow();
+
+				LOG_MAYBE(YES, ddLogLevel, DDLogFlagInfo, 0, @(start), __PRETTY_FUNCTION__,
+				          @"[%lu] %llu", (unsigned long)context->index, (unsigned long long)i);
+
+				uint64_t elapsed = DDBenchmarkNow() - start;
+
+				__atomic_fetch_add(context->produced, 1, __ATOMIC_RELEASE);
+
+				if (elapsed > context->blockThreshold)
+				{
+					__atomic_fetch_add(context->blockedNanoseconds, elapsed, __ATOMIC_RELAXED);
+					context->blockedStatements++;
+				}
+
+				context->worstStatementNanoseconds = MAX(context->worstStatementNanoseconds, elapsed);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+
+@implementation DDStressBenchmark
+{
+	DDBenchmarkOptions *_options;
+}
+
++ (NSDictionary<NSString *, NSNumber *> *)behaviorsByName
+{
+	return @{ @"slow"     : @(DDStressSinkBehaviorSlow),
+	          @"blocking" : @(DDStressSinkBehaviorBlocking),
+	          @"jittery"  : @(DDStressSinkBehaviorJittery),
+	          @"crashing" : @(DDStressSinkBehaviorCrashing) };
+}
+
+- (instancetype)init
+{
+	return [self initWithOptions:[[DDBenchmarkOptions alloc] initWithArguments:@[]]];
+}
+
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options
+{
+	if ((self = [super init]))
+	{
+		_options = options;
+
+		_scenarioNames = [options listForOption:@"scenarios" defaultValue:@"slow,blocking,jittery,crashing"];
+		_producers = MAX([options unsignedIntegerForOption:@"producers" defaultValue:4], 1);
+		_durationMilliseconds = MAX([options unsignedIntegerForOption:@"duration-ms" defaultValue:3000], 1);
+		_misbehaveMilliseconds = MIN([options unsignedIntegerForOption:@"misbehave-ms" defaultValue:1500], _durationMilliseconds);
+		_sampleMilliseconds = MAX([options unsignedIntegerForOption:@"sample-ms" defaultValue:10], 1);
+		_blockThresholdMicroseconds = [options unsignedIntegerForOption:@"block-threshold-us" defaultValue:100];
+		_recoveryDepth = [options unsignedIntegerForOption:@"recovery-depth" defaultValue:10];
+	}
+	return self;
+}
+
+- (DDStressLogger *)newLoggerWithBehavior:(DDStressSinkBehavior)behavior
+{
+	DDStressLogger *logger = [[DDStressLogger alloc] initWithBehavior:behavior];
+
+	logger.delayMicroseconds = [_options unsignedIntegerForOption:@"delay-us" defaultValue:logger.delayMicroseconds];
+	logger.period = MAX([_options unsignedIntegerForOption:@"period" defaultValue:logger.period], 1);
+	logger.stallMilliseconds = [_options unsignedIntegerForOption:@"stall-ms" defaultValue:logger.stallMilliseconds];
+	logger.inversionToleranceNanoseconds = (uint64_t)_blockThresholdMicroseconds * NSEC_PER_USEC;
+
+	return logger;
+}
+
+- (void)runScenario:(NSString *)name
+           behavior:(DDStressSinkBehavior)behavior
+             report:(DDBenchmarkReport *)report
+            summary:(DDBenchmarkReport *)summary
+{
+	DDStressLogger *logger = [self newLoggerWithBehavior:behavior];
+
+	[DDLog removeAllLoggers];
+	[DDLog addLogger:logger];
+	[DDLog flushLog];
+
+	NSUInteger count = _producers;
+
+	DDStressProducerContext contexts[count];
+	pthread_t threads[count];
+	volatile int32_t stopFlag = 0;
+	uint64_t produced = 0;
+	uint64_t blockedNanoseconds = 0;
+
+	for (NSUInteger p = 0; p < count; p++)
+	{
+		contexts[p] = (DDStressProducerContext) {
+			.index = p,
+			.blockThreshold = (uint64_t)_blockThresholdMicroseconds * NSEC_PER_USEC,
+			.stopFlag = &stopFlag,
+			.produced = &produced,
+			.blockedNanoseconds = &blockedNanoseconds,
+		};
+	}
+
+	uint64_t start = DDBenchmarkNow();
+	uint64_t fastAt = start + (uint64_t)_misbehaveMilliseconds * NSEC_PER_MSEC;
+	uint64_t end = start + (uint64_t)_durationMilliseconds * NSEC_PER_MSEC;
+
+	for (NSUInteger p = 0; p < count; p++)
+	{
+		pthread_create(&threads[p], NULL, DDStressProducerMain, &contexts[p]);
+	}
+
+	// Sample on this thread, until the end of the run
+
+	uint64_t maxDepth = 0;
+	uint64_t recoveredAt = 0;
+	uint64_t now;
+
+	while ((now = DDBenchmarkNow()) < end)
+	{
+		if (logger.misbehaving && now >= fastAt)
+		{
+			logger.misbehaving = NO;
+		}
+
+		uint64_t consumed = logger.consumedCount;
+		uint64_t producedSoFar = __atomic_load_n(&produced, __ATOMIC_ACQUIRE);
+		uint64_t depth = (producedSoFar > consumed) ? producedSoFar - consumed : 0;
+
+		maxDepth = MAX(maxDepth, depth);
+
+		if (!logger.misbehaving && recoveredAt == 0 && depth <= _recoveryDepth)
+		{
+			recoveredAt = now;
+		}
+
+		[report addRow:@[ name,
+		                  @((now - start) / NSEC_PER_MSEC),
+		                  logger.misbehaving ? @"misbehaving" : @"fast",
+		                  @(depth),
+		                  @(producedSoFar),
+		                  @(consumed),
+		                  @(__atomic_load_n(&blockedNanoseconds, __ATOMIC_RELAXED) / NSEC_PER_MSEC),
+		                  @(DDStressMaxResidentKilobytes()) ]];
+
+		usleep((useconds_t)(_sampleMilliseconds * USEC_PER_MSEC));
+	}
+
+	__atomic_store_n(&stopFlag, 1, __ATOMIC_RELEASE);
+
+	for (NSUInteger p = 0; p < count; p++)
+	{
+		pthread_join(threads[p], NULL);
+	}
+
+	[DDLog flushLog];
+	[DDLog removeAllLoggers];
+
+	uint64_t blockedStatements = 0;
+	uint64_t worstStatement = 0;
+
+	for (NSUInteger p = 0; p < count; p++)
+	{
+		blockedStatements += contexts[p].blockedStatements;
+		worstStatement = MAX(worstStatement, contexts[p].worstStatementNanoseconds);
+	}
+
+	id recovery = recoveredAt ? (id)@((double)(recoveredAt - fastAt) / NSEC_PER_MSEC) : [NSNull null];
+
+	[summary addRow:@[ name,
+	                   @(count),
+	                   @(produced),
+	                   @(logger.failureCount),
+	                   @(blockedStatements),
+	                   @((double)blockedNanoseconds / NSEC_PER_MSEC),
+	                   @((double)worstStatement / NSEC_PER_MSEC),
+	                   @(maxDepth),
+	                   @(DDStressMaxResidentKilobytes()),
+	                   @(logger.orderInversions),
+	                   @((double)logger.maxOrderInversionNanoseconds / NSEC_PER_USEC),
+	                   recovery ]];
+}
+
+- (DDBenchmarkReport *)run
+{
+	NSArray *columns = @[ @"scenario", @"t_ms", @"phase", @"queue_depth", @"produced", @"consumed",
+	                      @"producer_blocked_ms", @"max_rss_kb" ];
+
+	NSArray *summaryColumns = @[ @"scenario", @"producers", @"statements", @"sink_failures",
+	                             @"blocked_statements", @"blocked_total_ms", @"worst_statement_ms",
+	                             @"max_queue_depth", @"max_rss_kb",
+	                             @"order_inversions", @"max_order_inversion_us", @"recovery_ms" ];
+
+	DDBenchmarkReport *report = [[DDBenchmarkReport alloc] initWithName:@"stress" columns:columns];
+	DDBenchmarkReport *summary = [[DDBenchmarkReport alloc] initWithName:@"stress-summary" columns:summaryColumns];
+
+	NSDictionary *behaviors = [[self class] behaviorsByName];
+
+	for (NSString *name in _scenarioNames)
+	{
+		NSNumber *behavior = behaviors[name];
+
+		if (behavior == nil)
+		{
+			fprintf(stderr, "Unknown scenario: %s\n", name.UTF8String);
+			continue;
+		}
+
+		fprintf(stderr, "stress: %s\n", name.UTF8String);
+
+		@autoreleasepool {
+			[self runScenario:name behavior:behavior.unsignedIntegerValue report:report summary:summary];
+		}
+	}
+
+	_summary = summary;
+
+	NSString *summaryPath = [_options stringForOption:@"summary-output" defaultValue:nil];
+
+	if (summaryPath.length)
+	{
+		[summary writeToPath:summaryPath format:[_options outputFormat]];
+	}
+	else
+	{
+		NSData *data = [[summary CSVRepresentation] dataUsingEncoding:NSUTF8StringEncoding];
+		fwrite(data.bytes, 1, data.length, stderr);
+	}
+
+	return report;
+}
+
+@end
@@ -0,0 +1,37 @@
+#import <Foundation/Foundation.h>
+#import "DDBenchmarkSupport.h"
+
+/**
+ * Multi-threaded throughput and latency benchmark.
+ *
+ * Sweeps every combination of:
+ * - number of producer threads
+ * - message size (bytes of payload per log statement)
+ * - percentage of synchronous log statements (the rest is asynchronous)
+ * - sink configuration (see DDBenchmarkSinks)
+ *
+ * For each combination all producers are released at once, each issues `messagesPerProducer` log statements,
+ * and the run ends when the logging queue has been drained (flushLog).
+ *
+ * Reported per combination:
+ * - throughput, in messages per second, from the release of the producers until the queue is drained
+ * - caller side latency of a single log statement (p50, p99, p99.9 and max, in nanoseconds),
+ *   i.e. the time the producing thread is held up, including any blocking on a full queue.
+**/
+@interface DDThroughputBenchmark : NSObject
+
+@property (nonatomic, copy) NSArray<NSNumber *> *producerCounts;
+@property (nonatomic, copy) NSArray<NSNumber *> *messageSizes;
+@property (nonatomic, copy) NSArray<NSNumber *> *syncPercentages;
+@property (nonatomic, copy) NSArray<NSString *> *sinkNames;
+@property (nonatomic, assign) NSUInteger messagesPerProducer;
+
+/**
+ * Configures the sweep from command line options:
+ * --producers 1,2,4,8  --sizes 16,128,1024  --sync 0,10,100  --sinks null,tty,file,file+tty  --messages 20000
+**/
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options;
+
+- (DDBenchmarkReport *)run;
+
+@end
@@ -0,0 +1,199 @@
+#import "DDThroughputBenchmark.h"
+#import "DDBenchmarkSinks.h"
+#import "DDLogMacros.h"
+
+#import <pthread.h>
+#import <sched.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelInfo;
+
+// Warmup statements per producer, issued before each measured run (not measured)
+#define WARMUP_COUNT 1000
+
+typedef struct
+{
+	NSUInteger index;
+	NSUInteger count;
+	NSUInteger messageSize;
+	NSUInteger syncPercentage;
+	volatile int32_t *startFlag;
+	uint64_t *samples; // caller side latency of each statement, in ns
+} DDThroughputProducerContext;
+
+static void DDThroughputProduce(DDThroughputProducerContext *context, NSUInteger count, uint64_t *samples)
+{
+	char payload[context->messageSize + 1];
+	memset(payload, 'x', context->messageSize);
+	payload[context->messageSize] = '\0';
+
+	NSUInteger i = 0;
+
+	while (i < count)
+	{
+		// Keep the autorelease pool bounded, without paying for a pool per statement
+		@autoreleasepool {
+
+			NSUInteger end = MIN(i + 1000, count);
+
+			for (; i < end; i++)
+			{
+				// Spread the synchronous statements evenly: i = 0..99 -> sync if below the percentage
+				BOOL async = (i % 100) >= context->syncPercentage;
+
+				uint64_t start = DDBenchmarkNow();
+
+				LOG_MAYBE(async, ddLogLevel, DDLogFlagInfo, 0, nil, __PRETTY_FUNCTION__,
+				          @"[%lu] %lu %s", (unsigned long)context->index, (unsigned long)i, payload);
+
+				if (samples) samples[i] = DDBenchmarkNow() - start;
+			}
+		}
+	}
+}
+
+static void *DDThroughputProducerMain(void *arg)
+{
+	DDThroughputProducerContext *context = (DDThroughputProducerContext *)arg;
+
+	while (__atomic_load_n(context->startFlag, __ATOMIC_ACQUIRE) == 0)
+	{
+		sched_yield();
+	}
+
+	DDThroughputProduce(context, context->count, context->samples);
+
+	return NULL;
+}
+
+
+@implementation DDThroughputBenchmark
+
+- (instancetype)init
+{
+	return [self initWithOptions:[[DDBenchmarkOptions alloc] initWithArguments:@[]]];
+}
+
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options
+{
+	if ((self = [super init]))
+	{
+		_producerCounts = [options numberListForOption:@"producers" defaultValue:@"1,2,4,8"];
+		_messageSizes = [options numberListForOption:@"sizes" defaultValue:@"16,128,1024"];
+		_syncPercentages = [options numberListForOption:@"sync" defaultValue:@"0,10,100"];
+		_sinkNames = [options listForOption:@"sinks" defaultValue:[[DDBenchmarkSinks allSinkNames] componentsJoinedByString:@","]];
+		_messagesPerProducer = MAX([options unsignedIntegerForOption:@"messages" defaultValue:20000], 1);
+	}
+	return self;
+}
+
+- (NSArray *)runWithProducers:(NSUInteger)numProducers
+                  messageSize:(NSUInteger)messageSize
+               syncPercentage:(NSUInteger)syncPercentage
+{
+	NSUInteger count = _messagesPerProducer;
+
+	DDThroughputProducerContext contexts[numProducers];
+	pthread_t threads[numProducers];
+	volatile int32_t startFlag = 0;
+
+	uint64_t *samples = calloc(numProducers * count, sizeof(uint64_t));
+
+	for (NSUInteger p = 0; p < numProducers; p++)
+	{
+		contexts[p].index = p;
+		contexts[p].count = count;
+		contexts[p].messageSize = messageSize;
+		contexts[p].syncPercentage = syncPercentage;
+		contexts[p].startFlag = &startFlag;
+		contexts[p].samples = samples + p * count;
+	}
+
+	// Warm up the loggers (file creation, lazily created queues, ...)
+	DDThroughputProduce(&contexts[0], WARMUP_COUNT, NULL);
+	[DDLog flushLog];
+
+	for (NSUInteger p = 0; p < numProducers; p++)
+	{
+		pthread_create(&threads[p], NULL, DDThroughputProducerMain, &contexts[p]);
+	}
+
+	uint64_t start = DDBenchmarkNow();
+	__atomic_store_n(&startFlag, 1, __ATOMIC_RELEASE);
+
+	for (NSUInteger p = 0; p < numProducers; p++)
+	{
+		pthread_join(threads[p], NULL);
+	}
+
+	uint64_t producersDone = DDBenchmarkNow();
+
+	[DDLog flushLog];
+
+	uint64_t drained = DDBenchmarkNow();
+
+	size_t total = numProducers * count;
+	DDBenchmarkSortSamples(samples, total);
+
+	double seconds = (double)(drained - start) / NSEC_PER_SEC;
+	double producerSeconds = (double)(producersDone - start) / NSEC_PER_SEC;
+
+	NSArray *row = @[ @(numProducers),
+	                  @(messageSize),
+	                  @(syncPercentage),
+	                  @(total),
+	                  @(round(total / seconds)),
+	                  @(round(total / producerSeconds)),
+	                  @(DDBenchmarkPercentile(samples, total, 50.0)),
+	                  @(DDBenchmarkPercentile(samples, total, 99.0)),
+	                  @(DDBenchmarkPercentile(samples, total, 99.9)),
+	                  @(samples[total - 1]) ];
+
+	free(samples);
+
+	return row;
+}
+
+- (DDBenchmarkReport *)run
+{
+	NSArray *columns = @[ @"sink", @"producers", @"message_size", @"sync_percent", @"messages",
+	                      @"throughput_msgs_per_sec", @"producer_rate_msgs_per_sec",
+	                      @"latency_p50_ns", @"latency_p99_ns", @"latency_p999_ns", @"latency_max_ns" ];
+
+	DDBenchmarkReport *report = [[DDBenchmarkReport alloc] initWithName:@"throughput" columns:columns];
+	report.keyColumns = @[ @"sink", @"producers", @"message_size", @"sync_percent" ];
+	report.metricColumn = @"throughput_msgs_per_sec";
+	report.higherIsBetter = YES;
+
+	for (NSString *sinkName in _sinkNames)
+	{
+		if (![DDBenchmarkSinks installSinksNamed:sinkName])
+		{
+			fprintf(stderr, "Unknown sink configuration: %s\n", sinkName.UTF8String);
+			continue;
+		}
+
+		for (NSNumber *producers in _producerCounts)
+		{
+			for (NSNumber *size in _messageSizes)
+			{
+				for (NSNumber *syncPercentage in _syncPercentages)
+				{
+					@autoreleasepool {
+
+						NSArray *values = [self runWithProducers:producers.unsignedIntegerValue
+						                             messageSize:size.unsignedIntegerValue
+						                          syncPercentage:MIN(syncPercentage.unsignedIntegerValue, 100)];
+
+						[report addRow:[@[ sinkName ] arrayByAddingObjectsFromArray:values]];
+					}
+				}
+			}
+		}
+
+		[DDBenchmarkSinks uninstallSinks];
+	}
+
+	return report;
+}
+
+@end
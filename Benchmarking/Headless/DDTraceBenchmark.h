@@ -0,0 +1,33 @@
+#import <Foundation/Foundation.h>
+#import "DDBenchmarkSupport.h"
+
+/**
+ * Where messages wait on their way through the pipeline (see DDLogTrace.h).
+ *
+ * Requires the library to be compiled with DD_LOG_TRACE_ENABLED (`make TRACE=1`).
+ *
+ * For every sink configuration (see DDBenchmarkSinks), `producers` threads log `messages` asynchronous
+ * info statements each, and the queue is drained. Reported per logger and stage: the number of messages,
+ * the mean, and upper bounds (log2 buckets) of the median, p99 and maximum of the time spent since the previous stage.
+ *
+ * With --chrome-trace, the last messages of each configuration are also written as Chrome trace event JSON
+ * (the sink name is appended to the file name when there are several configurations).
+**/
+@interface DDTraceBenchmark : NSObject
+
+@property (nonatomic, copy) NSArray<NSString *> *sinkNames;
+@property (nonatomic, assign) NSUInteger producers;
+@property (nonatomic, assign) NSUInteger messagesPerProducer;
+@property (nonatomic, copy) NSString *chromeTracePath;
+
+/**
+ * --sinks file+tty  --producers 4  --messages 20000  --chrome-trace trace.json
+**/
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options;
+
+/**
+ * Returns nil if the library was compiled without tracing.
+**/
+- (DDBenchmarkReport *)run;
+
+@end
@@ -0,0 +1,141 @@
+#import "DDTraceBenchmark.h"
+#import "DDBenchmarkSinks.h"
+#import "DDLogMacros.h"
+#import "DDLogTrace.h"
+
+#import <pthread.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelInfo;
+
+typedef struct
+{
+	NSUInteger index;
+	NSUInteger count;
+} DDTraceProducerContext;
+
+static void *DDTraceProducerMain(void *arg)
+{
+	DDTraceProducerContext *context = (DDTraceProducerContext *)arg;
+
+	for (NSUInteger i = 0; i < context->count; i++)
+	{
+		@autoreleasepool {
+			LOG_MAYBE(YES, ddLogLevel, DDLogFlagInfo, 0, nil, __PRETTY_FUNCTION__,
+			          @"[%lu] Request %lu finished in %.3f ms", (unsigned long)context->index, (unsigned long)i, 12.5);
+		}
+	}
+
+	return NULL;
+}
+
+
+@implementation DDTraceBenchmark
+
+- (instancetype)init
+{
+	return [self initWithOptions:[[DDBenchmarkOptions alloc] initWithArguments:@[]]];
+}
+
+- (instancetype)initWithOptions:(DDBenchmarkOptions *)options
+{
+	if ((self = [super init]))
+	{
+		_sinkNames = [options listForOption:@"sinks" defaultValue:@"file+tty"];
+		_producers = MAX([options unsignedIntegerForOption:@"producers" defaultValue:4], 1);
+		_messagesPerProducer = MAX([options unsignedIntegerForOption:@"messages" defaultValue:20000], 1);
+		_chromeTracePath = [options stringForOption:@"chrome-trace" defaultValue:nil];
+	}
+	return self;
+}
+
+- (NSString *)chromeTracePathForSinks:(NSString *)sinkName
+{
+	if (_chromeTracePath == nil || _sinkNames.count == 1) return _chromeTracePath;
+
+	NSString *base = [_chromeTracePath stringByDeletingPathExtension];
+	NSString *suffix = [sinkName stringByReplacingOccurrencesOfString:@"+" withString:@"-"];
+
+	return [[base stringByAppendingFormat:@"-%@", suffix] stringByAppendingPathExtension:@"json"];
+}
+
+- (void)produce
+{
+	DDTraceProducerContext contexts[_producers];
+	pthread_t threads[_producers];
+
+	for (NSUInteger p = 0; p < _producers; p++)
+	{
+		contexts[p].index = p;
+		contexts[p].count = _messagesPerProducer;
+
+		pthread_create(&threads[p], NULL, DDTraceProducerMain, &contexts[p]);
+	}
+
+	for (NSUInteger p = 0; p < _producers; p++)
+	{
+		pthread_join(threads[p], NULL);
+	}
+
+	[DDLog flushLog];
+}
+
+- (DDBenchmarkReport *)run
+{
+	if (![DDLogTrace isEnabled])
+	{
+		fprintf(stderr, "The library was compiled without DD_LOG_TRACE_ENABLED, rebuild with: make clean && make TRACE=1\n");
+		return nil;
+	}
+
+	NSArray *columns = @[ @"sink", @"logger", @"stage", @"messages",
+	                      @"mean_ns", @"p50_ns_upper", @"p99_ns_upper", @"max_ns" ];
+
+	DDBenchmarkReport *report = [[DDBenchmarkReport alloc] initWithName:@"trace" columns:columns];
+
+	for (NSString *sinkName in _sinkNames)
+	{
+		if (![DDBenchmarkSinks installSinksNamed:sinkName])
+		{
+			fprintf(stderr, "Unknown sink configuration: %s\n", sinkName.UTF8String);
+			continue;
+		}
+
+		fprintf(stderr, "trace: sinks=%s producers=%lu\n", sinkName.UTF8String, (unsigned long)_producers);
+
+		[DDLogTrace reset];
+		[self produce];
+
+		for (DDLogTraceStatistics *statistics in [DDLogTrace statistics])
+		{
+			for (DDLogTraceStage stage = DDLogTraceStageEnqueued; stage <= DDLogTraceStageCount; stage++)
+			{
+				BOOL total = (stage == DDLogTraceStageCount);
+				DDLogTraceHistogram *histogram = total ? statistics.totalHistogram : [statistics histogramForStage:stage];
+
+				if (histogram.count == 0) continue;
+
+				[report addRow:@[ sinkName,
+				                  statistics.loggerName,
+				                  total ? @"total" : [DDLogTrace nameOfStage:stage],
+				                  @(histogram.count),
+				                  @(round((double)histogram.totalNanoseconds / histogram.count)),
+				                  @([histogram nanosecondsAtPercentile:50.0]),
+				                  @([histogram nanosecondsAtPercentile:99.0]),
+				                  @(histogram.maximumNanoseconds) ]];
+			}
+		}
+
+		NSString *tracePath = [self chromeTracePathForSinks:sinkName];
+
+		if (tracePath && ![DDLogTrace writeChromeTraceToFile:tracePath error:nil])
+		{
+			fprintf(stderr, "Can't write %s\n", tracePath.UTF8String);
+		}
+
+		[DDBenchmarkSinks uninstallSinks];
+	}
+
+	return report;
+}
+
+@end
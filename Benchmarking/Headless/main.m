@@ -0,0 +1,115 @@
+#import <Foundation/Foundation.h>
+#import "DDBenchmarkSupport.h"
+#import "DDThroughputBenchmark.h"
+#import "DDMicroBenchmark.h"
+#import "DDAllocationBenchmark.h"
+#import "DDStressBenchmark.h"
+#import "DDTraceBenchmark.h"
+#import "DDBenchmarkCompare.h"
+
+/**
+ * Headless benchmark runner.
+ *
+ * Usage: lumberjack-bench <benchmark> [options]
+ *
+ * Benchmarks:
+ *   throughput   multi-threaded throughput and caller side latency (see DDThroughputBenchmark.h)
+ *   micro        per-component cost of the logging hot path (see DDMicroBenchmark.h)
+ *   alloc        heap allocations and bytes per log statement (see DDAllocationBenchmark.h)
+ *   stress       backpressure with slow, blocking, jittery and failing sinks (see DDStressBenchmark.h)
+ *   trace        time spent in each pipeline stage, needs `make TRACE=1` (see DDTraceBenchmark.h)
+ *
+ * Tools:
+ *   compare      compares two JSON reports, and exits with 1 on a regression (see DDBenchmarkCompare.h)
+ *
+ * Common options:
+ *   --format csv|json   output format (default csv)
+ *   --output <path>     write the report to a file instead of stdout
+**/
+
+static void DDBenchmarkPrintUsage(void)
+{
+	fprintf(stderr,
+	        "Usage: lumberjack-bench <benchmark> [options]\n"
+	        "\n"
+	        "Benchmarks:\n"
+	        "  throughput  --producers 1,2,4,8 --sizes 16,128,1024 --sync 0,10,100\n"
+	        "              --sinks null,tty,file,file+tty --messages 20000\n"
+	        "              (also: syslog-udp, syslog-tcp)\n"
+	        "  micro       --cases message_init,tty_formatted,... --repetitions 15\n"
+	        "              --warmup-ms 100 --min-sample-ms 20 --file-directory /dev/shm\n"
+	        "  alloc       --sinks null,tty,file,file+tty --statements 1000\n"
+	        "  stress      --scenarios slow,blocking,jittery,crashing --producers 4\n"
+	        "              --duration-ms 3000 --misbehave-ms 1500 --sample-ms 10\n"
+	        "              --delay-us 200 --period 500 --stall-ms 100 --summary-output <path>\n"
+	        "  trace       --sinks file+tty --producers 4 --messages 20000 --chrome-trace <path>\n"
+	        "              (requires a build with make TRACE=1)\n"
+	        "\n"
+	        "Tools:\n"
+	        "  compare     --baseline <json> --candidate <json> --threshold 5 --alpha 0.05\n"
+	        "\n"
+	        "Common options:\n"
+	        "  --format csv|json  --output <path>\n");
+}
+
+int main(int argc, const char *argv[])
+{
+	@autoreleasepool {
+
+		if (argc < 2)
+		{
+			DDBenchmarkPrintUsage();
+			return 1;
+		}
+
+		NSMutableArray *arguments = [NSMutableArray arrayWithCapacity:argc];
+
+		for (int i = 2; i < argc; i++)
+		{
+			[arguments addObject:@(argv[i])];
+		}
+
+		NSString *benchmark = @(argv[1]);
+		DDBenchmarkOptions *options = [[DDBenchmarkOptions alloc] initWithArguments:arguments];
+		DDBenchmarkReport *report = nil;
+
+		if ([benchmark isEqualToString:@"throughput"])
+		{
+			report = [[[DDThroughputBenchmark alloc] initWithOptions:options] run];
+		}
+		else if ([benchmark isEqualToString:@"micro"])
+		{
+			report = [[[DDMicroBenchmark alloc] initWithOptions:options] run];
+		}
+		else if ([benchmark isEqualToString:@"alloc"])
+		{
+			report = [[[DDAllocationBenchmark alloc] initWithOptions:options] run];
+		}
+		else if ([benchmark isEqualToString:@"stress"])
+		{
+			report = [[[DDStressBenchmark alloc] initWithOptions:options] run];
+		}
+		else if ([benchmark isEqualToString:@"trace"])
+		{
+			report = [[[DDTraceBenchmark alloc] initWithOptions:options] run];
+		}
+		else if ([benchmark isEqualToString:@"compare"])
+		{
+			DDBenchmarkCompare *compare = [[DDBenchmarkCompare alloc] initWithOptions:options];
+
+			report = [compare run];
+
+			if (report == nil) return 2;
+			if (![report writeToPath:[options outputPath] format:[options outputFormat]]) return 2;
+
+			return (compare.regressionCount > 0) ? 1 : 0;
+		}
+		else
+		{
+			DDBenchmarkPrintUsage();
+			return 1;
+		}
+
+		return [report writeToPath:[options outputPath] format:[options outputFormat]] ? 0 : 1;
+	}
+}
@@ -66,9 +66,22 @@
 
 // Core
 #import "DDLog.h"
+#import "DDLogClock.h"
 
 // Main macros
 #import "DDLogMacros.h"
+#import "DDLogScope.h"
+#import "DDLogTrace.h"
+#import "DDLogCallSiteProfiler.h"
+#import "DDLogWatchdog.h"
+#import "DDLogMetrics.h"
+#import "DDSocketStreamLogger.h"
+#import "DDLogCollector.h"
+#import "DDSharedMemoryLogger.h"
+#import "DDRemoteSyslogLogger.h"
+#import "DDLogNumberFormatting.h"
+#import "DDLogFormatCache.h"
+#import "DDLogStringTable.h"
 #import "DDAssertMacros.h"
 
 // Capture ASL
@@ -78,4 +91,7 @@
 #import "DDTTYLogger.h"
 #import "DDASLLogger.h"
 #import "DDFileLogger.h"
+#import "DDFlightRecorderLogger.h"
+#import "DDEmergencyLog.h"
+#import "DDMemoryLogger.h"
 
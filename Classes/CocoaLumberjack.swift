@@ -52,11 +52,26 @@ public func resetDefaultDebugLevel() {
     defaultDebugLevel = DDLogLevel.verbose
 }
 
+/// The C string of a `StaticString`, without copying it. `#file` and `#function` always have one,
+/// NUL terminated, in the constant data of the binary.
+private func _DDStaticCString(_ string: StaticString) -> UnsafePointer<CChar> {
+    return UnsafeRawPointer(string.utf8Start).assumingMemoryBound(to: CChar.self)
+}
+
 public func _DDLogMessage(_ message: @autoclosure () -> String, level: DDLogLevel, flag: DDLogFlag, context: Int, file: StaticString, function: StaticString, line: UInt, tag: Any?, asynchronous: Bool, ddlog: DDLog) {
-    if level.rawValue & flag.rawValue != 0 {
-        // Tell the DDLogMessage constructor to copy the C strings that get passed to it.
-        let logMessage = DDLogMessage(message: message(), level: level, flag: flag, context: context, file: String(describing: file), function: String(describing: function), line: line, tag: tag, options: [.copyFile, .copyFunction], timestamp: nil)
-        ddlog.log(asynchronous: asynchronous, message: logMessage)
+    // The message closure is only evaluated if both the level (elevated by the current DDLogScope, if any)
+    // and at least one of the added loggers accept the flag.
+    let effectiveLevel = level.rawValue | DDLogScopeCurrentLevel().rawValue
+    if effectiveLevel & flag.rawValue != 0 && ddlog.loggersLevel().rawValue & flag.rawValue != 0 {
+        if file.hasPointerRepresentation && function.hasPointerRepresentation {
+            // Same path as the Objective-C macros: file and function are wrapped, not copied,
+            // and the statement shows up in the DDLogCallSiteProfiler.
+            ddlog.log(asynchronous: asynchronous, message: message(), level: level, flag: flag, context: context, staticFile: _DDStaticCString(file), staticFunction: _DDStaticCString(function), line: line, tag: tag)
+        } else {
+            // Tell the DDLogMessage constructor to copy the C strings that get passed to it.
+            let logMessage = DDLogMessage(message: message(), level: level, flag: flag, context: context != 0 ? context : DDLogScopeCurrentContext(), file: String(describing: file), function: String(describing: function), line: line, tag: tag, options: [.copyFile, .copyFunction], timestamp: nil)
+            ddlog.log(asynchronous: asynchronous, message: logMessage)
+        }
     }
 }
 
@@ -80,6 +95,70 @@ public func DDLogError(_ message: @autoclosure () -> String, level: DDLogLevel =
     _DDLogMessage(message, level: level, flag: .error, context: context, file: file, function: function, line: line, tag: tag, asynchronous: async, ddlog: ddlog)
 }
 
+// MARK: - Deferred interpolation
+
+/// When true (the default), `DDPrivate` values are logged as their placeholder.
+/// It's read when the message is rendered (on the logging queue for deferred messages): set it before logging.
+public var redactPrivateLogValues = true
+
+/// Marks an interpolated value as private:
+/// unless `redactPrivateLogValues` is false, the placeholder is logged instead.
+///
+///     DDLogInfo(deferred: "Signed in as \(DDPrivate(email))")
+public struct DDPrivate: CustomStringConvertible {
+    public let value: Any
+    public let placeholder: String
+
+    public init(_ value: Any, placeholder: String = "<private>") {
+        self.value = value
+        self.placeholder = placeholder
+    }
+
+    public var description: String {
+        return redactPrivateLogValues ? placeholder : String(describing: value)
+    }
+}
+
+/// The deferred functions take the message as an escaping closure, which is evaluated on the logging queue,
+/// and only if a logger takes the message: the calling thread doesn't build the string.
+///
+///     DDLogDebug(deferred: "User \(user) did \(action) in \(duration) s")
+///
+/// The closure captures the variables it uses, not their values: they must be safe to read from the logging queue,
+/// and a variable changed after the statement may be logged with its new value. To log an object that may change
+/// (or isn't thread safe) as it is now, interpolate a copy made on the calling thread: `\(object.description)`.
+public func _DDLogDeferredMessage(_ message: @autoclosure @escaping () -> String, level: DDLogLevel, flag: DDLogFlag, context: Int, file: StaticString, function: StaticString, line: UInt, tag: Any?, asynchronous: Bool, ddlog: DDLog) {
+    // As in _DDLogMessage: nothing happens unless the level and one of the loggers accept the flag.
+    let effectiveLevel = level.rawValue | DDLogScopeCurrentLevel().rawValue
+    if effectiveLevel & flag.rawValue != 0 && ddlog.loggersLevel().rawValue & flag.rawValue != 0 {
+        if file.hasPointerRepresentation && function.hasPointerRepresentation {
+            ddlog.log(asynchronous: asynchronous, level: level, flag: flag, context: context, staticFile: _DDStaticCString(file), staticFunction: _DDStaticCString(function), line: line, tag: tag, messageRenderer: message)
+        } else {
+            _DDLogMessage(message(), level: level, flag: flag, context: context, file: file, function: function, line: line, tag: tag, asynchronous: asynchronous, ddlog: ddlog)
+        }
+    }
+}
+
+public func DDLogDebug(deferred message: @autoclosure @escaping () -> String, level: DDLogLevel = defaultDebugLevel, context: Int = 0, file: StaticString = #file, function: StaticString = #function, line: UInt = #line, tag: Any? = nil, asynchronous async: Bool = true, ddlog: DDLog = DDLog.sharedInstance()) {
+    _DDLogDeferredMessage(message, level: level, flag: .debug, context: context, file: file, function: function, line: line, tag: tag, asynchronous: async, ddlog: ddlog)
+}
+
+public func DDLogInfo(deferred message: @autoclosure @escaping () -> String, level: DDLogLevel = defaultDebugLevel, context: Int = 0, file: StaticString = #file, function: StaticString = #function, line: UInt = #line, tag: Any? = nil, asynchronous async: Bool = true, ddlog: DDLog = DDLog.sharedInstance()) {
+    _DDLogDeferredMessage(message, level: level, flag: .info, context: context, file: file, function: function, line: line, tag: tag, asynchronous: async, ddlog: ddlog)
+}
+
+public func DDLogWarn(deferred message: @autoclosure @escaping () -> String, level: DDLogLevel = defaultDebugLevel, context: Int = 0, file: StaticString = #file, function: StaticString = #function, line: UInt = #line, tag: Any? = nil, asynchronous async: Bool = true, ddlog: DDLog = DDLog.sharedInstance()) {
+    _DDLogDeferredMessage(message, level: level, flag: .warning, context: context, file: file, function: function, line: line, tag: tag, asynchronous: async, ddlog: ddlog)
+}
+
+public func DDLogVerbose(deferred message: @autoclosure @escaping () -> String, level: DDLogLevel = defaultDebugLevel, context: Int = 0, file: StaticString = #file, function: StaticString = #function, line: UInt = #line, tag: Any? = nil, asynchronous async: Bool = true, ddlog: DDLog = DDLog.sharedInstance()) {
+    _DDLogDeferredMessage(message, level: level, flag: .verbose, context: context, file: file, function: function, line: line, tag: tag, asynchronous: async, ddlog: ddlog)
+}
+
+public func DDLogError(deferred message: @autoclosure @escaping () -> String, level: DDLogLevel = defaultDebugLevel, context: Int = 0, file: StaticString = #file, function: StaticString = #function, line: UInt = #line, tag: Any? = nil, asynchronous async: Bool = false, ddlog: DDLog = DDLog.sharedInstance()) {
+    _DDLogDeferredMessage(message, level: level, flag: .error, context: context, file: file, function: function, line: line, tag: tag, asynchronous: async, ddlog: ddlog)
+}
+
 /// Returns a String of the current filename, without full path or extension.
 ///
 /// Analogous to the C preprocessor macro `THIS_FILE`.
@@ -14,6 +14,7 @@
 //   prior written permission of Deusty, LLC.
 
 #import "DDASLLogger.h"
+#import "DDLogTrace.h"
 #import <asl.h>
 
 #if !__has_feature(objc_arc)
@@ -68,6 +69,8 @@ static DDASLLogger *sharedInstance;
 
     NSString * message = _logFormatter ? [_logFormatter formatLogMessage:logMessage] : logMessage->_message;
 
+    DDLogTraceMark(DDLogTraceStageFormatted);
+
     if (logMessage) {
         const char *msg = [message UTF8String];
 
@@ -20,6 +20,8 @@
 
 #import "DDLog.h"
 
+@protocol DDLogClockTimer;
+
 /**
  * This class provides an abstract implementation of a database logger.
  *
@@ -36,12 +38,11 @@
     NSTimeInterval _deleteInterval;
     BOOL _deleteOnEverySave;
     
-    BOOL _saveTimerSuspended;
     NSUInteger _unsavedCount;
-    dispatch_time_t _unsavedTime;
-    dispatch_source_t _saveTimer;
-    dispatch_time_t _lastDeleteTime;
-    dispatch_source_t _deleteTimer;
+    NSDate *_unsavedTime;
+    id <DDLogClockTimer> _saveTimer;
+    NSDate *_lastDeleteTime;
+    id <DDLogClockTimer> _deleteTimer;
 }
 
 /**
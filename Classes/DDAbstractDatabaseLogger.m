@@ -14,6 +14,7 @@
 //   prior written permission of Deusty, LLC.
 
 #import "DDAbstractDatabaseLogger.h"
+#import "DDLogClock.h"
 #import <math.h>
 
 
@@ -87,19 +88,18 @@
     }
 
     _unsavedCount = 0;
-    _unsavedTime = 0;
+    _unsavedTime = nil;
 
-    if (_saveTimer && !_saveTimerSuspended) {
-        dispatch_suspend(_saveTimer);
-        _saveTimerSuspended = YES;
-    }
+    // The timer is scheduled again with the next unsaved entry
+    [_saveTimer cancel];
+    _saveTimer = nil;
 }
 
 - (void)performDelete {
     if (_maxAge > 0.0) {
         [self db_delete];
 
-        _lastDeleteTime = dispatch_time(DISPATCH_TIME_NOW, 0);
+        _lastDeleteTime = [[DDLog clock] now];
     }
 }
 
@@ -108,88 +108,60 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 - (void)destroySaveTimer {
-    if (_saveTimer) {
-        dispatch_source_cancel(_saveTimer);
-
-        if (_saveTimerSuspended) {
-            // Must resume a timer before releasing it (or it will crash)
-            dispatch_resume(_saveTimer);
-            _saveTimerSuspended = NO;
-        }
-
-        #if !OS_OBJECT_USE_OBJC
-        dispatch_release(_saveTimer);
-        #endif
-        _saveTimer = NULL;
-    }
+    [_saveTimer cancel];
+    _saveTimer = nil;
 }
 
 - (void)updateAndResumeSaveTimer {
-    if ((_saveTimer != NULL) && (_saveInterval > 0.0) && (_unsavedTime > 0.0)) {
-        uint64_t interval = (uint64_t)(_saveInterval * NSEC_PER_SEC);
-        dispatch_time_t startTime = dispatch_time(_unsavedTime, interval);
-
-        dispatch_source_set_timer(_saveTimer, startTime, interval, 1.0);
-
-        if (_saveTimerSuspended) {
-            dispatch_resume(_saveTimer);
-            _saveTimerSuspended = NO;
-        }
+    if ((_saveInterval > 0.0) && (_unsavedTime != nil)) {
+        [_saveTimer cancel];
+
+        // The first save is due saveInterval after the oldest unsaved entry (which may be right away)
+        id <DDLogClock> clock = [DDLog clock];
+        NSTimeInterval delay = _saveInterval - [[clock now] timeIntervalSinceDate:_unsavedTime];
+
+        _saveTimer = [clock scheduleTimerWithDelay:delay
+                                          interval:_saveInterval
+                                             queue:self.loggerQueue
+                                           handler:^{
+                                               [self performSaveAndSuspendSaveTimer];
+                                           }];
     }
 }
 
-- (void)createSuspendedSaveTimer {
-    if ((_saveTimer == NULL) && (_saveInterval > 0.0)) {
-        _saveTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.loggerQueue);
+- (void)destroyDeleteTimer {
+    [_deleteTimer cancel];
+    _deleteTimer = nil;
+}
+
+- (void)scheduleDeleteTimer {
+    [_deleteTimer cancel];
 
-        dispatch_source_set_event_handler(_saveTimer, ^{ @autoreleasepool {
-                                                            [self performSaveAndSuspendSaveTimer];
-                                                        } });
+    // The next delete is due deleteInterval after the last one (or from now, if there was none yet)
+    id <DDLogClock> clock = [DDLog clock];
+    NSTimeInterval delay = _deleteInterval;
 
-        _saveTimerSuspended = YES;
+    if (_lastDeleteTime != nil) {
+        delay -= [[clock now] timeIntervalSinceDate:_lastDeleteTime];
     }
-}
 
-- (void)destroyDeleteTimer {
-    if (_deleteTimer) {
-        dispatch_source_cancel(_deleteTimer);
-        #if !OS_OBJECT_USE_OBJC
-        dispatch_release(_deleteTimer);
-        #endif
-        _deleteTimer = NULL;
-    }
+    _deleteTimer = [clock scheduleTimerWithDelay:delay
+                                        interval:_deleteInterval
+                                           queue:self.loggerQueue
+                                         handler:^{
+                                             [self performDelete];
+                                         }];
 }
 
 - (void)updateDeleteTimer {
-    if ((_deleteTimer != NULL) && (_deleteInterval > 0.0) && (_maxAge > 0.0)) {
-        uint64_t interval = (uint64_t)(_deleteInterval * NSEC_PER_SEC);
-        dispatch_time_t startTime;
-
-        if (_lastDeleteTime > 0) {
-            startTime = dispatch_time(_lastDeleteTime, interval);
-        } else {
-            startTime = dispatch_time(DISPATCH_TIME_NOW, interval);
-        }
-
-        dispatch_source_set_timer(_deleteTimer, startTime, interval, 1.0);
+    if ((_deleteTimer != nil) && (_deleteInterval > 0.0) && (_maxAge > 0.0)) {
+        [self scheduleDeleteTimer];
     }
 }
 
 - (void)createAndStartDeleteTimer {
-    if ((_deleteTimer == NULL) && (_deleteInterval > 0.0) && (_maxAge > 0.0)) {
-        _deleteTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.loggerQueue);
-
-        if (_deleteTimer != NULL) {
-            dispatch_source_set_event_handler(_deleteTimer, ^{ @autoreleasepool {
-                                                                  [self performDelete];
-                                                              } });
-
-            [self updateDeleteTimer];
-
-            if (_deleteTimer != NULL) {
-                dispatch_resume(_deleteTimer);
-            }
-        }
+    if ((_deleteTimer == nil) && (_deleteInterval > 0.0) && (_maxAge > 0.0)) {
+        [self scheduleDeleteTimer];
     }
 }
 
@@ -307,23 +279,15 @@
                 //    (Plus we might need to do an immediate save.)
 
                 if (_saveInterval > 0.0) {
-                    if (_saveTimer == NULL) {
-                        // Handles #2
-                        //
-                        // Since the saveTimer uses the unsavedTime to calculate it's first fireDate,
-                        // if a save is needed the timer will fire immediately.
-
-                        [self createSuspendedSaveTimer];
-                        [self updateAndResumeSaveTimer];
-                    } else {
-                        // Handles #3
-                        // Handles #4
-                        //
-                        // Since the saveTimer uses the unsavedTime to calculate it's first fireDate,
-                        // if a save is needed the timer will fire immediately.
-
-                        [self updateAndResumeSaveTimer];
-                    }
+                    // Handles #2
+                    // Handles #3
+                    // Handles #4
+                    //
+                    // Since the saveTimer uses the unsavedTime to calculate it's first fireDate,
+                    // if a save is needed the timer will fire immediately.
+                    // (And if there are no unsaved entries, the timer is scheduled with the next one.)
+
+                    [self updateAndResumeSaveTimer];
                 } else if (_saveTimer) {
                     // Handles #1
 
@@ -495,7 +459,7 @@
                 //    (Plus we might need to do an immediate delete.)
 
                 if (_deleteInterval > 0.0) {
-                    if (_deleteTimer == NULL) {
+                    if (_deleteTimer == nil) {
                         // Handles #2
                         //
                         // Since the deleteTimer uses the lastDeleteTime to calculate it's first fireDate,
@@ -621,8 +585,7 @@
 - (void)didAddLogger {
     // If you override me be sure to invoke [super didAddLogger];
 
-    [self createSuspendedSaveTimer];
-
+    // The save timer is scheduled with the first unsaved entry
     [self createAndStartDeleteTimer];
 }
 
@@ -642,7 +605,7 @@
         if ((_unsavedCount >= _saveThreshold) && (_saveThreshold > 0)) {
             [self performSaveAndSuspendSaveTimer];
         } else if (firstUnsavedEntry) {
-            _unsavedTime = dispatch_time(DISPATCH_TIME_NOW, 0);
+            _unsavedTime = [[DDLog clock] now];
             [self updateAndResumeSaveTimer];
         }
     }
@@ -0,0 +1,98 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Emergency logging, for use from signal handlers and other contexts where the regular logging path can't be used.
+ *
+ * `DDLogError` and friends allocate Objective-C objects and may `dispatch_sync` onto the logging queue.
+ * Neither is allowed in a signal handler: the crashed thread may hold the malloc lock, or be the logging thread itself.
+ *
+ * The functions below only use async-signal-safe calls (`write` and plain memory access).
+ * A message is assembled into a static, preallocated buffer and then written, unformatted and unbuffered, to:
+ * - stderr
+ * - every registered file descriptor (`DDFileLogger` registers the descriptor of its current log file)
+ * - the active flight recorder, if any (see `DDFlightRecorderLogger`)
+ *
+ * Usage:
+ *
+ * if (DDEmergencyLogBegin()) {
+ *     DDEmergencyLogAppendString("Caught signal ");
+ *     DDEmergencyLogAppendInteger(signo);
+ *     DDEmergencyLogEnd();
+ * }
+ *
+ * Only one message can be assembled at a time. `DDEmergencyLogBegin` returns NO (without blocking)
+ * if the buffer is in use, e.g. when a second thread crashes at the same time, or a handler crashes while logging.
+ **/
+
+/**
+ * Maximum length of an emergency message, longer messages are truncated.
+ **/
+#define DD_EMERGENCY_LOG_BUFFER_SIZE 1024
+
+/**
+ * Maximum number of file descriptors that can be registered.
+ **/
+#define DD_EMERGENCY_LOG_MAX_FILE_DESCRIPTORS 8
+
+/**
+ *  Registers a file descriptor to receive emergency messages.
+ *  Returns NO if the descriptor is invalid or all slots are taken.
+ *  Safe to call from any thread.
+ */
+BOOL DDEmergencyLogRegisterFileDescriptor(int fd);
+
+/**
+ *  Unregisters a file descriptor. Call this *before* closing the descriptor.
+ */
+void DDEmergencyLogUnregisterFileDescriptor(int fd);
+
+/**
+ *  Claims the static buffer and resets it. Returns NO if another message is being assembled.
+ */
+BOOL DDEmergencyLogBegin(void);
+
+/**
+ *  Appends a NUL terminated C string
+ */
+void DDEmergencyLogAppendString(const char *string);
+
+/**
+ *  Appends a signed integer in decimal
+ */
+void DDEmergencyLogAppendInteger(long long value);
+
+/**
+ *  Appends an unsigned integer in decimal
+ */
+void DDEmergencyLogAppendUnsignedInteger(unsigned long long value);
+
+/**
+ *  Appends an unsigned integer in hexadecimal, prefixed with "0x" (useful for addresses)
+ */
+void DDEmergencyLogAppendHex(unsigned long long value);
+
+/**
+ *  Writes the message (terminated with a newline) to all destinations and releases the buffer.
+ */
+void DDEmergencyLogEnd(void);
+
+/**
+ *  Convenience for logging a single C string: Begin, AppendString, End.
+ *  Returns NO if the buffer was in use.
+ */
+BOOL DDEmergencyLog(const char *message);
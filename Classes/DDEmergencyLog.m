@@ -0,0 +1,190 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDEmergencyLog.h"
+#import "DDFlightRecorderLogger.h"
+
+#import <errno.h>
+#import <unistd.h>
+#import <libkern/OSAtomic.h>
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+// IMPORTANT: Everything in this file may run in signal context.
+// Only async-signal-safe calls in here: no locks, no allocations, no Objective-C, no stdio.
+
+static char _buffer[DD_EMERGENCY_LOG_BUFFER_SIZE];
+static size_t _length = 0;
+static volatile int32_t _bufferInUse = 0;
+
+// -1 marks a free slot
+static volatile int32_t _fileDescriptors[DD_EMERGENCY_LOG_MAX_FILE_DESCRIPTORS] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+
+BOOL DDEmergencyLogRegisterFileDescriptor(int fd) {
+    if (fd < 0) {
+        return NO;
+    }
+
+    for (NSUInteger i = 0; i < DD_EMERGENCY_LOG_MAX_FILE_DESCRIPTORS; i++) {
+        if (OSAtomicCompareAndSwap32Barrier(-1, fd, &_fileDescriptors[i])) {
+            return YES;
+        }
+    }
+
+    return NO;
+}
+
+void DDEmergencyLogUnregisterFileDescriptor(int fd) {
+    if (fd < 0) {
+        return;
+    }
+
+    for (NSUInteger i = 0; i < DD_EMERGENCY_LOG_MAX_FILE_DESCRIPTORS; i++) {
+        if (OSAtomicCompareAndSwap32Barrier(fd, -1, &_fileDescriptors[i])) {
+            return;
+        }
+    }
+}
+
+BOOL DDEmergencyLogBegin(void) {
+    // Never spin here: the owner may be the very thread we interrupted.
+    if (!OSAtomicCompareAndSwap32Barrier(0, 1, &_bufferInUse)) {
+        return NO;
+    }
+
+    _length = 0;
+    return YES;
+}
+
+static inline void DDEmergencyLogAppendBytes(const char *bytes, size_t length) {
+    // Keep one byte for the trailing newline
+    size_t available = sizeof(_buffer) - 1 - _length;
+
+    if (length > available) {
+        length = available;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        _buffer[_length + i] = bytes[i];
+    }
+
+    _length += length;
+}
+
+void DDEmergencyLogAppendString(const char *string) {
+    if (string == NULL) {
+        string = "(null)";
+    }
+
+    size_t length = 0;
+
+    while (string[length] != '\0') {
+        length++;
+    }
+
+    DDEmergencyLogAppendBytes(string, length);
+}
+
+void DDEmergencyLogAppendUnsignedInteger(unsigned long long value) {
+    char digits[20];
+    size_t count = 0;
+
+    do {
+        digits[sizeof(digits) - 1 - count++] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+
+    DDEmergencyLogAppendBytes(digits + sizeof(digits) - count, count);
+}
+
+void DDEmergencyLogAppendInteger(long long value) {
+    if (value < 0) {
+        DDEmergencyLogAppendBytes("-", 1);
+        // Negate in unsigned arithmetic, so LLONG_MIN doesn't overflow
+        DDEmergencyLogAppendUnsignedInteger(0ULL - (unsigned long long)value);
+    } else {
+        DDEmergencyLogAppendUnsignedInteger((unsigned long long)value);
+    }
+}
+
+void DDEmergencyLogAppendHex(unsigned long long value) {
+    static const char hexDigits[] = "0123456789abcdef";
+    char digits[18];
+    size_t count = 0;
+
+    do {
+        digits[sizeof(digits) - 1 - count++] = hexDigits[value & 0xF];
+        value >>= 4;
+    } while (value != 0);
+
+    digits[sizeof(digits) - 1 - count++] = 'x';
+    digits[sizeof(digits) - 1 - count++] = '0';
+
+    DDEmergencyLogAppendBytes(digits + sizeof(digits) - count, count);
+}
+
+static void DDEmergencyLogWriteAll(int fd, const char *bytes, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return;
+        }
+
+        bytes += written;
+        length -= (size_t)written;
+    }
+}
+
+void DDEmergencyLogEnd(void) {
+    int savedErrno = errno;
+
+    // The flight recorder stores records, not lines
+    DDFlightRecorderAppend((DDLogFlag)0, _buffer, _length);
+
+    _buffer[_length++] = '\n';
+
+    DDEmergencyLogWriteAll(STDERR_FILENO, _buffer, _length);
+
+    for (NSUInteger i = 0; i < DD_EMERGENCY_LOG_MAX_FILE_DESCRIPTORS; i++) {
+        int fd = _fileDescriptors[i];
+
+        if (fd >= 0 && fd != STDERR_FILENO) {
+            DDEmergencyLogWriteAll(fd, _buffer, _length);
+        }
+    }
+
+    _length = 0;
+    OSAtomicCompareAndSwap32Barrier(1, 0, &_bufferInUse);
+
+    errno = savedErrno;
+}
+
+BOOL DDEmergencyLog(const char *message) {
+    if (!DDEmergencyLogBegin()) {
+        return NO;
+    }
+
+    DDEmergencyLogAppendString(message);
+    DDEmergencyLogEnd();
+
+    return YES;
+}
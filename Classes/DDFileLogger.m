@@ -14,6 +14,10 @@
 //   prior written permission of Deusty, LLC.
 
 #import "DDFileLogger.h"
+#import "DDEmergencyLog.h"
+#import "DDLogClock.h"
+#import "DDLogTrace.h"
+#import "DDLogMetrics.h"
 
 #import <unistd.h>
 #import <sys/attr.h>
@@ -428,7 +432,7 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
     NSString *appName = [self applicationName];
 
     NSDateFormatter *dateFormatter = [self logFileDateFormatter];
-    NSString *formattedDate = [dateFormatter stringFromDate:[NSDate date]];
+    NSString *formattedDate = [dateFormatter stringFromDate:[[DDLog clock] now]];
 
     return [NSString stringWithFormat:@"%@ %@.log", appName, formattedDate];
 }
@@ -458,7 +462,9 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
         if (![[NSFileManager defaultManager] fileExistsAtPath:filePath]) {
             NSLogVerbose(@"DDLogFileManagerDefault: Creating new log file: %@", actualFileName);
 
-            NSDictionary *attributes = nil;
+            // The age of a log file (and so rolling) is based on its creation date, which comes from the log clock
+            NSMutableDictionary *attributes = [NSMutableDictionary dictionary];
+            attributes[NSFileCreationDate] = [[DDLog clock] now];
 
         #if TARGET_OS_IPHONE
             // When creating log file on iOS we're setting NSFileProtectionKey attribute to NSFileProtectionCompleteUnlessOpen.
@@ -470,9 +476,7 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
             NSString *key = _defaultFileProtectionLevel ? :
                 (doesAppRunInBackground() ? NSFileProtectionCompleteUntilFirstUserAuthentication : NSFileProtectionCompleteUnlessOpen);
 
-            attributes = @{
-                NSFileProtectionKey: key
-            };
+            attributes[NSFileProtectionKey] = key;
         #endif
 
             [[NSFileManager defaultManager] createFileAtPath:filePath contents:nil attributes:attributes];
@@ -561,7 +565,7 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
     NSFileHandle *_currentLogFileHandle;
     
     dispatch_source_t _currentLogFileVnode;
-    dispatch_source_t _rollingTimer;
+    id <DDLogClockTimer> _rollingTimer;
     
     unsigned long long _maximumFileSize;
     NSTimeInterval _rollingFrequency;
@@ -596,6 +600,10 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
 }
 
 - (void)dealloc {
+    if (_currentLogFileHandle) {
+        DDEmergencyLogUnregisterFileDescriptor([_currentLogFileHandle fileDescriptor]);
+    }
+
     [_currentLogFileHandle synchronizeFile];
     [_currentLogFileHandle closeFile];
 
@@ -605,8 +613,8 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
     }
 
     if (_rollingTimer) {
-        dispatch_source_cancel(_rollingTimer);
-        _rollingTimer = NULL;
+        [_rollingTimer cancel];
+        _rollingTimer = nil;
     }
 }
 
@@ -736,8 +744,8 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
 
 - (void)scheduleTimerToRollLogFileDueToAge {
     if (_rollingTimer) {
-        dispatch_source_cancel(_rollingTimer);
-        _rollingTimer = NULL;
+        [_rollingTimer cancel];
+        _rollingTimer = nil;
     }
 
     if (_currentLogFileInfo == nil || _rollingFrequency <= 0.0) {
@@ -756,24 +764,14 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
     NSLogVerbose(@"DDFileLogger: logFileCreationDate: %@", logFileCreationDate);
     NSLogVerbose(@"DDFileLogger: logFileRollingDate : %@", logFileRollingDate);
 
-    _rollingTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.loggerQueue);
-
-    dispatch_source_set_event_handler(_rollingTimer, ^{ @autoreleasepool {
-                                                           [self maybeRollLogFileDueToAge];
-                                                       } });
-
-    #if !OS_OBJECT_USE_OBJC
-    dispatch_source_t theRollingTimer = _rollingTimer;
-    dispatch_source_set_cancel_handler(_rollingTimer, ^{
-        dispatch_release(theRollingTimer);
-    });
-    #endif
-
-    uint64_t delay = (uint64_t)([logFileRollingDate timeIntervalSinceNow] * NSEC_PER_SEC);
-    dispatch_time_t fireTime = dispatch_time(DISPATCH_TIME_NOW, delay);
+    NSTimeInterval delay = [logFileRollingDate timeIntervalSinceDate:[[DDLog clock] now]];
 
-    dispatch_source_set_timer(_rollingTimer, fireTime, DISPATCH_TIME_FOREVER, 1.0);
-    dispatch_resume(_rollingTimer);
+    _rollingTimer = [[DDLog clock] scheduleTimerWithDelay:delay
+                                                 interval:0.0
+                                                    queue:self.loggerQueue
+                                                  handler:^{
+                                                      [self maybeRollLogFileDueToAge];
+                                                  }];
 }
 
 - (void)rollLogFile {
@@ -818,12 +816,17 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
         return;
     }
 
+    // Withdraw the descriptor from signal context before it can be closed and reused
+    DDEmergencyLogUnregisterFileDescriptor([_currentLogFileHandle fileDescriptor]);
+
     [_currentLogFileHandle synchronizeFile];
     [_currentLogFileHandle closeFile];
     _currentLogFileHandle = nil;
 
     _currentLogFileInfo.isArchived = YES;
 
+    DDLogMetricsAdd(DDLogMetricsCounterFileRolls, 1);
+
     if ([logFileManager respondsToSelector:@selector(didRollAndArchiveLogFile:)]) {
         [logFileManager didRollAndArchiveLogFile:(_currentLogFileInfo.filePath)];
     }
@@ -836,8 +839,8 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
     }
 
     if (_rollingTimer) {
-        dispatch_source_cancel(_rollingTimer);
-        _rollingTimer = NULL;
+        [_rollingTimer cancel];
+        _rollingTimer = nil;
     }
 }
 
@@ -952,6 +955,9 @@ unsigned long long const kDDDefaultLogFilesDiskQuota   = 20 * 1024 * 1024; // 20
         [_currentLogFileHandle seekToEndOfFile];
 
         if (_currentLogFileHandle) {
+            // Publish the descriptor, so emergency messages (e.g. from a crash handler) end up in the log file too
+            DDEmergencyLogRegisterFileDescriptor([_currentLogFileHandle fileDescriptor]);
+
             [self scheduleTimerToRollLogFileDueToAge];
 
             // Here we are monitoring the log file. In case if it would be deleted ormoved
@@ -996,6 +1002,8 @@ static int exception_count = 0;
         isFormatted = message != logMessage->_message;
     }
 
+    DDLogTraceMark(DDLogTraceStageFormatted);
+
     if (message) {
         if ((!isFormatted || _automaticallyAppendNewlineForCustomFormatters) &&
             (![message hasSuffix:@"\n"])) {
@@ -1007,9 +1015,14 @@ static int exception_count = 0;
         @try {
             [[self currentLogFileHandle] writeData:logData];
 
+            if (DDLogMetricsActive) {
+                DDLogMetricsAdd(DDLogMetricsCounterFileBytesWritten, (int64_t)logData.length);
+            }
+
             [self maybeRollLogFileDueToSize];
         } @catch (NSException *exception) {
             exception_count++;
+            DDLogMetricsAdd(DDLogMetricsCounterFileExceptions, 1);
 
             if (exception_count <= 10) {
                 NSLogError(@"DDFileLogger.logMessage: %@", exception);
@@ -1132,7 +1145,7 @@ static int exception_count = 0;
 }
 
 - (NSTimeInterval)age {
-    return [[self creationDate] timeIntervalSinceNow] * -1.0;
+    return [[[DDLog clock] now] timeIntervalSinceDate:[self creationDate]];
 }
 
 - (NSString *)description {
@@ -0,0 +1,136 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+/**
+ * Default size (in bytes) of the ring used by `DDFlightRecorderLogger`.
+ **/
+extern NSUInteger const kDDDefaultFlightRecorderCapacity;
+
+/**
+ * A single record recovered from a flight recorder file.
+ **/
+@interface DDFlightRecorderRecord : NSObject
+
+/**
+ *  Monotonically increasing sequence number, unique within the recorder file
+ */
+@property (nonatomic, readonly) uint64_t sequence;
+
+/**
+ *  The time the record was written
+ */
+@property (nonatomic, readonly) NSDate *timestamp;
+
+/**
+ *  The flag of the original log message (0 for records written from a fatal signal handler)
+ */
+@property (nonatomic, readonly) DDLogFlag flag;
+
+/**
+ *  The (formatted) log message
+ */
+@property (nonatomic, readonly) NSString *message;
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A logger that keeps the most recent log messages in a file-backed ring buffer.
+ *
+ * The ring is mapped with `MAP_SHARED`, so every record that has been written to it lives in the kernel page cache
+ * and survives a crash of the process. There is no write(2) per message and nothing to flush on the way down.
+ * Place the file in the logs directory (the default), or in a RAM backed location such as `/dev/shm`.
+ *
+ * Each record carries a sequence number, a timestamp, the log flag, a checksum,
+ * and a commit marker that is only set once the record has been completely written.
+ * Partially written or overwritten records are therefore ignored during recovery.
+ *
+ * After a crash, the records can be recovered:
+ * - by the next launch, through the `recoveredRecords` property (populated before the logger appends anything)
+ * - by any other process or tool, through `+recoverRecordsAtPath:`
+ *
+ * Appending to the ring is lock free, which allows the fatal signal handlers
+ * (see `installFatalSignalHandlers`) to write a final record using async-signal-safe code only.
+ * For the same reason the ring stays mapped after the logger is deallocated, until the process exits.
+ **/
+@interface DDFlightRecorderLogger : DDAbstractLogger <DDLogger>
+
+/**
+ *  Creates a recorder at `<logs directory>/<process name>.flightrecorder` with the default capacity
+ */
+- (instancetype)init;
+
+/**
+ *  Designated initializer
+ *
+ *  @param path     the path of the ring file. It is created if needed, and reused (with its records) otherwise.
+ *  @param capacity the size of the ring in bytes
+ */
+- (instancetype)initWithPath:(NSString *)path capacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  The path of the ring file
+ */
+@property (nonatomic, readonly, copy) NSString *path;
+
+/**
+ *  The size of the ring in bytes
+ */
+@property (nonatomic, readonly) NSUInteger capacity;
+
+/**
+ *  The records that were present in the ring file when this logger opened it, oldest first.
+ *  Typically these are the last messages logged before the previous run of the application ended.
+ */
+@property (nonatomic, readonly) NSArray<DDFlightRecorderRecord *> *recoveredRecords;
+
+/**
+ *  Reads the committed records of a flight recorder file, oldest first.
+ *  Returns nil if the file does not exist or isn't a flight recorder file.
+ */
++ (NSArray<DDFlightRecorderRecord *> *)recoverRecordsAtPath:(NSString *)path;
+
+/**
+ * Installs handlers for SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT and SIGTRAP.
+ *
+ * On a fatal signal the handler logs the signal through the emergency log (see `DDEmergencyLog.h`),
+ * which appends a record to the most recently created flight recorder, then restores the previously installed handler and re-raises the signal.
+ * The handler only uses async-signal-safe calls.
+ **/
++ (void)installFatalSignalHandlers;
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Appends a record to the most recently created flight recorder.
+ *
+ * This function is async-signal-safe: it does not allocate, lock, or message Objective-C objects.
+ * It returns NO if there is no active flight recorder.
+ **/
+BOOL DDFlightRecorderAppend(DDLogFlag flag, const char *bytes, size_t length);
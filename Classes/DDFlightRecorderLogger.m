@@ -0,0 +1,501 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDFlightRecorderLogger.h"
+#import "DDFileLogger.h"
+#import "DDEmergencyLog.h"
+#import "DDLogTrace.h"
+
+#import <fcntl.h>
+#import <signal.h>
+#import <unistd.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <libkern/OSAtomic.h>
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+// We probably shouldn't be using DDLog() statements within the DDLog implementation.
+// But we still want to leave our log statements for any future debugging,
+// and to allow other developers to trace the implementation (which is a great learning tool).
+//
+// So we use primitive logging macros around NSLog.
+// We maintain the NS prefix on the macros to be explicit about the fact that we're using NSLog.
+
+#ifndef DD_NSLOG_LEVEL
+    #define DD_NSLOG_LEVEL 2
+#endif
+
+#define NSLogError(frmt, ...)    do{ if(DD_NSLOG_LEVEL >= 1) NSLog((frmt), ##__VA_ARGS__); } while(0)
+#define NSLogWarn(frmt, ...)     do{ if(DD_NSLOG_LEVEL >= 2) NSLog((frmt), ##__VA_ARGS__); } while(0)
+#define NSLogInfo(frmt, ...)     do{ if(DD_NSLOG_LEVEL >= 3) NSLog((frmt), ##__VA_ARGS__); } while(0)
+
+NSUInteger const kDDDefaultFlightRecorderCapacity = 1024 * 1024; // 1 MB
+
+// File layout:
+//
+// [DDFlightRecorderFileHeader, padded to kDDFlightRecorderDataOffset][data ring of `capacity` bytes]
+//
+// The ring is addressed with a monotonically increasing logical position (`head`).
+// A record written at logical position P lives at physical offset (P % capacity) and never straddles the end of the ring.
+// When a record doesn't fit before the end, the remaining bytes are skipped and the record is placed at offset 0.
+//
+// A record is valid if its commit marker is set, its checksum matches,
+// its stored logical position maps to the offset it was found at,
+// and that position is still inside the window [head - capacity, head).
+// Records that have been (partially) overwritten always fall outside that window.
+
+static uint32_t const kDDFlightRecorderMagic     = 0x52464444; // "DDFR"
+static uint32_t const kDDFlightRecorderVersion   = 1;
+static uint32_t const kDDFlightRecorderCommitted = 0x54494D43; // "CMIT"
+static size_t   const kDDFlightRecorderDataOffset = 64;
+static size_t   const kDDFlightRecorderMinCapacity = 4096;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    volatile int64_t head;
+    volatile int64_t sequence;
+} DDFlightRecorderFileHeader;
+
+typedef struct {
+    volatile uint32_t marker;
+    uint32_t length;
+    uint64_t position;
+    uint64_t sequence;
+    uint64_t timestamp; // microseconds since 1970
+    uint32_t flag;
+    uint32_t checksum;
+} DDFlightRecorderRecordHeader;
+
+typedef struct {
+    void *base;
+    size_t mappedLength;
+    DDFlightRecorderFileHeader *header;
+    uint8_t *data;
+    uint64_t capacity;
+} DDFlightRecorderRegion;
+
+// The region used by DDFlightRecorderAppend (and thus by the fatal signal handlers).
+static DDFlightRecorderRegion * volatile _activeRegion = NULL;
+
+static inline uint64_t DDFlightRecorderAlign(uint64_t size) {
+    return (size + 7) & ~((uint64_t)7);
+}
+
+static inline uint32_t DDFlightRecorderChecksum(const uint8_t *bytes, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static BOOL DDFlightRecorderRegionAppend(DDFlightRecorderRegion *region,
+                                         DDLogFlag flag,
+                                         uint64_t timestamp,
+                                         const char *bytes,
+                                         size_t length) {
+    // IMPORTANT: This function is called from signal handlers.
+    // Only async-signal-safe code in here: no locks, no allocations, no Objective-C.
+
+    if (region == NULL) {
+        return NO;
+    }
+
+    DDFlightRecorderFileHeader *header = region->header;
+    uint64_t capacity = region->capacity;
+
+    // Keep a single record from evicting most of the ring
+    size_t maxLength = (size_t)(capacity / 4) - sizeof(DDFlightRecorderRecordHeader);
+
+    if (length > maxLength) {
+        length = maxLength;
+    }
+
+    uint64_t size = DDFlightRecorderAlign(sizeof(DDFlightRecorderRecordHeader) + length);
+    int64_t oldHead, newHead;
+    uint64_t position;
+
+    do {
+        oldHead = header->head;
+
+        uint64_t offset = (uint64_t)oldHead % capacity;
+        uint64_t skip = (offset + size > capacity) ? (capacity - offset) : 0;
+
+        position = (uint64_t)oldHead + skip;
+        newHead = (int64_t)(position + size);
+    } while (!OSAtomicCompareAndSwap64Barrier(oldHead, newHead, &header->head));
+
+    DDFlightRecorderRecordHeader *record = (DDFlightRecorderRecordHeader *)(region->data + (position % capacity));
+
+    record->marker = 0;
+    OSMemoryBarrier();
+
+    memcpy((uint8_t *)record + sizeof(DDFlightRecorderRecordHeader), bytes, length);
+
+    record->length = (uint32_t)length;
+    record->position = position;
+    record->sequence = (uint64_t)OSAtomicIncrement64Barrier(&header->sequence);
+    record->timestamp = timestamp;
+    record->flag = (uint32_t)flag;
+    record->checksum = DDFlightRecorderChecksum((const uint8_t *)bytes, length);
+
+    OSMemoryBarrier();
+    record->marker = kDDFlightRecorderCommitted;
+
+    return YES;
+}
+
+BOOL DDFlightRecorderAppend(DDLogFlag flag, const char *bytes, size_t length) {
+    // time() is async-signal-safe, gettimeofday() isn't guaranteed to be.
+    uint64_t timestamp = (uint64_t)time(NULL) * USEC_PER_SEC;
+
+    return DDFlightRecorderRegionAppend(_activeRegion, flag, timestamp, bytes, length);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Recovery
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface DDFlightRecorderRecord ()
+
+- (instancetype)initWithSequence:(uint64_t)sequence
+                       timestamp:(NSDate *)timestamp
+                            flag:(DDLogFlag)flag
+                         message:(NSString *)message;
+
+@end
+
+@implementation DDFlightRecorderRecord
+
+- (instancetype)initWithSequence:(uint64_t)sequence
+                       timestamp:(NSDate *)timestamp
+                            flag:(DDLogFlag)flag
+                         message:(NSString *)message {
+    if ((self = [super init])) {
+        _sequence = sequence;
+        _timestamp = timestamp;
+        _flag = flag;
+        _message = [message copy];
+    }
+
+    return self;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ #%llu %@ %@>", NSStringFromClass([self class]), _sequence, _timestamp, _message];
+}
+
+@end
+
+static NSArray *DDFlightRecorderRecoverRecords(const DDFlightRecorderFileHeader *header, const uint8_t *data) {
+    uint64_t capacity = header->capacity;
+    uint64_t head = (uint64_t)header->head;
+    uint64_t windowStart = (head > capacity) ? (head - capacity) : 0;
+
+    NSMutableArray *records = [NSMutableArray array];
+
+    for (uint64_t offset = 0; offset + sizeof(DDFlightRecorderRecordHeader) <= capacity; offset += 8) {
+        const DDFlightRecorderRecordHeader *record = (const DDFlightRecorderRecordHeader *)(data + offset);
+
+        if (record->marker != kDDFlightRecorderCommitted) {
+            continue;
+        }
+
+        uint64_t size = DDFlightRecorderAlign(sizeof(DDFlightRecorderRecordHeader) + record->length);
+
+        if (offset + size > capacity ||
+            record->position % capacity != offset ||
+            record->position < windowStart ||
+            record->position + size > head) {
+            continue;
+        }
+
+        const uint8_t *payload = (const uint8_t *)record + sizeof(DDFlightRecorderRecordHeader);
+
+        if (DDFlightRecorderChecksum(payload, record->length) != record->checksum) {
+            continue;
+        }
+
+        NSString *message = [[NSString alloc] initWithBytes:payload length:record->length encoding:NSUTF8StringEncoding];
+        NSDate *timestamp = [NSDate dateWithTimeIntervalSince1970:((NSTimeInterval)record->timestamp / USEC_PER_SEC)];
+
+        [records addObject:[[DDFlightRecorderRecord alloc] initWithSequence:record->sequence
+                                                                  timestamp:timestamp
+                                                                       flag:(DDLogFlag)record->flag
+                                                                    message:message ?: @""]];
+
+        offset += size - 8;
+    }
+
+    [records sortUsingComparator:^NSComparisonResult(DDFlightRecorderRecord *r1, DDFlightRecorderRecord *r2) {
+        if (r1.sequence < r2.sequence) {
+            return NSOrderedAscending;
+        }
+
+        return (r1.sequence > r2.sequence) ? NSOrderedDescending : NSOrderedSame;
+    }];
+
+    return records;
+}
+
+static BOOL DDFlightRecorderHeaderIsValid(const DDFlightRecorderFileHeader *header, unsigned long long fileSize) {
+    return header->magic == kDDFlightRecorderMagic &&
+           header->version == kDDFlightRecorderVersion &&
+           header->capacity >= kDDFlightRecorderMinCapacity &&
+           header->capacity + kDDFlightRecorderDataOffset == fileSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface DDFlightRecorderLogger () {
+    DDFlightRecorderRegion *_region;
+}
+
+@end
+
+@implementation DDFlightRecorderLogger
+
+- (instancetype)init {
+    NSString *logsDirectory = [[[DDLogFileManagerDefault alloc] init] logsDirectory];
+    NSString *fileName = [[[NSProcessInfo processInfo] processName] stringByAppendingPathExtension:@"flightrecorder"];
+
+    return [self initWithPath:[logsDirectory stringByAppendingPathComponent:fileName]
+                     capacity:kDDDefaultFlightRecorderCapacity];
+}
+
+- (instancetype)initWithPath:(NSString *)path capacity:(NSUInteger)capacity {
+    if ((self = [super init])) {
+        _path = [path copy];
+        _capacity = (NSUInteger)DDFlightRecorderAlign(MAX(capacity, kDDFlightRecorderMinCapacity));
+
+        if (![self mapRegion]) {
+            return nil;
+        }
+
+        _recoveredRecords = DDFlightRecorderRecoverRecords(_region->header, _region->data);
+
+        _activeRegion = _region;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    if (_region) {
+        OSAtomicCompareAndSwapPtrBarrier(_region, NULL, (void * volatile *)&_activeRegion);
+
+        // Never unmapped: DDFlightRecorderAppend takes no lock, and a caller (a signal handler, the emergency log)
+        // may have loaded _activeRegion just before the swap and still be writing to it.
+        // The mapping and the region stay for the life of the process.
+    }
+}
+
+- (BOOL)mapRegion {
+    size_t mappedLength = kDDFlightRecorderDataOffset + _capacity;
+
+    int fd = open([_path fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+
+    if (fd < 0) {
+        NSLogError(@"DDFlightRecorderLogger: Error opening %@: %s", _path, strerror(errno));
+        return NO;
+    }
+
+    struct stat st;
+    BOOL reuse = NO;
+
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size == mappedLength) {
+        reuse = YES;
+    } else if (ftruncate(fd, (off_t)mappedLength) != 0) {
+        NSLogError(@"DDFlightRecorderLogger: Error resizing %@: %s", _path, strerror(errno));
+        close(fd);
+        return NO;
+    }
+
+    void *base = mmap(NULL, mappedLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED) {
+        NSLogError(@"DDFlightRecorderLogger: Error mapping %@: %s", _path, strerror(errno));
+        return NO;
+    }
+
+    DDFlightRecorderFileHeader *header = (DDFlightRecorderFileHeader *)base;
+
+    if (!reuse || !DDFlightRecorderHeaderIsValid(header, mappedLength)) {
+        // New file, or a file from an incompatible recorder.
+        // Clear the data as well, stale records from another generation could otherwise pass validation.
+
+        memset(base, 0, mappedLength);
+
+        header->magic = kDDFlightRecorderMagic;
+        header->version = kDDFlightRecorderVersion;
+        header->capacity = _capacity;
+    }
+
+    _region = (DDFlightRecorderRegion *)calloc(1, sizeof(DDFlightRecorderRegion));
+    _region->base = base;
+    _region->mappedLength = mappedLength;
+    _region->header = header;
+    _region->data = (uint8_t *)base + kDDFlightRecorderDataOffset;
+    _region->capacity = _capacity;
+
+    return YES;
+}
+
++ (NSArray *)recoverRecordsAtPath:(NSString *)path {
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+
+    if (data.length < kDDFlightRecorderDataOffset + kDDFlightRecorderMinCapacity) {
+        return nil;
+    }
+
+    const DDFlightRecorderFileHeader *header = (const DDFlightRecorderFileHeader *)data.bytes;
+
+    if (!DDFlightRecorderHeaderIsValid(header, data.length)) {
+        return nil;
+    }
+
+    return DDFlightRecorderRecoverRecords(header, (const uint8_t *)data.bytes + kDDFlightRecorderDataOffset);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark DDLogger Protocol
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)logMessage:(DDLogMessage *)logMessage {
+    NSString *message = logMessage->_message;
+
+    if (_logFormatter) {
+        message = [_logFormatter formatLogMessage:logMessage];
+    }
+
+    DDLogTraceMark(DDLogTraceStageFormatted);
+
+    if (message == nil) {
+        return;
+    }
+
+    // Convert to UTF-8 on the stack, records are capped at a quarter of the ring anyway.
+
+    char buffer[1024 * 4];
+    NSUInteger usedLength = 0;
+
+    [message getBytes:buffer
+            maxLength:sizeof(buffer)
+           usedLength:&usedLength
+             encoding:NSUTF8StringEncoding
+              options:NSStringEncodingConversionAllowLossy
+                range:NSMakeRange(0, message.length)
+       remainingRange:NULL];
+
+    uint64_t timestamp = (uint64_t)([logMessage->_timestamp timeIntervalSince1970] * USEC_PER_SEC);
+
+    DDFlightRecorderRegionAppend(_region, logMessage->_flag, timestamp, buffer, usedLength);
+}
+
+- (NSString *)loggerName {
+    return @"cocoa.lumberjack.flightRecorderLogger";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Fatal Signals
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static int const DDFlightRecorderFatalSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT, SIGTRAP };
+#define DD_FLIGHT_RECORDER_FATAL_SIGNAL_COUNT (sizeof(DDFlightRecorderFatalSignals) / sizeof(DDFlightRecorderFatalSignals[0]))
+
+static struct sigaction DDFlightRecorderPreviousActions[DD_FLIGHT_RECORDER_FATAL_SIGNAL_COUNT];
+
+static const char *DDFlightRecorderSignalName(int signo) {
+    // strsignal() isn't async-signal-safe
+    switch (signo) {
+        case SIGSEGV : return "SIGSEGV";
+        case SIGBUS  : return "SIGBUS";
+        case SIGILL  : return "SIGILL";
+        case SIGFPE  : return "SIGFPE";
+        case SIGABRT : return "SIGABRT";
+        case SIGTRAP : return "SIGTRAP";
+        default      : return "signal";
+    }
+}
+
+static void DDFlightRecorderHandleFatalSignal(int signo) {
+    // IMPORTANT: Only async-signal-safe code in here.
+    // The emergency log also reaches stderr and the current log file, and ends up in the flight recorder.
+
+    if (DDEmergencyLogBegin()) {
+        DDEmergencyLogAppendString("Fatal signal: ");
+        DDEmergencyLogAppendString(DDFlightRecorderSignalName(signo));
+        DDEmergencyLogAppendString(" (");
+        DDEmergencyLogAppendInteger(signo);
+        DDEmergencyLogAppendString(")");
+        DDEmergencyLogEnd();
+    } else {
+        // Another thread (or a crash inside the emergency log) holds its buffer, record at least this much.
+        static const char message[] = "Fatal signal";
+        DDFlightRecorderAppend((DDLogFlag)0, message, sizeof(message) - 1);
+    }
+
+    // Hand over to whoever was installed before us (or the default action), and let it crash for real.
+
+    for (size_t i = 0; i < DD_FLIGHT_RECORDER_FATAL_SIGNAL_COUNT; i++) {
+        if (DDFlightRecorderFatalSignals[i] == signo) {
+            sigaction(signo, &DDFlightRecorderPreviousActions[i], NULL);
+            break;
+        }
+    }
+
+    raise(signo);
+}
+
++ (void)installFatalSignalHandlers {
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        // Give the handler a stack of its own, so a stack overflow can still be recorded (on this thread).
+
+        stack_t alternateStack;
+        alternateStack.ss_sp = malloc(SIGSTKSZ);
+        alternateStack.ss_size = SIGSTKSZ;
+        alternateStack.ss_flags = 0;
+
+        if (alternateStack.ss_sp) {
+            sigaltstack(&alternateStack, NULL);
+        }
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = DDFlightRecorderHandleFatalSignal;
+        action.sa_flags = SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+
+        for (size_t i = 0; i < DD_FLIGHT_RECORDER_FATAL_SIGNAL_COUNT; i++) {
+            sigaction(DDFlightRecorderFatalSignals[i], &action, &DDFlightRecorderPreviousActions[i]);
+        }
+    });
+}
+
+@end
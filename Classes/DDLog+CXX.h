@@ -0,0 +1,408 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+#import "DDLogMacros.h"
+#import "DDLogNumberFormatting.h"
+
+/**
+ * Type safe log macros for C++ code compiled as Objective-C++:
+ *
+ * DDLogInfoCXX("Loaded {} items from {} in {} s", count, path, seconds);
+ *
+ * The format has a `{}` placeholder per argument (`{{` and `}}` for braces) and must be a string literal:
+ * the placeholders are counted at compile time, and a statement with more or fewer arguments,
+ * a lone brace or an argument of an unsupported type doesn't compile.
+ *
+ * A statement costs about as much as copying its arguments: they are written in binary to a buffer,
+ * which DDLog hands to the logging queue, and the message is only formatted there
+ * (see `log:level:flag:context:callSite:arguments:length:renderer:`). No Objective-C object is created
+ * on the calling thread. The file, function, line and format of a statement are a constant `DDLogCallSite`.
+ *
+ * Supported arguments:
+ * - bool, char, integers and enums
+ * - float, double and long double (formatted with the shortest digits that read back the same, see DDLogNumberFormatting.h)
+ * - C strings and std::string (copied)
+ * - Objective-C objects (retained until the message is formatted, then formatted with -description)
+ * - other pointers (formatted as addresses)
+ *
+ * Like the block based macros, a statement is skipped before its arguments are evaluated unless both the
+ * per-file level (LOG_LEVEL_DEF) and one of the loggers accept it.
+ *
+ * The placeholders are counted by a constexpr function that recurses once per character of the format,
+ * so formats are limited to about 500 characters with the default -fconstexpr-depth.
+ **/
+
+#if defined(__cplusplus) && defined(__OBJC__)
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace dd {
+namespace log {
+namespace detail {
+
+/**
+ * The number of `{}` placeholders in the format, or -1 if it has a brace that is neither part of one nor escaped.
+ **/
+constexpr int placeholder_count(const char *format, int count = 0) {
+    return (format[0] == '\0') ? count
+         : (format[0] == '{') ? ((format[1] == '{') ? placeholder_count(format + 2, count)
+                              :  (format[1] == '}') ? placeholder_count(format + 2, count + 1)
+                              :  -1)
+         : (format[0] == '}') ? ((format[1] == '}') ? placeholder_count(format + 2, count) : -1)
+         : placeholder_count(format + 1, count);
+}
+
+template <typename T>
+inline void write_value(char *&cursor, const T &value) {
+    memcpy(cursor, &value, sizeof(T));
+    cursor += sizeof(T);
+}
+
+template <typename T>
+inline T read_value(const char *&cursor) {
+    T value;
+    memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+}
+
+/**
+ * Strings are written as their length and bytes. SIZE_MAX stands for a NULL C string.
+ **/
+inline size_t string_size(const char *string, size_t length) {
+    return sizeof(size_t) + (string ? length : 0);
+}
+
+inline void write_string(char *&cursor, const char *string, size_t length) {
+    write_value<size_t>(cursor, string ? length : SIZE_MAX);
+    if (string) {
+        memcpy(cursor, string, length);
+        cursor += length;
+    }
+}
+
+inline void append_string(std::string &message, const char *&cursor) {
+    size_t length = read_value<size_t>(cursor);
+    if (length == SIZE_MAX) {
+        message.append("(null)");
+    } else {
+        message.append(cursor, length);
+        cursor += length;
+    }
+}
+
+inline void skip_string(const char *&cursor) {
+    size_t length = read_value<size_t>(cursor);
+    if (length != SIZE_MAX) {
+        cursor += length;
+    }
+}
+
+inline void append_signed(std::string &message, long long value) {
+    char digits[DD_LOG_INTEGER_MAX_LENGTH];
+    message.append(digits, DDLogFormatInteger(digits, value));
+}
+
+inline void append_unsigned(std::string &message, unsigned long long value) {
+    char digits[DD_LOG_INTEGER_MAX_LENGTH];
+    message.append(digits, DDLogFormatUnsignedInteger(digits, value));
+}
+
+inline void append_double(std::string &message, double value) {
+    char digits[DD_LOG_DOUBLE_MAX_LENGTH];
+    message.append(digits, DDLogFormatDouble(digits, value));
+}
+
+enum class argument_kind {
+    unsupported,
+    boolean,
+    character,
+    signed_integer,
+    unsigned_integer,
+    floating_point,
+    c_string,
+    string,
+    object,
+    pointer
+};
+
+template <typename T>
+struct kind_of {
+    static constexpr argument_kind value =
+        std::is_same<T, bool>::value ? argument_kind::boolean
+      : std::is_same<T, char>::value ? argument_kind::character
+      : (std::is_integral<T>::value || std::is_enum<T>::value) ?
+            (std::is_signed<typename std::conditional<std::is_enum<T>::value, std::underlying_type<T>, std::common_type<T>>::type::type>::value
+                ? argument_kind::signed_integer : argument_kind::unsigned_integer)
+      : std::is_floating_point<T>::value ? argument_kind::floating_point
+      : (std::is_same<T, const char *>::value || std::is_same<T, char *>::value) ? argument_kind::c_string
+      : std::is_same<T, std::string>::value ? argument_kind::string
+      : std::is_convertible<T, id>::value ? argument_kind::object
+      : std::is_pointer<T>::value ? argument_kind::pointer
+      : argument_kind::unsupported;
+};
+
+/**
+ * How an argument of a kind is written on the calling thread, and formatted (or skipped) on the logging queue.
+ **/
+template <argument_kind Kind>
+struct argument;
+
+template <>
+struct argument<argument_kind::boolean> {
+    static size_t size(bool) { return 1; }
+    static void write(char *&cursor, bool value) { write_value<uint8_t>(cursor, value ? 1 : 0); }
+    static void append(std::string &message, const char *&cursor) { message.append(read_value<uint8_t>(cursor) ? "true" : "false"); }
+    static void skip(const char *&cursor) { cursor += 1; }
+};
+
+template <>
+struct argument<argument_kind::character> {
+    static size_t size(char) { return 1; }
+    static void write(char *&cursor, char value) { write_value<char>(cursor, value); }
+    static void append(std::string &message, const char *&cursor) { message.push_back(read_value<char>(cursor)); }
+    static void skip(const char *&cursor) { cursor += 1; }
+};
+
+template <>
+struct argument<argument_kind::signed_integer> {
+    template <typename T> static size_t size(T) { return sizeof(long long); }
+    template <typename T> static void write(char *&cursor, T value) { write_value<long long>(cursor, (long long)value); }
+    static void append(std::string &message, const char *&cursor) { append_signed(message, read_value<long long>(cursor)); }
+    static void skip(const char *&cursor) { cursor += sizeof(long long); }
+};
+
+template <>
+struct argument<argument_kind::unsigned_integer> {
+    template <typename T> static size_t size(T) { return sizeof(unsigned long long); }
+    template <typename T> static void write(char *&cursor, T value) { write_value<unsigned long long>(cursor, (unsigned long long)value); }
+    static void append(std::string &message, const char *&cursor) { append_unsigned(message, read_value<unsigned long long>(cursor)); }
+    static void skip(const char *&cursor) { cursor += sizeof(unsigned long long); }
+};
+
+template <>
+struct argument<argument_kind::floating_point> {
+    template <typename T> static size_t size(T) { return sizeof(double); }
+    template <typename T> static void write(char *&cursor, T value) { write_value<double>(cursor, (double)value); }
+    static void append(std::string &message, const char *&cursor) { append_double(message, read_value<double>(cursor)); }
+    static void skip(const char *&cursor) { cursor += sizeof(double); }
+};
+
+template <>
+struct argument<argument_kind::c_string> {
+    static size_t size(const char *value) { return string_size(value, value ? strlen(value) : 0); }
+    static void write(char *&cursor, const char *value) { write_string(cursor, value, value ? strlen(value) : 0); }
+    static void append(std::string &message, const char *&cursor) { append_string(message, cursor); }
+    static void skip(const char *&cursor) { skip_string(cursor); }
+};
+
+template <>
+struct argument<argument_kind::string> {
+    static size_t size(const std::string &value) { return string_size(value.data(), value.size()); }
+    static void write(char *&cursor, const std::string &value) { write_string(cursor, value.data(), value.size()); }
+    static void append(std::string &message, const char *&cursor) { append_string(message, cursor); }
+    static void skip(const char *&cursor) { skip_string(cursor); }
+};
+
+template <>
+struct argument<argument_kind::object> {
+    static size_t size(id) { return sizeof(CFTypeRef); }
+    static void write(char *&cursor, id value) { write_value<CFTypeRef>(cursor, value ? CFBridgingRetain(value) : NULL); }
+
+    static void append(std::string &message, const char *&cursor) {
+        CFTypeRef value = read_value<CFTypeRef>(cursor);
+        NSString *description = value ? [CFBridgingRelease(value) description] : nil;
+
+        if (!description) {
+            message.append("(null)");
+            return;
+        }
+
+        // Copied straight into the message, so no pointer into the description outlives it
+        size_t offset = message.size();
+        message.resize(offset + [description lengthOfBytesUsingEncoding:NSUTF8StringEncoding]);
+
+        NSUInteger used = 0;
+        [description getBytes:&message[offset]
+                    maxLength:message.size() - offset
+                   usedLength:&used
+                     encoding:NSUTF8StringEncoding
+                      options:(NSStringEncodingConversionOptions)0
+                        range:NSMakeRange(0, description.length)
+               remainingRange:NULL];
+        message.resize(offset + used);
+    }
+
+    static void skip(const char *&cursor) {
+        CFTypeRef value = read_value<CFTypeRef>(cursor);
+        if (value) {
+            CFRelease(value);
+        }
+    }
+};
+
+template <>
+struct argument<argument_kind::pointer> {
+    static size_t size(const void *) { return sizeof(uintptr_t); }
+    static void write(char *&cursor, const void *value) { write_value<uintptr_t>(cursor, (uintptr_t)value); }
+
+    static void append(std::string &message, const char *&cursor) {
+        char digits[24];
+        int length = snprintf(digits, sizeof(digits), "0x%" PRIxPTR, read_value<uintptr_t>(cursor));
+        message.append(digits, (size_t)length);
+    }
+
+    static void skip(const char *&cursor) { cursor += sizeof(uintptr_t); }
+};
+
+template <typename T>
+using argument_for = argument<kind_of<typename std::decay<T>::type>::value>;
+
+template <typename... Args>
+struct all_supported;
+
+template <>
+struct all_supported<> : std::true_type {};
+
+template <typename T, typename... Args>
+struct all_supported<T, Args...> : std::integral_constant<bool, kind_of<T>::value != argument_kind::unsupported && all_supported<Args...>::value> {};
+
+/**
+ * The DDLogRecordRenderer of the statements with these argument types.
+ **/
+template <typename... Args>
+struct renderer {
+    static NSString *render(const DDLogCallSite *callSite, const void *arguments, BOOL shouldRender) {
+        // The first entries only keep the arrays from being empty
+        void (*appends[])(std::string &, const char *&) = { nullptr, &argument_for<Args>::append... };
+        void (*skips[])(const char *&) = { nullptr, &argument_for<Args>::skip... };
+
+        const char *cursor = static_cast<const char *>(arguments);
+
+        if (!shouldRender) {
+            for (size_t i = 1; i <= sizeof...(Args); i++) {
+                skips[i](cursor);
+            }
+            return nil;
+        }
+
+        std::string message;
+        size_t next = 1;
+        const char *text = callSite->format;
+
+        for (const char *brace = strpbrk(text, "{}"); brace; brace = strpbrk(text, "{}")) {
+            message.append(text, (size_t)(brace - text));
+
+            if (brace[0] == '{' && brace[1] == '}') {
+                appends[next++](message, cursor);
+            } else {
+                message.push_back(brace[0]); // Escaped brace
+            }
+
+            text = brace + 2;
+        }
+
+        message.append(text);
+
+        CFStringRef string = CFStringCreateWithBytes(kCFAllocatorDefault, (const UInt8 *)message.data(), (CFIndex)message.size(), kCFStringEncodingUTF8, false);
+        return string ? (NSString *)CFBridgingRelease(string) : nil;
+    }
+};
+
+} // namespace detail
+
+/**
+ * Logs a statement of the C++ front end. Use the macros below, which make the format type and call site.
+ *
+ * `Format::value()` returns the format, as a constant expression.
+ **/
+template <typename Format, typename... Args>
+inline void log(BOOL asynchronous, DDLogLevel level, DDLogFlag flag, NSInteger context, const DDLogCallSite *callSite, const Args &... args) {
+    static_assert(detail::placeholder_count(Format::value()) >= 0,
+                  "A brace in the log format is neither part of a {} placeholder nor escaped ({{ or }})");
+    static_assert(detail::placeholder_count(Format::value()) == (int)sizeof...(Args),
+                  "The number of {} placeholders in the log format doesn't match the number of arguments");
+    static_assert(detail::all_supported<typename std::decay<Args>::type...>::value,
+                  "Unsupported log argument type (see DDLog+CXX.h)");
+
+    size_t length = 0;
+    int sizes[] = { 0, ((void)(length += detail::argument_for<Args>::size(args)), 0)... };
+    (void)sizes;
+
+    // Most statements fit on the stack, DDLog copies the arguments anyway
+    char stackBuffer[256];
+    char *buffer = (length <= sizeof(stackBuffer)) ? stackBuffer : static_cast<char *>(malloc(length));
+
+    if (buffer == nullptr) {
+        // Out of memory: the statement is dropped, before the arguments retain anything
+        return;
+    }
+
+    char *cursor = buffer;
+
+    int writes[] = { 0, ((void)detail::argument_for<Args>::write(cursor, args), 0)... };
+    (void)writes;
+
+    [DDLog log:asynchronous
+         level:level
+          flag:flag
+       context:context
+      callSite:callSite
+     arguments:buffer
+        length:length
+      renderer:&detail::renderer<typename std::decay<Args>::type...>::render];
+
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+}
+
+} // namespace log
+} // namespace dd
+
+/**
+ * This is the single macro that all other macros below compile into.
+ **/
+#define LOG_MACRO_CXX(isAsynchronous, lvl, flg, ctx, frmt, ...)                                               \
+        do {                                                                                                  \
+            struct DDLogCXXFormat { static constexpr const char *value() { return frmt; } };                  \
+            static constexpr DDLogCallSite DDLogCXXCallSite = { __FILE__, __PRETTY_FUNCTION__, __LINE__, frmt }; \
+            ::dd::log::log<DDLogCXXFormat>(isAsynchronous, lvl, flg, ctx, &DDLogCXXCallSite, ##__VA_ARGS__);  \
+        } while(0)
+
+#define LOG_MAYBE_CXX(async, lvl, flg, ctx, frmt, ...) \
+        do { if(LOG_LEVEL_ACCEPTS(lvl, flg) && (DDLogLoggersLevel & flg)) LOG_MACRO_CXX(async, lvl, flg, ctx, frmt, ##__VA_ARGS__); } while(0)
+
+/**
+ * Ready to use log macros with no context.
+ **/
+#define DDLogErrorCXX(frmt, ...)   LOG_MAYBE_CXX(NO,                LOG_LEVEL_DEF, DDLogFlagError,   0, frmt, ##__VA_ARGS__)
+#define DDLogWarnCXX(frmt, ...)    LOG_MAYBE_CXX(LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagWarning, 0, frmt, ##__VA_ARGS__)
+#define DDLogInfoCXX(frmt, ...)    LOG_MAYBE_CXX(LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagInfo,    0, frmt, ##__VA_ARGS__)
+#define DDLogDebugCXX(frmt, ...)   LOG_MAYBE_CXX(LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagDebug,   0, frmt, ##__VA_ARGS__)
+#define DDLogVerboseCXX(frmt, ...) LOG_MAYBE_CXX(LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagVerbose, 0, frmt, ##__VA_ARGS__)
+
+#endif /* if defined(__cplusplus) && defined(__OBJC__) */
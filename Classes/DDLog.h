@@ -31,6 +31,8 @@
 @class DDLogMessage;
 @class DDLoggerInformation;
 @protocol DDLogger;
+@protocol DDLogClock;
+@class DDLogWatchdog;
 @protocol DDLogFormatter;
 
 /**
@@ -195,6 +197,40 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy);
  **/
 #define THIS_METHOD       NSStringFromSelector(_cmd)
 
+/**
+ * A block that builds the text of a log message.
+ * It is used by the block based macros (`DDLogDebugBlock` & co), and only invoked if some logger accepts the message.
+ **/
+typedef NSString * (^DDLogMessageBlock)(void);
+
+/**
+ * The union of the levels of all loggers currently added to `[DDLog sharedInstance]`.
+ *
+ * It is maintained by `DDLog` (never write to it), and read by the block based macros
+ * so that a message nobody would receive isn't even built.
+ * Same as `[DDLog loggersLevel]`, without the method call.
+ **/
+extern volatile DDLogLevel DDLogLoggersLevel;
+
+/**
+ * The constant part of a log statement whose arguments are recorded in binary and formatted on the logging queue
+ * (see `log:level:flag:context:callSite:arguments:length:renderer:`).
+ * The C++ front end (`DDLog+CXX.h`) makes one per statement at compile time.
+ **/
+typedef struct DDLogCallSite {
+    const char *file;       // never deallocated
+    const char *function;   // never deallocated
+    NSUInteger line;
+    const char *format;     // never deallocated
+} DDLogCallSite;
+
+/**
+ * Formats the message of a recorded log statement from the argument bytes the statement wrote.
+ *
+ * It is called exactly once per statement, on the logging queue. If no logger takes the message by then,
+ * `render` is NO: the renderer only has to release what the arguments hold, and may return nil.
+ **/
+typedef NSString * (*DDLogRecordRenderer)(const DDLogCallSite *callSite, const void *arguments, BOOL render);
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
@@ -220,6 +256,27 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy);
  **/
 + (dispatch_queue_t)loggingQueue;
 
+/**
+ * The clock used for the timestamps of log messages and by the time based behavior of the loggers
+ * (rolling log files, saving and deleting database entries). See DDLogClock.h.
+ *
+ * Defaults to the system clock. Replace it before logging starts (or while no log statements are in flight),
+ * e.g. with a `DDVirtualLogClock` to make tests and benchmarks deterministic.
+ * Setting nil restores the system clock.
+ **/
++ (id <DDLogClock>)clock;
++ (void)setClock:(id <DDLogClock>)clock;
+
+/**
+ * Detection (and optionally quarantine) of loggers that stall in `logMessage:`, see DDLogWatchdog.h.
+ * Nil, the default, disables it.
+ *
+ * Like loggers, the watchdog is installed asynchronously on the logging queue:
+ * install it at startup, not once a logger is already stuck.
+ **/
++ (DDLogWatchdog *)watchdog;
++ (void)setWatchdog:(DDLogWatchdog *)watchdog;
+
 /**
  * Logging Primitive.
  *
@@ -328,6 +385,150 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy);
      format:(NSString *)format
        args:(va_list)argList NS_SWIFT_NAME(log(asynchronous:level:flag:context:file:function:line:tag:format:arguments:));
 
+/**
+ * Logging Primitive.
+ *
+ * For a message that is already built, with a file and function that live as long as the process:
+ * string literals such as `__FILE__`, or the `StaticString`s of Swift's `#file` and `#function`.
+ * They are wrapped as they are, where the other primitives copy them into new strings.
+ * This is the primitive behind the Swift logging functions.
+ *
+ *  @param asynchronous YES if the logging is done async, NO if you want to force sync
+ *  @param message      the message
+ *  @param level        the log level
+ *  @param flag         the log flag
+ *  @param context      the context (if any is defined)
+ *  @param file         the current file, never deallocated
+ *  @param function     the current function, never deallocated
+ *  @param line         the current code line
+ *  @param tag          potential tag
+ */
++ (void)log:(BOOL)asynchronous
+        message:(NSString *)message
+          level:(DDLogLevel)level
+           flag:(DDLogFlag)flag
+        context:(NSInteger)context
+     staticFile:(const char *)file
+ staticFunction:(const char *)function
+           line:(NSUInteger)line
+            tag:(id)tag NS_SWIFT_NAME(log(asynchronous:message:level:flag:context:staticFile:staticFunction:line:tag:));
+
+/**
+ * Logging Primitive.
+ *
+ * For a message that is already built, with a file and function that live as long as the process:
+ * string literals such as `__FILE__`, or the `StaticString`s of Swift's `#file` and `#function`.
+ * They are wrapped as they are, where the other primitives copy them into new strings.
+ * This is the primitive behind the Swift logging functions.
+ *
+ *  @param asynchronous YES if the logging is done async, NO if you want to force sync
+ *  @param message      the message
+ *  @param level        the log level
+ *  @param flag         the log flag
+ *  @param context      the context (if any is defined)
+ *  @param file         the current file, never deallocated
+ *  @param function     the current function, never deallocated
+ *  @param line         the current code line
+ *  @param tag          potential tag
+ */
+- (void)log:(BOOL)asynchronous
+        message:(NSString *)message
+          level:(DDLogLevel)level
+           flag:(DDLogFlag)flag
+        context:(NSInteger)context
+     staticFile:(const char *)file
+ staticFunction:(const char *)function
+           line:(NSUInteger)line
+            tag:(id)tag NS_SWIFT_NAME(log(asynchronous:message:level:flag:context:staticFile:staticFunction:line:tag:));
+
+/**
+ * Logging Primitive.
+ *
+ * Like `log:message:level:flag:context:staticFile:staticFunction:line:tag:`, but the message is rendered later:
+ * the renderer is called on the logging queue, before the loggers get the message, and only if one of them accepts it.
+ * The calling thread only pays for capturing the values the message is made of.
+ * This is the primitive behind the deferred messages of the Swift logging functions (`DDLogInfo(deferred:)` and the other levels).
+ *
+ * The renderer runs on another thread than the log statement: it must only use values that are safe to use from there.
+ *
+ *  @param asynchronous    YES if the logging is done async, NO if you want to force sync
+ *  @param level           the log level
+ *  @param flag            the log flag
+ *  @param context         the context (if any is defined)
+ *  @param file            the current file, never deallocated
+ *  @param function        the current function, never deallocated
+ *  @param line            the current code line
+ *  @param tag             potential tag
+ *  @param messageRenderer the block building the message
+ */
++ (void)log:(BOOL)asynchronous
+          level:(DDLogLevel)level
+           flag:(DDLogFlag)flag
+        context:(NSInteger)context
+     staticFile:(const char *)file
+ staticFunction:(const char *)function
+           line:(NSUInteger)line
+            tag:(id)tag
+messageRenderer:(DDLogMessageBlock)messageRenderer NS_SWIFT_NAME(log(asynchronous:level:flag:context:staticFile:staticFunction:line:tag:messageRenderer:));
+
+/**
+ * Logging Primitive.
+ *
+ * Like `log:message:level:flag:context:staticFile:staticFunction:line:tag:`, but the message is rendered later:
+ * the renderer is called on the logging queue, before the loggers get the message, and only if one of them accepts it.
+ * The calling thread only pays for capturing the values the message is made of.
+ * This is the primitive behind the deferred messages of the Swift logging functions (`DDLogInfo(deferred:)` and the other levels).
+ *
+ * The renderer runs on another thread than the log statement: it must only use values that are safe to use from there.
+ *
+ *  @param asynchronous    YES if the logging is done async, NO if you want to force sync
+ *  @param level           the log level
+ *  @param flag            the log flag
+ *  @param context         the context (if any is defined)
+ *  @param file            the current file, never deallocated
+ *  @param function        the current function, never deallocated
+ *  @param line            the current code line
+ *  @param tag             potential tag
+ *  @param messageRenderer the block building the message
+ */
+- (void)log:(BOOL)asynchronous
+          level:(DDLogLevel)level
+           flag:(DDLogFlag)flag
+        context:(NSInteger)context
+     staticFile:(const char *)file
+ staticFunction:(const char *)function
+           line:(NSUInteger)line
+            tag:(id)tag
+messageRenderer:(DDLogMessageBlock)messageRenderer NS_SWIFT_NAME(log(asynchronous:level:flag:context:staticFile:staticFunction:line:tag:messageRenderer:));
+
+/**
+ * Logging Primitive.
+ *
+ * Logs a statement from its call site and a binary record of its arguments, without creating any object
+ * on the calling thread: the arguments are copied into a single buffer with the time, thread and queue of the
+ * statement, and handed to the logging queue. There the renderer formats the message, before the loggers get it.
+ * This is the primitive behind the C++ front end (`DDLog+CXX.h`).
+ *
+ * The statement is dropped (after letting the renderer release the arguments) if no logger accepts the flag.
+ *
+ *  @param asynchronous YES if the logging is done async, NO if you want to force sync
+ *  @param level        the log level
+ *  @param flag         the log flag
+ *  @param context      the context (if any is defined)
+ *  @param callSite     the file, function, line and format of the statement, never deallocated
+ *  @param arguments    the argument bytes, copied before the method returns
+ *  @param length       the number of argument bytes
+ *  @param renderer     the function formatting the message from the argument bytes
+ */
++ (void)log:(BOOL)asynchronous
+      level:(DDLogLevel)level
+       flag:(DDLogFlag)flag
+    context:(NSInteger)context
+   callSite:(const DDLogCallSite *)callSite
+  arguments:(const void *)arguments
+     length:(size_t)length
+   renderer:(DDLogRecordRenderer)renderer NS_SWIFT_NAME(log(asynchronous:level:flag:context:callSite:arguments:length:renderer:));
+
 /**
  * Logging Primitive.
  *
@@ -339,6 +540,34 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy);
 + (void)log:(BOOL)asynchronous
     message:(DDLogMessage *)logMessage NS_SWIFT_NAME(log(asynchronous:message:));
 
+/**
+ * Logging Primitive.
+ *
+ * Logs a statement from its call site and a binary record of its arguments, without creating any object
+ * on the calling thread: the arguments are copied into a single buffer with the time, thread and queue of the
+ * statement, and handed to the logging queue. There the renderer formats the message, before the loggers get it.
+ * This is the primitive behind the C++ front end (`DDLog+CXX.h`).
+ *
+ * The statement is dropped (after letting the renderer release the arguments) if no logger accepts the flag.
+ *
+ *  @param asynchronous YES if the logging is done async, NO if you want to force sync
+ *  @param level        the log level
+ *  @param flag         the log flag
+ *  @param context      the context (if any is defined)
+ *  @param callSite     the file, function, line and format of the statement, never deallocated
+ *  @param arguments    the argument bytes, copied before the method returns
+ *  @param length       the number of argument bytes
+ *  @param renderer     the function formatting the message from the argument bytes
+ */
+- (void)log:(BOOL)asynchronous
+      level:(DDLogLevel)level
+       flag:(DDLogFlag)flag
+    context:(NSInteger)context
+   callSite:(const DDLogCallSite *)callSite
+  arguments:(const void *)arguments
+     length:(size_t)length
+   renderer:(DDLogRecordRenderer)renderer NS_SWIFT_NAME(log(asynchronous:level:flag:context:callSite:arguments:length:renderer:));
+
 /**
  * Logging Primitive.
  *
@@ -350,6 +579,62 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy);
 - (void)log:(BOOL)asynchronous
     message:(DDLogMessage *)logMessage NS_SWIFT_NAME(log(asynchronous:message:));
 
+/**
+ * Logging Primitive.
+ *
+ * The message block is only invoked (synchronously, on the calling thread) if at least one of the added loggers
+ * accepts the flag. Expensive arguments (`description` of large objects, ...) therefore cost nothing
+ * for messages that would be filtered out anyway.
+ * Similar to `log:level:flag:context:file:function:line:tag:format:...`
+ *
+ *  @param asynchronous YES if the logging is done async, NO if you want to force sync
+ *  @param level        the log level
+ *  @param flag         the log flag
+ *  @param context      the context (if any is defined)
+ *  @param file         the current file
+ *  @param function     the current function
+ *  @param line         the current code line
+ *  @param tag          potential tag
+ *  @param messageBlock the block building the message
+ */
++ (void)log:(BOOL)asynchronous
+        level:(DDLogLevel)level
+         flag:(DDLogFlag)flag
+      context:(NSInteger)context
+         file:(const char *)file
+     function:(const char *)function
+         line:(NSUInteger)line
+          tag:(id)tag
+ messageBlock:(DDLogMessageBlock)messageBlock NS_SWIFT_NAME(log(asynchronous:level:flag:context:file:function:line:tag:messageBlock:));
+
+/**
+ * Logging Primitive.
+ *
+ * The message block is only invoked (synchronously, on the calling thread) if at least one of the added loggers
+ * accepts the flag. Expensive arguments (`description` of large objects, ...) therefore cost nothing
+ * for messages that would be filtered out anyway.
+ * Similar to `log:level:flag:context:file:function:line:tag:format:...`
+ *
+ *  @param asynchronous YES if the logging is done async, NO if you want to force sync
+ *  @param level        the log level
+ *  @param flag         the log flag
+ *  @param context      the context (if any is defined)
+ *  @param file         the current file
+ *  @param function     the current function
+ *  @param line         the current code line
+ *  @param tag          potential tag
+ *  @param messageBlock the block building the message
+ */
+- (void)log:(BOOL)asynchronous
+        level:(DDLogLevel)level
+         flag:(DDLogFlag)flag
+      context:(NSInteger)context
+         file:(const char *)file
+     function:(const char *)function
+         line:(NSUInteger)line
+          tag:(id)tag
+ messageBlock:(DDLogMessageBlock)messageBlock NS_SWIFT_NAME(log(asynchronous:level:flag:context:file:function:line:tag:messageBlock:));
+
 /**
  * Since logging can be asynchronous, there may be times when you want to flush the logs.
  * The framework invokes this automatically when the application quits.
@@ -482,6 +767,22 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy);
  */
 - (void)removeAllLoggers;
 
+/**
+ *  The union of the levels of all the current loggers.
+ *  A message whose flag isn't part of it won't reach any logger.
+ *
+ *  Adding a logger extends it immediately, removing one narrows it once the removal has been processed.
+ */
++ (DDLogLevel)loggersLevel;
+
+/**
+ *  The union of the levels of all the current loggers.
+ *  A message whose flag isn't part of it won't reach any logger.
+ *
+ *  Adding a logger extends it immediately, removing one narrows it once the removal has been processed.
+ */
+- (DDLogLevel)loggersLevel;
+
 /**
  *  Return all the current loggers
  */
@@ -507,6 +808,10 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy);
  *
  * These methods allow you to obtain a list of classes that are using registered dynamic logging,
  * and also provides methods to get and set their log level during run time.
+ *
+ * The registered classes are found once, and then kept up to date as images (frameworks, bundles) get loaded.
+ * Getting or setting a level by class name is a dictionary lookup. Listing the classes also picks up
+ * the classes created at runtime: when the number of classes changed, the classes not seen before are checked.
  **/
 
 /**
@@ -718,6 +1023,11 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy);
     #define NS_DESIGNATED_INITIALIZER
 #endif
 
+/**
+ *  The ID of a string in the intern table of `DDLogStringTable.h`. 0 means the string isn't interned.
+ */
+typedef uint32_t DDLogStringID;
+
 /**
  *  Log message options, allow copying certain log elements
  */
@@ -754,6 +1064,12 @@ typedef NS_OPTIONS(NSInteger, DDLogMessageOptions){
     NSString *_threadID;
     NSString *_threadName;
     NSString *_queueLabel;
+
+    // The IDs of the strings above in DDLogStringTable (the strings then are the ones of the table)
+    DDLogStringID _fileID;
+    DDLogStringID _functionID;
+    DDLogStringID _threadNameID;
+    DDLogStringID _queueLabelID;
 }
 
 /**
@@ -821,6 +1137,17 @@ typedef NS_OPTIONS(NSInteger, DDLogMessageOptions){
 @property (readonly, nonatomic) NSString *threadName;
 @property (readonly, nonatomic) NSString *queueLabel;
 
+/**
+ *  The IDs of `file`, `function`, `threadName` and `queueLabel` in the intern table of `DDLogStringTable.h`,
+ *  whose cached UTF-8 bytes sinks can write without converting the strings again.
+ *  The log statements of DDLog intern all four; messages created with `initWithMessage:...` only the thread name and queue label.
+ *  0 if a string isn't interned (or is nil).
+ */
+@property (readonly, nonatomic) DDLogStringID fileID;
+@property (readonly, nonatomic) DDLogStringID functionID;
+@property (readonly, nonatomic) DDLogStringID threadNameID;
+@property (readonly, nonatomic) DDLogStringID queueLabelID;
+
 @end
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
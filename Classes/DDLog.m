@@ -19,13 +19,30 @@
 #endif
 
 #import "DDLog.h"
+#import "DDLogScope.h"
+#import "DDLogClock.h"
+#import "DDLogTrace.h"
+#import "DDLogCallSiteProfiler.h"
+#import "DDLogWatchdog.h"
+#import "DDLogMetrics.h"
+#import "DDLogNumberFormatting.h"
+#import "DDLogFormatCache.h"
+#import "DDLogStringTable.h"
 
 #import <pthread.h>
 #import <objc/runtime.h>
 #import <mach/mach_host.h>
 #import <mach/host_info.h>
+#import <mach/mach_time.h>
 #import <libkern/OSAtomic.h>
 #import <Availability.h>
+#import <dlfcn.h>
+#if __has_include(<mach-o/dyld.h>)
+    #import <mach-o/dyld.h>
+    #define DD_HAS_DYLD_IMAGE_NOTIFICATIONS 1
+#else
+    #define DD_HAS_DYLD_IMAGE_NOTIFICATIONS 0
+#endif
 #if TARGET_OS_IOS
     #import <UIKit/UIDevice.h>
 #endif
@@ -69,6 +86,68 @@
 
 static void *const GlobalLoggingQueueIdentityKey = (void *)&GlobalLoggingQueueIdentityKey;
 
+#if DD_LOG_TRACE_ENABLED
+
+// Stage timestamps (see DDLogTrace.h), up to the logging queue. The logger stages are recorded per logger.
+@interface DDLogMessage () {
+    @public
+    int64_t _traceSequence;
+    uint64_t _traceTimestamps[DDLogTraceStageHanded];
+}
+
+@end
+
+static volatile int64_t _traceSequenceCounter;
+
+#endif
+
+// A log statement recorded in binary by log:level:flag:context:callSite:arguments:length:renderer:,
+// on its way from the calling thread to the logging queue. Allocated as one block:
+// the header, the argument bytes and the (NUL terminated) label of the calling queue.
+typedef struct {
+    void *log; // Retained DDLog
+    DDLogLevel level;
+    DDLogFlag flag;
+    NSInteger context;
+    const DDLogCallSite *callSite;
+    DDLogRecordRenderer renderer;
+    NSTimeInterval timestamp; // Since the reference date
+    uint64_t threadID;
+    char threadName[64];
+    size_t length;
+
+    #if DD_LOG_TRACE_ENABLED
+    uint64_t traceCreated;
+    uint64_t traceEnqueued;
+    #endif
+} DDLogRecord;
+
+#define DDLogRecordArguments(record)  ((char *)(record) + sizeof(DDLogRecord))
+#define DDLogRecordQueueLabel(record) (DDLogRecordArguments(record) + (record)->length)
+
+// Where the thread and queue metadata of a message come from (see DDLogMessage)
+static uint64_t DDLogCurrentThreadID(void);
+static const char * DDLogCurrentQueueLabel(void);
+
+@interface DDLogMessage () {
+    @public
+    // Set for messages rendered on the logging queue, until they are (see lt_log:)
+    DDLogMessageBlock _messageRenderer;
+}
+
+- (instancetype)initWithRecord:(const DDLogRecord *)record message:(NSString *)message NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)initWithMessage:(NSString *)message
+                          level:(DDLogLevel)level
+                           flag:(DDLogFlag)flag
+                        context:(NSInteger)context
+                         fileID:(DDLogStringID)fileID
+                     functionID:(DDLogStringID)functionID
+                           line:(NSUInteger)line
+                            tag:(id)tag NS_DESIGNATED_INITIALIZER;
+
+@end
+
 @interface DDLoggerNode : NSObject
 {
     // Direct accessors to be used only for performance
@@ -76,6 +155,19 @@ static void *const GlobalLoggingQueueIdentityKey = (void *)&GlobalLoggingQueueId
     id <DDLogger> _logger;
     DDLogLevel _level;
     dispatch_queue_t _loggerQueue;
+
+    // Watchdog state (see DDLogWatchdog.h).
+    // _busySince is set on the logging queue when the logger is handed a message, and cleared on the logger queue
+    // when it is done. _groupEntered is cleared by whoever leaves the logging group for the message:
+    // the logger queue, or the watchdog when it quarantines the logger. The rest is only used on the logging queue.
+    volatile uint64_t _busySince;
+    volatile int32_t _groupEntered;
+    BOOL _stallReported;
+    BOOL _quarantined;
+    NSUInteger _droppedMessages;
+
+    // Write latency counters, looked up on the logging queue the first time they're needed (see DDLogMetrics.h)
+    DDLogMetricsLoggerCounters *_metrics;
 }
 
 @property (nonatomic, readonly) id <DDLogger> logger;
@@ -93,7 +185,17 @@ static void *const GlobalLoggingQueueIdentityKey = (void *)&GlobalLoggingQueueId
 #pragma mark -
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-@interface DDLog ()
+@interface DDLog () {
+    // Union of the levels of all loggers, see loggersLevel.
+    // Points to the DDLogLoggersLevel global for the shared instance (so the macros can read it directly),
+    // and to _ownLoggersLevel for any other instance.
+    volatile DDLogLevel *_loggersLevel;
+    volatile DDLogLevel _ownLoggersLevel;
+
+    // Number of addLogger calls that haven't been processed on the logging queue yet.
+    // While there are any, the loggers level may only grow.
+    volatile int32_t _numPendingAdditions;
+}
 
 // An array used to manage all the individual loggers.
 // The array is only modified on the loggingQueue/loggingThread.
@@ -101,6 +203,8 @@ static void *const GlobalLoggingQueueIdentityKey = (void *)&GlobalLoggingQueueId
 
 @end
 
+volatile DDLogLevel DDLogLoggersLevel = DDLogLevelOff;
+
 @implementation DDLog
 
 // All logging statements are added to the same queue to ensure FIFO operation.
@@ -117,6 +221,12 @@ static dispatch_semaphore_t _queueSemaphore;
 // Minor optimization for uniprocessor machines
 static NSUInteger _numProcessors;
 
+// The clock used for timestamps and timers. Nil means the system clock, which DDLogMessage reads directly.
+static id <DDLogClock> _clock;
+
+// Detection of stalled loggers. Only used (and only changed) on the logging queue.
+static DDLogWatchdog *_watchdog;
+
 /**
  *  Returns the singleton `DDLog`.
  *  The instance is used by `DDLog` class methods.
@@ -129,6 +239,7 @@ static NSUInteger _numProcessors;
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
         sharedInstance = [[self alloc] init];
+        ((DDLog *)sharedInstance)->_loggersLevel = &DDLogLoggersLevel;
     });
     
     return sharedInstance;
@@ -176,6 +287,7 @@ static NSUInteger _numProcessors;
     
     if (self) {
         self._loggers = [[NSMutableArray alloc] initWithCapacity:4];
+        _loggersLevel = &_ownLoggersLevel;
         
 #if TARGET_OS_IOS
         NSString *notificationName = @"UIApplicationWillTerminateNotification";
@@ -219,6 +331,38 @@ static NSUInteger _numProcessors;
     return _loggingQueue;
 }
 
++ (id <DDLogClock>)clock {
+    return _clock ?: [DDSystemLogClock sharedInstance];
+}
+
++ (void)setClock:(id <DDLogClock>)clock {
+    _clock = (clock == [DDSystemLogClock sharedInstance]) ? nil : clock;
+}
+
++ (DDLogWatchdog *)watchdog {
+    __block DDLogWatchdog *result;
+
+    dispatch_sync(_loggingQueue, ^{
+        result = _watchdog;
+    });
+
+    return result;
+}
+
++ (void)setWatchdog:(DDLogWatchdog *)watchdog {
+    dispatch_async(_loggingQueue, ^{ @autoreleasepool {
+        _watchdog = watchdog;
+
+        if (watchdog == nil) {
+            // Loggers in quarantine are waited for again
+            for (DDLoggerNode *loggerNode in [self sharedInstance]._loggers) {
+                loggerNode->_quarantined = NO;
+                loggerNode->_droppedMessages = 0;
+            }
+        }
+    } });
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Notifications
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -247,9 +391,23 @@ static NSUInteger _numProcessors;
     if (!logger) {
         return;
     }
-    
+
+    // Extend the loggers level right away (the logger itself is added asynchronously),
+    // so the block based macros don't drop messages logged right after this call.
+
+    OSAtomicIncrement32Barrier(&_numPendingAdditions);
+
+    DDLogLevel oldLevel;
+
+    do {
+        oldLevel = *_loggersLevel;
+    } while (!OSAtomicCompareAndSwapLongBarrier((long)oldLevel, (long)(oldLevel | level), (volatile long *)_loggersLevel));
+
     dispatch_async(_loggingQueue, ^{ @autoreleasepool {
         [self lt_addLogger:logger level:level];
+
+        OSAtomicDecrement32Barrier(&self->_numPendingAdditions);
+        [self lt_updateLoggersLevel];
     } });
 }
 
@@ -277,6 +435,14 @@ static NSUInteger _numProcessors;
     } });
 }
 
++ (DDLogLevel)loggersLevel {
+    return [self.sharedInstance loggersLevel];
+}
+
+- (DDLogLevel)loggersLevel {
+    return *_loggersLevel;
+}
+
 + (NSArray *)allLoggers {
     return [self.sharedInstance allLoggers];
 }
@@ -309,6 +475,27 @@ static NSUInteger _numProcessors;
 #pragma mark - Master Logging
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Takes a slot in the logging queue (see queueLogMessage:asynchronously:), given back by lt_log:.
+ **/
+static void DDLogWaitForQueueSlot(void) {
+    if (DDLogMetricsActive) {
+        // Only a statement that has to wait reads the clock
+        if (dispatch_semaphore_wait(_queueSemaphore, DISPATCH_TIME_NOW) != 0) {
+            uint64_t blockedSince = DDLogMetricsNow();
+
+            dispatch_semaphore_wait(_queueSemaphore, DISPATCH_TIME_FOREVER);
+
+            DDLogMetricsAdd(DDLogMetricsCounterProducerBlocks, 1);
+            DDLogMetricsAdd(DDLogMetricsCounterProducerBlockNanoseconds, (int64_t)(DDLogMetricsNow() - blockedSince));
+        }
+
+        DDLogMetricsAdd(DDLogMetricsCounterMessagesEnqueued, 1);
+    } else {
+        dispatch_semaphore_wait(_queueSemaphore, DISPATCH_TIME_FOREVER);
+    }
+}
+
 - (void)queueLogMessage:(DDLogMessage *)logMessage asynchronously:(BOOL)asyncFlag {
     // We have a tricky situation here...
     //
@@ -348,7 +535,11 @@ static NSUInteger _numProcessors;
     // Dispatch semaphores call down to the kernel only when the calling thread needs to be blocked.
     // If the calling semaphore does not need to block, no kernel call is made.
 
-    dispatch_semaphore_wait(_queueSemaphore, DISPATCH_TIME_FOREVER);
+    DDLogWaitForQueueSlot();
+
+    #if DD_LOG_TRACE_ENABLED
+    logMessage->_traceTimestamps[DDLogTraceStageEnqueued] = DDLogTraceNow();
+    #endif
 
     // We've now sure we won't overflow the queue.
     // It is time to queue our log message.
@@ -380,7 +571,11 @@ static NSUInteger _numProcessors;
     if (format) {
         va_start(args, format);
         
-        NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
+        if (DDLogCallSiteProfilerActive) {
+            DDLogCallSiteProfilerBeginStatement();
+        }
+
+        NSString *message = DDLogFormatString(format, args);
         [self log:asynchronous
           message:message
             level:level
@@ -409,7 +604,11 @@ static NSUInteger _numProcessors;
     if (format) {
         va_start(args, format);
         
-        NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
+        if (DDLogCallSiteProfilerActive) {
+            DDLogCallSiteProfilerBeginStatement();
+        }
+
+        NSString *message = DDLogFormatString(format, args);
         [self log:asynchronous
           message:message
             level:level
@@ -448,7 +647,11 @@ static NSUInteger _numProcessors;
      format:(NSString *)format
        args:(va_list)args {
     if (format) {
-        NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
+        if (DDLogCallSiteProfilerActive) {
+            DDLogCallSiteProfilerBeginStatement();
+        }
+
+        NSString *message = DDLogFormatString(format, args);
         [self log:asynchronous
           message:message
             level:level
@@ -482,18 +685,294 @@ static NSUInteger _numProcessors;
    function:(const char *)function
        line:(NSUInteger)line
         tag:(id)tag {
-    DDLogMessage *logMessage = [[DDLogMessage alloc] initWithMessage:message
-                                                               level:level
-                                                                flag:flag
-                                                             context:context
-                                                                file:[NSString stringWithFormat:@"%s", file]
-                                                            function:[NSString stringWithFormat:@"%s", function]
-                                                                line:line
-                                                                 tag:tag
-                                                             options:(DDLogMessageOptions)0
-                                                           timestamp:nil];
+    [self log:asynchronous message:message level:level flag:flag context:context file:file function:function line:line tag:tag messageRenderer:nil staticStrings:NO];
+}
+
++ (void)log:(BOOL)asynchronous
+        message:(NSString *)message
+          level:(DDLogLevel)level
+           flag:(DDLogFlag)flag
+        context:(NSInteger)context
+     staticFile:(const char *)file
+ staticFunction:(const char *)function
+           line:(NSUInteger)line
+            tag:(id)tag {
+    [self.sharedInstance log:asynchronous message:message level:level flag:flag context:context file:file function:function line:line tag:tag messageRenderer:nil staticStrings:YES];
+}
+
+- (void)log:(BOOL)asynchronous
+        message:(NSString *)message
+          level:(DDLogLevel)level
+           flag:(DDLogFlag)flag
+        context:(NSInteger)context
+     staticFile:(const char *)file
+ staticFunction:(const char *)function
+           line:(NSUInteger)line
+            tag:(id)tag {
+    [self log:asynchronous message:message level:level flag:flag context:context file:file function:function line:line tag:tag messageRenderer:nil staticStrings:YES];
+}
+
+/**
+ * Wraps a C string that is never deallocated, without copying it.
+ **/
+static NSString * DDLogStaticString(const char *string) {
+    if (string == NULL) {
+        return nil;
+    }
+
+    return [[NSString alloc] initWithBytesNoCopy:(void *)string
+                                          length:strlen(string)
+                                        encoding:NSUTF8StringEncoding
+                                    freeWhenDone:NO];
+}
+
++ (void)log:(BOOL)asynchronous
+          level:(DDLogLevel)level
+           flag:(DDLogFlag)flag
+        context:(NSInteger)context
+     staticFile:(const char *)file
+ staticFunction:(const char *)function
+           line:(NSUInteger)line
+            tag:(id)tag
+messageRenderer:(DDLogMessageBlock)messageRenderer {
+    [self.sharedInstance log:asynchronous level:level flag:flag context:context staticFile:file staticFunction:function line:line tag:tag messageRenderer:messageRenderer];
+}
+
+- (void)log:(BOOL)asynchronous
+          level:(DDLogLevel)level
+           flag:(DDLogFlag)flag
+        context:(NSInteger)context
+     staticFile:(const char *)file
+ staticFunction:(const char *)function
+           line:(NSUInteger)line
+            tag:(id)tag
+messageRenderer:(DDLogMessageBlock)messageRenderer {
+    if (!messageRenderer || !(flag & *_loggersLevel)) {
+        return;
+    }
+
+    [self log:asynchronous message:nil level:level flag:flag context:context file:file function:function line:line tag:tag messageRenderer:messageRenderer staticStrings:YES];
+}
+
+/**
+ * Runs on the logging queue: renders the message of a record (see below) and logs it.
+ **/
+static void DDLogDequeueRecord(void *context) {
+    @autoreleasepool {
+        DDLogRecord *record = context;
+        DDLog *log = (__bridge_transfer DDLog *)record->log;
+
+        BOOL render = (record->flag & *log->_loggersLevel) != 0;
+        NSString *message = record->renderer(record->callSite, DDLogRecordArguments(record), render);
+
+        DDLogMessage *logMessage = [[DDLogMessage alloc] initWithRecord:record message:(render ? ([message copy] ?: @"") : nil)];
+        free(record);
+
+        [log lt_log:logMessage];
+    }
+}
+
++ (void)log:(BOOL)asynchronous
+      level:(DDLogLevel)level
+       flag:(DDLogFlag)flag
+    context:(NSInteger)context
+   callSite:(const DDLogCallSite *)callSite
+  arguments:(const void *)arguments
+     length:(size_t)length
+   renderer:(DDLogRecordRenderer)renderer {
+    [self.sharedInstance log:asynchronous level:level flag:flag context:context callSite:callSite arguments:arguments length:length renderer:renderer];
+}
+
+- (void)log:(BOOL)asynchronous
+      level:(DDLogLevel)level
+       flag:(DDLogFlag)flag
+    context:(NSInteger)context
+   callSite:(const DDLogCallSite *)callSite
+  arguments:(const void *)arguments
+     length:(size_t)length
+   renderer:(DDLogRecordRenderer)renderer {
+    if (!(flag & *_loggersLevel)) {
+        // Nobody would take it, the renderer only releases what the arguments hold
+        renderer(callSite, arguments, NO);
+        return;
+    }
+
+    BOOL profiling = DDLogCallSiteProfilerActive;
+
+    if (profiling) {
+        DDLogCallSiteProfilerBeginStatement();
+    }
+
+    if (context == 0) {
+        context = DDLogScopeCurrentContext();
+    }
+
+    // Everything the message needs from the calling thread goes into a single allocation
+    const char *queueLabel = DDLogCurrentQueueLabel();
+    size_t queueLabelLength = strlen(queueLabel);
+    DDLogRecord *record = malloc(sizeof(DDLogRecord) + length + queueLabelLength + 1);
+
+    if (record == NULL) {
+        // Dropped, as if nobody took it
+        if (profiling) {
+            DDLogCallSiteProfilerCancelStatement();
+        }
+
+        renderer(callSite, arguments, NO);
+        return;
+    }
+
+    #if DD_LOG_TRACE_ENABLED
+    record->traceCreated = DDLogTraceNow();
+    #endif
+
+    record->log = (__bridge_retained void *)self;
+    record->level = level;
+    record->flag = flag;
+    record->context = context;
+    record->callSite = callSite;
+    record->renderer = renderer;
+    record->timestamp = _clock ? [[_clock now] timeIntervalSinceReferenceDate] : CFAbsoluteTimeGetCurrent();
+    record->threadID = DDLogCurrentThreadID();
+    record->length = length;
+
+    if (pthread_getname_np(pthread_self(), record->threadName, sizeof(record->threadName)) != 0) {
+        record->threadName[0] = '\0';
+    }
+
+    memcpy(DDLogRecordArguments(record), arguments, length);
+    memcpy(DDLogRecordQueueLabel(record), queueLabel, queueLabelLength + 1);
+
+    DDLogWaitForQueueSlot();
+
+    #if DD_LOG_TRACE_ENABLED
+    record->traceEnqueued = DDLogTraceNow();
+    #endif
+
+    if (asynchronous) {
+        dispatch_async_f(_loggingQueue, record, DDLogDequeueRecord);
+    } else {
+        dispatch_sync_f(_loggingQueue, record, DDLogDequeueRecord);
+    }
+
+    if (profiling) {
+        // The message doesn't exist yet, so no bytes are counted
+        DDLogCallSiteProfilerEndStatement(callSite->file, callSite->function, callSite->line, nil, YES);
+    }
+}
+
+/**
+ * The message is either given, or rendered later by the renderer (see lt_log:).
+ **/
+- (void)log:(BOOL)asynchronous
+        message:(NSString *)message
+          level:(DDLogLevel)level
+           flag:(DDLogFlag)flag
+        context:(NSInteger)context
+           file:(const char *)file
+       function:(const char *)function
+           line:(NSUInteger)line
+            tag:(id)tag
+messageRenderer:(DDLogMessageBlock)messageRenderer
+  staticStrings:(BOOL)staticStrings {
+    BOOL profiling = DDLogCallSiteProfilerActive;
+
+    if (profiling) {
+        DDLogCallSiteProfilerBeginStatement();
+    }
+
+    if (context == 0) {
+        // Messages without a context of their own pick up the context of the current scope (if any)
+        context = DDLogScopeCurrentContext();
+    }
+
+    DDLogStringID fileID = staticStrings ? DDLogStringTableInternStatic(file) : DDLogStringTableIntern(file, file ? strlen(file) : 0);
+    DDLogStringID functionID = staticStrings ? DDLogStringTableInternStatic(function) : DDLogStringTableIntern(function, function ? strlen(function) : 0);
+    DDLogMessage *logMessage;
+
+    if (fileID && functionID) {
+        logMessage = [[DDLogMessage alloc] initWithMessage:message
+                                                     level:level
+                                                      flag:flag
+                                                   context:context
+                                                    fileID:fileID
+                                                functionID:functionID
+                                                      line:line
+                                                       tag:tag];
+    } else {
+        // The intern table is full (or a string is missing)
+        NSString *fileString = staticStrings ? DDLogStaticString(file) : [NSString stringWithFormat:@"%s", file];
+        NSString *functionString = staticStrings ? DDLogStaticString(function) : [NSString stringWithFormat:@"%s", function];
+
+        logMessage = [[DDLogMessage alloc] initWithMessage:message
+                                                     level:level
+                                                      flag:flag
+                                                   context:context
+                                                      file:fileString
+                                                  function:functionString
+                                                      line:line
+                                                       tag:tag
+                                                   options:(DDLogMessageOptions)0
+                                                 timestamp:nil];
+    }
+
+    if (messageRenderer) {
+        logMessage->_messageRenderer = [messageRenderer copy];
+    }
     
     [self queueLogMessage:logMessage asynchronously:asynchronous];
+
+    if (profiling) {
+        DDLogCallSiteProfilerEndStatement(file, function, line, message, staticStrings);
+    }
+}
+
++ (void)log:(BOOL)asynchronous
+        level:(DDLogLevel)level
+         flag:(DDLogFlag)flag
+      context:(NSInteger)context
+         file:(const char *)file
+     function:(const char *)function
+         line:(NSUInteger)line
+          tag:(id)tag
+ messageBlock:(DDLogMessageBlock)messageBlock {
+    [self.sharedInstance log:asynchronous level:level flag:flag context:context file:file function:function line:line tag:tag messageBlock:messageBlock];
+}
+
+- (void)log:(BOOL)asynchronous
+        level:(DDLogLevel)level
+         flag:(DDLogFlag)flag
+      context:(NSInteger)context
+         file:(const char *)file
+     function:(const char *)function
+         line:(NSUInteger)line
+          tag:(id)tag
+ messageBlock:(DDLogMessageBlock)messageBlock {
+    if (!messageBlock || !(flag & *_loggersLevel)) {
+        return;
+    }
+
+    BOOL profiling = DDLogCallSiteProfilerActive;
+
+    if (profiling) {
+        DDLogCallSiteProfilerBeginStatement();
+    }
+
+    NSString *message = messageBlock();
+
+    if (message) {
+        [self log:asynchronous
+          message:message
+            level:level
+             flag:flag
+          context:context
+             file:file
+         function:function
+             line:line
+              tag:tag];
+    } else if (profiling) {
+        DDLogCallSiteProfilerCancelStatement();
+    }
 }
 
 + (void)log:(BOOL)asynchronous
@@ -582,7 +1061,28 @@ static NSUInteger _numProcessors;
 #endif /* if TARGET_OS_IPHONE && !TARGET_OS_SIMULATOR */
 }
 
-+ (NSArray *)registeredClasses {
+// The registry of classes using registered dynamic logging, indexed by class name.
+//
+// Scanning every class of the process (objc_getClassList) is expensive with tens of thousands of classes,
+// so the registry is built once and then maintained incrementally:
+// dyld tells us about every image (at registration for the ones already loaded, and later as they get loaded),
+// and the classes of these images are scanned lazily, on the next access to the registry.
+//
+// The dyld callback runs with the dyld lock held, so it only records the image header (under its own spin lock).
+// Scanning (dladdr, objc_copyClassNamesForImage) happens outside of that spin lock.
+//
+// Classes created at runtime (objc_allocateClassPair, KVO) belong to no image, so dyld never reports them.
+// Listing all the registered classes compares the number of classes of the process with the number accounted for,
+// and when they differ, only checks the classes that weren't accounted for yet.
+
+static NSMutableDictionary *_registeredClassesByName;
+static pthread_mutex_t _registryMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// The classes of the process the registry has seen, by pointer (classes aren't retained)
+static CFMutableSetRef _accountedClasses;
+
+// Returns a malloc'ed list of all the classes of the process, or NULL
+static Class * DDLogCopyClassList(NSUInteger *outCount) {
 
     // We're going to get the list of all registered classes.
     // The Objective-C runtime library automatically registers all the classes defined in your source code.
@@ -609,7 +1109,7 @@ static NSUInteger _numProcessors;
 
         classes = numClasses ? (Class *)malloc(sizeof(Class) * bufferSize) : NULL;
         if (classes == NULL) {
-            return nil; //no memory or classes?
+            return NULL; //no memory or classes?
         }
 
         numClasses = (NSUInteger)MAX(objc_getClassList(classes, (int)bufferSize),0);
@@ -621,30 +1121,220 @@ static NSUInteger _numProcessors;
         }
     }
 
-    // We can now loop through the classes, and test each one to see if it is a DDLogging class.
+    *outCount = numClasses;
 
-    NSMutableArray *result = [NSMutableArray arrayWithCapacity:numClasses];
+    return classes;
+}
+
+#if DD_HAS_DYLD_IMAGE_NOTIFICATIONS
+
+static const struct mach_header **_pendingImages;
+static NSUInteger _numPendingImages;
+static NSUInteger _pendingImagesCapacity;
+static OSSpinLock _pendingImagesLock = OS_SPINLOCK_INIT;
+
+static void DDLogImageAdded(const struct mach_header *header, intptr_t __attribute__((unused)) slide) {
+    OSSpinLockLock(&_pendingImagesLock);
+
+    if (_numPendingImages == _pendingImagesCapacity) {
+        NSUInteger newCapacity = MAX(_pendingImagesCapacity * 2, 64);
+        const struct mach_header **newImages = realloc(_pendingImages, newCapacity * sizeof(*_pendingImages));
+
+        if (newImages) {
+            _pendingImages = newImages;
+            _pendingImagesCapacity = newCapacity;
+        }
+    }
+
+    if (_numPendingImages < _pendingImagesCapacity) {
+        _pendingImages[_numPendingImages++] = header;
+    }
+
+    OSSpinLockUnlock(&_pendingImagesLock);
+}
+
+#endif /* if DD_HAS_DYLD_IMAGE_NOTIFICATIONS */
+
+// Must be called with _registryMutex held
++ (void)lockedUpdateRegistry {
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        _registeredClassesByName = [[NSMutableDictionary alloc] init];
+        _accountedClasses = CFSetCreateMutable(NULL, 0, NULL);
+
+#if DD_HAS_DYLD_IMAGE_NOTIFICATIONS
+        // Invokes the callback for every image already loaded, then for each image loaded later on
+        _dyld_register_func_for_add_image(DDLogImageAdded);
+#else
+        // Every class is unaccounted for
+        [self lockedUpdateRegistryWithUnaccountedClasses];
+#endif
+    });
+
+#if DD_HAS_DYLD_IMAGE_NOTIFICATIONS
+
+    if (_numPendingImages == 0) {
+        return;
+    }
+
+    OSSpinLockLock(&_pendingImagesLock);
+
+    const struct mach_header **images = _pendingImages;
+    NSUInteger numImages = _numPendingImages;
+
+    _pendingImages = NULL;
+    _numPendingImages = 0;
+    _pendingImagesCapacity = 0;
+
+    OSSpinLockUnlock(&_pendingImagesLock);
+
+    for (NSUInteger i = 0; i < numImages; i++) {
+        Dl_info info;
+
+        if (dladdr(images[i], &info) == 0 || info.dli_fname == NULL) {
+            continue;
+        }
+
+        unsigned int numClassNames = 0;
+        const char **classNames = objc_copyClassNamesForImage(info.dli_fname, &numClassNames);
+
+        for (unsigned int j = 0; j < numClassNames; j++) {
+            Class class = objc_getClass(classNames[j]);
+
+            if (class == Nil || CFSetContainsValue(_accountedClasses, (__bridge const void *)class)) {
+                continue;
+            }
+
+            CFSetAddValue(_accountedClasses, (__bridge const void *)class);
+
+            if ([self isRegisteredClass:class]) {
+                _registeredClassesByName[@(classNames[j])] = class;
+            }
+        }
+
+        free(classNames);
+    }
+
+    free(images);
+
+#endif /* if DD_HAS_DYLD_IMAGE_NOTIFICATIONS */
+}
+
+// Must be called with _registryMutex held, after lockedUpdateRegistry
++ (void)lockedUpdateRegistryWithUnaccountedClasses {
+    // Only counts: no class is listed unless the count changed
+    if (objc_getClassList(NULL, 0) == (int)CFSetGetCount(_accountedClasses)) {
+        return;
+    }
+
+    NSUInteger numClasses = 0;
+    Class *classes = DDLogCopyClassList(&numClasses);
+
+    if (classes == NULL) {
+        return;
+    }
+
+    // Rebuilt from the list, so classes that were disposed of go away. Only the new ones are checked.
+    CFMutableSetRef accountedClasses = CFSetCreateMutable(NULL, (CFIndex)numClasses, NULL);
 
     for (NSUInteger i = 0; i < numClasses; i++) {
         Class class = classes[i];
 
-        if ([self isRegisteredClass:class]) {
-            [result addObject:class];
+        CFSetAddValue(accountedClasses, (__bridge const void *)class);
+
+        if (!CFSetContainsValue(_accountedClasses, (__bridge const void *)class) && [self isRegisteredClass:class]) {
+            _registeredClassesByName[NSStringFromClass(class)] = class;
         }
     }
 
     free(classes);
 
+    CFRelease(_accountedClasses);
+    _accountedClasses = accountedClasses;
+
+    for (NSString *className in [_registeredClassesByName allKeys]) {
+        if (!CFSetContainsValue(_accountedClasses, (__bridge const void *)_registeredClassesByName[className])) {
+            [_registeredClassesByName removeObjectForKey:className];
+        }
+    }
+}
+
++ (NSArray *)registeredClasses {
+    pthread_mutex_lock(&_registryMutex);
+
+    [self lockedUpdateRegistry];
+    [self lockedUpdateRegistryWithUnaccountedClasses];
+    NSArray *result = [_registeredClassesByName allValues];
+
+    pthread_mutex_unlock(&_registryMutex);
+
     return result;
 }
 
 + (NSArray *)registeredClassNames {
-    NSArray *registeredClasses = [self registeredClasses];
-    NSMutableArray *result = [NSMutableArray arrayWithCapacity:[registeredClasses count]];
+    pthread_mutex_lock(&_registryMutex);
+
+    [self lockedUpdateRegistry];
+    [self lockedUpdateRegistryWithUnaccountedClasses];
+    NSArray *result = [_registeredClassesByName allKeys];
+
+    pthread_mutex_unlock(&_registryMutex);
+
+    return result;
+}
 
-    for (Class class in registeredClasses) {
-        [result addObject:NSStringFromClass(class)];
++ (Class)registeredClassWithName:(NSString *)aClassName {
+    if (aClassName == nil) {
+        return Nil;
     }
+
+    pthread_mutex_lock(&_registryMutex);
+
+    [self lockedUpdateRegistry];
+    Class aClass = _registeredClassesByName[aClassName];
+
+    if (aClass == Nil) {
+        // Not part of the registry, which happens for classes created at runtime,
+        // or whose ddLogLevel methods come from a category in another image.
+        // Check this single class the slow way, and remember it.
+
+        aClass = NSClassFromString(aClassName);
+
+        if (aClass && [self isRegisteredClass:aClass]) {
+            _registeredClassesByName[aClassName] = aClass;
+        } else {
+            aClass = Nil;
+        }
+    }
+
+    pthread_mutex_unlock(&_registryMutex);
+
+    return aClass;
+}
+
++ (NSArray *)registeredClassesByScanningAllClasses {
+    NSUInteger numClasses = 0;
+    Class *classes = DDLogCopyClassList(&numClasses);
+
+    if (classes == NULL) {
+        return nil; //no memory or classes?
+    }
+
+    // We can now loop through the classes, and test each one to see if it is a DDLogging class.
+
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:numClasses];
+
+    for (NSUInteger i = 0; i < numClasses; i++) {
+        Class class = classes[i];
+
+        if ([self isRegisteredClass:class]) {
+            [result addObject:class];
+        }
+    }
+
+    free(classes);
+
     return result;
 }
 
@@ -656,9 +1346,9 @@ static NSUInteger _numProcessors;
 }
 
 + (DDLogLevel)levelForClassWithName:(NSString *)aClassName {
-    Class aClass = NSClassFromString(aClassName);
+    Class aClass = [self registeredClassWithName:aClassName];
 
-    return [self levelForClass:aClass];
+    return aClass ? [aClass ddLogLevel] : (DDLogLevel)-1;
 }
 
 + (void)setLevel:(DDLogLevel)level forClass:(Class)aClass {
@@ -668,8 +1358,7 @@ static NSUInteger _numProcessors;
 }
 
 + (void)setLevel:(DDLogLevel)level forClassWithName:(NSString *)aClassName {
-    Class aClass = NSClassFromString(aClassName);
-    [self setLevel:level forClass:aClass];
+    [[self registeredClassWithName:aClassName] ddSetLogLevel:level];
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -751,6 +1440,8 @@ static NSUInteger _numProcessors;
     
     // Remove from loggers array
     [self._loggers removeObject:loggerNode];
+
+    [self lt_updateLoggersLevel];
 }
 
 - (void)lt_removeAllLoggers {
@@ -769,6 +1460,29 @@ static NSUInteger _numProcessors;
     // Remove all loggers from array
 
     [self._loggers removeAllObjects];
+
+    [self lt_updateLoggersLevel];
+}
+
+- (void)lt_updateLoggersLevel {
+    NSAssert(dispatch_get_specific(GlobalLoggingQueueIdentityKey),
+             @"This method should only be run on the logging thread/queue");
+
+    DDLogLevel level = DDLogLevelOff;
+
+    for (DDLoggerNode *loggerNode in self._loggers) {
+        level |= loggerNode->_level;
+    }
+
+    // While an addLogger call is still pending, its level has already been added eagerly: don't take it away.
+    // The pending counter is bumped before that eager update, so the CAS below catches any update we raced with.
+
+    DDLogLevel oldLevel, newLevel;
+
+    do {
+        oldLevel = *_loggersLevel;
+        newLevel = (_numPendingAdditions > 0) ? (oldLevel | level) : level;
+    } while (!OSAtomicCompareAndSwapLongBarrier((long)oldLevel, (long)newLevel, (volatile long *)_loggersLevel));
 }
 
 - (NSArray *)lt_allLoggers {
@@ -804,13 +1518,37 @@ static NSUInteger _numProcessors;
     NSAssert(dispatch_get_specific(GlobalLoggingQueueIdentityKey),
              @"This method should only be run on the logging thread/queue");
 
-    if (_numProcessors > 1) {
+    #if DD_LOG_TRACE_ENABLED
+    logMessage->_traceTimestamps[DDLogTraceStageDequeued] = DDLogTraceNow();
+    #endif
+
+    BOOL metricsActive = DDLogMetricsActive;
+
+    if (metricsActive) {
+        DDLogMetricsAdd(DDLogMetricsCounterMessagesDequeued, 1);
+    }
+
+    if (logMessage->_messageRenderer) {
+        // Deferred messages are rendered once, here, for all loggers (not at all if none of them takes the message)
+        DDLogMessageBlock renderer = logMessage->_messageRenderer;
+        logMessage->_messageRenderer = nil;
+
+        if (logMessage->_flag & *_loggersLevel) {
+            logMessage->_message = [renderer() copy] ?: @"";
+        }
+    }
+
+    DDLogWatchdog *watchdog = _watchdog;
+
+    if (_numProcessors > 1 || watchdog) {
         // Execute each logger concurrently, each within its own queue.
         // All blocks are added to same group.
         // After each block has been queued, wait on group.
         //
         // The waiting ensures that a slow logger doesn't end up with a large queue of pending log messages.
         // This would defeat the purpose of the efforts we made earlier to restrict the max queue size.
+        //
+        // With a watchdog, the wait is also where stalled loggers are detected (and possibly left behind).
 
         for (DDLoggerNode *loggerNode in self._loggers) {
             // skip the loggers that shouldn't write this message based on the log level
@@ -818,13 +1556,41 @@ static NSUInteger _numProcessors;
             if (!(logMessage->_flag & loggerNode->_level)) {
                 continue;
             }
-            
-            dispatch_group_async(_loggingGroup, loggerNode->_loggerQueue, ^{ @autoreleasepool {
+
+            DDLogMetricsLoggerCounters *metrics = metricsActive ? [self lt_metricsForLoggerNode:loggerNode] : NULL;
+
+            dispatch_block_t logBlock = ^{ @autoreleasepool {
+                #if DD_LOG_TRACE_ENABLED
+                DDLogTraceLoggerBegin(loggerNode->_logger, logMessage->_traceSequence, logMessage->_traceTimestamps);
+                #endif
+
+                uint64_t writeStart = metrics ? DDLogMetricsNow() : 0;
+
                 [loggerNode->_logger logMessage:logMessage];
-            } });
+
+                if (metrics) {
+                    DDLogMetricsRecordLoggerWrite(metrics, DDLogMetricsNow() - writeStart);
+                }
+
+                #if DD_LOG_TRACE_ENABLED
+                DDLogTraceLoggerEnd();
+                #endif
+            } };
+
+            if (watchdog) {
+                if ([self lt_watchdog:watchdog admitsLoggerNode:loggerNode]) {
+                    [self lt_dispatchWatchedBlock:logBlock toLoggerNode:loggerNode];
+                }
+            } else {
+                dispatch_group_async(_loggingGroup, loggerNode->_loggerQueue, logBlock);
+            }
+        }
+
+        if (watchdog) {
+            [self lt_waitForLoggersWithWatchdog:watchdog];
+        } else {
+            dispatch_group_wait(_loggingGroup, DISPATCH_TIME_FOREVER);
         }
-        
-        dispatch_group_wait(_loggingGroup, DISPATCH_TIME_FOREVER);
     } else {
         // Execute each logger serialy, each within its own queue.
         
@@ -835,8 +1601,24 @@ static NSUInteger _numProcessors;
                 continue;
             }
             
+            DDLogMetricsLoggerCounters *metrics = metricsActive ? [self lt_metricsForLoggerNode:loggerNode] : NULL;
+
             dispatch_sync(loggerNode->_loggerQueue, ^{ @autoreleasepool {
+                #if DD_LOG_TRACE_ENABLED
+                DDLogTraceLoggerBegin(loggerNode->_logger, logMessage->_traceSequence, logMessage->_traceTimestamps);
+                #endif
+
+                uint64_t writeStart = metrics ? DDLogMetricsNow() : 0;
+
                 [loggerNode->_logger logMessage:logMessage];
+
+                if (metrics) {
+                    DDLogMetricsRecordLoggerWrite(metrics, DDLogMetricsNow() - writeStart);
+                }
+
+                #if DD_LOG_TRACE_ENABLED
+                DDLogTraceLoggerEnd();
+                #endif
             } });
         }
     }
@@ -858,6 +1640,14 @@ static NSUInteger _numProcessors;
     dispatch_semaphore_signal(_queueSemaphore);
 }
 
+- (DDLogMetricsLoggerCounters *)lt_metricsForLoggerNode:(DDLoggerNode *)loggerNode {
+    if (loggerNode->_metrics == NULL) {
+        loggerNode->_metrics = DDLogMetricsCountersForLogger(loggerNode->_logger);
+    }
+
+    return loggerNode->_metrics;
+}
+
 - (void)lt_flush {
     // All log statements issued before the flush method was invoked have now been executed.
     //
@@ -867,15 +1657,133 @@ static NSUInteger _numProcessors;
     NSAssert(dispatch_get_specific(GlobalLoggingQueueIdentityKey),
              @"This method should only be run on the logging thread/queue");
     
+    DDLogWatchdog *watchdog = _watchdog;
+
     for (DDLoggerNode *loggerNode in self._loggers) {
         if ([loggerNode->_logger respondsToSelector:@selector(flush)]) {
-            dispatch_group_async(_loggingGroup, loggerNode->_loggerQueue, ^{ @autoreleasepool {
+            dispatch_block_t flushBlock = ^{ @autoreleasepool {
                 [loggerNode->_logger flush];
-            } });
+            } };
+
+            if (watchdog) {
+                // A quarantined logger is still busy with its stalled message
+                if (!loggerNode->_quarantined) {
+                    [self lt_dispatchWatchedBlock:flushBlock toLoggerNode:loggerNode];
+                }
+            } else {
+                dispatch_group_async(_loggingGroup, loggerNode->_loggerQueue, flushBlock);
+            }
+        }
+    }
+
+    if (watchdog) {
+        [self lt_waitForLoggersWithWatchdog:watchdog];
+    } else {
+        dispatch_group_wait(_loggingGroup, DISPATCH_TIME_FOREVER);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Watchdog
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t DDLogWatchdogNow(void) {
+    static mach_timebase_info_data_t timebase;
+
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+}
+
+/**
+ * Whether a logger gets the next message. A quarantined logger gets it again once it returned from the stalled one.
+ **/
+- (BOOL)lt_watchdog:(DDLogWatchdog *)watchdog admitsLoggerNode:(DDLoggerNode *)loggerNode {
+    if (!loggerNode->_quarantined) {
+        return YES;
+    }
+
+    if (loggerNode->_busySince != 0) {
+        loggerNode->_droppedMessages++;
+        [watchdog loggerDidDropMessage:loggerNode->_logger];
+        DDLogMetricsAdd(DDLogMetricsCounterMessagesDropped, 1);
+
+        return NO;
+    }
+
+    NSUInteger droppedMessages = loggerNode->_droppedMessages;
+
+    loggerNode->_quarantined = NO;
+    loggerNode->_droppedMessages = 0;
+
+    [watchdog loggerDidRecover:loggerNode->_logger droppedMessages:droppedMessages];
+
+    return YES;
+}
+
+/**
+ * Like dispatch_group_async on the logging group, with the bookkeeping the watchdog needs.
+ **/
+- (void)lt_dispatchWatchedBlock:(dispatch_block_t)block toLoggerNode:(DDLoggerNode *)loggerNode {
+    dispatch_group_t group = _loggingGroup;
+
+    loggerNode->_stallReported = NO;
+    loggerNode->_groupEntered = 1;
+    loggerNode->_busySince = DDLogWatchdogNow();
+
+    dispatch_group_enter(group);
+
+    dispatch_async(loggerNode->_loggerQueue, ^{
+        block();
+
+        // Not busy anymore before leaving the group: once it is left, the logging queue may hand over the next message
+        // and set _busySince again, which a late clear would wipe out
+        loggerNode->_busySince = 0;
+        OSMemoryBarrier();
+
+        // Leave the group, unless the watchdog already did so when it quarantined the logger
+        if (OSAtomicCompareAndSwap32Barrier(1, 0, &loggerNode->_groupEntered)) {
+            dispatch_group_leave(group);
+        }
+    });
+}
+
+/**
+ * dispatch_group_wait on the logging group, checking for stalled loggers every quarter of the threshold.
+ **/
+- (void)lt_waitForLoggersWithWatchdog:(DDLogWatchdog *)watchdog {
+    uint64_t threshold = (uint64_t)(MAX(watchdog.stallThreshold, 0.001) * NSEC_PER_SEC);
+    int64_t checkInterval = (int64_t)MAX(threshold / 4, NSEC_PER_MSEC);
+
+    while (dispatch_group_wait(_loggingGroup, dispatch_time(DISPATCH_TIME_NOW, checkInterval)) != 0) {
+        uint64_t now = DDLogWatchdogNow();
+
+        for (DDLoggerNode *loggerNode in self._loggers) {
+            uint64_t busySince = loggerNode->_busySince;
+
+            if (busySince == 0 || loggerNode->_stallReported || now < busySince + threshold) {
+                continue;
+            }
+
+            loggerNode->_stallReported = YES;
+
+            BOOL quarantined = NO;
+
+            if (watchdog.quarantinesStalledLoggers && OSAtomicCompareAndSwap32Barrier(1, 0, &loggerNode->_groupEntered)) {
+                // Stop waiting for it: the stalled block won't leave the group anymore
+                loggerNode->_quarantined = YES;
+                quarantined = YES;
+
+                dispatch_group_leave(_loggingGroup);
+            }
+
+            [watchdog loggerDidStall:loggerNode->_logger
+                            duration:(double)(now - busySince) / NSEC_PER_SEC
+                         quarantined:quarantined];
         }
     }
-    
-    dispatch_group_wait(_loggingGroup, DISPATCH_TIME_FOREVER);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1065,6 +1973,144 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy) {
 
 #endif /* if TARGET_OS_IOS */
 
+static uint64_t DDLogCurrentThreadID(void) {
+    if (USE_PTHREAD_THREADID_NP) {
+        __uint64_t tid;
+        pthread_threadid_np(NULL, &tid);
+        return tid;
+    } else {
+        return pthread_mach_thread_np(pthread_self());
+    }
+}
+
+static NSString * DDLogThreadIDString(uint64_t threadID) {
+    if (USE_PTHREAD_THREADID_NP) {
+        // Every message needs one, so don't go through the format parser
+        char digits[DD_LOG_INTEGER_MAX_LENGTH];
+        size_t length = DDLogFormatUnsignedInteger(digits, threadID);
+        return [[NSString alloc] initWithBytes:digits length:length encoding:NSASCIIStringEncoding];
+    } else {
+        return [[NSString alloc] initWithFormat:@"%x", (unsigned int)threadID];
+    }
+}
+
+static const char * DDLogCurrentQueueLabel(void) {
+    // Try to get the current queue's label
+    if (USE_DISPATCH_CURRENT_QUEUE_LABEL) {
+        return dispatch_queue_get_label(DISPATCH_CURRENT_QUEUE_LABEL);
+    } else if (USE_DISPATCH_GET_CURRENT_QUEUE) {
+        #pragma clang diagnostic push
+        #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+        dispatch_queue_t currentQueue = dispatch_get_current_queue();
+        #pragma clang diagnostic pop
+        return dispatch_queue_get_label(currentQueue);
+    } else {
+        return ""; // iOS 6.x only
+    }
+}
+
+// Get the file name without extension
+static NSString * DDLogFileNameWithoutExtension(NSString *file) {
+    NSString *fileName = [file lastPathComponent];
+    NSUInteger dotLocation = [fileName rangeOfString:@"." options:NSBackwardsSearch].location;
+    if (dotLocation != NSNotFound)
+    {
+        fileName = [fileName substringToIndex:dotLocation];
+    }
+    return fileName;
+}
+
+// Same as DDLogFileNameWithoutExtension, on the bytes of an interned file, and interned too
+static NSString * DDLogInternedFileNameWithoutExtension(DDLogStringID fileID) {
+    size_t length = 0;
+    const char *file = DDLogStringTableUTF8(fileID, &length);
+    const char *start = file + length;
+    const char *end = file + length;
+
+    while (start > file && start[-1] != '/') {
+        start--;
+    }
+
+    for (const char *dot = end; dot > start; dot--) {
+        if (dot[-1] == '.') {
+            end = dot - 1;
+            break;
+        }
+    }
+
+    DDLogStringID fileNameID = DDLogStringTableIntern(start, (size_t)(end - start));
+
+    return fileNameID ? DDLogStringTableString(fileNameID) : DDLogFileNameWithoutExtension(DDLogStringTableString(fileID));
+}
+
+// The last name of a thread and its ID, so that a thread only interns its name again when it changes
+typedef struct {
+    const void *name; // Retained NSString
+    DDLogStringID nameID;
+} DDLogThreadNameCache;
+
+static pthread_key_t DDLogThreadNameCacheKey;
+
+static void DDLogThreadNameCacheFree(void *value) {
+    DDLogThreadNameCache *cache = value;
+
+    if (cache->name) {
+        (void)(__bridge_transfer NSString *)cache->name;
+    }
+
+    free(cache);
+}
+
+static DDLogStringID DDLogThreadNameID(NSString *name) {
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        pthread_key_create(&DDLogThreadNameCacheKey, DDLogThreadNameCacheFree);
+    });
+
+    DDLogThreadNameCache *cache = pthread_getspecific(DDLogThreadNameCacheKey);
+
+    if (cache && cache->name == (__bridge const void *)name) {
+        return cache->nameID;
+    }
+
+    DDLogStringID nameID = DDLogStringTableInternString(name);
+
+    if (cache == NULL) {
+        cache = calloc(1, sizeof(DDLogThreadNameCache));
+
+        if (cache == NULL) {
+            return nameID;
+        }
+
+        pthread_setspecific(DDLogThreadNameCacheKey, cache);
+    }
+
+    if (cache->name) {
+        (void)(__bridge_transfer NSString *)cache->name;
+    }
+
+    cache->name = (__bridge_retained const void *)name;
+    cache->nameID = nameID;
+
+    return nameID;
+}
+
+// The thread ID, thread name and queue label of the calling thread
+static void DDLogMessageCaptureThread(DDLogMessage *message) {
+    NSString *threadName = NSThread.currentThread.name;
+    const char *queueLabel = DDLogCurrentQueueLabel();
+
+    message->_threadID = DDLogThreadIDString(DDLogCurrentThreadID());
+
+    message->_threadNameID = DDLogThreadNameID(threadName);
+    message->_threadName = message->_threadNameID ? DDLogStringTableString(message->_threadNameID) : threadName;
+
+    message->_queueLabelID = DDLogStringTableIntern(queueLabel, queueLabel ? strlen(queueLabel) : 0);
+    message->_queueLabel = message->_queueLabelID ? DDLogStringTableString(message->_queueLabelID)
+                                                  : [[NSString alloc] initWithFormat:@"%s", queueLabel];
+}
+
 - (instancetype)initWithMessage:(NSString *)message
                           level:(DDLogLevel)level
                            flag:(DDLogFlag)flag
@@ -1076,6 +2122,11 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy) {
                         options:(DDLogMessageOptions)options
                       timestamp:(NSDate *)timestamp {
     if ((self = [super init])) {
+        #if DD_LOG_TRACE_ENABLED
+        _traceTimestamps[DDLogTraceStageCreated] = DDLogTraceNow();
+        _traceSequence = OSAtomicIncrement64Barrier(&_traceSequenceCounter);
+        #endif
+
         _message      = [message copy];
         _level        = level;
         _flag         = flag;
@@ -1090,37 +2141,82 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy) {
         _line         = line;
         _tag          = tag;
         _options      = options;
-        _timestamp    = timestamp ?: [NSDate new];
+        _timestamp    = timestamp ?: (_clock ? [_clock now] : [NSDate new]);
 
-        if (USE_PTHREAD_THREADID_NP) {
-            __uint64_t tid;
-            pthread_threadid_np(NULL, &tid);
-            _threadID = [[NSString alloc] initWithFormat:@"%llu", tid];
-        } else {
-            _threadID = [[NSString alloc] initWithFormat:@"%x", pthread_mach_thread_np(pthread_self())];
-        }
-        _threadName   = NSThread.currentThread.name;
-
-        // Get the file name without extension
-        _fileName = [_file lastPathComponent];
-        NSUInteger dotLocation = [_fileName rangeOfString:@"." options:NSBackwardsSearch].location;
-        if (dotLocation != NSNotFound)
-        {
-            _fileName = [_fileName substringToIndex:dotLocation];
-        }
-        
-        // Try to get the current queue's label
-        if (USE_DISPATCH_CURRENT_QUEUE_LABEL) {
-            _queueLabel = [[NSString alloc] initWithFormat:@"%s", dispatch_queue_get_label(DISPATCH_CURRENT_QUEUE_LABEL)];
-        } else if (USE_DISPATCH_GET_CURRENT_QUEUE) {
-            #pragma clang diagnostic push
-            #pragma clang diagnostic ignored "-Wdeprecated-declarations"
-            dispatch_queue_t currentQueue = dispatch_get_current_queue();
-            #pragma clang diagnostic pop
-            _queueLabel = [[NSString alloc] initWithFormat:@"%s", dispatch_queue_get_label(currentQueue)];
-        } else {
-            _queueLabel = @""; // iOS 6.x only
-        }
+        _fileName     = DDLogFileNameWithoutExtension(_file);
+
+        DDLogMessageCaptureThread(self);
+    }
+    return self;
+}
+
+/**
+ * A message from a log statement of DDLog, with the file and function in the intern table.
+ **/
+- (instancetype)initWithMessage:(NSString *)message
+                          level:(DDLogLevel)level
+                           flag:(DDLogFlag)flag
+                        context:(NSInteger)context
+                         fileID:(DDLogStringID)fileID
+                     functionID:(DDLogStringID)functionID
+                           line:(NSUInteger)line
+                            tag:(id)tag {
+    if ((self = [super init])) {
+        #if DD_LOG_TRACE_ENABLED
+        _traceTimestamps[DDLogTraceStageCreated] = DDLogTraceNow();
+        _traceSequence = OSAtomicIncrement64Barrier(&_traceSequenceCounter);
+        #endif
+
+        _message      = [message copy];
+        _level        = level;
+        _flag         = flag;
+        _context      = context;
+        _fileID       = fileID;
+        _file         = DDLogStringTableString(fileID);
+        _fileName     = DDLogInternedFileNameWithoutExtension(fileID);
+        _functionID   = functionID;
+        _function     = DDLogStringTableString(functionID);
+        _line         = line;
+        _tag          = tag;
+        _options      = (DDLogMessageOptions)0;
+        _timestamp    = _clock ? [_clock now] : [NSDate new];
+
+        DDLogMessageCaptureThread(self);
+    }
+    return self;
+}
+
+/**
+ * A message from a log statement recorded on another thread (see log:level:flag:context:callSite:arguments:length:renderer:).
+ * The thread name is the name of the thread as pthread_getname_np knows it.
+ **/
+- (instancetype)initWithRecord:(const DDLogRecord *)record message:(NSString *)message {
+    if ((self = [super init])) {
+        #if DD_LOG_TRACE_ENABLED
+        _traceTimestamps[DDLogTraceStageCreated] = record->traceCreated;
+        _traceTimestamps[DDLogTraceStageEnqueued] = record->traceEnqueued;
+        _traceSequence = OSAtomicIncrement64Barrier(&_traceSequenceCounter);
+        #endif
+
+        _message      = message;
+        _level        = record->level;
+        _flag         = record->flag;
+        _context      = record->context;
+        _fileID       = DDLogStringTableInternStatic(record->callSite->file);
+        _file         = _fileID ? DDLogStringTableString(_fileID) : DDLogStaticString(record->callSite->file);
+        _functionID   = DDLogStringTableInternStatic(record->callSite->function);
+        _function     = _functionID ? DDLogStringTableString(_functionID) : DDLogStaticString(record->callSite->function);
+        _line         = record->callSite->line;
+        _options      = (DDLogMessageOptions)0;
+        _timestamp    = [[NSDate alloc] initWithTimeIntervalSinceReferenceDate:record->timestamp];
+        _threadID     = DDLogThreadIDString(record->threadID);
+        _threadNameID = record->threadName[0] ? DDLogStringTableIntern(record->threadName, strlen(record->threadName)) : 0;
+        _threadName   = _threadNameID ? DDLogStringTableString(_threadNameID)
+                                      : (record->threadName[0] ? [[NSString alloc] initWithUTF8String:record->threadName] : nil);
+        _fileName     = _fileID ? DDLogInternedFileNameWithoutExtension(_fileID) : DDLogFileNameWithoutExtension(_file);
+        _queueLabelID = DDLogStringTableIntern(DDLogRecordQueueLabel(record), strlen(DDLogRecordQueueLabel(record)));
+        _queueLabel   = _queueLabelID ? DDLogStringTableString(_queueLabelID)
+                                      : [[NSString alloc] initWithUTF8String:DDLogRecordQueueLabel(record)];
     }
     return self;
 }
@@ -1129,6 +2225,7 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy) {
     DDLogMessage *newMessage = [DDLogMessage new];
     
     newMessage->_message = _message;
+    newMessage->_messageRenderer = _messageRenderer;
     newMessage->_level = _level;
     newMessage->_flag = _flag;
     newMessage->_context = _context;
@@ -1142,6 +2239,15 @@ NSString * DDExtractFileNameWithoutExtension(const char *filePath, BOOL copy) {
     newMessage->_threadID = _threadID;
     newMessage->_threadName = _threadName;
     newMessage->_queueLabel = _queueLabel;
+    newMessage->_fileID = _fileID;
+    newMessage->_functionID = _functionID;
+    newMessage->_threadNameID = _threadNameID;
+    newMessage->_queueLabelID = _queueLabelID;
+
+    #if DD_LOG_TRACE_ENABLED
+    newMessage->_traceSequence = _traceSequence;
+    memcpy(newMessage->_traceTimestamps, _traceTimestamps, sizeof(_traceTimestamps));
+    #endif
 
     return newMessage;
 }
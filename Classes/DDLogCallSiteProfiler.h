@@ -0,0 +1,131 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+/**
+ * Call site profiling: which log statements cost the most.
+ *
+ * While enabled, every log statement that goes through the C string API of DDLog (the log macros)
+ * is counted per call site (file, function and line): the number of messages, the UTF-8 bytes of the messages,
+ * and the time the calling thread spent in the statement, formatting included.
+ *
+ * [DDLogCallSiteProfiler setEnabled:YES];
+ * ...
+ * NSLog(@"%@", [DDLogCallSiteProfiler reportSortedBy:DDLogCallSiteSortKeyTime limit:20]);
+ *
+ * The counters live in per thread tables that only their thread writes to, without locks or atomic
+ * read-modify-write operations; they are merged when a report is made. A thread keeps up to 1024 call sites,
+ * statements from further call sites are only counted as dropped.
+ *
+ * When disabled (the default), a log statement pays a single load of a global flag.
+ **/
+
+/**
+ * Set by `+[DDLogCallSiteProfiler setEnabled:]`. Don't use directly.
+ **/
+extern volatile BOOL DDLogCallSiteProfilerActive;
+
+/**
+ *  Called by DDLog at the start of a log statement, before formatting. Don't use directly.
+ */
+void DDLogCallSiteProfilerBeginStatement(void);
+
+/**
+ *  Called by DDLog instead of the end of a statement that logs nothing (a message block returned nil). Don't use directly.
+ */
+void DDLogCallSiteProfilerCancelStatement(void);
+
+/**
+ *  Called by DDLog after the message of a log statement has been queued. Don't use directly.
+ *
+ *  Unless `staticStrings` is YES, the file and function names are copied the first time the call site is seen.
+ */
+void DDLogCallSiteProfilerEndStatement(const char *file, const char *function, NSUInteger line, NSString *message, BOOL staticStrings);
+
+
+typedef NS_ENUM(NSUInteger, DDLogCallSiteSortKey) {
+    DDLogCallSiteSortKeyMessages,
+    DDLogCallSiteSortKeyBytes,
+    DDLogCallSiteSortKeyTime
+};
+
+/**
+ * The counters of one call site.
+ **/
+@interface DDLogCallSiteStatistics : NSObject
+
+@property (nonatomic, readonly) NSString *file;
+@property (nonatomic, readonly) NSString *function;
+@property (nonatomic, readonly) NSUInteger line;
+
+@property (nonatomic, readonly) uint64_t messageCount;
+@property (nonatomic, readonly) uint64_t byteCount;
+
+/**
+ * The time spent by the calling threads in the statements, in nanoseconds.
+ **/
+@property (nonatomic, readonly) uint64_t nanoseconds;
+
+@end
+
+
+@interface DDLogCallSiteProfiler : NSObject
+
+/**
+ *  Starts or stops counting. Counters are kept when stopping.
+ */
++ (BOOL)isEnabled;
++ (void)setEnabled:(BOOL)enabled;
+
+/**
+ *  The call sites with the highest counts, highest first.
+ *
+ *  @param key   the counter to sort by
+ *  @param limit the maximum number of call sites to return, 0 for all
+ */
++ (NSArray<DDLogCallSiteStatistics *> *)topCallSitesSortedBy:(DDLogCallSiteSortKey)key limit:(NSUInteger)limit;
+
+/**
+ *  `topCallSitesSortedBy:limit:` as a human readable table, with the share of each call site in the totals.
+ */
++ (NSString *)reportSortedBy:(DDLogCallSiteSortKey)key limit:(NSUInteger)limit;
+
+/**
+ *  The number of statements that weren't counted because their thread already had the maximum number of call sites.
+ */
++ (uint64_t)droppedStatementCount;
+
+/**
+ *  Sets all counters to zero.
+ */
++ (void)reset;
+
+/**
+ *  Hands a report to the handler every `interval` seconds, on a private queue, until stopped.
+ *  The timer comes from `+[DDLog clock]`. A nil handler writes the reports to stderr.
+ */
++ (void)startPeriodicReportsWithInterval:(NSTimeInterval)interval
+                                  sortedBy:(DDLogCallSiteSortKey)key
+                                     limit:(NSUInteger)limit
+                                   handler:(void (^)(NSString *report))handler;
++ (void)stopPeriodicReports;
+
+@end
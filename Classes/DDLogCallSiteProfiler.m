@@ -0,0 +1,539 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDLogCallSiteProfiler.h"
+#import "DDLogClock.h"
+
+#import <pthread.h>
+#import <time.h>
+#if __has_include(<mach/mach_time.h>)
+    #import <mach/mach_time.h>
+    #define DD_CALL_SITE_MACH_TIME 1
+#else
+    #define DD_CALL_SITE_MACH_TIME 0
+#endif
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+// Call sites per thread, must be a power of 2
+#define DD_CALL_SITE_CAPACITY 1024
+
+/**
+ * The counters of a call site, in the table of one thread.
+ * Only the owning thread writes; `file` is written last, so a reader that sees it sees the rest of the key.
+ *
+ * Static strings (string literals, the call sites of DDLog+CXX.h) are kept as is and identified by their address.
+ * Any other file or function name may be freed, or its memory reused, once the statement returns:
+ * the entry keeps a copy of it and is identified by the contents.
+ **/
+typedef struct {
+    const char *file; // NULL for a free slot
+    const char *function;
+    NSUInteger line;
+    uint64_t hash;
+    BOOL copied; // file and function are copies owned by the entry
+    uint64_t messages;
+    uint64_t bytes;
+    uint64_t ticks;
+} DDLogCallSiteEntry;
+
+typedef struct DDLogCallSiteShard {
+    struct DDLogCallSiteShard *next;
+    uint64_t generation;
+    uint64_t pendingStart;
+    uint64_t dropped;
+    DDLogCallSiteEntry entries[DD_CALL_SITE_CAPACITY];
+} DDLogCallSiteShard;
+
+volatile BOOL DDLogCallSiteProfilerActive = NO;
+
+static pthread_key_t _shardKey;
+
+// Guards the list of shards (threads come and go) and the counters of exited threads
+static pthread_mutex_t _registryMutex = PTHREAD_MUTEX_INITIALIZER;
+static DDLogCallSiteShard *_shards;
+static NSMutableDictionary *_retiredStatistics;
+static uint64_t _retiredDropped;
+
+// Bumped by reset. A shard of an older generation is cleared by its thread before it is written to again.
+static volatile uint64_t _generation = 1;
+
+static uint64_t DDLogCallSiteNow(void) {
+#if DD_CALL_SITE_MACH_TIME
+    return mach_absolute_time();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static uint64_t DDLogCallSiteNanoseconds(uint64_t ticks) {
+#if DD_CALL_SITE_MACH_TIME
+    static mach_timebase_info_data_t timebase;
+
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+
+    return ticks * timebase.numer / timebase.denom;
+#else
+    return ticks;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Statistics
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface DDLogCallSiteStatistics ()
+
+@property (nonatomic, readwrite) NSString *file;
+@property (nonatomic, readwrite) NSString *function;
+@property (nonatomic, readwrite) NSUInteger line;
+@property (nonatomic, readwrite) uint64_t messageCount;
+@property (nonatomic, readwrite) uint64_t byteCount;
+@property (nonatomic, readwrite) uint64_t nanoseconds;
+
+@end
+
+@implementation DDLogCallSiteStatistics
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %@:%lu %@ messages=%llu bytes=%llu ns=%llu>",
+            NSStringFromClass([self class]), [_file lastPathComponent], (unsigned long)_line, _function,
+            _messageCount, _byteCount, _nanoseconds];
+}
+
+@end
+
+static void DDLogCallSiteAccumulate(NSMutableDictionary *statistics,
+                                    NSString *key,
+                                    const char *file,
+                                    const char *function,
+                                    NSUInteger line,
+                                    uint64_t messages,
+                                    uint64_t bytes,
+                                    uint64_t nanoseconds) {
+    DDLogCallSiteStatistics *site = statistics[key];
+
+    if (site == nil) {
+        site = [[DDLogCallSiteStatistics alloc] init];
+        site.file = [NSString stringWithUTF8String:file] ?: @"";
+        site.function = function ? ([NSString stringWithUTF8String:function] ?: @"") : @"";
+        site.line = line;
+
+        statistics[key] = site;
+    }
+
+    site.messageCount += messages;
+    site.byteCount += bytes;
+    site.nanoseconds += nanoseconds;
+}
+
+static NSString * DDLogCallSiteKey(const char *file, const char *function, NSUInteger line) {
+    // By contents: a call site may have an entry for static strings and one for copies in the same table
+    return [NSString stringWithFormat:@"%s|%s|%lu", file, function ?: "", (unsigned long)line];
+}
+
+/**
+ * Frees the copied strings of a table. Only the owning thread, or the thread retiring the table, calls this.
+ **/
+static void DDLogCallSiteFreeCopies(DDLogCallSiteShard *shard) {
+    for (NSUInteger i = 0; i < DD_CALL_SITE_CAPACITY; i++) {
+        DDLogCallSiteEntry *entry = &shard->entries[i];
+
+        if (entry->file && entry->copied) {
+            free((void *)entry->file);
+            free((void *)entry->function);
+        }
+    }
+}
+
+/**
+ * Adds the counters of a shard to the statistics. Called with the registry mutex held.
+ **/
+static void DDLogCallSiteMergeShard(DDLogCallSiteShard *shard, NSMutableDictionary *statistics, uint64_t *dropped) {
+    if (__atomic_load_n(&shard->generation, __ATOMIC_ACQUIRE) != __atomic_load_n(&_generation, __ATOMIC_ACQUIRE)) {
+        return; // Reset since the thread last logged
+    }
+
+    for (NSUInteger i = 0; i < DD_CALL_SITE_CAPACITY; i++) {
+        DDLogCallSiteEntry *entry = &shard->entries[i];
+        const char *file = __atomic_load_n(&entry->file, __ATOMIC_ACQUIRE);
+
+        if (file == NULL) {
+            continue;
+        }
+
+        DDLogCallSiteAccumulate(statistics,
+                                DDLogCallSiteKey(file, entry->function, entry->line),
+                                file,
+                                entry->function,
+                                entry->line,
+                                __atomic_load_n(&entry->messages, __ATOMIC_RELAXED),
+                                __atomic_load_n(&entry->bytes, __ATOMIC_RELAXED),
+                                DDLogCallSiteNanoseconds(__atomic_load_n(&entry->ticks, __ATOMIC_RELAXED)));
+    }
+
+    *dropped += __atomic_load_n(&shard->dropped, __ATOMIC_RELAXED);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Shards
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void DDLogCallSiteRetireShard(void *value) {
+    DDLogCallSiteShard *shard = (DDLogCallSiteShard *)value;
+
+    pthread_mutex_lock(&_registryMutex);
+
+    for (DDLogCallSiteShard **link = &_shards; *link; link = &(*link)->next) {
+        if (*link == shard) {
+            *link = shard->next;
+            break;
+        }
+    }
+
+    // Keep the counts of the exiting thread
+    if (_retiredStatistics == nil) {
+        _retiredStatistics = [NSMutableDictionary dictionary];
+    }
+
+    @autoreleasepool {
+        DDLogCallSiteMergeShard(shard, _retiredStatistics, &_retiredDropped);
+    }
+
+    pthread_mutex_unlock(&_registryMutex);
+
+    DDLogCallSiteFreeCopies(shard);
+    free(shard);
+}
+
+__attribute__((constructor)) static void DDLogCallSiteCreateKey(void) {
+    pthread_key_create(&_shardKey, DDLogCallSiteRetireShard);
+}
+
+static DDLogCallSiteShard * DDLogCallSiteCurrentShard(void) {
+    DDLogCallSiteShard *shard = (DDLogCallSiteShard *)pthread_getspecific(_shardKey);
+
+    if (shard == NULL) {
+        shard = (DDLogCallSiteShard *)calloc(1, sizeof(DDLogCallSiteShard));
+
+        if (shard == NULL) {
+            return NULL;
+        }
+
+        shard->generation = __atomic_load_n(&_generation, __ATOMIC_ACQUIRE);
+
+        pthread_mutex_lock(&_registryMutex);
+        shard->next = _shards;
+        _shards = shard;
+        pthread_mutex_unlock(&_registryMutex);
+
+        pthread_setspecific(_shardKey, shard);
+    }
+
+    return shard;
+}
+
+static uint64_t DDLogCallSiteHashString(uint64_t hash, const char *string) {
+    // FNV-1a
+    for (const unsigned char *c = (const unsigned char *)string; c && *c; c++) {
+        hash = (hash ^ *c) * 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+static DDLogCallSiteEntry * DDLogCallSiteLookup(DDLogCallSiteShard *shard, const char *file, const char *function, NSUInteger line, BOOL staticStrings) {
+    uint64_t hash;
+
+    if (staticStrings) {
+        hash = (uint64_t)(uintptr_t)file ^ ((uint64_t)(uintptr_t)function << 1);
+    } else {
+        hash = DDLogCallSiteHashString(DDLogCallSiteHashString(0xCBF29CE484222325ULL, file), function);
+    }
+
+    hash ^= (uint64_t)line * 0x9E3779B97F4A7C15ULL;
+    hash ^= hash >> 29;
+
+    for (NSUInteger probe = 0; probe < DD_CALL_SITE_CAPACITY; probe++) {
+        DDLogCallSiteEntry *entry = &shard->entries[(hash + probe) & (DD_CALL_SITE_CAPACITY - 1)];
+
+        if (entry->file == NULL) {
+            if (!staticStrings) {
+                // First time this call site is seen: the caller's strings may not outlive the statement
+                file = strdup(file);
+                function = function ? strdup(function) : NULL;
+
+                if (file == NULL) {
+                    free((void *)function);
+                    return NULL;
+                }
+            }
+
+            entry->function = function;
+            entry->line = line;
+            entry->hash = hash;
+            entry->copied = !staticStrings;
+            __atomic_store_n(&entry->file, file, __ATOMIC_RELEASE);
+
+            return entry;
+        }
+
+        if (entry->line != line || entry->copied == staticStrings) {
+            continue;
+        }
+
+        if (staticStrings) {
+            if (entry->file == file && entry->function == function) {
+                return entry;
+            }
+        } else if (entry->hash == hash &&
+                   strcmp(entry->file, file) == 0 &&
+                   (entry->function == function || (entry->function && function && strcmp(entry->function, function) == 0))) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+void DDLogCallSiteProfilerBeginStatement(void) {
+    DDLogCallSiteShard *shard = DDLogCallSiteCurrentShard();
+
+    // A statement that formats its message has already started
+    if (shard && shard->pendingStart == 0) {
+        shard->pendingStart = DDLogCallSiteNow();
+    }
+}
+
+void DDLogCallSiteProfilerCancelStatement(void) {
+    DDLogCallSiteShard *shard = (DDLogCallSiteShard *)pthread_getspecific(_shardKey);
+
+    // Otherwise the next statement of the thread would be charged from here
+    if (shard) {
+        shard->pendingStart = 0;
+    }
+}
+
+void DDLogCallSiteProfilerEndStatement(const char *file, const char *function, NSUInteger line, NSString *message, BOOL staticStrings) {
+    uint64_t end = DDLogCallSiteNow();
+
+    DDLogCallSiteShard *shard = (DDLogCallSiteShard *)pthread_getspecific(_shardKey);
+
+    if (shard == NULL || shard->pendingStart == 0) {
+        return;
+    }
+
+    uint64_t ticks = end - shard->pendingStart;
+    shard->pendingStart = 0;
+
+    uint64_t generation = __atomic_load_n(&_generation, __ATOMIC_ACQUIRE);
+
+    if (shard->generation != generation) {
+        // No report reads the table until its generation is current again
+        DDLogCallSiteFreeCopies(shard);
+        memset(shard->entries, 0, sizeof(shard->entries));
+        __atomic_store_n(&shard->dropped, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&shard->generation, generation, __ATOMIC_RELEASE);
+    }
+
+    DDLogCallSiteEntry *entry = DDLogCallSiteLookup(shard, file ?: "", function, line, staticStrings && file);
+
+    if (entry == NULL) {
+        __atomic_store_n(&shard->dropped, shard->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    // Single writer: plain increments, published with relaxed stores for the reporting thread
+    __atomic_store_n(&entry->messages, entry->messages + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->bytes, entry->bytes + [message lengthOfBytesUsingEncoding:NSUTF8StringEncoding], __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->ticks, entry->ticks + ticks, __ATOMIC_RELAXED);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@implementation DDLogCallSiteProfiler
+
+static dispatch_queue_t _reportQueue;
+static id <DDLogClockTimer> _reportTimer;
+
++ (void)initialize {
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        pthread_mutex_lock(&_registryMutex);
+
+        if (_retiredStatistics == nil) {
+            _retiredStatistics = [NSMutableDictionary dictionary];
+        }
+
+        pthread_mutex_unlock(&_registryMutex);
+
+        _reportQueue = dispatch_queue_create("cocoa.lumberjack.callSiteProfiler", DISPATCH_QUEUE_SERIAL);
+    });
+}
+
++ (BOOL)isEnabled {
+    return DDLogCallSiteProfilerActive;
+}
+
++ (void)setEnabled:(BOOL)enabled {
+    DDLogCallSiteProfilerActive = enabled;
+}
+
++ (NSArray<DDLogCallSiteStatistics *> *)allCallSitesWithDropped:(uint64_t *)dropped {
+    NSMutableDictionary *statistics = [NSMutableDictionary dictionary];
+    uint64_t droppedCount = 0;
+
+    pthread_mutex_lock(&_registryMutex);
+
+    [_retiredStatistics enumerateKeysAndObjectsUsingBlock:^(NSString *key, DDLogCallSiteStatistics *site, BOOL *stop) {
+        DDLogCallSiteStatistics *copy = [[DDLogCallSiteStatistics alloc] init];
+        copy.file = site.file;
+        copy.function = site.function;
+        copy.line = site.line;
+        copy.messageCount = site.messageCount;
+        copy.byteCount = site.byteCount;
+        copy.nanoseconds = site.nanoseconds;
+
+        statistics[key] = copy;
+    }];
+
+    droppedCount = _retiredDropped;
+
+    for (DDLogCallSiteShard *shard = _shards; shard; shard = shard->next) {
+        DDLogCallSiteMergeShard(shard, statistics, &droppedCount);
+    }
+
+    pthread_mutex_unlock(&_registryMutex);
+
+    if (dropped) {
+        *dropped = droppedCount;
+    }
+
+    return [statistics allValues];
+}
+
++ (NSArray<DDLogCallSiteStatistics *> *)topCallSitesSortedBy:(DDLogCallSiteSortKey)key limit:(NSUInteger)limit {
+    NSArray *sites = [[self allCallSitesWithDropped:NULL] sortedArrayUsingComparator:^NSComparisonResult(DDLogCallSiteStatistics *a, DDLogCallSiteStatistics *b) {
+        uint64_t x, y;
+
+        switch (key) {
+            case DDLogCallSiteSortKeyMessages : x = a.messageCount; y = b.messageCount; break;
+            case DDLogCallSiteSortKeyBytes    : x = a.byteCount;    y = b.byteCount;    break;
+            case DDLogCallSiteSortKeyTime     :
+            default                           : x = a.nanoseconds;  y = b.nanoseconds;  break;
+        }
+
+        if (x != y) {
+            return (x > y) ? NSOrderedAscending : NSOrderedDescending;
+        }
+
+        // Stable order for ties
+        NSComparisonResult result = [a.file compare:b.file];
+        return (result != NSOrderedSame) ? result : [@(a.line) compare:@(b.line)];
+    }];
+
+    if (limit > 0 && sites.count > limit) {
+        sites = [sites subarrayWithRange:NSMakeRange(0, limit)];
+    }
+
+    return sites;
+}
+
++ (NSString *)reportSortedBy:(DDLogCallSiteSortKey)key limit:(NSUInteger)limit {
+    uint64_t dropped = 0;
+    NSArray *all = [self allCallSitesWithDropped:&dropped];
+
+    uint64_t totalMessages = 0, totalBytes = 0, totalNanoseconds = 0;
+
+    for (DDLogCallSiteStatistics *site in all) {
+        totalMessages += site.messageCount;
+        totalBytes += site.byteCount;
+        totalNanoseconds += site.nanoseconds;
+    }
+
+    NSArray *top = [self topCallSitesSortedBy:key limit:limit];
+
+    NSMutableString *report = [NSMutableString string];
+    [report appendFormat:@"Log call sites: %lu, messages: %llu, bytes: %llu, time: %.3f ms, dropped: %llu\n",
+                         (unsigned long)all.count, totalMessages, totalBytes, totalNanoseconds / 1e6, dropped];
+    [report appendString:@"  messages   msg%         bytes  bytes%     time ms  time%   avg ns  call site\n"];
+
+    for (DDLogCallSiteStatistics *site in top) {
+        [report appendFormat:@"%10llu %5.1f%% %13llu %6.1f%% %11.3f %5.1f%% %8llu  %@:%lu %@\n",
+                             site.messageCount, totalMessages ? 100.0 * site.messageCount / totalMessages : 0.0,
+                             site.byteCount, totalBytes ? 100.0 * site.byteCount / totalBytes : 0.0,
+                             site.nanoseconds / 1e6, totalNanoseconds ? 100.0 * site.nanoseconds / totalNanoseconds : 0.0,
+                             site.messageCount ? site.nanoseconds / site.messageCount : 0,
+                             [site.file lastPathComponent], (unsigned long)site.line, site.function];
+    }
+
+    return report;
+}
+
++ (uint64_t)droppedStatementCount {
+    uint64_t dropped = 0;
+    [self allCallSitesWithDropped:&dropped];
+
+    return dropped;
+}
+
++ (void)reset {
+    pthread_mutex_lock(&_registryMutex);
+
+    [_retiredStatistics removeAllObjects];
+    _retiredDropped = 0;
+    __atomic_add_fetch(&_generation, 1, __ATOMIC_ACQ_REL);
+
+    pthread_mutex_unlock(&_registryMutex);
+}
+
++ (void)startPeriodicReportsWithInterval:(NSTimeInterval)interval
+                                  sortedBy:(DDLogCallSiteSortKey)key
+                                     limit:(NSUInteger)limit
+                                   handler:(void (^)(NSString *report))handler {
+    [self stopPeriodicReports];
+
+    id <DDLogClockTimer> timer = [[DDLog clock] scheduleTimerWithDelay:interval interval:interval queue:_reportQueue handler:^{
+        NSString *report = [self reportSortedBy:key limit:limit];
+
+        if (handler) {
+            handler(report);
+        } else {
+            fprintf(stderr, "%s", [report UTF8String]);
+        }
+    }];
+
+    @synchronized(self) {
+        _reportTimer = timer;
+    }
+}
+
++ (void)stopPeriodicReports {
+    @synchronized(self) {
+        [_reportTimer cancel];
+        _reportTimer = nil;
+    }
+}
+
+@end
@@ -0,0 +1,127 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+/**
+ * Clock sources.
+ *
+ * Everything in the framework that depends on the time goes through the clock returned by `+[DDLog clock]`:
+ * the timestamps of log messages, the names and ages of log files, the rolling timer of `DDFileLogger`
+ * and the save and delete timers of `DDAbstractDatabaseLogger`.
+ *
+ * By default this is the system clock. Tests and benchmarks can install a `DDVirtualLogClock` instead,
+ * and move time forward explicitly, e.g. to roll a log file after a simulated day, in no time and deterministically:
+ *
+ * DDVirtualLogClock *clock = [[DDVirtualLogClock alloc] initWithDate:[NSDate dateWithTimeIntervalSince1970:0]];
+ * [DDLog setClock:clock];
+ * ...
+ * [clock advanceBy:(60 * 60 * 24)]; // Runs the rolling timer, before returning
+ **/
+
+/**
+ * A scheduled timer, as returned by `-[DDLogClock scheduleTimerWithDelay:interval:queue:handler:]`.
+ **/
+@protocol DDLogClockTimer <NSObject>
+
+/**
+ * Stops the timer. The handler is not invoked anymore after this returns,
+ * unless it is currently running (or was already dispatched).
+ **/
+- (void)cancel;
+
+@end
+
+
+@protocol DDLogClock <NSObject>
+
+/**
+ * The current date.
+ **/
+@property (nonatomic, readonly) NSDate *now;
+
+/**
+ * Schedules a timer. The handler is invoked on the given queue, after `delay` seconds,
+ * and then every `interval` seconds (or only once if the interval is 0), until the timer is cancelled.
+ **/
+- (id <DDLogClockTimer>)scheduleTimerWithDelay:(NSTimeInterval)delay
+                                      interval:(NSTimeInterval)interval
+                                         queue:(dispatch_queue_t)queue
+                                       handler:(dispatch_block_t)handler;
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The wall clock, with GCD timers.
+ **/
+@interface DDSystemLogClock : NSObject <DDLogClock>
+
++ (instancetype)sharedInstance;
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A clock that only moves when told to.
+ *
+ * Timers fire from within `advanceBy:` / `advanceToDate:`, in the order of their fire dates,
+ * and synchronously: when the method returns, every handler that became due has run.
+ * While a handler runs, `now` is its fire date.
+ *
+ * The advance methods must not be called on the queue of a scheduled timer.
+ **/
+@interface DDVirtualLogClock : NSObject <DDLogClock>
+
+/**
+ *  Creates a clock that starts at the given date.
+ */
+- (instancetype)initWithDate:(NSDate *)date NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  Creates a clock that starts at the current date.
+ */
+- (instancetype)init;
+
+/**
+ *  Moves the clock forward, running the timers that become due.
+ *
+ *  @param interval the number of seconds to move forward (negative values are ignored)
+ */
+- (void)advanceBy:(NSTimeInterval)interval;
+
+/**
+ *  Moves the clock forward to the given date, running the timers that become due.
+ *  Dates in the past are ignored.
+ */
+- (void)advanceToDate:(NSDate *)date;
+
+/**
+ *  The number of timers that are scheduled and not cancelled.
+ */
+@property (nonatomic, readonly) NSUInteger scheduledTimerCount;
+
+@end
@@ -0,0 +1,251 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDLogClock.h"
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark System Clock
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface DDSystemLogClockTimer : NSObject <DDLogClockTimer> {
+    dispatch_source_t _source;
+}
+
+- (instancetype)initWithSource:(dispatch_source_t)source;
+
+@end
+
+@implementation DDSystemLogClockTimer
+
+- (instancetype)initWithSource:(dispatch_source_t)source {
+    if ((self = [super init])) {
+        _source = source;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [self cancel];
+}
+
+- (void)cancel {
+    @synchronized(self) {
+        if (_source) {
+            dispatch_source_cancel(_source);
+            #if !OS_OBJECT_USE_OBJC
+            dispatch_release(_source);
+            #endif
+            _source = NULL;
+        }
+    }
+}
+
+@end
+
+@implementation DDSystemLogClock
+
++ (instancetype)sharedInstance {
+    static DDSystemLogClock *sharedInstance;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        sharedInstance = [[self alloc] init];
+    });
+
+    return sharedInstance;
+}
+
+- (NSDate *)now {
+    return [NSDate new];
+}
+
+- (id <DDLogClockTimer>)scheduleTimerWithDelay:(NSTimeInterval)delay
+                                      interval:(NSTimeInterval)interval
+                                         queue:(dispatch_queue_t)queue
+                                       handler:(dispatch_block_t)handler {
+    dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, queue);
+
+    dispatch_source_set_event_handler(source, ^{ @autoreleasepool {
+        handler();
+    } });
+
+    dispatch_time_t fireTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MAX(delay, 0.0) * NSEC_PER_SEC));
+    uint64_t repeat = (interval > 0.0) ? (uint64_t)(interval * NSEC_PER_SEC) : DISPATCH_TIME_FOREVER;
+
+    dispatch_source_set_timer(source, fireTime, repeat, 1.0);
+    dispatch_resume(source);
+
+    return [[DDSystemLogClockTimer alloc] initWithSource:source];
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Virtual Clock
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface DDVirtualLogClockTimer : NSObject <DDLogClockTimer> {
+    @public
+    NSTimeInterval _fireTime;
+    NSTimeInterval _interval;
+    NSUInteger _sequence;
+    dispatch_queue_t _queue;
+    dispatch_block_t _handler;
+    __weak DDVirtualLogClock *_clock;
+}
+
+@end
+
+@interface DDVirtualLogClock () {
+    NSTimeInterval _now;
+    NSUInteger _nextSequence;
+    NSMutableArray<DDVirtualLogClockTimer *> *_timers;
+}
+
+- (void)removeTimer:(DDVirtualLogClockTimer *)timer;
+
+@end
+
+@implementation DDVirtualLogClockTimer
+
+- (void)cancel {
+    [_clock removeTimer:self];
+}
+
+@end
+
+@implementation DDVirtualLogClock
+
+- (instancetype)init {
+    return [self initWithDate:[NSDate date]];
+}
+
+- (instancetype)initWithDate:(NSDate *)date {
+    if ((self = [super init])) {
+        _now = [date timeIntervalSinceReferenceDate];
+        _timers = [NSMutableArray array];
+    }
+
+    return self;
+}
+
+- (NSDate *)now {
+    @synchronized(self) {
+        return [NSDate dateWithTimeIntervalSinceReferenceDate:_now];
+    }
+}
+
+- (NSUInteger)scheduledTimerCount {
+    @synchronized(self) {
+        return [_timers count];
+    }
+}
+
+- (id <DDLogClockTimer>)scheduleTimerWithDelay:(NSTimeInterval)delay
+                                      interval:(NSTimeInterval)interval
+                                         queue:(dispatch_queue_t)queue
+                                       handler:(dispatch_block_t)handler {
+    DDVirtualLogClockTimer *timer = [[DDVirtualLogClockTimer alloc] init];
+
+    timer->_interval = MAX(interval, 0.0);
+    timer->_queue = queue;
+    timer->_handler = [handler copy];
+    timer->_clock = self;
+
+    @synchronized(self) {
+        timer->_fireTime = _now + MAX(delay, 0.0);
+        timer->_sequence = _nextSequence++;
+        [_timers addObject:timer];
+    }
+
+    return timer;
+}
+
+- (void)removeTimer:(DDVirtualLogClockTimer *)timer {
+    @synchronized(self) {
+        [_timers removeObjectIdenticalTo:timer];
+    }
+}
+
+/**
+ * The next timer due at or before the given time, earliest (and then first scheduled) first.
+ **/
+- (DDVirtualLogClockTimer *)nextTimerDueBefore:(NSTimeInterval)time {
+    DDVirtualLogClockTimer *next = nil;
+
+    for (DDVirtualLogClockTimer *timer in _timers) {
+        if (timer->_fireTime > time) {
+            continue;
+        }
+
+        if (next == nil ||
+            timer->_fireTime < next->_fireTime ||
+            (timer->_fireTime == next->_fireTime && timer->_sequence < next->_sequence)) {
+            next = timer;
+        }
+    }
+
+    return next;
+}
+
+- (void)advanceBy:(NSTimeInterval)interval {
+    NSTimeInterval target;
+
+    @synchronized(self) {
+        target = _now + MAX(interval, 0.0);
+    }
+
+    [self advanceToTime:target];
+}
+
+- (void)advanceToDate:(NSDate *)date {
+    [self advanceToTime:[date timeIntervalSinceReferenceDate]];
+}
+
+- (void)advanceToTime:(NSTimeInterval)target {
+    while (YES) {
+        DDVirtualLogClockTimer *timer;
+
+        @synchronized(self) {
+            NSTimeInterval limit = MAX(target, _now);
+
+            timer = [self nextTimerDueBefore:limit];
+
+            if (timer == nil) {
+                _now = limit;
+                return;
+            }
+
+            _now = MAX(_now, timer->_fireTime);
+
+            if (timer->_interval > 0.0) {
+                timer->_fireTime += timer->_interval;
+            } else {
+                [_timers removeObjectIdenticalTo:timer];
+            }
+        }
+
+        dispatch_sync(timer->_queue, ^{ @autoreleasepool {
+            timer->_handler();
+        } });
+    }
+}
+
+@end
@@ -0,0 +1,203 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+/**
+ * Log aggregation on a single host.
+ *
+ * Instead of each process writing, rolling and compressing its own log files, the processes ship their messages
+ * to one collector process over a Unix domain socket, and only the collector writes files:
+ *
+ * // In the collector process
+ * DDLog *collectedLog = [[DDLog alloc] init];
+ * [collectedLog addLogger:[[DDFileLogger alloc] init]];
+ * DDLogCollector *collector = [[DDLogCollector alloc] initWithSocketPath:path log:collectedLog];
+ * [collector startListening:NULL];
+ *
+ * // In every client process
+ * [DDLog addLogger:[[DDLogCollectorClient alloc] initWithSocketPath:path spoolDirectory:spoolDirectory]];
+ *
+ * The messages travel in batches, in the binary encoding of DDLogMessageBatch, each prefixed with its length.
+ * While the collector is unavailable, a client appends the batches to a spool file, and sends them first
+ * once it gets a connection again (which may be in a later run of the process).
+ *
+ * Everything runs in one process just as well, which is how the tests use it.
+ **/
+
+/**
+ * A log message received by a DDLogCollector, with the process that logged it.
+ **/
+@interface DDCollectedLogMessage : DDLogMessage
+
+@property (readonly, nonatomic) NSString *processName;
+@property (readonly, nonatomic) int processID;
+
+@end
+
+
+/**
+ * The binary encoding of a batch of log messages.
+ *
+ * All fields are little endian. A batch is:
+ * the magic "DDLB", a version byte (1), 3 reserved bytes, the process ID (u32), the process name (string),
+ * the number of messages (u32), and the messages.
+ *
+ * A message is: level (u32), flag (u32), context (i64), line (u64), options (u32), timestamp (f64, seconds since 1970),
+ * then the strings message, file, function, tag, threadID, threadName and queueLabel.
+ * A string is its UTF-8 length (u32, 0xFFFFFFFF for nil) followed by the bytes.
+ * Tags that aren't strings are sent as nil.
+ **/
+@interface DDLogMessageBatch : NSObject
+
+/**
+ *  Encodes the messages, as logged by this process.
+ */
++ (NSData *)dataWithMessages:(NSArray<DDLogMessage *> *)messages;
+
+/**
+ *  Decodes a batch, or returns nil if the data isn't a valid batch.
+ */
++ (NSArray<DDCollectedLogMessage *> *)messagesWithData:(NSData *)data;
+
+/**
+ *  Appends the encoding of a single message, as it appears in a batch.
+ */
++ (void)appendMessage:(DDLogMessage *)message toData:(NSMutableData *)data;
+
+/**
+ *  Decodes a single message, or returns nil if the bytes aren't exactly one valid message.
+ */
++ (DDCollectedLogMessage *)messageWithBytes:(const void *)bytes
+                                     length:(NSUInteger)length
+                                processName:(NSString *)processName
+                                  processID:(int)processID;
+
+@end
+
+
+/**
+ * A logger that sends the messages to a DDLogCollector.
+ *
+ * Messages are sent in batches: when `batchSize` messages are pending, `batchInterval` seconds after the first
+ * pending message (timer from `+[DDLog clock]`), and on flush. Sending never waits longer than `sendTimeout`.
+ **/
+@interface DDLogCollectorClient : DDAbstractLogger <DDLogger>
+
+/**
+ *  Designated initializer
+ *
+ *  @param socketPath     the socket the collector listens on
+ *  @param spoolDirectory where batches are kept while the collector is unavailable; nil to drop them instead
+ */
+- (instancetype)initWithSocketPath:(NSString *)socketPath spoolDirectory:(NSString *)spoolDirectory NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly, copy) NSString *socketPath;
+@property (nonatomic, readonly, copy) NSString *spoolDirectory;
+
+/**
+ * The spool file of this process, named after the process. A later run picks it up.
+ **/
+@property (nonatomic, readonly, copy) NSString *spoolFilePath;
+
+/**
+ * Defaults to 64 messages.
+ **/
+@property (assign) NSUInteger batchSize;
+
+/**
+ * Defaults to 0.1 seconds.
+ **/
+@property (assign) NSTimeInterval batchInterval;
+
+/**
+ * Defaults to 1 second.
+ **/
+@property (assign) NSTimeInterval sendTimeout;
+
+/**
+ * How long to wait before trying to connect again after a failure. Defaults to 1 second.
+ **/
+@property (assign) NSTimeInterval reconnectInterval;
+
+/**
+ * Batches that would make the spool file larger than this are dropped. Defaults to 10 MB.
+ **/
+@property (assign) unsigned long long maximumSpoolSize;
+
+/**
+ * Whether the client currently has a connection to the collector.
+ **/
+@property (readonly, getter=isConnected) BOOL connected;
+
+/**
+ * The number of messages dropped because the spool was full (or there was none).
+ **/
+@property (readonly) uint64_t droppedMessageCount;
+
+@end
+
+
+/**
+ * Receives the messages of DDLogCollectorClients, and logs them to a DDLog instance.
+ **/
+@interface DDLogCollector : NSObject
+
+/**
+ *  Designated initializer
+ *
+ *  @param socketPath the Unix domain socket to listen on; a socket file left there by an earlier run is replaced
+ *  @param log        the DDLog instance the messages are logged to, with the loggers that write them
+ */
+- (instancetype)initWithSocketPath:(NSString *)socketPath log:(DDLog *)log NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly, copy) NSString *socketPath;
+@property (nonatomic, readonly, strong) DDLog *log;
+
+/**
+ *  @return NO, with the POSIX error, if the socket couldn't be opened
+ */
+- (BOOL)startListening:(NSError **)error;
+
+/**
+ *  Disconnects all clients, closes and removes the socket.
+ */
+- (void)stopListening;
+
+/**
+ * The number of connected clients.
+ **/
+@property (readonly) NSUInteger clientCount;
+
+/**
+ * The number of messages received so far.
+ **/
+@property (readonly) uint64_t receivedMessageCount;
+
+/**
+ * The number of connections closed because they sent data that isn't a valid batch.
+ **/
+@property (readonly) uint64_t invalidBatchCount;
+
+@end
@@ -0,0 +1,887 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDLogCollector.h"
+#import "DDLogClock.h"
+#import "DDLogStringTable.h"
+
+#import <unistd.h>
+#import <fcntl.h>
+#import <sys/socket.h>
+#import <sys/stat.h>
+#import <sys/un.h>
+#import <libkern/OSAtomic.h>
+#import <libkern/OSByteOrder.h>
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+// We probably shouldn't be using DDLog() statements within the DDLog implementation.
+// But we still want to leave our log statements for any future debugging,
+// and to allow other developers to trace the implementation (which is a great learning tool).
+//
+// So we use primitive logging macros around NSLog.
+// We maintain the NS prefix on the macros to be explicit about the fact that we're using NSLog.
+
+#ifndef DD_NSLOG_LEVEL
+    #define DD_NSLOG_LEVEL 2
+#endif
+
+#define NSLogWarn(frmt, ...)     do{ if(DD_NSLOG_LEVEL >= 2) NSLog((frmt), ##__VA_ARGS__); } while(0)
+
+static const char kDDLogBatchMagic[4] = { 'D', 'D', 'L', 'B' };
+static const uint8_t kDDLogBatchVersion = 1;
+static const uint32_t kDDLogBatchNilString = UINT32_MAX;
+
+// A larger length prefix means the peer isn't speaking the protocol
+static const uint32_t kDDLogBatchMaximumLength = 16 * 1024 * 1024;
+
+static BOOL DDLogCollectorSocketAddress(NSString *path, struct sockaddr_un *address) {
+    const char *fileSystemPath = [path fileSystemRepresentation];
+
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+
+    if (strlen(fileSystemPath) >= sizeof(address->sun_path)) {
+        return NO;
+    }
+
+    strlcpy(address->sun_path, fileSystemPath, sizeof(address->sun_path));
+
+    return YES;
+}
+
+static void DDLogCollectorIgnoreSigPipe(int fd) {
+    #ifdef SO_NOSIGPIPE
+    int noSigPipe = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+    #else
+    (void)fd;
+    #endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface DDCollectedLogMessage () {
+    @public
+    NSString *_processName;
+    int _processID;
+}
+
+@end
+
+@implementation DDCollectedLogMessage
+
+- (NSString *)processName {
+    return _processName;
+}
+
+- (int)processID {
+    return _processID;
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void DDLogBatchAppendUInt32(NSMutableData *data, uint32_t value) {
+    value = OSSwapHostToLittleInt32(value);
+    [data appendBytes:&value length:sizeof(value)];
+}
+
+static void DDLogBatchAppendUInt64(NSMutableData *data, uint64_t value) {
+    value = OSSwapHostToLittleInt64(value);
+    [data appendBytes:&value length:sizeof(value)];
+}
+
+static void DDLogBatchAppendString(NSMutableData *data, NSString *string) {
+    if (string == nil) {
+        DDLogBatchAppendUInt32(data, kDDLogBatchNilString);
+        return;
+    }
+
+    NSUInteger lengthOffset = data.length;
+    NSUInteger maximumLength = [string maximumLengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    NSUInteger length = 0;
+
+    // Encode straight into the batch, then fix the length
+    DDLogBatchAppendUInt32(data, 0);
+    [data increaseLengthBy:maximumLength];
+    [string getBytes:(uint8_t *)data.mutableBytes + lengthOffset + sizeof(uint32_t)
+           maxLength:maximumLength
+          usedLength:&length
+            encoding:NSUTF8StringEncoding
+             options:0
+               range:NSMakeRange(0, string.length)
+      remainingRange:NULL];
+    data.length = lengthOffset + sizeof(uint32_t) + length;
+
+    uint32_t encodedLength = OSSwapHostToLittleInt32((uint32_t)length);
+    memcpy((uint8_t *)data.mutableBytes + lengthOffset, &encodedLength, sizeof(encodedLength));
+}
+
+// Same encoding as DDLogBatchAppendString, from the cached UTF-8 of an interned string (if it is)
+static void DDLogBatchAppendInternedString(NSMutableData *data, DDLogStringID identifier, NSString *string) {
+    size_t length = 0;
+    const char *bytes = DDLogStringTableUTF8(identifier, &length);
+
+    if (bytes == NULL) {
+        DDLogBatchAppendString(data, string);
+        return;
+    }
+
+    DDLogBatchAppendUInt32(data, (uint32_t)length);
+    [data appendBytes:bytes length:length];
+}
+
+typedef struct {
+    const uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger offset;
+    BOOL failed;
+} DDLogBatchReader;
+
+static BOOL DDLogBatchRead(DDLogBatchReader *reader, void *value, NSUInteger length) {
+    if (reader->failed || reader->length - reader->offset < length) {
+        reader->failed = YES;
+        memset(value, 0, length);
+        return NO;
+    }
+
+    memcpy(value, reader->bytes + reader->offset, length);
+    reader->offset += length;
+
+    return YES;
+}
+
+static uint32_t DDLogBatchReadUInt32(DDLogBatchReader *reader) {
+    uint32_t value;
+    DDLogBatchRead(reader, &value, sizeof(value));
+    return OSSwapLittleToHostInt32(value);
+}
+
+static uint64_t DDLogBatchReadUInt64(DDLogBatchReader *reader) {
+    uint64_t value;
+    DDLogBatchRead(reader, &value, sizeof(value));
+    return OSSwapLittleToHostInt64(value);
+}
+
+static NSString * DDLogBatchReadString(DDLogBatchReader *reader) {
+    uint32_t length = DDLogBatchReadUInt32(reader);
+
+    if (reader->failed || length == kDDLogBatchNilString) {
+        return nil;
+    }
+
+    if (reader->length - reader->offset < length) {
+        reader->failed = YES;
+        return nil;
+    }
+
+    NSString *string = [[NSString alloc] initWithBytes:reader->bytes + reader->offset
+                                                length:length
+                                              encoding:NSUTF8StringEncoding];
+    reader->offset += length;
+
+    if (string == nil) {
+        reader->failed = YES;
+    }
+
+    return string;
+}
+
+static void DDLogBatchAppendMessage(NSMutableData *data, DDLogMessage *message) {
+    double timestamp = [message->_timestamp timeIntervalSince1970];
+    uint64_t timestampBits;
+    memcpy(&timestampBits, &timestamp, sizeof(timestampBits));
+
+    DDLogBatchAppendUInt32(data, (uint32_t)message->_level);
+    DDLogBatchAppendUInt32(data, (uint32_t)message->_flag);
+    DDLogBatchAppendUInt64(data, (uint64_t)(int64_t)message->_context);
+    DDLogBatchAppendUInt64(data, (uint64_t)message->_line);
+    DDLogBatchAppendUInt32(data, (uint32_t)message->_options);
+    DDLogBatchAppendUInt64(data, timestampBits);
+
+    DDLogBatchAppendString(data, message->_message);
+    DDLogBatchAppendInternedString(data, message->_fileID, message->_file);
+    DDLogBatchAppendInternedString(data, message->_functionID, message->_function);
+    DDLogBatchAppendString(data, [message->_tag isKindOfClass:[NSString class]] ? message->_tag : nil);
+    DDLogBatchAppendString(data, message->_threadID);
+    DDLogBatchAppendInternedString(data, message->_threadNameID, message->_threadName);
+    DDLogBatchAppendInternedString(data, message->_queueLabelID, message->_queueLabel);
+}
+
+static DDCollectedLogMessage * DDLogBatchReadMessage(DDLogBatchReader *reader, NSString *processName, int processID) {
+    DDLogLevel level = (DDLogLevel)DDLogBatchReadUInt32(reader);
+    DDLogFlag flag = (DDLogFlag)DDLogBatchReadUInt32(reader);
+    NSInteger context = (NSInteger)(int64_t)DDLogBatchReadUInt64(reader);
+    NSUInteger line = (NSUInteger)DDLogBatchReadUInt64(reader);
+    DDLogMessageOptions options = (DDLogMessageOptions)DDLogBatchReadUInt32(reader);
+    uint64_t timestampBits = DDLogBatchReadUInt64(reader);
+    double timestamp;
+    memcpy(&timestamp, &timestampBits, sizeof(timestamp));
+
+    // Not interned: the intern table never shrinks, and a peer could fill it with strings of its choosing
+    NSString *text = DDLogBatchReadString(reader);
+    NSString *file = DDLogBatchReadString(reader);
+    NSString *function = DDLogBatchReadString(reader);
+    NSString *tag = DDLogBatchReadString(reader);
+    NSString *threadID = DDLogBatchReadString(reader);
+    NSString *threadName = DDLogBatchReadString(reader);
+    NSString *queueLabel = DDLogBatchReadString(reader);
+
+    if (reader->failed) {
+        return nil;
+    }
+
+    DDCollectedLogMessage *message = [[DDCollectedLogMessage alloc] initWithMessage:text
+                                                                              level:level
+                                                                               flag:flag
+                                                                            context:context
+                                                                               file:file
+                                                                           function:function
+                                                                               line:line
+                                                                                tag:tag
+                                                                            options:options
+                                                                          timestamp:[NSDate dateWithTimeIntervalSince1970:timestamp]];
+
+    // The thread and queue of the logging process, not of the decoding one
+    message->_threadID = threadID;
+    message->_threadName = threadName;
+    message->_threadNameID = 0;
+    message->_queueLabel = queueLabel;
+    message->_queueLabelID = 0;
+    message->_processName = processName;
+    message->_processID = processID;
+
+    return message;
+}
+
+@implementation DDLogMessageBatch
+
++ (NSData *)dataWithMessages:(NSArray<DDLogMessage *> *)messages {
+    static NSString *processName;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        processName = [[NSProcessInfo processInfo] processName];
+    });
+
+    NSMutableData *data = [NSMutableData dataWithCapacity:64 + messages.count * 256];
+    uint8_t reserved[3] = { 0, 0, 0 };
+
+    [data appendBytes:kDDLogBatchMagic length:sizeof(kDDLogBatchMagic)];
+    [data appendBytes:&kDDLogBatchVersion length:sizeof(kDDLogBatchVersion)];
+    [data appendBytes:reserved length:sizeof(reserved)];
+    DDLogBatchAppendUInt32(data, (uint32_t)getpid());
+    DDLogBatchAppendString(data, processName);
+    DDLogBatchAppendUInt32(data, (uint32_t)messages.count);
+
+    for (DDLogMessage *message in messages) {
+        DDLogBatchAppendMessage(data, message);
+    }
+
+    return data;
+}
+
++ (NSArray<DDCollectedLogMessage *> *)messagesWithData:(NSData *)data {
+    DDLogBatchReader reader = { data.bytes, data.length, 0, NO };
+    char magic[4];
+    uint8_t version;
+    uint8_t reserved[3];
+
+    DDLogBatchRead(&reader, magic, sizeof(magic));
+    DDLogBatchRead(&reader, &version, sizeof(version));
+    DDLogBatchRead(&reader, reserved, sizeof(reserved));
+
+    if (reader.failed || memcmp(magic, kDDLogBatchMagic, sizeof(magic)) != 0 || version != kDDLogBatchVersion) {
+        return nil;
+    }
+
+    int processID = (int)DDLogBatchReadUInt32(&reader);
+    NSString *processName = DDLogBatchReadString(&reader);
+    uint32_t count = DDLogBatchReadUInt32(&reader);
+
+    // Each message takes at least 60 bytes, don't trust a count beyond that
+    if (reader.failed || count > (reader.length - reader.offset) / 60) {
+        return nil;
+    }
+
+    NSMutableArray *messages = [NSMutableArray arrayWithCapacity:count];
+
+    for (uint32_t i = 0; i < count && !reader.failed; i++) {
+        DDCollectedLogMessage *message = DDLogBatchReadMessage(&reader, processName, processID);
+
+        if (message) {
+            [messages addObject:message];
+        }
+    }
+
+    if (reader.failed || reader.offset != reader.length) {
+        return nil;
+    }
+
+    return messages;
+}
+
++ (void)appendMessage:(DDLogMessage *)message toData:(NSMutableData *)data {
+    DDLogBatchAppendMessage(data, message);
+}
+
++ (DDCollectedLogMessage *)messageWithBytes:(const void *)bytes
+                                     length:(NSUInteger)length
+                                processName:(NSString *)processName
+                                  processID:(int)processID {
+    DDLogBatchReader reader = { bytes, length, 0, NO };
+    DDCollectedLogMessage *message = DDLogBatchReadMessage(&reader, processName, processID);
+
+    return (reader.offset == length) ? message : nil;
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface DDLogCollectorClient () {
+    // Only used on the logger queue
+    NSMutableArray *_pendingMessages;
+    id <DDLogClockTimer> _batchTimer;
+    int _socket;
+    NSDate *_nextConnectionAttempt;
+
+    volatile int32_t _connected;
+    volatile int64_t _droppedMessageCount;
+}
+
+@end
+
+@implementation DDLogCollectorClient
+
+- (instancetype)initWithSocketPath:(NSString *)socketPath spoolDirectory:(NSString *)spoolDirectory {
+    if ((self = [super init])) {
+        _socketPath = [socketPath copy];
+        _spoolDirectory = [spoolDirectory copy];
+
+        if (_spoolDirectory) {
+            NSString *fileName = [[[NSProcessInfo processInfo] processName] stringByAppendingPathExtension:@"ddlogspool"];
+            _spoolFilePath = [_spoolDirectory stringByAppendingPathComponent:fileName];
+
+            [[NSFileManager defaultManager] createDirectoryAtPath:_spoolDirectory
+                                      withIntermediateDirectories:YES
+                                                       attributes:nil
+                                                            error:nil];
+        }
+
+        _pendingMessages = [NSMutableArray array];
+        _socket = -1;
+
+        _batchSize = 64;
+        _batchInterval = 0.1;
+        _sendTimeout = 1.0;
+        _reconnectInterval = 1.0;
+        _maximumSpoolSize = 10 * 1024 * 1024;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [_batchTimer cancel];
+
+    if (_socket >= 0) {
+        close(_socket);
+    }
+}
+
+- (NSString *)loggerName {
+    return @"cocoa.lumberjack.collectorClient";
+}
+
+- (BOOL)isConnected {
+    return _connected != 0;
+}
+
+- (uint64_t)droppedMessageCount {
+    return (uint64_t)_droppedMessageCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark DDLogger Protocol
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)logMessage:(DDLogMessage *)logMessage {
+    [_pendingMessages addObject:logMessage];
+
+    if (_pendingMessages.count >= self.batchSize) {
+        [self lt_sendPendingMessages];
+    } else if (_batchTimer == nil) {
+        __weak DDLogCollectorClient *weakSelf = self;
+
+        _batchTimer = [[DDLog clock] scheduleTimerWithDelay:self.batchInterval
+                                                   interval:0
+                                                      queue:_loggerQueue
+                                                    handler:^{ @autoreleasepool {
+            [weakSelf lt_sendPendingMessages];
+        } }];
+    }
+}
+
+- (void)flush {
+    [self lt_sendPendingMessages];
+}
+
+- (void)willRemoveLogger {
+    [self lt_sendPendingMessages];
+    [self lt_disconnect];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Sending
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)lt_sendPendingMessages {
+    [_batchTimer cancel];
+    _batchTimer = nil;
+
+    NSUInteger count = _pendingMessages.count;
+
+    if (count == 0) {
+        return;
+    }
+
+    NSData *batch = [DDLogMessageBatch dataWithMessages:_pendingMessages];
+    [_pendingMessages removeAllObjects];
+
+    NSMutableData *frame = [NSMutableData dataWithCapacity:sizeof(uint32_t) + batch.length];
+    DDLogBatchAppendUInt32(frame, (uint32_t)batch.length);
+    [frame appendData:batch];
+
+    // The spool goes first, to keep the order
+    if ([self lt_connect] && [self lt_sendSpool] && [self lt_sendData:frame]) {
+        return;
+    }
+
+    [self lt_spoolFrame:frame messageCount:count];
+}
+
+- (BOOL)lt_connect {
+    if (_socket >= 0) {
+        return YES;
+    }
+
+    NSDate *now = [[DDLog clock] now];
+
+    if (_nextConnectionAttempt && [now compare:_nextConnectionAttempt] == NSOrderedAscending) {
+        return NO;
+    }
+
+    struct sockaddr_un address;
+    int fd = -1;
+
+    if (DDLogCollectorSocketAddress(_socketPath, &address)) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    }
+
+    if (fd >= 0) {
+        NSTimeInterval timeout = self.sendTimeout;
+        struct timeval sendTimeout = { (time_t)timeout, (suseconds_t)((timeout - floor(timeout)) * USEC_PER_SEC) };
+
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+        DDLogCollectorIgnoreSigPipe(fd);
+
+        if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    if (fd < 0) {
+        _nextConnectionAttempt = [now dateByAddingTimeInterval:self.reconnectInterval];
+        return NO;
+    }
+
+    _socket = fd;
+    _nextConnectionAttempt = nil;
+    _connected = 1;
+    OSMemoryBarrier();
+
+    return YES;
+}
+
+- (void)lt_disconnect {
+    if (_socket >= 0) {
+        close(_socket);
+        _socket = -1;
+        _connected = 0;
+        OSMemoryBarrier();
+    }
+}
+
+- (BOOL)lt_sendData:(NSData *)data {
+    const uint8_t *bytes = data.bytes;
+    NSUInteger remaining = data.length;
+
+    while (remaining > 0) {
+        ssize_t written = write(_socket, bytes, remaining);
+
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (written <= 0) {
+            // Also a timeout: a collector that doesn't keep up is treated as unavailable.
+            // It drops the partial batch when the connection closes.
+            [self lt_disconnect];
+            _nextConnectionAttempt = [[[DDLog clock] now] dateByAddingTimeInterval:self.reconnectInterval];
+
+            return NO;
+        }
+
+        bytes += written;
+        remaining -= (NSUInteger)written;
+    }
+
+    return YES;
+}
+
+- (BOOL)lt_sendSpool {
+    if (_spoolFilePath == nil) {
+        return YES;
+    }
+
+    NSData *spool = [NSData dataWithContentsOfFile:_spoolFilePath options:NSDataReadingMappedIfSafe error:nil];
+
+    if (spool == nil) {
+        return YES;
+    }
+
+    // The spool holds complete frames, as sent over the socket
+    if (spool.length > 0 && ![self lt_sendData:spool]) {
+        return NO;
+    }
+
+    [[NSFileManager defaultManager] removeItemAtPath:_spoolFilePath error:nil];
+
+    return YES;
+}
+
+- (void)lt_spoolFrame:(NSData *)frame messageCount:(NSUInteger)count {
+    if (_spoolFilePath == nil) {
+        OSAtomicAdd64Barrier((int64_t)count, &_droppedMessageCount);
+        return;
+    }
+
+    int fd = open([_spoolFilePath fileSystemRepresentation], O_WRONLY | O_CREAT | O_APPEND, 0600);
+    struct stat fileInfo;
+
+    if (fd < 0 || fstat(fd, &fileInfo) != 0 ||
+        (unsigned long long)fileInfo.st_size + frame.length > self.maximumSpoolSize ||
+        write(fd, frame.bytes, frame.length) != (ssize_t)frame.length) {
+        OSAtomicAdd64Barrier((int64_t)count, &_droppedMessageCount);
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A connected client of a DDLogCollector. Only used on the collector queue.
+ **/
+@interface DDLogCollectorConnection : NSObject
+{
+    @public
+    int _fd;
+    dispatch_source_t _readSource;
+    NSMutableData *_buffer;
+}
+
+@end
+
+@implementation DDLogCollectorConnection
+
+@end
+
+
+@interface DDLogCollector () {
+    dispatch_queue_t _queue;
+
+    // Only used on the collector queue
+    int _listenFD;
+    dispatch_source_t _listenSource;
+    NSMutableArray *_connections;
+
+    volatile int32_t _clientCount;
+    volatile int64_t _receivedMessageCount;
+    volatile int64_t _invalidBatchCount;
+}
+
+@end
+
+@implementation DDLogCollector
+
+- (instancetype)initWithSocketPath:(NSString *)socketPath log:(DDLog *)log {
+    if ((self = [super init])) {
+        _socketPath = [socketPath copy];
+        _log = log;
+        _queue = dispatch_queue_create("cocoa.lumberjack.collector", DISPATCH_QUEUE_SERIAL);
+        _listenFD = -1;
+        _connections = [NSMutableArray array];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    // The handlers only hold weak references, so nothing else can be using the sources anymore
+    [self q_stopListening];
+
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_release(_queue);
+    #endif
+}
+
+- (NSUInteger)clientCount {
+    return (NSUInteger)_clientCount;
+}
+
+- (uint64_t)receivedMessageCount {
+    return (uint64_t)_receivedMessageCount;
+}
+
+- (uint64_t)invalidBatchCount {
+    return (uint64_t)_invalidBatchCount;
+}
+
+- (BOOL)startListening:(NSError **)error {
+    __block int errorCode = 0;
+
+    dispatch_sync(_queue, ^{
+        if (_listenSource == NULL) {
+            errorCode = [self q_startListening];
+        }
+    });
+
+    if (errorCode != 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errorCode userInfo:nil];
+        }
+
+        return NO;
+    }
+
+    return YES;
+}
+
+- (int)q_startListening {
+    struct sockaddr_un address;
+
+    if (!DDLogCollectorSocketAddress(_socketPath, &address)) {
+        return ENAMETOOLONG;
+    }
+
+    // Replace a socket left behind by an earlier run, but nothing else
+    struct stat fileInfo;
+
+    if (lstat(address.sun_path, &fileInfo) == 0 && S_ISSOCK(fileInfo.st_mode)) {
+        unlink(address.sun_path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0 ||
+        bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(fd, 64) != 0 ||
+        fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+        int errorCode = errno;
+
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        return errorCode;
+    }
+
+    __weak DDLogCollector *weakSelf = self;
+    NSString *socketPath = _socketPath;
+
+    _listenFD = fd;
+    _listenSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _queue);
+
+    dispatch_source_set_event_handler(_listenSource, ^{ @autoreleasepool {
+        [weakSelf q_acceptClients];
+    } });
+
+    dispatch_source_set_cancel_handler(_listenSource, ^{
+        close(fd);
+        unlink([socketPath fileSystemRepresentation]);
+    });
+
+    dispatch_resume(_listenSource);
+
+    return 0;
+}
+
+- (void)stopListening {
+    dispatch_sync(_queue, ^{
+        [self q_stopListening];
+    });
+}
+
+- (void)q_stopListening {
+    if (_listenSource) {
+        dispatch_source_cancel(_listenSource);
+        #if !OS_OBJECT_USE_OBJC
+        dispatch_release(_listenSource);
+        #endif
+        _listenSource = NULL;
+        _listenFD = -1;
+    }
+
+    for (DDLogCollectorConnection *connection in [_connections copy]) {
+        [self q_closeConnection:connection];
+    }
+}
+
+- (void)q_acceptClients {
+    int fd;
+
+    while ((fd = accept(_listenFD, NULL, NULL)) >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        DDLogCollectorIgnoreSigPipe(fd);
+
+        DDLogCollectorConnection *connection = [[DDLogCollectorConnection alloc] init];
+        connection->_fd = fd;
+        connection->_buffer = [NSMutableData data];
+        connection->_readSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _queue);
+
+        __weak DDLogCollector *weakSelf = self;
+        __weak DDLogCollectorConnection *weakConnection = connection;
+
+        dispatch_source_set_event_handler(connection->_readSource, ^{ @autoreleasepool {
+            [weakSelf q_readFromConnection:weakConnection];
+        } });
+
+        dispatch_source_set_cancel_handler(connection->_readSource, ^{
+            close(fd);
+        });
+
+        [_connections addObject:connection];
+        _clientCount = (int32_t)_connections.count;
+        OSMemoryBarrier();
+
+        dispatch_resume(connection->_readSource);
+    }
+}
+
+- (void)q_closeConnection:(DDLogCollectorConnection *)connection {
+    if (connection == nil || connection->_readSource == NULL) {
+        return;
+    }
+
+    dispatch_source_cancel(connection->_readSource);
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_release(connection->_readSource);
+    #endif
+    connection->_readSource = NULL;
+
+    [_connections removeObjectIdenticalTo:connection];
+    _clientCount = (int32_t)_connections.count;
+    OSMemoryBarrier();
+}
+
+- (void)q_readFromConnection:(DDLogCollectorConnection *)connection {
+    if (connection == nil || connection->_readSource == NULL) {
+        return;
+    }
+
+    NSMutableData *buffer = connection->_buffer;
+    NSUInteger previousLength = buffer.length;
+    const NSUInteger chunkSize = 64 * 1024;
+
+    [buffer increaseLengthBy:chunkSize];
+
+    ssize_t length = read(connection->_fd, (uint8_t *)buffer.mutableBytes + previousLength, chunkSize);
+
+    buffer.length = previousLength + (NSUInteger)MAX(length, 0);
+
+    if (length == 0 || (length < 0 && errno != EAGAIN && errno != EINTR)) {
+        // A partial batch at the end is dropped: the client spools it and sends it again
+        [self q_closeConnection:connection];
+        return;
+    }
+
+    const uint8_t *bytes = buffer.bytes;
+    NSUInteger offset = 0;
+
+    while (buffer.length - offset >= sizeof(uint32_t)) {
+        uint32_t batchLength;
+        memcpy(&batchLength, bytes + offset, sizeof(batchLength));
+        batchLength = OSSwapLittleToHostInt32(batchLength);
+
+        if (batchLength > kDDLogBatchMaximumLength) {
+            [self q_rejectConnection:connection];
+            return;
+        }
+
+        if (buffer.length - offset - sizeof(uint32_t) < batchLength) {
+            break;
+        }
+
+        NSData *batch = [NSData dataWithBytesNoCopy:(void *)(bytes + offset + sizeof(uint32_t))
+                                             length:batchLength
+                                       freeWhenDone:NO];
+        NSArray *messages = [DDLogMessageBatch messagesWithData:batch];
+
+        if (messages == nil) {
+            [self q_rejectConnection:connection];
+            return;
+        }
+
+        // Asynchronous: when the loggers fall behind, this blocks, the socket buffers fill up,
+        // and the clients spool rather than wait
+        for (DDLogMessage *message in messages) {
+            [_log log:YES message:message];
+        }
+
+        OSAtomicAdd64Barrier((int64_t)messages.count, &_receivedMessageCount);
+
+        offset += sizeof(uint32_t) + batchLength;
+    }
+
+    [buffer replaceBytesInRange:NSMakeRange(0, offset) withBytes:NULL length:0];
+}
+
+- (void)q_rejectConnection:(DDLogCollectorConnection *)connection {
+    NSLogWarn(@"DDLogCollector: Closing a connection that sent an invalid batch");
+
+    OSAtomicIncrement64Barrier(&_invalidBatchCount);
+    [self q_closeConnection:connection];
+}
+
+@end
@@ -0,0 +1,45 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A cache of parsed format strings for the format based log primitives of DDLog (and so the log macros).
+ *
+ * `-[NSString initWithFormat:arguments:]` parses the format again on every call, although a log statement
+ * always passes the same string literal. `DDLogFormatString` parses a literal once into a list of text segments
+ * and conversion specifiers, and later calls only walk that list against the `va_list`, writing straight into
+ * a UTF-8 buffer (numbers with the functions of `DDLogNumberFormatting.h`).
+ *
+ * The cache is direct-mapped and keyed by the address of the format: 1024 slots, each of which keeps
+ * the first format that maps to it. Lookups don't lock and entries are never freed, so the cache
+ * never takes more than a fixed amount of memory. Only constant strings (string literals) are cached;
+ * they live as long as the binary that contains them, so their address can't be reused by another format.
+ *
+ * Handled: %%, %d, %i, %u, %x, %X (with the hh, h, l, ll, q, z, t and j length modifiers), %p, %c, %s, %f and %g,
+ * with a width and the '-' and '0' flags, and a precision for %f and %g.
+ * Formats with anything else, such as %@ or positional arguments, and arguments that could be rendered
+ * differently (C strings and characters outside of ASCII), are formatted by Foundation, with the same result.
+ **/
+
+/**
+ *  Same result as `[[NSString alloc] initWithFormat:format arguments:arguments]`.
+ */
+NSString * DDLogFormatString(NSString *format, va_list arguments);
+
+/**
+ *  Whether the format is in the cache and is formatted without Foundation. For tests and benchmarks.
+ */
+BOOL DDLogFormatIsPreparsed(NSString *format);
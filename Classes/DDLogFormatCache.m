@@ -0,0 +1,538 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDLogFormatCache.h"
+#import "DDLogNumberFormatting.h"
+
+#import <libkern/OSAtomic.h>
+#import <objc/runtime.h>
+#import <stdlib.h>
+#import <string.h>
+#import <sys/types.h>
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+// Number of slots of the cache, a power of two (see DDLogFormatCacheSlot)
+#define DD_LOG_FORMAT_CACHE_SLOT_BITS 10
+#define DD_LOG_FORMAT_CACHE_SLOTS     (1 << DD_LOG_FORMAT_CACHE_SLOT_BITS)
+
+// Larger widths and precisions are left to Foundation
+#define DD_LOG_FORMAT_MAX_WIDTH     256
+#define DD_LOG_FORMAT_MAX_PRECISION 64
+
+typedef NS_ENUM(uint8_t, DDLogFormatConversion) {
+    DDLogFormatConversionText,
+    DDLogFormatConversionSigned,
+    DDLogFormatConversionUnsigned,
+    DDLogFormatConversionHex,
+    DDLogFormatConversionUppercaseHex,
+    DDLogFormatConversionPointer,
+    DDLogFormatConversionCharacter,
+    DDLogFormatConversionCString,
+    DDLogFormatConversionFixed,
+    DDLogFormatConversionGeneral
+};
+
+typedef NS_ENUM(uint8_t, DDLogFormatLength) {
+    DDLogFormatLengthDefault,
+    DDLogFormatLengthChar,
+    DDLogFormatLengthShort,
+    DDLogFormatLengthLong,
+    DDLogFormatLengthLongLong,
+    DDLogFormatLengthSize,
+    DDLogFormatLengthPointerDifference,
+    DDLogFormatLengthMax
+};
+
+typedef struct {
+    DDLogFormatConversion conversion;
+    DDLogFormatLength length;
+    BOOL leftAligned;
+    BOOL zeroPadded;
+    uint16_t width;
+    int16_t precision;   // -1 if not given
+    uint32_t textOffset; // Text segments: the bytes in DDLogParsedFormat.text
+    uint32_t textLength;
+} DDLogFormatSegment;
+
+typedef struct {
+    const void *format;         // The key. A constant string, never deallocated.
+    BOOL preparsed;             // NO if the format is left to Foundation
+    NSStringEncoding encoding;  // ASCII if the format is, otherwise UTF-8
+    NSUInteger segmentCount;
+    const char *text;
+    DDLogFormatSegment segments[];
+} DDLogParsedFormat;
+
+static DDLogParsedFormat * volatile DDLogFormatCacheSlots[DD_LOG_FORMAT_CACHE_SLOTS];
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Parsing
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void DDLogFormatAppendText(DDLogParsedFormat *parsed, char *text, size_t *textLength, char c) {
+    if (parsed->segmentCount == 0 || parsed->segments[parsed->segmentCount - 1].conversion != DDLogFormatConversionText) {
+        DDLogFormatSegment *segment = &parsed->segments[parsed->segmentCount++];
+        segment->conversion = DDLogFormatConversionText;
+        segment->textOffset = (uint32_t)*textLength;
+        segment->textLength = 0;
+    }
+
+    text[(*textLength)++] = c;
+    parsed->segments[parsed->segmentCount - 1].textLength++;
+}
+
+/**
+ * Parses the specifier after a '%'. Returns NO if it is one Foundation has to handle.
+ **/
+static BOOL DDLogFormatParseSpecifier(const char **cursor, DDLogFormatSegment *segment) {
+    const char *p = *cursor;
+
+    segment->precision = -1;
+
+    for (;; p++) {
+        if (*p == '-') {
+            segment->leftAligned = YES;
+        } else if (*p == '0') {
+            segment->zeroPadded = YES;
+        } else {
+            break;
+        }
+    }
+
+    NSUInteger width = 0;
+    while (*p >= '0' && *p <= '9' && width <= DD_LOG_FORMAT_MAX_WIDTH) {
+        width = width * 10 + (NSUInteger)(*p++ - '0');
+    }
+
+    // Positional arguments and widths taken from the arguments
+    if (width > DD_LOG_FORMAT_MAX_WIDTH || *p == '$' || *p == '*') {
+        return NO;
+    }
+
+    segment->width = (uint16_t)width;
+
+    if (*p == '.') {
+        NSInteger precision = 0;
+        p++;
+        while (*p >= '0' && *p <= '9' && precision <= DD_LOG_FORMAT_MAX_PRECISION) {
+            precision = precision * 10 + (*p++ - '0');
+        }
+
+        if (precision > DD_LOG_FORMAT_MAX_PRECISION || *p == '*') {
+            return NO;
+        }
+
+        segment->precision = (int16_t)precision;
+    }
+
+    if (p[0] == 'h' && p[1] == 'h') {
+        segment->length = DDLogFormatLengthChar;
+        p += 2;
+    } else if (p[0] == 'l' && p[1] == 'l') {
+        segment->length = DDLogFormatLengthLongLong;
+        p += 2;
+    } else {
+        switch (*p) {
+            case 'h': segment->length = DDLogFormatLengthShort; break;
+            case 'l': segment->length = DDLogFormatLengthLong; break;
+            case 'q': segment->length = DDLogFormatLengthLongLong; break;
+            case 'z': segment->length = DDLogFormatLengthSize; break;
+            case 't': segment->length = DDLogFormatLengthPointerDifference; break;
+            case 'j': segment->length = DDLogFormatLengthMax; break;
+            default: break;
+        }
+
+        p += (segment->length != DDLogFormatLengthDefault);
+    }
+
+    BOOL integer = NO;
+
+    switch (*p) {
+        case 'd':
+        case 'i': segment->conversion = DDLogFormatConversionSigned; integer = YES; break;
+        case 'u': segment->conversion = DDLogFormatConversionUnsigned; integer = YES; break;
+        case 'x': segment->conversion = DDLogFormatConversionHex; integer = YES; break;
+        case 'X': segment->conversion = DDLogFormatConversionUppercaseHex; integer = YES; break;
+        case 'p': segment->conversion = DDLogFormatConversionPointer; break;
+        case 'c': segment->conversion = DDLogFormatConversionCharacter; break;
+        case 's': segment->conversion = DDLogFormatConversionCString; break;
+        case 'f': segment->conversion = DDLogFormatConversionFixed; break;
+        case 'g': segment->conversion = DDLogFormatConversionGeneral; break;
+        default: return NO; // %@, %e, %C, %S, %o, ...
+    }
+
+    *cursor = p + 1;
+
+    BOOL floatingPoint = (segment->conversion == DDLogFormatConversionFixed || segment->conversion == DDLogFormatConversionGeneral);
+
+    // As in printf, '-' wins over '0'
+    if (segment->leftAligned) {
+        segment->zeroPadded = NO;
+    }
+
+    if (segment->zeroPadded && !integer) {
+        return NO;
+    }
+
+    if (segment->precision >= 0 && !floatingPoint) {
+        return NO;
+    }
+
+    // %lc, %ls (wide characters) and long double
+    if (segment->length != DDLogFormatLengthDefault && !integer &&
+        !(floatingPoint && segment->length == DDLogFormatLengthLong)) {
+        return NO;
+    }
+
+    return YES;
+}
+
+static DDLogParsedFormat * DDLogFormatParse(NSString *format) {
+    const char *utf8 = format.UTF8String;
+    size_t utf8Length = utf8 ? strlen(utf8) : 0;
+
+    NSUInteger specifierCount = 0;
+    for (const char *p = utf8; p && *p; p++) {
+        specifierCount += (*p == '%');
+    }
+
+    // Each specifier adds at most itself and the text after it
+    NSUInteger segmentCapacity = specifierCount * 2 + 1;
+    size_t size = sizeof(DDLogParsedFormat) + segmentCapacity * sizeof(DDLogFormatSegment);
+    DDLogParsedFormat *parsed = calloc(1, size + utf8Length);
+
+    if (!parsed) {
+        return NULL;
+    }
+
+    parsed->format = (__bridge const void *)format;
+
+    // Embedded NUL characters
+    if (!utf8 || [format lengthOfBytesUsingEncoding:NSUTF8StringEncoding] != utf8Length) {
+        return parsed;
+    }
+
+    char *text = (char *)parsed + size;
+    size_t textLength = 0;
+    BOOL ascii = YES;
+
+    for (const char *p = utf8; *p;) {
+        if (*p != '%') {
+            ascii = ascii && ((unsigned char)*p < 0x80);
+            DDLogFormatAppendText(parsed, text, &textLength, *p++);
+        } else if (p[1] == '%') {
+            DDLogFormatAppendText(parsed, text, &textLength, '%');
+            p += 2;
+        } else {
+            DDLogFormatSegment segment = { 0 };
+            p++;
+
+            if (!DDLogFormatParseSpecifier(&p, &segment)) {
+                parsed->segmentCount = 0;
+                return parsed;
+            }
+
+            parsed->segments[parsed->segmentCount++] = segment;
+        }
+    }
+
+    parsed->text = text;
+    parsed->encoding = ascii ? NSASCIIStringEncoding : NSUTF8StringEncoding;
+    parsed->preparsed = YES;
+
+    return parsed;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Cache
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static BOOL DDLogFormatIsConstant(NSString *format) {
+    static Class constantStringClass;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        constantStringClass = object_getClass(@"");
+    });
+
+    return format && object_getClass(format) == constantStringClass;
+}
+
+static NSUInteger DDLogFormatCacheSlot(const void *format) {
+    // Fibonacci hashing: the low bits of an address are mostly alignment
+    return (NSUInteger)(((uint64_t)(uintptr_t)format * 0x9E3779B97F4A7C15ULL) >> (64 - DD_LOG_FORMAT_CACHE_SLOT_BITS));
+}
+
+static const DDLogParsedFormat * DDLogFormatCacheLookup(NSString *format) {
+    if (!DDLogFormatIsConstant(format)) {
+        return NULL;
+    }
+
+    const void *key = (__bridge const void *)format;
+    NSUInteger slot = DDLogFormatCacheSlot(key);
+
+    // Entries don't change once they are published, and are only read through this pointer (an address
+    // dependency), so reading a slot needs no barrier.
+    const DDLogParsedFormat *entry = DDLogFormatCacheSlots[slot];
+
+    if (!entry) {
+        DDLogParsedFormat *parsed = DDLogFormatParse(format);
+
+        if (!parsed) {
+            return NULL;
+        }
+
+        if (OSAtomicCompareAndSwapPtrBarrier(NULL, parsed, (void * volatile *)&DDLogFormatCacheSlots[slot])) {
+            return parsed;
+        }
+
+        // Another thread filled the slot first
+        free(parsed);
+        entry = DDLogFormatCacheSlots[slot];
+    }
+
+    // A slot keeps the first format that maps to it
+    return (entry->format == key) ? entry : NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Rendering
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    char *bytes;
+    size_t length;
+    size_t capacity;
+    char stackBytes[512];
+} DDLogFormatOutput;
+
+static BOOL DDLogFormatOutputReserve(DDLogFormatOutput *output, size_t length) {
+    if (output->length + length <= output->capacity) {
+        return YES;
+    }
+
+    size_t capacity = MAX(output->capacity * 2, output->length + length);
+    BOOL onStack = (output->bytes == output->stackBytes);
+    char *bytes = onStack ? malloc(capacity) : realloc(output->bytes, capacity);
+
+    if (!bytes) {
+        return NO;
+    }
+
+    if (onStack) {
+        memcpy(bytes, output->stackBytes, output->length);
+    }
+
+    output->bytes = bytes;
+    output->capacity = capacity;
+
+    return YES;
+}
+
+static BOOL DDLogFormatOutputAppend(DDLogFormatOutput *output, const DDLogFormatSegment *segment, const char *bytes, size_t length) {
+    size_t padding = (segment->width > length) ? segment->width - length : 0;
+
+    if (!DDLogFormatOutputReserve(output, length + padding)) {
+        return NO;
+    }
+
+    char *cursor = output->bytes + output->length;
+
+    if (padding && !segment->leftAligned) {
+        // Zeros go between the sign and the digits
+        size_t sign = (segment->zeroPadded && length && bytes[0] == '-') ? 1 : 0;
+
+        memcpy(cursor, bytes, sign);
+        memset(cursor + sign, segment->zeroPadded ? '0' : ' ', padding);
+        memcpy(cursor + sign + padding, bytes + sign, length - sign);
+    } else {
+        memcpy(cursor, bytes, length);
+        memset(cursor + length, ' ', padding);
+    }
+
+    output->length += length + padding;
+
+    return YES;
+}
+
+static int64_t DDLogFormatSignedArgument(va_list *arguments, DDLogFormatLength length) {
+    switch (length) {
+        case DDLogFormatLengthChar:              return (signed char)va_arg(*arguments, int);
+        case DDLogFormatLengthShort:             return (short)va_arg(*arguments, int);
+        case DDLogFormatLengthLong:              return va_arg(*arguments, long);
+        case DDLogFormatLengthLongLong:          return va_arg(*arguments, long long);
+        case DDLogFormatLengthSize:              return va_arg(*arguments, ssize_t);
+        case DDLogFormatLengthPointerDifference: return va_arg(*arguments, ptrdiff_t);
+        case DDLogFormatLengthMax:               return va_arg(*arguments, intmax_t);
+        default:                                 return va_arg(*arguments, int);
+    }
+}
+
+static uint64_t DDLogFormatUnsignedArgument(va_list *arguments, DDLogFormatLength length) {
+    switch (length) {
+        case DDLogFormatLengthChar:              return (unsigned char)va_arg(*arguments, int);
+        case DDLogFormatLengthShort:             return (unsigned short)va_arg(*arguments, int);
+        case DDLogFormatLengthLong:              return va_arg(*arguments, unsigned long);
+        case DDLogFormatLengthLongLong:          return va_arg(*arguments, unsigned long long);
+        case DDLogFormatLengthSize:              return va_arg(*arguments, size_t);
+        case DDLogFormatLengthPointerDifference: return (size_t)va_arg(*arguments, ptrdiff_t);
+        case DDLogFormatLengthMax:               return va_arg(*arguments, uintmax_t);
+        default:                                 return va_arg(*arguments, unsigned int);
+    }
+}
+
+static size_t DDLogFormatHex(char *buffer, uint64_t value, BOOL uppercase) {
+    const char *digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+    char reversed[16];
+    size_t length = 0;
+
+    do {
+        reversed[length++] = digits[value & 0xf];
+        value >>= 4;
+    } while (value);
+
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = reversed[length - 1 - i];
+    }
+
+    return length;
+}
+
+/**
+ * Returns nil if an argument has to be formatted by Foundation.
+ **/
+static NSString * DDLogFormatRender(const DDLogParsedFormat *parsed, va_list *arguments) {
+    DDLogFormatOutput output;
+    output.bytes = output.stackBytes;
+    output.length = 0;
+    output.capacity = sizeof(output.stackBytes);
+
+    BOOL rendered = YES;
+
+    for (NSUInteger i = 0; i < parsed->segmentCount && rendered; i++) {
+        const DDLogFormatSegment *segment = &parsed->segments[i];
+        char scratch[512];
+        size_t length = 0;
+
+        switch (segment->conversion) {
+            case DDLogFormatConversionText:
+                rendered = DDLogFormatOutputReserve(&output, segment->textLength);
+                if (rendered) {
+                    memcpy(output.bytes + output.length, parsed->text + segment->textOffset, segment->textLength);
+                    output.length += segment->textLength;
+                }
+                continue;
+
+            case DDLogFormatConversionSigned:
+                length = DDLogFormatInteger(scratch, DDLogFormatSignedArgument(arguments, segment->length));
+                break;
+
+            case DDLogFormatConversionUnsigned:
+                length = DDLogFormatUnsignedInteger(scratch, DDLogFormatUnsignedArgument(arguments, segment->length));
+                break;
+
+            case DDLogFormatConversionHex:
+            case DDLogFormatConversionUppercaseHex:
+                length = DDLogFormatHex(scratch,
+                                        DDLogFormatUnsignedArgument(arguments, segment->length),
+                                        segment->conversion == DDLogFormatConversionUppercaseHex);
+                break;
+
+            case DDLogFormatConversionPointer:
+                memcpy(scratch, "0x", 2);
+                length = 2 + DDLogFormatHex(scratch + 2, (uintptr_t)va_arg(*arguments, void *), NO);
+                break;
+
+            case DDLogFormatConversionCharacter: {
+                unsigned char c = (unsigned char)va_arg(*arguments, int);
+                // Foundation decodes the rest in the default C string encoding
+                rendered = (c > 0 && c < 0x80);
+                scratch[0] = (char)c;
+                length = 1;
+                break;
+            }
+
+            case DDLogFormatConversionCString: {
+                const char *string = va_arg(*arguments, const char *);
+                string = string ? string : "(null)";
+
+                size_t stringLength = 0;
+                while (string[stringLength] && (unsigned char)string[stringLength] < 0x80) {
+                    stringLength++;
+                }
+
+                rendered = (string[stringLength] == '\0') && DDLogFormatOutputAppend(&output, segment, string, stringLength);
+                continue;
+            }
+
+            case DDLogFormatConversionFixed:
+            case DDLogFormatConversionGeneral: {
+                double value = va_arg(*arguments, double);
+                int precision = segment->precision;
+                int formattedLength = (segment->conversion == DDLogFormatConversionFixed)
+                    ? DDLogFormatDoubleFixed(scratch, sizeof(scratch), value, precision)
+                    : DDLogFormatDoubleGeneral(scratch, sizeof(scratch), value, precision);
+
+                rendered = (formattedLength >= 0 && (size_t)formattedLength < sizeof(scratch));
+                length = (size_t)MAX(formattedLength, 0);
+                break;
+            }
+        }
+
+        rendered = rendered && DDLogFormatOutputAppend(&output, segment, scratch, length);
+    }
+
+    NSString *message = nil;
+
+    if (rendered) {
+        message = [[NSString alloc] initWithBytes:output.bytes length:output.length encoding:parsed->encoding];
+    }
+
+    if (output.bytes != output.stackBytes) {
+        free(output.bytes);
+    }
+
+    return message;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Public
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+NSString * DDLogFormatString(NSString *format, va_list arguments) {
+    const DDLogParsedFormat *parsed = DDLogFormatCacheLookup(format);
+
+    if (parsed && parsed->preparsed) {
+        // On a copy, so Foundation gets the arguments from the start if it has to take over
+        va_list copy;
+        va_copy(copy, arguments);
+        NSString *message = DDLogFormatRender(parsed, &copy);
+        va_end(copy);
+
+        if (message) {
+            return message;
+        }
+    }
+
+    return [[NSString alloc] initWithFormat:format arguments:arguments];
+}
+
+BOOL DDLogFormatIsPreparsed(NSString *format) {
+    const DDLogParsedFormat *parsed = DDLogFormatCacheLookup(format);
+    return parsed && parsed->preparsed;
+}
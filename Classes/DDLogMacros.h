@@ -19,6 +19,7 @@
 #endif
 
 #import "DDLog.h"
+#import "DDLogScope.h"
 
 /**
  * The constant/variable/method responsible for controlling the current log level.
@@ -34,6 +35,20 @@
     #define LOG_ASYNC_ENABLED YES
 #endif
 
+/**
+ * Whether the macros should also consult the scoped log level (see DDLogScope.h).
+ * Set to 1 to enable. Note that this prevents log statements from being compiled out when LOG_LEVEL_DEF is a constant.
+ **/
+#ifndef DD_LOG_SCOPED_LEVELS
+    #define DD_LOG_SCOPED_LEVELS 0
+#endif
+
+#if DD_LOG_SCOPED_LEVELS
+    #define LOG_LEVEL_ACCEPTS(lvl, flg) (((lvl) | DDLogScopeCurrentLevel()) & (flg))
+#else
+    #define LOG_LEVEL_ACCEPTS(lvl, flg) ((lvl) & (flg))
+#endif
+
 /**
  * These are the two macros that all other macros below compile into.
  * These big multiline macros makes all the other macros easier to read.
@@ -77,13 +92,54 @@
  * (If the compiler sees LOG_LEVEL_DEF/ddLogLevel declared as a constant, the compiler simply checks to see
  *  if the 'if' statement would execute, and if not it strips it from the binary.)
  *
+ * If DD_LOG_SCOPED_LEVELS is enabled, the level of the current scope is added to the check:
+ *
+ * if (logFlagForThisLogMsg & (ddLogLevel | DDLogScopeCurrentLevel())) { execute log message }
+ *
  * We also define shorthand versions for asynchronous and synchronous logging.
  **/
 #define LOG_MAYBE(async, lvl, flg, ctx, tag, fnct, frmt, ...) \
-        do { if(lvl & flg) LOG_MACRO(async, lvl, flg, ctx, tag, fnct, frmt, ##__VA_ARGS__); } while(0)
+        do { if(LOG_LEVEL_ACCEPTS(lvl, flg)) LOG_MACRO(async, lvl, flg, ctx, tag, fnct, frmt, ##__VA_ARGS__); } while(0)
 
 #define LOG_MAYBE_TO_DDLOG(ddlog, async, lvl, flg, ctx, tag, fnct, frmt, ...) \
-        do { if(lvl & flg) LOG_MACRO_TO_DDLOG(ddlog, async, lvl, flg, ctx, tag, fnct, frmt, ##__VA_ARGS__); } while(0)
+        do { if(LOG_LEVEL_ACCEPTS(lvl, flg)) LOG_MACRO_TO_DDLOG(ddlog, async, lvl, flg, ctx, tag, fnct, frmt, ##__VA_ARGS__); } while(0)
+
+/**
+ * Block based versions of the macros above.
+ *
+ * The block building the message is only invoked if the flag passes both the per-file level (LOG_LEVEL_DEF)
+ * and the union of the levels of the added loggers (see `[DDLog loggersLevel]`).
+ * So an expensive message costs nothing if no logger would receive it:
+ *
+ * DDLogDebugBlock(^{ return [NSString stringWithFormat:@"State: %@", [hugeObject description]]; });
+ **/
+#define LOG_MACRO_BLOCK(isAsynchronous, lvl, flg, ctx, atag, fnct, blk) \
+        [DDLog log : isAsynchronous                                     \
+             level : lvl                                                \
+              flag : flg                                                \
+           context : ctx                                                \
+              file : __FILE__                                           \
+          function : fnct                                               \
+              line : __LINE__                                           \
+               tag : atag                                               \
+      messageBlock : (blk)]
+
+#define LOG_MACRO_BLOCK_TO_DDLOG(ddlog, isAsynchronous, lvl, flg, ctx, atag, fnct, blk) \
+        [ddlog log : isAsynchronous                                     \
+             level : lvl                                                \
+              flag : flg                                                \
+           context : ctx                                                \
+              file : __FILE__                                           \
+          function : fnct                                               \
+              line : __LINE__                                           \
+               tag : atag                                               \
+      messageBlock : (blk)]
+
+#define LOG_MAYBE_BLOCK(async, lvl, flg, ctx, tag, fnct, blk) \
+        do { if(LOG_LEVEL_ACCEPTS(lvl, flg) && (DDLogLoggersLevel & flg)) LOG_MACRO_BLOCK(async, lvl, flg, ctx, tag, fnct, blk); } while(0)
+
+#define LOG_MAYBE_BLOCK_TO_DDLOG(ddlog, async, lvl, flg, ctx, tag, fnct, blk) \
+        do { if(LOG_LEVEL_ACCEPTS(lvl, flg) && ([ddlog loggersLevel] & flg)) LOG_MACRO_BLOCK_TO_DDLOG(ddlog, async, lvl, flg, ctx, tag, fnct, blk); } while(0)
 
 /**
  * Ready to use log macros with no context or tag.
@@ -99,3 +155,15 @@
 #define DDLogInfoToDDLog(ddlog, frmt, ...)    LOG_MAYBE_TO_DDLOG(ddlog, LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagInfo,    0, nil, __PRETTY_FUNCTION__, frmt, ##__VA_ARGS__)
 #define DDLogDebugToDDLog(ddlog, frmt, ...)   LOG_MAYBE_TO_DDLOG(ddlog, LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagDebug,   0, nil, __PRETTY_FUNCTION__, frmt, ##__VA_ARGS__)
 #define DDLogVerboseToDDLog(ddlog, frmt, ...) LOG_MAYBE_TO_DDLOG(ddlog, LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagVerbose, 0, nil, __PRETTY_FUNCTION__, frmt, ##__VA_ARGS__)
+
+#define DDLogErrorBlock(blk)   LOG_MAYBE_BLOCK(NO,                LOG_LEVEL_DEF, DDLogFlagError,   0, nil, __PRETTY_FUNCTION__, blk)
+#define DDLogWarnBlock(blk)    LOG_MAYBE_BLOCK(LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagWarning, 0, nil, __PRETTY_FUNCTION__, blk)
+#define DDLogInfoBlock(blk)    LOG_MAYBE_BLOCK(LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagInfo,    0, nil, __PRETTY_FUNCTION__, blk)
+#define DDLogDebugBlock(blk)   LOG_MAYBE_BLOCK(LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagDebug,   0, nil, __PRETTY_FUNCTION__, blk)
+#define DDLogVerboseBlock(blk) LOG_MAYBE_BLOCK(LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagVerbose, 0, nil, __PRETTY_FUNCTION__, blk)
+
+#define DDLogErrorBlockToDDLog(ddlog, blk)   LOG_MAYBE_BLOCK_TO_DDLOG(ddlog, NO,                LOG_LEVEL_DEF, DDLogFlagError,   0, nil, __PRETTY_FUNCTION__, blk)
+#define DDLogWarnBlockToDDLog(ddlog, blk)    LOG_MAYBE_BLOCK_TO_DDLOG(ddlog, LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagWarning, 0, nil, __PRETTY_FUNCTION__, blk)
+#define DDLogInfoBlockToDDLog(ddlog, blk)    LOG_MAYBE_BLOCK_TO_DDLOG(ddlog, LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagInfo,    0, nil, __PRETTY_FUNCTION__, blk)
+#define DDLogDebugBlockToDDLog(ddlog, blk)   LOG_MAYBE_BLOCK_TO_DDLOG(ddlog, LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagDebug,   0, nil, __PRETTY_FUNCTION__, blk)
+#define DDLogVerboseBlockToDDLog(ddlog, blk) LOG_MAYBE_BLOCK_TO_DDLOG(ddlog, LOG_ASYNC_ENABLED, LOG_LEVEL_DEF, DDLogFlagVerbose, 0, nil, __PRETTY_FUNCTION__, blk)
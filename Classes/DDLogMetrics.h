@@ -0,0 +1,125 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+/**
+ * Health counters of the logging pipeline, exported in the Prometheus text format.
+ *
+ * While enabled, DDLog and the bundled loggers count:
+ *
+ * - dd_log_messages_enqueued_total, dd_log_messages_dequeued_total and dd_log_queue_depth (the difference)
+ * - dd_log_messages_dropped_total: messages not delivered to loggers in quarantine (see DDLogWatchdog.h)
+ * - dd_log_producer_blocks_total and dd_log_producer_block_seconds_total: log statements that had to wait
+ *   because the queue was full, and how long they waited
+ * - dd_log_logger_write_seconds{logger="..."}: a histogram of the time each logger spent per message
+ * - dd_log_file_rolls_total, dd_log_file_bytes_written_total and dd_log_file_exceptions_total (DDFileLogger)
+ * - dd_log_compression_backlog: archived log files waiting to be compressed, for log file managers that compress
+ *
+ * Rates (such as the enqueue rate) are left to the monitoring system, e.g. `rate(dd_log_messages_enqueued_total[1m])`.
+ *
+ * The counters are updated with atomic increments only; reading a clock is limited to producers that block anyway
+ * and to the logger queues. Formatting and writing the export happens on a private queue.
+ * When disabled (the default), each counter costs a single load of a global flag.
+ *
+ * [DDLogMetrics startWritingTextFileAtPath:@"/var/lib/node_exporter/textfile/myapp.prom" interval:15];
+ **/
+
+typedef NS_ENUM(NSUInteger, DDLogMetricsCounter) {
+    DDLogMetricsCounterMessagesEnqueued,
+    DDLogMetricsCounterMessagesDequeued,
+    DDLogMetricsCounterMessagesDropped,
+    DDLogMetricsCounterProducerBlocks,
+    DDLogMetricsCounterProducerBlockNanoseconds,
+    DDLogMetricsCounterFileRolls,
+    DDLogMetricsCounterFileBytesWritten,
+    DDLogMetricsCounterFileExceptions,
+    DDLogMetricsCounterCompressionBacklog,  // A gauge: set, rather than added to
+    DDLogMetricsCounterCount
+};
+
+/**
+ * Set by `+[DDLogMetrics setEnabled:]`. Check it before computing a value for `DDLogMetricsAdd`.
+ **/
+extern volatile BOOL DDLogMetricsActive;
+
+/**
+ *  Adds to a counter, if metrics are enabled. Thread safe.
+ */
+void DDLogMetricsAdd(DDLogMetricsCounter counter, int64_t value);
+
+/**
+ *  Sets a gauge (e.g. DDLogMetricsCounterCompressionBacklog), if metrics are enabled. Thread safe.
+ */
+void DDLogMetricsSet(DDLogMetricsCounter counter, int64_t value);
+
+/**
+ * The write latency counters of the loggers with a given name.
+ **/
+typedef struct DDLogMetricsLoggerCounters DDLogMetricsLoggerCounters;
+
+/**
+ *  Called by DDLog, on the logging queue. Don't use directly.
+ */
+DDLogMetricsLoggerCounters * DDLogMetricsCountersForLogger(id <DDLogger> logger);
+uint64_t DDLogMetricsNow(void);
+void DDLogMetricsRecordLoggerWrite(DDLogMetricsLoggerCounters *counters, uint64_t nanoseconds);
+
+
+@interface DDLogMetrics : NSObject
+
+/**
+ *  Starts or stops counting. Counters are kept when stopping. Starting an export enables counting.
+ */
++ (BOOL)isEnabled;
++ (void)setEnabled:(BOOL)enabled;
+
+/**
+ *  The current values, in the Prometheus text exposition format (version 0.0.4).
+ */
++ (NSString *)prometheusText;
+
+/**
+ *  Writes `prometheusText` to the file every `interval` seconds (and once right away), until stopped.
+ *  The file is replaced atomically, as the node_exporter textfile collector requires; its name should end in `.prom`.
+ *  The timer comes from `+[DDLog clock]`.
+ */
++ (void)startWritingTextFileAtPath:(NSString *)path interval:(NSTimeInterval)interval;
+
+/**
+ *  Listens on a Unix domain stream socket at `path` (replacing any socket file there).
+ *  Every client that connects is sent `prometheusText`, and the connection is closed,
+ *  so e.g. `nc -U path` or a local scrape proxy can read the metrics.
+ *
+ *  @return NO, with the POSIX error, if the socket couldn't be set up
+ */
++ (BOOL)startServingOnUnixSocketAtPath:(NSString *)path error:(NSError **)error;
+
+/**
+ *  Stops the text file and socket exports, and removes the socket file. Counting goes on.
+ */
++ (void)stopExporting;
+
+/**
+ *  Sets all counters to zero. Mainly for tests: counters that go down look like restarts to Prometheus.
+ */
++ (void)reset;
+
+@end
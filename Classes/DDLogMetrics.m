@@ -0,0 +1,437 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDLogMetrics.h"
+#import "DDLogClock.h"
+
+#import <pthread.h>
+#import <unistd.h>
+#import <fcntl.h>
+#import <sys/socket.h>
+#import <sys/stat.h>
+#import <sys/un.h>
+#import <mach/mach_time.h>
+#import <libkern/OSAtomic.h>
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+// We probably shouldn't be using DDLog() statements within the DDLog implementation.
+// But we still want to leave our log statements for any future debugging,
+// and to allow other developers to trace the implementation (which is a great learning tool).
+//
+// So we use primitive logging macros around NSLog.
+// We maintain the NS prefix on the macros to be explicit about the fact that we're using NSLog.
+
+#ifndef DD_NSLOG_LEVEL
+    #define DD_NSLOG_LEVEL 2
+#endif
+
+#define NSLogError(frmt, ...)    do{ if(DD_NSLOG_LEVEL >= 1) NSLog((frmt), ##__VA_ARGS__); } while(0)
+
+// Upper bounds of the write latency buckets, in nanoseconds (10µs to 1s); a last bucket takes the rest
+#define DD_METRICS_BUCKET_COUNT 7
+
+static const int64_t DDLogMetricsBucketBounds[DD_METRICS_BUCKET_COUNT - 1] = {
+    10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+struct DDLogMetricsLoggerCounters {
+    struct DDLogMetricsLoggerCounters *next;
+    char *name; // Escaped for use as a label value
+    volatile int64_t count;
+    volatile int64_t nanoseconds;
+    volatile int64_t buckets[DD_METRICS_BUCKET_COUNT];
+};
+
+// Each counter on its own cache line, so producers incrementing one don't slow down the logging queue using another
+typedef struct {
+    volatile int64_t value;
+    char padding[64 - sizeof(int64_t)];
+} DDLogMetricsSlot;
+
+volatile BOOL DDLogMetricsActive = NO;
+
+static DDLogMetricsSlot _counters[DDLogMetricsCounterCount] __attribute__((aligned(64)));
+
+// The per logger counters are never freed: a logger that is removed and added again keeps counting
+static DDLogMetricsLoggerCounters *_loggerCounters;
+static pthread_mutex_t _loggerCountersMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static mach_timebase_info_data_t _timebase;
+
+void DDLogMetricsAdd(DDLogMetricsCounter counter, int64_t value) {
+    if (DDLogMetricsActive && counter < DDLogMetricsCounterCount) {
+        OSAtomicAdd64Barrier(value, &_counters[counter].value);
+    }
+}
+
+void DDLogMetricsSet(DDLogMetricsCounter counter, int64_t value) {
+    if (DDLogMetricsActive && counter < DDLogMetricsCounterCount) {
+        _counters[counter].value = value;
+        OSMemoryBarrier();
+    }
+}
+
+uint64_t DDLogMetricsNow(void) {
+    return mach_absolute_time() * _timebase.numer / _timebase.denom;
+}
+
+static char * DDLogMetricsCopyLabelValue(NSString *string) {
+    NSMutableString *escaped = [string mutableCopy];
+
+    [escaped replaceOccurrencesOfString:@"\\" withString:@"\\\\" options:0 range:NSMakeRange(0, escaped.length)];
+    [escaped replaceOccurrencesOfString:@"\"" withString:@"\\\"" options:0 range:NSMakeRange(0, escaped.length)];
+    [escaped replaceOccurrencesOfString:@"\n" withString:@"\\n" options:0 range:NSMakeRange(0, escaped.length)];
+
+    return strdup([escaped UTF8String]);
+}
+
+DDLogMetricsLoggerCounters * DDLogMetricsCountersForLogger(id <DDLogger> logger) {
+    NSString *name = nil;
+
+    if ([logger respondsToSelector:@selector(loggerName)]) {
+        name = [logger loggerName];
+    }
+
+    if (name.length == 0) {
+        name = NSStringFromClass([logger class]);
+    }
+
+    char *label = DDLogMetricsCopyLabelValue(name);
+    DDLogMetricsLoggerCounters *counters;
+
+    pthread_mutex_lock(&_loggerCountersMutex);
+
+    for (counters = _loggerCounters; counters; counters = counters->next) {
+        if (strcmp(counters->name, label) == 0) {
+            break;
+        }
+    }
+
+    if (counters == NULL) {
+        counters = calloc(1, sizeof(DDLogMetricsLoggerCounters));
+        counters->name = label;
+        counters->next = _loggerCounters;
+        _loggerCounters = counters;
+        label = NULL;
+    }
+
+    pthread_mutex_unlock(&_loggerCountersMutex);
+
+    free(label);
+
+    return counters;
+}
+
+void DDLogMetricsRecordLoggerWrite(DDLogMetricsLoggerCounters *counters, uint64_t nanoseconds) {
+    NSUInteger bucket = 0;
+
+    while (bucket < DD_METRICS_BUCKET_COUNT - 1 && (int64_t)nanoseconds > DDLogMetricsBucketBounds[bucket]) {
+        bucket++;
+    }
+
+    OSAtomicIncrement64Barrier(&counters->count);
+    OSAtomicAdd64Barrier((int64_t)nanoseconds, &counters->nanoseconds);
+    OSAtomicIncrement64Barrier(&counters->buckets[bucket]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static dispatch_queue_t _exportQueue;
+
+// Guarded by @synchronized([DDLogMetrics class])
+static id <DDLogClockTimer> _textFileTimer;
+static dispatch_source_t _socketSource;
+static NSString *_socketPath;
+
+@implementation DDLogMetrics
+
++ (void)initialize {
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        _exportQueue = dispatch_queue_create("cocoa.lumberjack.metrics", DISPATCH_QUEUE_SERIAL);
+    });
+}
+
++ (BOOL)isEnabled {
+    return DDLogMetricsActive;
+}
+
++ (void)setEnabled:(BOOL)enabled {
+    if (_timebase.denom == 0) {
+        mach_timebase_info(&_timebase);
+    }
+
+    DDLogMetricsActive = enabled;
+    OSMemoryBarrier();
+}
+
+static int64_t DDLogMetricsValue(DDLogMetricsCounter counter) {
+    return _counters[counter].value;
+}
+
+static void DDLogMetricsAppend(NSMutableString *text, NSString *name, NSString *type, NSString *help, NSString *value) {
+    [text appendFormat:@"# HELP %@ %@\n# TYPE %@ %@\n%@ %@\n", name, help, name, type, name, value];
+}
+
++ (NSString *)prometheusText {
+    NSMutableString *text = [NSMutableString stringWithCapacity:4096];
+
+    OSMemoryBarrier();
+
+    int64_t enqueued = DDLogMetricsValue(DDLogMetricsCounterMessagesEnqueued);
+    int64_t dequeued = DDLogMetricsValue(DDLogMetricsCounterMessagesDequeued);
+
+    DDLogMetricsAppend(text, @"dd_log_messages_enqueued_total", @"counter",
+                       @"Log messages added to the logging queue.", @(enqueued).stringValue);
+    DDLogMetricsAppend(text, @"dd_log_messages_dequeued_total", @"counter",
+                       @"Log messages taken from the logging queue and handed to the loggers.", @(dequeued).stringValue);
+    // Messages queued before counting started are dequeued without having been counted
+    DDLogMetricsAppend(text, @"dd_log_queue_depth", @"gauge",
+                       @"Log messages waiting in the logging queue.", @(MAX(enqueued - dequeued, 0)).stringValue);
+    DDLogMetricsAppend(text, @"dd_log_messages_dropped_total", @"counter",
+                       @"Log messages not delivered to loggers in quarantine.",
+                       @(DDLogMetricsValue(DDLogMetricsCounterMessagesDropped)).stringValue);
+    DDLogMetricsAppend(text, @"dd_log_producer_blocks_total", @"counter",
+                       @"Log statements that waited for room in the logging queue.",
+                       @(DDLogMetricsValue(DDLogMetricsCounterProducerBlocks)).stringValue);
+    DDLogMetricsAppend(text, @"dd_log_producer_block_seconds_total", @"counter",
+                       @"Time log statements waited for room in the logging queue.",
+                       [self secondsString:DDLogMetricsValue(DDLogMetricsCounterProducerBlockNanoseconds)]);
+    DDLogMetricsAppend(text, @"dd_log_file_rolls_total", @"counter",
+                       @"Log files rolled by file loggers.",
+                       @(DDLogMetricsValue(DDLogMetricsCounterFileRolls)).stringValue);
+    DDLogMetricsAppend(text, @"dd_log_file_bytes_written_total", @"counter",
+                       @"Bytes written to log files by file loggers.",
+                       @(DDLogMetricsValue(DDLogMetricsCounterFileBytesWritten)).stringValue);
+    DDLogMetricsAppend(text, @"dd_log_file_exceptions_total", @"counter",
+                       @"Exceptions raised while writing log files.",
+                       @(DDLogMetricsValue(DDLogMetricsCounterFileExceptions)).stringValue);
+    DDLogMetricsAppend(text, @"dd_log_compression_backlog", @"gauge",
+                       @"Archived log files waiting to be compressed.",
+                       @(DDLogMetricsValue(DDLogMetricsCounterCompressionBacklog)).stringValue);
+
+    [text appendString:@"# HELP dd_log_logger_write_seconds Time a logger spent on a log message.\n"
+                       @"# TYPE dd_log_logger_write_seconds histogram\n"];
+
+    pthread_mutex_lock(&_loggerCountersMutex);
+
+    for (DDLogMetricsLoggerCounters *counters = _loggerCounters; counters; counters = counters->next) {
+        int64_t cumulative = 0;
+
+        for (NSUInteger i = 0; i < DD_METRICS_BUCKET_COUNT; i++) {
+            cumulative += counters->buckets[i];
+
+            NSString *bound = (i < DD_METRICS_BUCKET_COUNT - 1) ? [self secondsString:DDLogMetricsBucketBounds[i]] : @"+Inf";
+            [text appendFormat:@"dd_log_logger_write_seconds_bucket{logger=\"%s\",le=\"%@\"} %lld\n",
+                               counters->name, bound, cumulative];
+        }
+
+        [text appendFormat:@"dd_log_logger_write_seconds_sum{logger=\"%s\"} %@\n",
+                           counters->name, [self secondsString:counters->nanoseconds]];
+        [text appendFormat:@"dd_log_logger_write_seconds_count{logger=\"%s\"} %lld\n", counters->name, cumulative];
+    }
+
+    pthread_mutex_unlock(&_loggerCountersMutex);
+
+    return text;
+}
+
++ (NSString *)secondsString:(int64_t)nanoseconds {
+    return [NSString stringWithFormat:@"%.9g", (double)nanoseconds / NSEC_PER_SEC];
+}
+
++ (void)reset {
+    for (NSUInteger i = 0; i < DDLogMetricsCounterCount; i++) {
+        _counters[i].value = 0;
+    }
+
+    pthread_mutex_lock(&_loggerCountersMutex);
+
+    for (DDLogMetricsLoggerCounters *counters = _loggerCounters; counters; counters = counters->next) {
+        counters->count = 0;
+        counters->nanoseconds = 0;
+        memset((void *)counters->buckets, 0, sizeof(counters->buckets));
+    }
+
+    pthread_mutex_unlock(&_loggerCountersMutex);
+
+    OSMemoryBarrier();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Export
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
++ (void)startWritingTextFileAtPath:(NSString *)path interval:(NSTimeInterval)interval {
+    [self setEnabled:YES];
+
+    dispatch_block_t writeBlock = ^{ @autoreleasepool {
+        NSData *data = [[self prometheusText] dataUsingEncoding:NSUTF8StringEncoding];
+        NSError *error = nil;
+
+        if (![data writeToFile:path options:NSDataWritingAtomic error:&error]) {
+            NSLogError(@"DDLogMetrics: Error writing %@: %@", path, error);
+        }
+    } };
+
+    id <DDLogClockTimer> timer = [[DDLog clock] scheduleTimerWithDelay:interval
+                                                              interval:interval
+                                                                 queue:_exportQueue
+                                                               handler:writeBlock];
+
+    @synchronized(self) {
+        [_textFileTimer cancel];
+        _textFileTimer = timer;
+    }
+
+    dispatch_async(_exportQueue, writeBlock);
+}
+
++ (BOOL)startServingOnUnixSocketAtPath:(NSString *)path error:(NSError **)error {
+    struct sockaddr_un address;
+    const char *fileSystemPath = [path fileSystemRepresentation];
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (strlen(fileSystemPath) >= sizeof(address.sun_path)) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:ENAMETOOLONG userInfo:nil];
+        }
+
+        return NO;
+    }
+
+    strlcpy(address.sun_path, fileSystemPath, sizeof(address.sun_path));
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        }
+
+        return NO;
+    }
+
+    // Replace a socket left behind by an earlier run, but nothing else
+    struct stat fileInfo;
+
+    if (lstat(fileSystemPath, &fileInfo) == 0 && S_ISSOCK(fileInfo.st_mode)) {
+        unlink(fileSystemPath);
+    }
+
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(fd, 8) != 0 ||
+        fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+        int errorCode = errno;
+
+        close(fd);
+
+        if (error) {
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errorCode userInfo:nil];
+        }
+
+        return NO;
+    }
+
+    [self setEnabled:YES];
+
+    dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _exportQueue);
+
+    dispatch_source_set_event_handler(source, ^{ @autoreleasepool {
+        int client;
+
+        while ((client = accept(fd, NULL, NULL)) >= 0) {
+            [self writeText:[self prometheusText] toClient:client];
+            close(client);
+        }
+    } });
+
+    NSString *socketPath = [path copy];
+
+    dispatch_source_set_cancel_handler(source, ^{
+        close(fd);
+        unlink([socketPath fileSystemRepresentation]);
+    });
+
+    @synchronized(self) {
+        [self cancelSocketSource];
+
+        _socketSource = source;
+        _socketPath = socketPath;
+    }
+
+    dispatch_resume(source);
+
+    return YES;
+}
+
++ (void)writeText:(NSString *)text toClient:(int)client {
+    NSData *data = [text dataUsingEncoding:NSUTF8StringEncoding];
+    const uint8_t *bytes = data.bytes;
+    size_t remaining = data.length;
+
+    // The listening socket is non blocking, and on some systems accepted sockets inherit that
+    fcntl(client, F_SETFL, fcntl(client, F_GETFL) & ~O_NONBLOCK);
+
+    #ifdef SO_NOSIGPIPE
+    int noSigPipe = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+    #endif
+
+    while (remaining > 0) {
+        ssize_t written = write(client, bytes, remaining);
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            break;
+        }
+
+        bytes += written;
+        remaining -= (size_t)written;
+    }
+}
+
++ (void)cancelSocketSource {
+    if (_socketSource) {
+        dispatch_source_cancel(_socketSource);
+        #if !OS_OBJECT_USE_OBJC
+        dispatch_release(_socketSource);
+        #endif
+        _socketSource = NULL;
+        _socketPath = nil;
+    }
+}
+
++ (void)stopExporting {
+    @synchronized(self) {
+        [_textFileTimer cancel];
+        _textFileTimer = nil;
+
+        [self cancelSocketSource];
+    }
+}
+
+@end
@@ -0,0 +1,100 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Number rendering for message formatting, straight into UTF-8 (ASCII) buffers.
+ *
+ * The `printf` family goes through the generic format parser and the locale for every number.
+ * These functions don't: integers are written two digits at a time from a table of digit pairs,
+ * and doubles are converted with Grisu2 (Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+ * with Integers", PLDI 2010), which finds digits that read back as the same double with 64 bit integer arithmetic
+ * only. They are the shortest such digits in over 99.9% of the cases.
+ *
+ * The output never depends on the locale (the decimal separator is always '.').
+ * `DDLogFormatDoubleFixed` and `DDLogFormatDoubleGeneral` print exactly what `%.*f` and `%.*g` would;
+ * when the shortest digits aren't enough to know the correctly rounded result, they fall back to `snprintf`.
+ *
+ * None of the functions allocate, and all but the `snprintf` fallbacks are async-signal-safe.
+ * Used by the C++ front end (`DDLog+CXX.h`), `DDTTYLogger` timestamps and the thread IDs of `DDLogMessage`.
+ **/
+
+/**
+ * Maximum number of characters written by the integer functions (without width).
+ **/
+#define DD_LOG_INTEGER_MAX_LENGTH 20
+
+/**
+ * Maximum number of characters written by `DDLogFormatDouble`.
+ **/
+#define DD_LOG_DOUBLE_MAX_LENGTH 32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  Writes an unsigned integer in decimal, like `%llu`. The buffer isn't NUL terminated.
+ *
+ *  @param buffer at least DD_LOG_INTEGER_MAX_LENGTH characters
+ *
+ *  @return the number of characters written
+ */
+size_t DDLogFormatUnsignedInteger(char *buffer, uint64_t value);
+
+/**
+ *  Writes a signed integer in decimal, like `%lld`. The buffer isn't NUL terminated.
+ *
+ *  @param buffer at least DD_LOG_INTEGER_MAX_LENGTH characters
+ *
+ *  @return the number of characters written
+ */
+size_t DDLogFormatInteger(char *buffer, int64_t value);
+
+/**
+ *  Writes an unsigned integer in decimal, padded with zeros to at least `width` digits, like `%0*llu`.
+ *  The buffer isn't NUL terminated.
+ *
+ *  @param buffer at least MAX(width, DD_LOG_INTEGER_MAX_LENGTH) characters
+ *
+ *  @return the number of characters written
+ */
+size_t DDLogFormatUnsignedIntegerWithWidth(char *buffer, uint64_t value, NSUInteger width);
+
+/**
+ *  Writes the shortest (see above) decimal representation of a double that reads back as the same double,
+ *  in the notation `%.17g` would use (so integers below 10^17 have no exponent). The buffer isn't NUL terminated.
+ *  Infinities and NaN are written as "inf", "-inf" and "nan".
+ *
+ *  @param buffer at least DD_LOG_DOUBLE_MAX_LENGTH characters
+ *
+ *  @return the number of characters written
+ */
+size_t DDLogFormatDouble(char *buffer, double value);
+
+/**
+ *  Same output and return value as `snprintf(buffer, size, "%.*f", precision, value)`.
+ */
+int DDLogFormatDoubleFixed(char *buffer, size_t size, double value, int precision);
+
+/**
+ *  Same output and return value as `snprintf(buffer, size, "%.*g", precision, value)`.
+ */
+int DDLogFormatDoubleGeneral(char *buffer, size_t size, double value, int precision);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,492 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDLogNumberFormatting.h"
+
+#import <float.h>
+#import <math.h>
+#import <stdio.h>
+#import <string.h>
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Integers
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static const char DDLogDigitPairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static NSUInteger DDLogDecimalDigitCount(uint64_t value) {
+    NSUInteger count = 1;
+
+    while (value >= 10000) {
+        value /= 10000;
+        count += 4;
+    }
+
+    return count + (value >= 10) + (value >= 100) + (value >= 1000);
+}
+
+/**
+ * Writes the `count` last digits of the value, ending right before `end`.
+ **/
+static void DDLogWriteDigitsBackwards(char *end, uint64_t value, NSUInteger count) {
+    while (count >= 2) {
+        end -= 2;
+        memcpy(end, DDLogDigitPairs + (value % 100) * 2, 2);
+        value /= 100;
+        count -= 2;
+    }
+
+    if (count) {
+        *--end = (char)('0' + value % 10);
+    }
+}
+
+size_t DDLogFormatUnsignedInteger(char *buffer, uint64_t value) {
+    NSUInteger count = DDLogDecimalDigitCount(value);
+    DDLogWriteDigitsBackwards(buffer + count, value, count);
+    return count;
+}
+
+size_t DDLogFormatInteger(char *buffer, int64_t value) {
+    if (value < 0) {
+        buffer[0] = '-';
+        return 1 + DDLogFormatUnsignedInteger(buffer + 1, (uint64_t)0 - (uint64_t)value);
+    }
+
+    return DDLogFormatUnsignedInteger(buffer, (uint64_t)value);
+}
+
+size_t DDLogFormatUnsignedIntegerWithWidth(char *buffer, uint64_t value, NSUInteger width) {
+    NSUInteger count = DDLogDecimalDigitCount(value);
+    NSUInteger length = MAX(count, width);
+
+    memset(buffer, '0', length - count);
+    DDLogWriteDigitsBackwards(buffer + length, value, count);
+
+    return length;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Grisu2
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A floating point number with a 64 bit significand: f * 2^e ("do it yourself floating point")
+typedef struct {
+    uint64_t f;
+    int e;
+} DDLogDiyFp;
+
+#define DD_DOUBLE_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define DD_DOUBLE_HIDDEN_BIT       0x0010000000000000ULL
+#define DD_DOUBLE_EXPONENT_BIAS    (0x3FF + 52)
+
+// Normalized 10^k, for k from -348 to 340 in steps of 8
+static const uint64_t DDLogCachedPowersF[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+
+static const int16_t DDLogCachedPowersE[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066,
+};
+
+static uint64_t DDLogDoubleBits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static DDLogDiyFp DDLogDiyFpFromDouble(double value) {
+    uint64_t bits = DDLogDoubleBits(value);
+    int biasedExponent = (int)((bits >> 52) & 0x7FF);
+    uint64_t significand = bits & DD_DOUBLE_SIGNIFICAND_MASK;
+
+    if (biasedExponent != 0) {
+        return (DDLogDiyFp){ significand + DD_DOUBLE_HIDDEN_BIT, biasedExponent - DD_DOUBLE_EXPONENT_BIAS };
+    } else {
+        return (DDLogDiyFp){ significand, 1 - DD_DOUBLE_EXPONENT_BIAS };
+    }
+}
+
+static DDLogDiyFp DDLogDiyFpNormalize(DDLogDiyFp x) {
+    while (!(x.f & (1ULL << 63))) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+// The upper 64 bits of the product, rounded
+static DDLogDiyFp DDLogDiyFpMultiply(DDLogDiyFp x, DDLogDiyFp y) {
+    uint64_t a = x.f >> 32, b = x.f & 0xFFFFFFFF;
+    uint64_t c = y.f >> 32, d = y.f & 0xFFFFFFFF;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t middle = (bd >> 32) + (ad & 0xFFFFFFFF) + (bc & 0xFFFFFFFF) + (1ULL << 31);
+
+    return (DDLogDiyFp){ ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64 };
+}
+
+static void DDLogGrisuRound(char *digits, int length, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t distance) {
+    while (rest < distance && delta - rest >= tenKappa &&
+           (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance)) {
+        digits[length - 1]--;
+        rest += tenKappa;
+    }
+}
+
+static const uint64_t DDLogPowersOf10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+    10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+    10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static int DDLogGrisuDigitGen(DDLogDiyFp w, DDLogDiyFp mp, uint64_t delta, char *digits, int *k) {
+
+    DDLogDiyFp one = { 1ULL << -mp.e, mp.e };
+    uint64_t distance = mp.f - w.f;
+    uint32_t p1 = (uint32_t)(mp.f >> -one.e);
+    uint64_t p2 = mp.f & (one.f - 1);
+    int kappa = (int)DDLogDecimalDigitCount(p1);
+    int length = 0;
+
+    while (kappa > 0) {
+        uint32_t digit = (uint32_t)(p1 / DDLogPowersOf10[kappa - 1]);
+        p1 = (uint32_t)(p1 % DDLogPowersOf10[kappa - 1]);
+
+        if (digit || length) {
+            digits[length++] = (char)('0' + digit);
+        }
+
+        kappa--;
+
+        uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+        if (rest <= delta) {
+            *k += kappa;
+            DDLogGrisuRound(digits, length, delta, rest, DDLogPowersOf10[kappa] << -one.e, distance);
+            return length;
+        }
+    }
+
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+
+        char digit = (char)(p2 >> -one.e);
+        if (digit || length) {
+            digits[length++] = (char)('0' + digit);
+        }
+
+        p2 &= one.f - 1;
+        kappa--;
+
+        if (p2 < delta) {
+            *k += kappa;
+            DDLogGrisuRound(digits, length, delta, p2, one.f, distance * (-kappa < 20 ? DDLogPowersOf10[-kappa] : 0));
+            return length;
+        }
+    }
+}
+
+/**
+ * The shortest digits (up to 17, without trailing zeros) of a finite, positive double: value = digits * 10^exponent.
+ * Returns the number of digits.
+ **/
+static int DDLogShortestDigits(double value, char *digits, int *exponent) {
+    DDLogDiyFp v = DDLogDiyFpFromDouble(value);
+
+    // The boundaries of the rounding interval, with the same exponent
+    DDLogDiyFp plus = { (v.f << 1) + 1, v.e - 1 };
+    while (!(plus.f & (DD_DOUBLE_HIDDEN_BIT << 1))) {
+        plus.f <<= 1;
+        plus.e--;
+    }
+    plus.f <<= 64 - 52 - 2;
+    plus.e -= 64 - 52 - 2;
+
+    DDLogDiyFp minus = (v.f == DD_DOUBLE_HIDDEN_BIT) ? (DDLogDiyFp){ (v.f << 2) - 1, v.e - 2 } : (DDLogDiyFp){ (v.f << 1) - 1, v.e - 1 };
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    // A cached power of ten that brings the exponent of the upper boundary into [-60, -32]
+    double dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    if (dk - k > 0.0) {
+        k++;
+    }
+
+    unsigned index = (unsigned)((k >> 3) + 1);
+    DDLogDiyFp cachedPower = { DDLogCachedPowersF[index], DDLogCachedPowersE[index] };
+    int decimalExponent = -(-348 + (int)(index << 3));
+
+    DDLogDiyFp w = DDLogDiyFpMultiply(DDLogDiyFpNormalize(v), cachedPower);
+    DDLogDiyFp wPlus = DDLogDiyFpMultiply(plus, cachedPower);
+    DDLogDiyFp wMinus = DDLogDiyFpMultiply(minus, cachedPower);
+    wMinus.f++;
+    wPlus.f--;
+
+    int length = DDLogGrisuDigitGen(w, wPlus, wPlus.f - wMinus.f, digits, &decimalExponent);
+
+    while (length > 1 && digits[length - 1] == '0') {
+        length--;
+        decimalExponent++;
+    }
+
+    *exponent = decimalExponent;
+    return length;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Doubles
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Writes digits * 10^exponent in the notation of %g with the given precision (without trailing zeros).
+ **/
+static size_t DDLogWriteGeneral(char *buffer, BOOL negative, const char *digits, int length, int exponent, int precision) {
+    char *out = buffer;
+    int x = length + exponent - 1; // The exponent in scientific notation
+
+    if (negative) {
+        *out++ = '-';
+    }
+
+    if (x < -4 || x >= precision) {
+        *out++ = digits[0];
+        if (length > 1) {
+            *out++ = '.';
+            memcpy(out, digits + 1, (size_t)(length - 1));
+            out += length - 1;
+        }
+
+        *out++ = 'e';
+        *out++ = (x < 0) ? '-' : '+';
+        out += DDLogFormatUnsignedIntegerWithWidth(out, (uint64_t)(x < 0 ? -x : x), 2);
+    } else if (x < 0) {
+        // 0.000ddd
+        memcpy(out, "0.0000", (size_t)(1 - x));
+        out += 1 - x;
+        memcpy(out, digits, (size_t)length);
+        out += length;
+    } else if (length <= x + 1) {
+        // ddd000
+        memcpy(out, digits, (size_t)length);
+        out += length;
+        memset(out, '0', (size_t)(x + 1 - length));
+        out += x + 1 - length;
+    } else {
+        // ddd.ddd
+        memcpy(out, digits, (size_t)(x + 1));
+        out += x + 1;
+        *out++ = '.';
+        memcpy(out, digits + x + 1, (size_t)(length - x - 1));
+        out += length - x - 1;
+    }
+
+    return (size_t)(out - buffer);
+}
+
+size_t DDLogFormatDouble(char *buffer, double value) {
+    if (isnan(value)) {
+        memcpy(buffer, "nan", 3);
+        return 3;
+    }
+
+    BOOL negative = signbit(value) != 0;
+
+    if (isinf(value) || value == 0) {
+        const char *text = isinf(value) ? "-inf" : "-0";
+        size_t length = strlen(text) - (negative ? 0 : 1);
+        memcpy(buffer, text + (negative ? 0 : 1), length);
+        return length;
+    }
+
+    char digits[18];
+    int exponent;
+    int length = DDLogShortestDigits(fabs(value), digits, &exponent);
+
+    return DDLogWriteGeneral(buffer, negative, digits, length, exponent, 17);
+}
+
+/**
+ * Copies what the fast paths wrote, with the semantics of snprintf.
+ **/
+static int DDLogCopyFormatted(char *buffer, size_t size, const char *formatted, size_t length) {
+    if (size > 0) {
+        size_t copied = MIN(length, size - 1);
+        memcpy(buffer, formatted, copied);
+        buffer[copied] = '\0';
+    }
+
+    return (int)length;
+}
+
+/**
+ * Whether the distance between the double and its neighbours is below 10^-precision,
+ * so that rounding it to `precision` decimals gives the same result as rounding its shortest digits.
+ **/
+static BOOL DDLogDoubleIsFinerThanDecimals(double value, int precision) {
+    int biasedExponent = (int)((DDLogDoubleBits(value) >> 52) & 0x7FF);
+    int ulpExponent = (biasedExponent ? biasedExponent : 1) - DD_DOUBLE_EXPONENT_BIAS;
+
+    // 2^ulpExponent < 10^-precision (they are never equal)
+    return ulpExponent < -precision * 3.321928094887362;
+}
+
+int DDLogFormatDoubleFixed(char *buffer, size_t size, double value, int precision) {
+    if (precision < 0) {
+        precision = 6;
+    }
+
+    // Beyond 2^53 every double is an integer, with more digits than the shortest ones
+    if (!isfinite(value) || precision > 17 || fabs(value) >= 9007199254740992.0) {
+        return snprintf(buffer, size, "%.*f", precision, value);
+    }
+
+    char digits[18];
+    int exponent = 0;
+    int length = 1;
+    digits[0] = '0';
+
+    if (value != 0) {
+        length = DDLogShortestDigits(fabs(value), digits, &exponent);
+
+        if (-exponent > precision || !DDLogDoubleIsFinerThanDecimals(value, precision)) {
+            return snprintf(buffer, size, "%.*f", precision, value);
+        }
+    }
+
+    char formatted[64];
+    char *out = formatted;
+    int integerDigits = length + exponent;
+
+    if (signbit(value)) {
+        *out++ = '-';
+    }
+
+    // Integer part
+    if (integerDigits <= 0) {
+        *out++ = '0';
+    } else if (exponent >= 0) {
+        memcpy(out, digits, (size_t)length);
+        out += length;
+        memset(out, '0', (size_t)exponent);
+        out += exponent;
+    } else {
+        memcpy(out, digits, (size_t)integerDigits);
+        out += integerDigits;
+    }
+
+    // Fraction
+    if (precision > 0) {
+        *out++ = '.';
+        int written = 0;
+
+        if (exponent < 0) {
+            int leadingZeros = MAX(0, -integerDigits);
+            memset(out, '0', (size_t)leadingZeros);
+            out += leadingZeros;
+
+            int fractionDigits = -exponent - leadingZeros;
+            memcpy(out, digits + length - fractionDigits, (size_t)fractionDigits);
+            out += fractionDigits;
+
+            written = -exponent;
+        }
+
+        memset(out, '0', (size_t)(precision - written));
+        out += precision - written;
+    }
+
+    return DDLogCopyFormatted(buffer, size, formatted, (size_t)(out - formatted));
+}
+
+int DDLogFormatDoubleGeneral(char *buffer, size_t size, double value, int precision) {
+    if (precision < 0) {
+        precision = 6;
+    } else if (precision == 0) {
+        precision = 1;
+    }
+
+    // Up to 15 digits, the shortest digits padded with zeros are the correctly rounded ones,
+    // as long as the double has all 53 bits of precision (subnormals don't)
+    if (!isfinite(value) || precision > 15 || (value != 0 && fabs(value) < DBL_MIN)) {
+        return snprintf(buffer, size, "%.*g", precision, value);
+    }
+
+    char formatted[DD_LOG_DOUBLE_MAX_LENGTH];
+
+    if (value == 0) {
+        return DDLogCopyFormatted(buffer, size, signbit(value) ? "-0" : "0", signbit(value) ? 2 : 1);
+    }
+
+    char digits[18];
+    int exponent;
+    int length = DDLogShortestDigits(fabs(value), digits, &exponent);
+
+    if (length > precision) {
+        return snprintf(buffer, size, "%.*g", precision, value);
+    }
+
+    size_t formattedLength = DDLogWriteGeneral(formatted, signbit(value) != 0, digits, length, exponent, precision);
+    return DDLogCopyFormatted(buffer, size, formatted, formattedLength);
+}
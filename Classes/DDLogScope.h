@@ -0,0 +1,126 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+#import <pthread.h>
+
+/**
+ * Scoped log levels.
+ *
+ * A scope temporarily elevates the log level (and optionally sets the context) for the code running inside of it,
+ * on the current thread, without touching the global or per-file levels. For example, to get verbose logs
+ * for one request in a thousand, or for a single customer:
+ *
+ * if (arc4random_uniform(1000) == 0) {
+ *     [DDLogScope performWithLevel:DDLogLevelVerbose context:kRequestTracingContext block:^{
+ *         [self handleRequest:request];
+ *     }];
+ * }
+ *
+ * The scope is kept in thread local storage. Work dispatched from inside a scope only inherits it
+ * if the block is wrapped with `DDLogScopeWrapBlock` (or dispatched with `DDLogScopeDispatchAsync`).
+ *
+ * The log macros only consult the scope if `DD_LOG_SCOPED_LEVELS` is defined to 1 before DDLogMacros.h is imported.
+ * This is opt-in because a runtime check defeats the compile-time stripping of log statements
+ * when `ddLogLevel` is a constant. When enabled, a log statement below the per-file level costs
+ * a single thread local load if no scope is active.
+ *
+ * Messages logged from inside a scope with a context of 0 get the context of the scope.
+ **/
+
+/**
+ * A scope frame. Frames live on the stack of `performWithLevel:context:block:`.
+ **/
+typedef struct DDLogScopeFrame {
+    DDLogLevel level;
+    NSInteger context;
+    const struct DDLogScopeFrame *parent;
+} DDLogScopeFrame;
+
+/**
+ * The thread local storage key holding the innermost `DDLogScopeFrame`. Don't use directly.
+ **/
+extern pthread_key_t DDLogScopeKey;
+
+/**
+ *  The level of the innermost scope of the current thread, `DDLogLevelOff` outside of any scope.
+ */
+static inline DDLogLevel DDLogScopeCurrentLevel(void) {
+    const DDLogScopeFrame *frame = (const DDLogScopeFrame *)pthread_getspecific(DDLogScopeKey);
+    return frame ? frame->level : DDLogLevelOff;
+}
+
+/**
+ *  The context of the innermost scope of the current thread, 0 outside of any scope.
+ */
+static inline NSInteger DDLogScopeCurrentContext(void) {
+    const DDLogScopeFrame *frame = (const DDLogScopeFrame *)pthread_getspecific(DDLogScopeKey);
+    return frame ? frame->context : 0;
+}
+
+/**
+ *  Returns a block that runs `block` inside the scope that is current when this function is called.
+ *  Returns `block` itself if there is no current scope.
+ */
+dispatch_block_t DDLogScopeWrapBlock(dispatch_block_t block);
+
+/**
+ *  `dispatch_async`, propagating the current scope into the block.
+ */
+void DDLogScopeDispatchAsync(dispatch_queue_t queue, dispatch_block_t block);
+
+/**
+ *  `dispatch_sync`, propagating the current scope into the block.
+ */
+void DDLogScopeDispatchSync(dispatch_queue_t queue, dispatch_block_t block);
+
+
+@interface DDLogScope : NSObject
+
+/**
+ *  Runs the block synchronously, with the given level on the current thread.
+ *  The context of the enclosing scope (if any) is kept.
+ *
+ *  @param level the level of the scope. It is combined (OR) with the per-file level by the macros.
+ *  @param block the code to run inside the scope
+ */
++ (void)performWithLevel:(DDLogLevel)level block:(dispatch_block_t)block;
+
+/**
+ *  Runs the block synchronously, with the given level and context on the current thread.
+ *
+ *  @param level   the level of the scope. It is combined (OR) with the per-file level by the macros.
+ *  @param context the context for messages logged with a context of 0, or 0 to keep the context of the enclosing scope
+ *  @param block   the code to run inside the scope
+ */
++ (void)performWithLevel:(DDLogLevel)level context:(NSInteger)context block:(dispatch_block_t)block;
+
+/**
+ *  The level of the innermost scope of the current thread, `DDLogLevelOff` outside of any scope.
+ */
++ (DDLogLevel)currentLevel;
+
+/**
+ *  The context of the innermost scope of the current thread, 0 outside of any scope.
+ */
++ (NSInteger)currentContext;
+
+@end
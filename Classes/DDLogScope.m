@@ -0,0 +1,88 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDLogScope.h"
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+pthread_key_t DDLogScopeKey;
+
+// The key has to exist before the first log statement, which may well run before any class is initialized.
+__attribute__((constructor)) static void DDLogScopeCreateKey(void) {
+    pthread_key_create(&DDLogScopeKey, NULL);
+}
+
+dispatch_block_t DDLogScopeWrapBlock(dispatch_block_t block) {
+    const DDLogScopeFrame *frame = (const DDLogScopeFrame *)pthread_getspecific(DDLogScopeKey);
+
+    if (frame == NULL || block == nil) {
+        return block;
+    }
+
+    // Capture by value, the frame itself is gone as soon as the scope ends
+    DDLogLevel level = frame->level;
+    NSInteger context = frame->context;
+
+    return ^{
+        [DDLogScope performWithLevel:level context:context block:block];
+    };
+}
+
+void DDLogScopeDispatchAsync(dispatch_queue_t queue, dispatch_block_t block) {
+    dispatch_async(queue, DDLogScopeWrapBlock(block));
+}
+
+void DDLogScopeDispatchSync(dispatch_queue_t queue, dispatch_block_t block) {
+    dispatch_sync(queue, DDLogScopeWrapBlock(block));
+}
+
+@implementation DDLogScope
+
++ (void)performWithLevel:(DDLogLevel)level block:(dispatch_block_t)block {
+    [self performWithLevel:level context:0 block:block];
+}
+
++ (void)performWithLevel:(DDLogLevel)level context:(NSInteger)context block:(dispatch_block_t)block {
+    if (block == nil) {
+        return;
+    }
+
+    const DDLogScopeFrame *parent = (const DDLogScopeFrame *)pthread_getspecific(DDLogScopeKey);
+
+    DDLogScopeFrame frame;
+    frame.level = level;
+    frame.context = (context == 0 && parent) ? parent->context : context;
+    frame.parent = parent;
+
+    pthread_setspecific(DDLogScopeKey, &frame);
+
+    @try {
+        block();
+    } @finally {
+        pthread_setspecific(DDLogScopeKey, parent);
+    }
+}
+
++ (DDLogLevel)currentLevel {
+    return DDLogScopeCurrentLevel();
+}
+
++ (NSInteger)currentContext {
+    return DDLogScopeCurrentContext();
+}
+
+@end
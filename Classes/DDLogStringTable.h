@@ -0,0 +1,75 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+/**
+ * An intern table for the strings every log message carries and that repeat all the time:
+ * file and function names, thread names and queue labels.
+ *
+ * Each distinct string gets a small integer ID (see `DDLogStringID`), one shared immutable NSString
+ * and its UTF-8 bytes, kept for the lifetime of the process. Messages store the IDs and point to the shared strings
+ * instead of creating strings of their own, and sinks that write bytes (such as `DDLogCollector`) copy
+ * the cached UTF-8 instead of converting the strings for every message.
+ *
+ * The table is sharded by the hash of the bytes, 16 ways. Lookups don't lock: entries never change
+ * or go away once published. Adding a string locks its shard only. The table holds at most 65536 strings;
+ * once it is full, interning fails (returns 0) and callers keep strings of their own.
+ **/
+
+/**
+ *  Maximum number of strings in the table.
+ */
+#define DD_LOG_STRING_TABLE_CAPACITY 65536
+
+/**
+ *  Interns `length` bytes of UTF-8 (not necessarily NUL terminated).
+ *
+ *  @return the ID of the string, or 0 if `bytes` is NULL, isn't valid UTF-8 or the table is full
+ */
+DDLogStringID DDLogStringTableIntern(const char *bytes, size_t length);
+
+/**
+ *  Interns a NUL terminated UTF-8 string that is never deallocated, such as `__FILE__` or a string literal.
+ *  The ID is also cached by the address of the string, so interning it again doesn't even read it.
+ */
+DDLogStringID DDLogStringTableInternStatic(const char *string);
+
+/**
+ *  Interns the UTF-8 of a string.
+ */
+DDLogStringID DDLogStringTableInternString(NSString *string);
+
+/**
+ *  The shared string of an ID, nil for 0.
+ */
+NSString * DDLogStringTableString(DDLogStringID identifier);
+
+/**
+ *  The UTF-8 bytes of an ID (NUL terminated), NULL for 0.
+ *
+ *  @param length if not NULL, set to the number of bytes (without the NUL)
+ */
+const char * DDLogStringTableUTF8(DDLogStringID identifier, size_t *length);
+
+/**
+ *  Number of strings in the table.
+ */
+NSUInteger DDLogStringTableCount(void);
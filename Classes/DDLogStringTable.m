@@ -0,0 +1,357 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDLogStringTable.h"
+
+#import <libkern/OSAtomic.h>
+#import <pthread.h>
+#import <stdlib.h>
+#import <string.h>
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+#define DD_LOG_STRING_TABLE_SHARD_BITS   4
+#define DD_LOG_STRING_TABLE_SHARDS       (1 << DD_LOG_STRING_TABLE_SHARD_BITS)
+#define DD_LOG_STRING_TABLE_CHUNK_LENGTH 1024
+#define DD_LOG_STRING_TABLE_CHUNKS       (DD_LOG_STRING_TABLE_CAPACITY / DD_LOG_STRING_TABLE_CHUNK_LENGTH)
+
+// Capacity of a shard's hash table when its first string is added; it doubles at 75% load
+#define DD_LOG_STRING_TABLE_INITIAL_BUCKETS 64
+
+// Slots of the cache of static strings by address (a power of two)
+#define DD_LOG_STRING_TABLE_STATIC_BITS  10
+#define DD_LOG_STRING_TABLE_STATIC_SLOTS (1 << DD_LOG_STRING_TABLE_STATIC_BITS)
+
+typedef struct {
+    uint64_t hash;
+    size_t length;
+    DDLogStringID identifier;
+    const void *string; // Retained NSString on `bytes`, never released
+    char bytes[];       // NUL terminated
+} DDLogStringEntry;
+
+typedef struct {
+    NSUInteger capacity; // A power of two
+    DDLogStringEntry * volatile entries[];
+} DDLogStringBuckets;
+
+typedef struct {
+    pthread_mutex_t lock;
+    DDLogStringBuckets * volatile buckets;
+    NSUInteger count;
+} DDLogStringShard;
+
+typedef struct {
+    const char *string;
+    DDLogStringID identifier;
+} DDLogStaticStringEntry;
+
+static DDLogStringShard _shards[DD_LOG_STRING_TABLE_SHARDS];
+
+// ID -> entry, in chunks that are allocated on demand and never move
+static DDLogStringEntry * volatile * volatile _chunks[DD_LOG_STRING_TABLE_CHUNKS];
+static volatile int32_t _count;
+
+static DDLogStaticStringEntry * volatile _staticStrings[DD_LOG_STRING_TABLE_STATIC_SLOTS];
+
+// Entries are published with a barrier and never change afterwards. Readers only reach them through
+// the published pointers (address dependencies), which orders their reads without barriers of their own.
+
+static void DDLogStringTableInitialize(void) {
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        for (NSUInteger i = 0; i < DD_LOG_STRING_TABLE_SHARDS; i++) {
+            pthread_mutex_init(&_shards[i].lock, NULL);
+        }
+    });
+}
+
+// FNV-1a
+static uint64_t DDLogStringTableHash(const char *bytes, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static DDLogStringEntry * DDLogStringTableEntry(DDLogStringID identifier) {
+    if (identifier == 0 || identifier > DD_LOG_STRING_TABLE_CAPACITY) {
+        return NULL;
+    }
+
+    NSUInteger index = identifier - 1;
+    DDLogStringEntry * volatile *chunk = _chunks[index / DD_LOG_STRING_TABLE_CHUNK_LENGTH];
+
+    return chunk ? chunk[index % DD_LOG_STRING_TABLE_CHUNK_LENGTH] : NULL;
+}
+
+static DDLogStringEntry * DDLogStringBucketsFind(DDLogStringBuckets *buckets, uint64_t hash, const char *bytes, size_t length) {
+    if (buckets == NULL) {
+        return NULL;
+    }
+
+    NSUInteger mask = buckets->capacity - 1;
+
+    // Linear probing; the load factor stays below 75%, so there always is an empty bucket
+    for (NSUInteger i = (NSUInteger)hash & mask;; i = (i + 1) & mask) {
+        DDLogStringEntry *entry = buckets->entries[i];
+
+        if (entry == NULL) {
+            return NULL;
+        }
+
+        if (entry->hash == hash && entry->length == length && memcmp(entry->bytes, bytes, length) == 0) {
+            return entry;
+        }
+    }
+}
+
+static void DDLogStringBucketsInsert(DDLogStringBuckets *buckets, DDLogStringEntry *entry) {
+    NSUInteger mask = buckets->capacity - 1;
+    NSUInteger i = (NSUInteger)entry->hash & mask;
+
+    while (buckets->entries[i]) {
+        i = (i + 1) & mask;
+    }
+
+    buckets->entries[i] = entry;
+}
+
+/**
+ * Makes room for one more entry. Called with the lock of the shard held.
+ **/
+static BOOL DDLogStringShardReserve(DDLogStringShard *shard) {
+    DDLogStringBuckets *buckets = shard->buckets;
+
+    if (buckets && (shard->count + 1) * 4 <= buckets->capacity * 3) {
+        return YES;
+    }
+
+    NSUInteger capacity = buckets ? buckets->capacity * 2 : DD_LOG_STRING_TABLE_INITIAL_BUCKETS;
+    DDLogStringBuckets *grown = calloc(1, sizeof(DDLogStringBuckets) + capacity * sizeof(DDLogStringEntry *));
+
+    if (grown == NULL) {
+        return NO;
+    }
+
+    grown->capacity = capacity;
+
+    for (NSUInteger i = 0; buckets && i < buckets->capacity; i++) {
+        if (buckets->entries[i]) {
+            DDLogStringBucketsInsert(grown, buckets->entries[i]);
+        }
+    }
+
+    OSMemoryBarrier();
+    shard->buckets = grown;
+
+    // The old buckets may still be read by lookups without the lock, so they are never freed.
+    // As the capacity doubles each time, they add up to less than the current buckets.
+
+    return YES;
+}
+
+/**
+ * Gives the entry an ID and publishes it. Called with the lock of its shard held.
+ **/
+static BOOL DDLogStringTablePublish(DDLogStringShard *shard, DDLogStringEntry *entry) {
+    if (_count >= DD_LOG_STRING_TABLE_CAPACITY) {
+        return NO;
+    }
+
+    int32_t identifier = OSAtomicIncrement32Barrier(&_count);
+
+    if (identifier > DD_LOG_STRING_TABLE_CAPACITY) {
+        // Lost a race for the last IDs against another shard
+        OSAtomicDecrement32Barrier(&_count);
+        return NO;
+    }
+
+    NSUInteger index = (NSUInteger)identifier - 1;
+    NSUInteger chunkIndex = index / DD_LOG_STRING_TABLE_CHUNK_LENGTH;
+
+    if (_chunks[chunkIndex] == NULL) {
+        DDLogStringEntry * volatile *chunk = calloc(DD_LOG_STRING_TABLE_CHUNK_LENGTH, sizeof(DDLogStringEntry *));
+
+        // Another shard may add the same chunk at the same time
+        if (chunk && !OSAtomicCompareAndSwapPtrBarrier(NULL, (void *)chunk, (void * volatile *)&_chunks[chunkIndex])) {
+            free((void *)chunk);
+        }
+
+        if (_chunks[chunkIndex] == NULL) {
+            // Out of memory; the ID stays unused
+            return NO;
+        }
+    }
+
+    entry->identifier = (DDLogStringID)identifier;
+
+    OSMemoryBarrier();
+    _chunks[chunkIndex][index % DD_LOG_STRING_TABLE_CHUNK_LENGTH] = entry;
+    DDLogStringBucketsInsert(shard->buckets, entry);
+    shard->count++;
+
+    return YES;
+}
+
+DDLogStringID DDLogStringTableIntern(const char *bytes, size_t length) {
+    if (bytes == NULL) {
+        return 0;
+    }
+
+    DDLogStringTableInitialize();
+
+    uint64_t hash = DDLogStringTableHash(bytes, length);
+    DDLogStringShard *shard = &_shards[hash >> (64 - DD_LOG_STRING_TABLE_SHARD_BITS)];
+
+    DDLogStringEntry *entry = DDLogStringBucketsFind(shard->buckets, hash, bytes, length);
+
+    if (entry) {
+        return entry->identifier;
+    }
+
+    // Not there yet: build the entry outside of the lock, then look again with the lock held
+    DDLogStringEntry *newEntry = malloc(sizeof(DDLogStringEntry) + length + 1);
+
+    if (newEntry == NULL) {
+        return 0;
+    }
+
+    newEntry->hash = hash;
+    newEntry->length = length;
+    memcpy(newEntry->bytes, bytes, length);
+    newEntry->bytes[length] = '\0';
+
+    NSString *string = [[NSString alloc] initWithBytesNoCopy:newEntry->bytes
+                                                      length:length
+                                                    encoding:NSUTF8StringEncoding
+                                                freeWhenDone:NO];
+
+    if (string == nil) {
+        free(newEntry);
+        return 0;
+    }
+
+    newEntry->string = (__bridge_retained const void *)string;
+
+    DDLogStringID identifier = 0;
+
+    pthread_mutex_lock(&shard->lock);
+    {
+        entry = DDLogStringBucketsFind(shard->buckets, hash, bytes, length);
+
+        if (entry) {
+            identifier = entry->identifier;
+        } else if (DDLogStringShardReserve(shard) && DDLogStringTablePublish(shard, newEntry)) {
+            identifier = newEntry->identifier;
+            newEntry = NULL;
+        }
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    if (newEntry) {
+        string = (__bridge_transfer NSString *)newEntry->string;
+        string = nil;
+        free(newEntry);
+    }
+
+    return identifier;
+}
+
+DDLogStringID DDLogStringTableInternStatic(const char *string) {
+    if (string == NULL) {
+        return 0;
+    }
+
+    // Fibonacci hashing: the low bits of an address are mostly alignment
+    NSUInteger slot = (NSUInteger)(((uint64_t)(uintptr_t)string * 0x9E3779B97F4A7C15ULL) >> (64 - DD_LOG_STRING_TABLE_STATIC_BITS));
+    DDLogStaticStringEntry *cached = _staticStrings[slot];
+
+    if (cached && cached->string == string) {
+        return cached->identifier;
+    }
+
+    DDLogStringID identifier = DDLogStringTableIntern(string, strlen(string));
+
+    // A slot keeps the first string that maps to it
+    if (identifier && cached == NULL) {
+        DDLogStaticStringEntry *newCached = malloc(sizeof(DDLogStaticStringEntry));
+
+        if (newCached) {
+            newCached->string = string;
+            newCached->identifier = identifier;
+
+            if (!OSAtomicCompareAndSwapPtrBarrier(NULL, newCached, (void * volatile *)&_staticStrings[slot])) {
+                free(newCached);
+            }
+        }
+    }
+
+    return identifier;
+}
+
+DDLogStringID DDLogStringTableInternString(NSString *string) {
+    if (string == nil) {
+        return 0;
+    }
+
+    char buffer[256];
+    NSUInteger length = 0;
+    NSRange remainingRange = NSMakeRange(0, 0);
+
+    BOOL converted = [string getBytes:buffer
+                            maxLength:sizeof(buffer)
+                           usedLength:&length
+                             encoding:NSUTF8StringEncoding
+                              options:0
+                                range:NSMakeRange(0, string.length)
+                       remainingRange:&remainingRange];
+
+    if (converted && remainingRange.length == 0) {
+        return DDLogStringTableIntern(buffer, length);
+    }
+
+    // Longer than the buffer
+    const char *utf8 = string.UTF8String;
+
+    return utf8 ? DDLogStringTableIntern(utf8, strlen(utf8)) : 0;
+}
+
+NSString * DDLogStringTableString(DDLogStringID identifier) {
+    DDLogStringEntry *entry = DDLogStringTableEntry(identifier);
+
+    return entry ? (__bridge NSString *)entry->string : nil;
+}
+
+const char * DDLogStringTableUTF8(DDLogStringID identifier, size_t *length) {
+    DDLogStringEntry *entry = DDLogStringTableEntry(identifier);
+
+    if (length) {
+        *length = entry ? entry->length : 0;
+    }
+
+    return entry ? entry->bytes : NULL;
+}
+
+NSUInteger DDLogStringTableCount(void) {
+    return (NSUInteger)MIN(MAX(_count, 0), DD_LOG_STRING_TABLE_CAPACITY);
+}
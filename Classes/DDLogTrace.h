@@ -0,0 +1,197 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+/**
+ * Pipeline stage tracing.
+ *
+ * To find out where a log message spends its time between the log statement and the write,
+ * the framework can be compiled with `DD_LOG_TRACE_ENABLED` defined to 1 (e.g. in the preprocessor macros
+ * of the CocoaLumberjack target). Every message then records a monotonic timestamp at each stage:
+ *
+ * - created:   the `DDLogMessage` was created
+ * - enqueued:  the log statement got a slot in the logging queue (after waiting, if the queue was full)
+ * - dequeued:  the logging queue started with the message (`lt_log:`)
+ * - handed:    the logger queue started with the message
+ * - formatted: the logger formatted the message (loggers mark this themselves, see `DDLogTraceMark`)
+ * - written:   the logger returned from `logMessage:`
+ *
+ * The time between consecutive stages is aggregated per logger into log2 histograms (`+[DDLogTrace statistics]`),
+ * and the last messages are kept for export as Chrome trace events (`+[DDLogTrace chromeTraceData]`),
+ * which can be opened in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Timestamps come from `mach_absolute_time` (a few nanoseconds per read) or `CLOCK_MONOTONIC` where that isn't available.
+ *
+ * Without `DD_LOG_TRACE_ENABLED` (the default) nothing is recorded and no code is added to the logging path;
+ * the API below is still available, and returns empty results.
+ **/
+
+#ifndef DD_LOG_TRACE_ENABLED
+    #define DD_LOG_TRACE_ENABLED 0
+#endif
+
+typedef NS_ENUM(NSUInteger, DDLogTraceStage) {
+    DDLogTraceStageCreated = 0,
+    DDLogTraceStageEnqueued,
+    DDLogTraceStageDequeued,
+    DDLogTraceStageHanded,
+    DDLogTraceStageFormatted,
+    DDLogTraceStageWritten,
+    DDLogTraceStageCount
+};
+
+/**
+ * The number of buckets of a `DDLogTraceHistogram`. Bucket `i` counts durations of [2^i, 2^(i+1)) nanoseconds,
+ * bucket 0 also counts durations of 0.
+ **/
+#define DDLogTraceHistogramBucketCount 64
+
+#if DD_LOG_TRACE_ENABLED
+
+/**
+ *  The current trace timestamp.
+ */
+uint64_t DDLogTraceNow(void);
+
+/**
+ *  Records a stage of the message currently being logged by the calling logger.
+ *  Only meaningful from within `-[DDLogger logMessage:]`.
+ */
+void DDLogTraceMarkStage(DDLogTraceStage stage);
+
+/**
+ *  Called by DDLog around `-[DDLogger logMessage:]`, on the logger queue. Don't use directly.
+ */
+void DDLogTraceLoggerBegin(id <DDLogger> logger, int64_t sequence, const uint64_t *messageTimestamps);
+void DDLogTraceLoggerEnd(void);
+
+    #define DDLogTraceMark(stage) DDLogTraceMarkStage(stage)
+
+#else
+
+    #define DDLogTraceMark(stage) do { } while (0)
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Durations between two consecutive stages, in log2 buckets of nanoseconds.
+ **/
+@interface DDLogTraceHistogram : NSObject
+
+/**
+ * The number of recorded durations.
+ **/
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ * The sum and the maximum of the recorded durations, in nanoseconds.
+ **/
+@property (nonatomic, readonly) uint64_t totalNanoseconds;
+@property (nonatomic, readonly) uint64_t maximumNanoseconds;
+
+/**
+ * `DDLogTraceHistogramBucketCount` counts. Bucket `i` counts durations of [2^i, 2^(i+1)) nanoseconds.
+ **/
+@property (nonatomic, readonly) NSArray<NSNumber *> *buckets;
+
+/**
+ *  An upper bound of the given percentile (0-100), in nanoseconds: the upper end of the bucket the percentile falls in.
+ */
+- (uint64_t)nanosecondsAtPercentile:(double)percentile;
+
+@end
+
+/**
+ * The stage histograms of one logger.
+ **/
+@interface DDLogTraceStatistics : NSObject
+
+/**
+ * The `loggerName` of the logger, or its class name.
+ **/
+@property (nonatomic, readonly) NSString *loggerName;
+
+/**
+ * The number of messages traced through the logger.
+ **/
+@property (nonatomic, readonly) NSUInteger messageCount;
+
+/**
+ *  The durations from the previous stage to the given one (e.g. `DDLogTraceStageDequeued`: the time spent in the queue).
+ *  Returns nil for `DDLogTraceStageCreated`.
+ */
+- (DDLogTraceHistogram *)histogramForStage:(DDLogTraceStage)stage;
+
+/**
+ * The durations from creation to written.
+ **/
+@property (nonatomic, readonly) DDLogTraceHistogram *totalHistogram;
+
+@end
+
+/**
+ * Access to the collected traces.
+ **/
+@interface DDLogTrace : NSObject
+
+/**
+ *  YES if the framework was compiled with `DD_LOG_TRACE_ENABLED`.
+ */
++ (BOOL)isEnabled;
+
+/**
+ *  The human readable name of a stage, e.g. "enqueued".
+ */
++ (NSString *)nameOfStage:(DDLogTraceStage)stage;
+
+/**
+ *  A snapshot of the histograms, one entry per logger that logged a traced message.
+ */
++ (NSArray<DDLogTraceStatistics *> *)statistics;
+
+/**
+ *  The number of messages (per logger) kept for the Chrome trace export. The oldest are dropped first.
+ *  The default is 10000. Setting it discards the kept messages.
+ */
++ (NSUInteger)maximumEventCount;
++ (void)setMaximumEventCount:(NSUInteger)maximumEventCount;
+
+/**
+ *  The kept messages as Chrome trace event JSON ("Trace Event Format"): the queue waits as asynchronous events,
+ *  and the work of each logger as complete events on a track named after the logger.
+ */
++ (NSData *)chromeTraceData;
+
+/**
+ *  Writes `chromeTraceData` to a file.
+ */
++ (BOOL)writeChromeTraceToFile:(NSString *)path error:(NSError **)error;
+
+/**
+ *  Forgets all histograms and kept messages.
+ */
++ (void)reset;
+
+@end
@@ -0,0 +1,513 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDLogTrace.h"
+
+#import <pthread.h>
+#import <time.h>
+#if __has_include(<mach/mach_time.h>)
+    #import <mach/mach_time.h>
+    #define DD_LOG_TRACE_MACH_TIME 1
+#else
+    #define DD_LOG_TRACE_MACH_TIME 0
+#endif
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+#define DD_LOG_TRACE_DEFAULT_EVENT_COUNT 10000
+
+typedef struct {
+    uint64_t buckets[DDLogTraceHistogramBucketCount];
+    uint64_t count;
+    uint64_t total;
+    uint64_t maximum;
+} DDLogTraceHistogramData;
+
+/**
+ * One message through one logger, in trace timestamps.
+ **/
+typedef struct {
+    int64_t sequence;
+    uint64_t timestamps[DDLogTraceStageCount];
+} DDLogTraceEvent;
+
+static uint64_t DDLogTraceNanoseconds(uint64_t ticks) {
+#if DD_LOG_TRACE_MACH_TIME
+    static mach_timebase_info_data_t timebase;
+
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+
+    return ticks * timebase.numer / timebase.denom;
+#else
+    return ticks;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Histograms
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface DDLogTraceHistogram () {
+    DDLogTraceHistogramData _data;
+}
+
+- (instancetype)initWithData:(const DDLogTraceHistogramData *)data;
+
+@end
+
+@implementation DDLogTraceHistogram
+
+- (instancetype)initWithData:(const DDLogTraceHistogramData *)data {
+    if ((self = [super init])) {
+        _data = *data;
+    }
+
+    return self;
+}
+
+- (NSUInteger)count {
+    return (NSUInteger)_data.count;
+}
+
+- (uint64_t)totalNanoseconds {
+    return _data.total;
+}
+
+- (uint64_t)maximumNanoseconds {
+    return _data.maximum;
+}
+
+- (NSArray<NSNumber *> *)buckets {
+    NSMutableArray *buckets = [NSMutableArray arrayWithCapacity:DDLogTraceHistogramBucketCount];
+
+    for (NSUInteger i = 0; i < DDLogTraceHistogramBucketCount; i++) {
+        [buckets addObject:@(_data.buckets[i])];
+    }
+
+    return buckets;
+}
+
+- (uint64_t)nanosecondsAtPercentile:(double)percentile {
+    if (_data.count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)ceil(_data.count * MIN(MAX(percentile, 0.0), 100.0) / 100.0);
+    uint64_t seen = 0;
+
+    for (NSUInteger i = 0; i < DDLogTraceHistogramBucketCount; i++) {
+        seen += _data.buckets[i];
+
+        if (seen >= MAX(rank, 1) && _data.buckets[i] > 0) {
+            uint64_t upper = (i < 63) ? ((uint64_t)2 << i) : UINT64_MAX;
+            return MIN(upper, _data.maximum);
+        }
+    }
+
+    return _data.maximum;
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Statistics
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The live state of one logger, protected by the trace mutex.
+ **/
+@interface DDLogTraceLoggerRecord : NSObject {
+    @public
+    NSString *_loggerName;
+    NSUInteger _messageCount;
+    DDLogTraceHistogramData _histograms[DDLogTraceStageCount];
+    DDLogTraceHistogramData _total;
+    DDLogTraceEvent *_events;
+    NSUInteger _eventCapacity;
+    NSUInteger _eventCount;
+    NSUInteger _nextEvent;
+}
+
+@end
+
+@implementation DDLogTraceLoggerRecord
+
+- (void)dealloc {
+    free(_events);
+}
+
+- (void)resetWithEventCapacity:(NSUInteger)eventCapacity {
+    _messageCount = 0;
+    memset(_histograms, 0, sizeof(_histograms));
+    memset(&_total, 0, sizeof(_total));
+
+    free(_events);
+    _eventCapacity = eventCapacity;
+    _events = eventCapacity ? (DDLogTraceEvent *)calloc(eventCapacity, sizeof(DDLogTraceEvent)) : NULL;
+    _eventCount = 0;
+    _nextEvent = 0;
+}
+
+@end
+
+@interface DDLogTraceStatistics () {
+    NSArray *_histograms;
+}
+
+- (instancetype)initWithRecord:(DDLogTraceLoggerRecord *)record;
+
+@end
+
+@implementation DDLogTraceStatistics
+
+- (instancetype)initWithRecord:(DDLogTraceLoggerRecord *)record {
+    if ((self = [super init])) {
+        _loggerName = record->_loggerName;
+        _messageCount = record->_messageCount;
+
+        NSMutableArray *histograms = [NSMutableArray arrayWithCapacity:DDLogTraceStageCount];
+
+        for (NSUInteger stage = 0; stage < DDLogTraceStageCount; stage++) {
+            [histograms addObject:[[DDLogTraceHistogram alloc] initWithData:&record->_histograms[stage]]];
+        }
+
+        _histograms = histograms;
+        _totalHistogram = [[DDLogTraceHistogram alloc] initWithData:&record->_total];
+    }
+
+    return self;
+}
+
+- (DDLogTraceHistogram *)histogramForStage:(DDLogTraceStage)stage {
+    if (stage == DDLogTraceStageCreated || stage >= DDLogTraceStageCount) {
+        return nil;
+    }
+
+    return _histograms[stage];
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Recording
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static pthread_mutex_t _traceMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Logger -> DDLogTraceLoggerRecord, and the records in the order the loggers were first seen
+static NSMapTable *_recordsByLogger;
+static NSMutableArray *_records;
+static NSUInteger _maximumEventCount = DD_LOG_TRACE_DEFAULT_EVENT_COUNT;
+
+#if DD_LOG_TRACE_ENABLED
+
+/**
+ * The message being logged on the current logger queue.
+ **/
+typedef struct {
+    BOOL active;
+    __unsafe_unretained id <DDLogger> logger;
+    DDLogTraceEvent event;
+} DDLogTraceContext;
+
+static pthread_key_t _traceContextKey;
+
+static NSUInteger DDLogTraceBucket(uint64_t nanoseconds) {
+    return nanoseconds < 2 ? 0 : (NSUInteger)(63 - __builtin_clzll(nanoseconds));
+}
+
+static void DDLogTraceHistogramAdd(DDLogTraceHistogramData *histogram, uint64_t nanoseconds) {
+    histogram->buckets[DDLogTraceBucket(nanoseconds)]++;
+    histogram->count++;
+    histogram->total += nanoseconds;
+    histogram->maximum = MAX(histogram->maximum, nanoseconds);
+}
+
+__attribute__((constructor)) static void DDLogTraceCreateKey(void) {
+    pthread_key_create(&_traceContextKey, free);
+}
+
+static DDLogTraceContext * DDLogTraceCurrentContext(void) {
+    DDLogTraceContext *context = (DDLogTraceContext *)pthread_getspecific(_traceContextKey);
+
+    if (context == NULL) {
+        context = (DDLogTraceContext *)calloc(1, sizeof(DDLogTraceContext));
+        pthread_setspecific(_traceContextKey, context);
+    }
+
+    return context;
+}
+
+uint64_t DDLogTraceNow(void) {
+#if DD_LOG_TRACE_MACH_TIME
+    return mach_absolute_time();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + (uint64_t)now.tv_nsec;
+#endif
+}
+
+void DDLogTraceMarkStage(DDLogTraceStage stage) {
+    DDLogTraceContext *context = (DDLogTraceContext *)pthread_getspecific(_traceContextKey);
+
+    if (context && context->active && stage < DDLogTraceStageCount) {
+        context->event.timestamps[stage] = DDLogTraceNow();
+    }
+}
+
+void DDLogTraceLoggerBegin(id <DDLogger> logger, int64_t sequence, const uint64_t *messageTimestamps) {
+    DDLogTraceContext *context = DDLogTraceCurrentContext();
+
+    context->active = YES;
+    context->logger = logger;
+    context->event.sequence = sequence;
+
+    memcpy(context->event.timestamps, messageTimestamps, DDLogTraceStageHanded * sizeof(uint64_t));
+    context->event.timestamps[DDLogTraceStageFormatted] = 0;
+    context->event.timestamps[DDLogTraceStageWritten] = 0;
+    context->event.timestamps[DDLogTraceStageHanded] = DDLogTraceNow();
+}
+
+void DDLogTraceLoggerEnd(void) {
+    DDLogTraceContext *context = (DDLogTraceContext *)pthread_getspecific(_traceContextKey);
+
+    if (context == NULL || !context->active) {
+        return;
+    }
+
+    DDLogTraceEvent *event = &context->event;
+
+    if (event->timestamps[DDLogTraceStageWritten] == 0) {
+        event->timestamps[DDLogTraceStageWritten] = DDLogTraceNow();
+    }
+
+    context->active = NO;
+
+    pthread_mutex_lock(&_traceMutex);
+
+    if (_recordsByLogger == nil) {
+        _recordsByLogger = [NSMapTable weakToStrongObjectsMapTable];
+        _records = [NSMutableArray array];
+    }
+
+    DDLogTraceLoggerRecord *record = [_recordsByLogger objectForKey:context->logger];
+
+    if (record == nil) {
+        record = [[DDLogTraceLoggerRecord alloc] init];
+        record->_loggerName = [context->logger respondsToSelector:@selector(loggerName)] ? [context->logger loggerName] : nil;
+        record->_loggerName = record->_loggerName ?: NSStringFromClass([context->logger class]);
+        [record resetWithEventCapacity:_maximumEventCount];
+
+        [_recordsByLogger setObject:record forKey:context->logger];
+        [_records addObject:record];
+    }
+
+    // Stages that weren't marked (e.g. formatted, by a logger that doesn't mark it) are skipped
+    uint64_t previous = event->timestamps[DDLogTraceStageCreated];
+
+    for (NSUInteger stage = DDLogTraceStageEnqueued; stage < DDLogTraceStageCount; stage++) {
+        uint64_t timestamp = event->timestamps[stage];
+
+        if (timestamp == 0) {
+            continue;
+        }
+
+        DDLogTraceHistogramAdd(&record->_histograms[stage], DDLogTraceNanoseconds(timestamp >= previous ? timestamp - previous : 0));
+        previous = timestamp;
+    }
+
+    DDLogTraceHistogramAdd(&record->_total, DDLogTraceNanoseconds(previous - event->timestamps[DDLogTraceStageCreated]));
+    record->_messageCount++;
+
+    if (record->_eventCapacity > 0) {
+        record->_events[record->_nextEvent] = *event;
+        record->_nextEvent = (record->_nextEvent + 1) % record->_eventCapacity;
+        record->_eventCount = MIN(record->_eventCount + 1, record->_eventCapacity);
+    }
+
+    pthread_mutex_unlock(&_traceMutex);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@implementation DDLogTrace
+
++ (BOOL)isEnabled {
+    return DD_LOG_TRACE_ENABLED;
+}
+
++ (NSString *)nameOfStage:(DDLogTraceStage)stage {
+    switch (stage) {
+        case DDLogTraceStageCreated   : return @"created";
+        case DDLogTraceStageEnqueued  : return @"enqueued";
+        case DDLogTraceStageDequeued  : return @"dequeued";
+        case DDLogTraceStageHanded    : return @"handed";
+        case DDLogTraceStageFormatted : return @"formatted";
+        case DDLogTraceStageWritten   : return @"written";
+        default                       : return nil;
+    }
+}
+
++ (NSArray<DDLogTraceStatistics *> *)statistics {
+    NSMutableArray *statistics = [NSMutableArray array];
+
+    pthread_mutex_lock(&_traceMutex);
+
+    for (DDLogTraceLoggerRecord *record in _records) {
+        [statistics addObject:[[DDLogTraceStatistics alloc] initWithRecord:record]];
+    }
+
+    pthread_mutex_unlock(&_traceMutex);
+
+    return statistics;
+}
+
++ (NSUInteger)maximumEventCount {
+    pthread_mutex_lock(&_traceMutex);
+    NSUInteger result = _maximumEventCount;
+    pthread_mutex_unlock(&_traceMutex);
+
+    return result;
+}
+
++ (void)setMaximumEventCount:(NSUInteger)maximumEventCount {
+    pthread_mutex_lock(&_traceMutex);
+
+    _maximumEventCount = maximumEventCount;
+
+    for (DDLogTraceLoggerRecord *record in _records) {
+        NSUInteger messageCount = record->_messageCount;
+        DDLogTraceHistogramData total = record->_total;
+        DDLogTraceHistogramData histograms[DDLogTraceStageCount];
+        memcpy(histograms, record->_histograms, sizeof(histograms));
+
+        // Keep the histograms, only the kept messages go
+        [record resetWithEventCapacity:maximumEventCount];
+
+        record->_messageCount = messageCount;
+        record->_total = total;
+        memcpy(record->_histograms, histograms, sizeof(histograms));
+    }
+
+    pthread_mutex_unlock(&_traceMutex);
+}
+
++ (void)reset {
+    pthread_mutex_lock(&_traceMutex);
+
+    [_recordsByLogger removeAllObjects];
+    [_records removeAllObjects];
+
+    pthread_mutex_unlock(&_traceMutex);
+}
+
++ (NSData *)chromeTraceData {
+    NSMutableArray *traceEvents = [NSMutableArray array];
+
+    pthread_mutex_lock(&_traceMutex);
+
+    // Timestamps are relative to the oldest kept message, in microseconds
+    uint64_t origin = UINT64_MAX;
+
+    for (DDLogTraceLoggerRecord *record in _records) {
+        for (NSUInteger i = 0; i < record->_eventCount; i++) {
+            origin = MIN(origin, record->_events[i].timestamps[DDLogTraceStageCreated]);
+        }
+    }
+
+    double (^microseconds)(uint64_t) = ^double (uint64_t timestamp) {
+        return DDLogTraceNanoseconds(timestamp - origin) / 1000.0;
+    };
+
+    // The queue waits are the same for every logger: track 0, once per message
+    NSMutableSet *seenSequences = [NSMutableSet set];
+
+    [traceEvents addObject:@{ @"name": @"thread_name", @"ph": @"M", @"pid": @1, @"tid": @0,
+                              @"args": @{ @"name": @"DDLog queue" } }];
+
+    [_records enumerateObjectsUsingBlock:^(DDLogTraceLoggerRecord *record, NSUInteger index, BOOL *stop) {
+        NSNumber *tid = @(index + 1);
+
+        [traceEvents addObject:@{ @"name": @"thread_name", @"ph": @"M", @"pid": @1, @"tid": tid,
+                                  @"args": @{ @"name": record->_loggerName } }];
+
+        // Oldest first
+        NSUInteger first = (record->_eventCount < record->_eventCapacity) ? 0 : record->_nextEvent;
+
+        for (NSUInteger i = 0; i < record->_eventCount; i++) {
+            const DDLogTraceEvent *event = &record->_events[(first + i) % record->_eventCapacity];
+            const uint64_t *t = event->timestamps;
+            NSNumber *sequence = @(event->sequence);
+
+            if (![seenSequences containsObject:sequence]) {
+                [seenSequences addObject:sequence];
+
+                NSArray *waits = @[ @[ @"wait for queue slot", @(DDLogTraceStageCreated), @(DDLogTraceStageEnqueued) ],
+                                    @[ @"queued", @(DDLogTraceStageEnqueued), @(DDLogTraceStageDequeued) ] ];
+
+                for (NSArray *wait in waits) {
+                    uint64_t begin = t[[wait[1] unsignedIntegerValue]];
+                    uint64_t end = t[[wait[2] unsignedIntegerValue]];
+
+                    if (begin == 0 || end == 0) {
+                        continue;
+                    }
+
+                    [traceEvents addObject:@{ @"name": wait[0], @"cat": @"DDLog", @"ph": @"b", @"id": sequence,
+                                              @"pid": @1, @"tid": @0, @"ts": @(microseconds(begin)) }];
+                    [traceEvents addObject:@{ @"name": wait[0], @"cat": @"DDLog", @"ph": @"e", @"id": sequence,
+                                              @"pid": @1, @"tid": @0, @"ts": @(microseconds(end)) }];
+                }
+            }
+
+            uint64_t handed = t[DDLogTraceStageHanded];
+            uint64_t formatted = t[DDLogTraceStageFormatted];
+            uint64_t written = t[DDLogTraceStageWritten];
+
+            if (formatted) {
+                [traceEvents addObject:@{ @"name": @"format", @"cat": @"logger", @"ph": @"X", @"pid": @1, @"tid": tid,
+                                          @"ts": @(microseconds(handed)), @"dur": @(microseconds(formatted) - microseconds(handed)),
+                                          @"args": @{ @"sequence": sequence } }];
+            }
+
+            uint64_t writeStart = formatted ?: handed;
+
+            [traceEvents addObject:@{ @"name": @"write", @"cat": @"logger", @"ph": @"X", @"pid": @1, @"tid": tid,
+                                      @"ts": @(microseconds(writeStart)), @"dur": @(microseconds(written) - microseconds(writeStart)),
+                                      @"args": @{ @"sequence": sequence } }];
+        }
+    }];
+
+    pthread_mutex_unlock(&_traceMutex);
+
+    return [NSJSONSerialization dataWithJSONObject:@{ @"traceEvents": traceEvents, @"displayTimeUnit": @"ns" }
+                                           options:0
+                                             error:nil];
+}
+
++ (BOOL)writeChromeTraceToFile:(NSString *)path error:(NSError **)error {
+    return [[self chromeTraceData] writeToFile:path options:NSDataWritingAtomic error:error];
+}
+
+@end
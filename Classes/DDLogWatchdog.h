@@ -0,0 +1,88 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+/**
+ * Detection of stalled loggers.
+ *
+ * DDLog waits for every logger to finish a message before it takes the next one from the queue.
+ * A logger that hangs in `logMessage:` (e.g. a socket write without a timeout) therefore stops all logging,
+ * and once the queue is full, every thread that logs blocks too.
+ *
+ * With a watchdog installed (`+[DDLog setWatchdog:]`), DDLog tracks how long each logger has been working
+ * on its current message. When that exceeds the `stallThreshold`:
+ *
+ * - the `stallHandler` is called (once per stall), and `stallCount` is incremented
+ * - with `quarantinesStalledLoggers`, DDLog stops waiting for the logger and continues with the other loggers.
+ *   The quarantined logger receives no messages (they are counted as dropped) until it returns from the stalled
+ *   `logMessage:`. It then receives messages again, and the `recoveryHandler` is called.
+ *
+ * While a watchdog is installed, loggers always run concurrently (as on multiprocessor machines without a watchdog),
+ * and each message costs two timestamps per logger. Without a watchdog nothing changes.
+ *
+ * The handlers are called on a private serial queue. Configure the watchdog before installing it.
+ **/
+@interface DDLogWatchdog : NSObject
+
+/**
+ * How long a logger may work on a single message (or flush) before it counts as stalled. Defaults to 1 second.
+ **/
+@property (nonatomic, assign) NSTimeInterval stallThreshold;
+
+/**
+ * Whether stalled loggers are detached until they recover. Defaults to NO: they are only reported.
+ **/
+@property (nonatomic, assign) BOOL quarantinesStalledLoggers;
+
+/**
+ * Called when a logger has been working on a message for longer than `stallThreshold`.
+ **/
+@property (nonatomic, copy) void (^stallHandler)(id <DDLogger> logger, NSTimeInterval duration);
+
+/**
+ * Called when a quarantined logger finished its stalled message and receives messages again.
+ * `droppedMessages` is the number of messages it missed.
+ **/
+@property (nonatomic, copy) void (^recoveryHandler)(id <DDLogger> logger, NSUInteger droppedMessages);
+
+/**
+ * The number of stalls detected so far.
+ **/
+@property (readonly) NSUInteger stallCount;
+
+/**
+ * The number of messages not delivered to quarantined loggers so far.
+ **/
+@property (readonly) NSUInteger droppedMessageCount;
+
+/**
+ * The loggers currently in quarantine.
+ **/
+@property (readonly, copy) NSArray<id <DDLogger>> *quarantinedLoggers;
+
+/**
+ *  Called by DDLog, on the logging queue. Don't use directly.
+ */
+- (void)loggerDidStall:(id <DDLogger>)logger duration:(NSTimeInterval)duration quarantined:(BOOL)quarantined;
+- (void)loggerDidDropMessage:(id <DDLogger>)logger;
+- (void)loggerDidRecover:(id <DDLogger>)logger droppedMessages:(NSUInteger)droppedMessages;
+
+@end
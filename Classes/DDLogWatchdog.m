@@ -0,0 +1,94 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDLogWatchdog.h"
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+@interface DDLogWatchdog () {
+    dispatch_queue_t _handlerQueue;
+    NSMutableArray *_quarantinedLoggers;
+}
+
+@property (readwrite) NSUInteger stallCount;
+@property (readwrite) NSUInteger droppedMessageCount;
+
+@end
+
+@implementation DDLogWatchdog
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        _stallThreshold = 1.0;
+        _handlerQueue = dispatch_queue_create("cocoa.lumberjack.watchdog", DISPATCH_QUEUE_SERIAL);
+        _quarantinedLoggers = [NSMutableArray array];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_release(_handlerQueue);
+    #endif
+}
+
+- (NSArray<id <DDLogger>> *)quarantinedLoggers {
+    @synchronized(self) {
+        return [_quarantinedLoggers copy];
+    }
+}
+
+- (void)loggerDidStall:(id <DDLogger>)logger duration:(NSTimeInterval)duration quarantined:(BOOL)quarantined {
+    @synchronized(self) {
+        self.stallCount++;
+
+        if (quarantined) {
+            [_quarantinedLoggers addObject:logger];
+        }
+    }
+
+    void (^handler)(id <DDLogger>, NSTimeInterval) = self.stallHandler;
+
+    if (handler) {
+        dispatch_async(_handlerQueue, ^{ @autoreleasepool {
+            handler(logger, duration);
+        } });
+    }
+}
+
+- (void)loggerDidDropMessage:(id <DDLogger> __attribute__((unused)))logger {
+    @synchronized(self) {
+        self.droppedMessageCount++;
+    }
+}
+
+- (void)loggerDidRecover:(id <DDLogger>)logger droppedMessages:(NSUInteger)droppedMessages {
+    @synchronized(self) {
+        [_quarantinedLoggers removeObjectIdenticalTo:logger];
+    }
+
+    void (^handler)(id <DDLogger>, NSUInteger) = self.recoveryHandler;
+
+    if (handler) {
+        dispatch_async(_handlerQueue, ^{ @autoreleasepool {
+            handler(logger, droppedMessages);
+        } });
+    }
+}
+
+@end
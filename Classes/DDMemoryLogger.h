@@ -0,0 +1,114 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+#import "DDFileLogger.h"
+
+/**
+ * In-memory stand-ins for tests and benchmarks.
+ *
+ * Together with a `DDVirtualLogClock` (see DDLogClock.h) they make formatter, rolling and retention
+ * measurements deterministic and repeatable: no terminal, no disk, no wall clock.
+ **/
+
+/**
+ * A logger that keeps the log messages in memory.
+ *
+ * Logging a message only stores a reference to it: nothing is formatted or copied.
+ * The formatter (if any) is applied when the formatted messages are asked for.
+ *
+ * With a capacity, the logger keeps the most recent `capacity` messages (a ring buffer);
+ * with a capacity of 0 it keeps every message.
+ **/
+@interface DDMemoryLogger : DDAbstractLogger <DDLogger>
+
+/**
+ *  Creates a logger that keeps every message.
+ */
+- (instancetype)init;
+
+/**
+ *  Designated initializer
+ *
+ *  @param capacity the number of messages to keep, or 0 for all
+ */
+- (instancetype)initWithCapacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+
+@property (nonatomic, readonly) NSUInteger capacity;
+
+/**
+ * The kept messages, oldest first.
+ **/
+@property (readonly, copy) NSArray<DDLogMessage *> *logMessages;
+
+/**
+ * The kept messages, formatted with the logFormatter (or the plain message if there is none), oldest first.
+ **/
+@property (readonly, copy) NSArray<NSString *> *formattedLogMessages;
+
+/**
+ * The number of messages logged since the logger was created (or cleared), including the ones no longer kept.
+ **/
+@property (readonly) NSUInteger totalMessageCount;
+
+/**
+ * Forgets all messages.
+ **/
+- (void)removeAllMessages;
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A log file manager for tests and benchmarks of `DDFileLogger`.
+ *
+ * - the log files live in a private directory on a RAM backed file system where there is one
+ *   (`/dev/shm`, otherwise the temporary directory), which is removed with the manager
+ * - file names don't depend on the date (`log.log`, `log 2.log`, ...)
+ * - creation dates (and so ages, rolling and the order of the files) come from the log clock
+ *
+ * Retention (`maximumNumberOfLogFiles`, `logFilesDiskQuota`) works as in `DDLogFileManagerDefault`.
+ *
+ * `DDFileLogger` writes through file handles, so the files are real files;
+ * this manager only keeps them off the disk and out of the wall clock.
+ **/
+@interface DDMemoryLogFileManager : DDLogFileManagerDefault
+
+/**
+ *  Creates a manager with a new private logs directory.
+ */
+- (instancetype)init;
+
+/**
+ *  Designated initializer
+ *
+ *  @param logsDirectory the logs directory, or nil for a new private directory
+ */
+- (instancetype)initWithLogsDirectory:(NSString *)logsDirectory NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  Deletes the logs directory and its files. Also done when the manager is deallocated.
+ */
+- (void)removeLogsDirectory;
+
+@end
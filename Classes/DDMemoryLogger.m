@@ -0,0 +1,186 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDMemoryLogger.h"
+
+#import <unistd.h>
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+@interface DDMemoryLogger () {
+    NSMutableArray *_messages;
+    NSUInteger _nextIndex;
+    NSUInteger _totalMessageCount;
+}
+
+@end
+
+@implementation DDMemoryLogger
+
+- (instancetype)init {
+    return [self initWithCapacity:0];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    if ((self = [super init])) {
+        _capacity = capacity;
+        _messages = [[NSMutableArray alloc] initWithCapacity:(capacity ?: 1024)];
+    }
+
+    return self;
+}
+
+- (void)logMessage:(DDLogMessage *)logMessage {
+    if (_capacity == 0 || [_messages count] < _capacity) {
+        [_messages addObject:logMessage];
+    } else {
+        // Full: overwrite the oldest message
+        _messages[_nextIndex] = logMessage;
+        _nextIndex = (_nextIndex + 1) % _capacity;
+    }
+
+    _totalMessageCount++;
+}
+
+- (NSString *)loggerName {
+    return @"cocoa.lumberjack.memoryLogger";
+}
+
+/**
+ * Runs the block on the logger queue, after every message queued so far has been logged.
+ **/
+- (void)performSynchronouslyAfterQueuedMessages:(dispatch_block_t)block {
+    // The design of this method is taken from the DDAbstractLogger implementation.
+    // For extensive documentation please refer to the DDAbstractLogger implementation.
+
+    if ([self isOnInternalLoggerQueue]) {
+        block();
+    } else {
+        NSAssert(![self isOnGlobalLoggingQueue], @"Core architecture requirement failure");
+
+        dispatch_sync([DDLog loggingQueue], ^{
+            dispatch_sync(self.loggerQueue, block);
+        });
+    }
+}
+
+- (NSArray *)orderedMessages {
+    // Oldest first: with a full ring buffer, the oldest message is at _nextIndex
+    if (_nextIndex == 0) {
+        return [_messages copy];
+    }
+
+    NSRange newer = NSMakeRange(0, _nextIndex);
+    NSRange older = NSMakeRange(_nextIndex, [_messages count] - _nextIndex);
+
+    return [[_messages subarrayWithRange:older] arrayByAddingObjectsFromArray:[_messages subarrayWithRange:newer]];
+}
+
+- (NSArray<DDLogMessage *> *)logMessages {
+    __block NSArray *result;
+
+    [self performSynchronouslyAfterQueuedMessages:^{
+        result = [self orderedMessages];
+    }];
+
+    return result;
+}
+
+- (NSArray<NSString *> *)formattedLogMessages {
+    __block NSMutableArray *result;
+
+    [self performSynchronouslyAfterQueuedMessages:^{ @autoreleasepool {
+        NSArray *messages = [self orderedMessages];
+
+        result = [NSMutableArray arrayWithCapacity:[messages count]];
+
+        for (DDLogMessage *logMessage in messages) {
+            NSString *message = _logFormatter ? [_logFormatter formatLogMessage:logMessage] : logMessage->_message;
+
+            if (message) {
+                [result addObject:message];
+            }
+        }
+    }}];
+
+    return result;
+}
+
+- (NSUInteger)totalMessageCount {
+    __block NSUInteger result;
+
+    [self performSynchronouslyAfterQueuedMessages:^{
+        result = _totalMessageCount;
+    }];
+
+    return result;
+}
+
+- (void)removeAllMessages {
+    [self performSynchronouslyAfterQueuedMessages:^{
+        [_messages removeAllObjects];
+        _nextIndex = 0;
+        _totalMessageCount = 0;
+    }];
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@implementation DDMemoryLogFileManager
+
+- (instancetype)init {
+    return [self initWithLogsDirectory:nil];
+}
+
+- (instancetype)initWithLogsDirectory:(NSString *)logsDirectory {
+    if (logsDirectory == nil) {
+        BOOL isDirectory = NO;
+        NSString *parent = NSTemporaryDirectory();
+
+        if ([[NSFileManager defaultManager] fileExistsAtPath:@"/dev/shm" isDirectory:&isDirectory] && isDirectory) {
+            parent = @"/dev/shm";
+        }
+
+        NSString *name = [NSString stringWithFormat:@"DDMemoryLogFileManager-%d-%@", getpid(), [[NSUUID UUID] UUIDString]];
+        logsDirectory = [parent stringByAppendingPathComponent:name];
+    }
+
+    return [super initWithLogsDirectory:logsDirectory];
+}
+
+- (void)dealloc {
+    [self removeLogsDirectory];
+}
+
+- (NSString *)newLogFileName {
+    return @"log.log";
+}
+
+- (BOOL)isLogFile:(NSString *)fileName {
+    // "log.log", or with the attempt number appended by createNewLogFile: "log 2.log"
+    return [fileName hasPrefix:@"log"] && [fileName hasSuffix:@".log"];
+}
+
+- (void)removeLogsDirectory {
+    [[NSFileManager defaultManager] removeItemAtPath:[self logsDirectory] error:nil];
+}
+
+@end
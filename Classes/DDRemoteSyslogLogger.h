@@ -0,0 +1,188 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+typedef NS_ENUM(NSUInteger, DDRemoteSyslogTransport) {
+    /**
+     * One message per datagram (RFC 5426). Messages longer than `maximumMessageSize` are truncated.
+     **/
+    DDRemoteSyslogTransportUDP,
+    /**
+     * A stream of octet-counted messages (RFC 6587, "LEN SP MSG").
+     **/
+    DDRemoteSyslogTransportTCP
+};
+
+/**
+ * Forwards the log to a remote syslog server (rsyslog, syslog-ng, a log shipper...), as RFC 5424 messages:
+ *
+ * <PRI>1 TIMESTAMP HOSTNAME APP-NAME PROCID - - MSG
+ *
+ * The severity comes from the flag of the message (error: 3, warning: 4, info: 6, debug and verbose: 7),
+ * the timestamp is the one of the message (UTC, microseconds), and MSG is the formatted message.
+ *
+ * DDRemoteSyslogLogger *syslogLogger = [[DDRemoteSyslogLogger alloc] initWithHost:@"logs.example.com"
+ *                                                                            port:514
+ *                                                                       transport:DDRemoteSyslogTransportTCP];
+ * [DDLog addLogger:syslogLogger];
+ *
+ * Sending never blocks the logger queue: the socket is non blocking, and messages wait in a retry buffer
+ * until it can take them. Whatever accumulated in the meantime goes out in a single `writev` (TCP),
+ * or in a row of `send` calls (UDP).
+ *
+ * When the connection fails (or the server can't be resolved), the messages stay in the buffer
+ * and the logger connects again after a delay that doubles with each failure,
+ * from `minimumReconnectDelay` up to `maximumReconnectDelay` (timer from `+[DDLog clock]`).
+ * Once the buffer holds `retryBufferSize` bytes, the oldest messages are dropped.
+ *
+ * Flushing waits up to `flushTimeout` for the buffer to be sent.
+ **/
+@interface DDRemoteSyslogLogger : DDAbstractLogger <DDLogger>
+
+/**
+ *  Designated initializer. Nothing is resolved or connected before the first message.
+ *
+ *  @param host      a host name or a numeric address
+ *  @param port      usually 514
+ *  @param transport UDP or TCP
+ */
+- (instancetype)initWithHost:(NSString *)host
+                        port:(uint16_t)port
+                   transport:(DDRemoteSyslogTransport)transport NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly, copy) NSString *host;
+@property (nonatomic, readonly) uint16_t port;
+@property (nonatomic, readonly) DDRemoteSyslogTransport transport;
+
+/**
+ * The HOSTNAME field. Defaults to the host name of this machine. Set before adding the logger.
+ **/
+@property (nonatomic, copy) NSString *hostName;
+
+/**
+ * The APP-NAME field. Defaults to the process name. Set before adding the logger.
+ **/
+@property (nonatomic, copy) NSString *appName;
+
+/**
+ * The syslog facility, 0 to 23. Defaults to 1 (user-level messages). Set before adding the logger.
+ **/
+@property (nonatomic, assign) NSUInteger facility;
+
+/**
+ * For UDP, the maximum size of a datagram, in bytes. Defaults to 2048, which RFC 5426 recommends receivers to accept.
+ **/
+@property (assign) NSUInteger maximumMessageSize;
+
+/**
+ * The maximum number of bytes waiting to be sent. Defaults to 1 MB.
+ **/
+@property (assign) NSUInteger retryBufferSize;
+
+/**
+ * Defaults to 0.5 seconds.
+ **/
+@property (assign) NSTimeInterval minimumReconnectDelay;
+
+/**
+ * Defaults to 60 seconds.
+ **/
+@property (assign) NSTimeInterval maximumReconnectDelay;
+
+/**
+ * How long flushing waits for the buffer to be sent. Defaults to 1 second.
+ **/
+@property (assign) NSTimeInterval flushTimeout;
+
+/**
+ * Whether the logger currently has a connection (for UDP: a connected socket that hasn't failed).
+ **/
+@property (readonly, getter=isConnected) BOOL connected;
+
+/**
+ * The number of messages sent so far.
+ **/
+@property (readonly) uint64_t sentMessageCount;
+
+/**
+ * The number of messages dropped because the retry buffer was full.
+ **/
+@property (readonly) uint64_t droppedMessageCount;
+
+/**
+ *  The RFC 5424 message for a log message, without the framing of the transport.
+ */
+- (NSData *)syslogMessageForLogMessage:(DDLogMessage *)logMessage;
+
+@end
+
+
+/**
+ * A minimal syslog server on the loopback interface, standing in for a real one in tests and benchmarks.
+ *
+ * It accepts UDP datagrams, or TCP connections carrying octet-counted messages, and hands each message
+ * (without framing) to the `messageHandler`, on a private serial queue.
+ **/
+@interface DDLoopbackSyslogServer : NSObject
+
+/**
+ *  Designated initializer
+ *
+ *  @param transport UDP or TCP
+ *  @param port      the port to listen on, 0 for a free one (see `port`)
+ */
+- (instancetype)initWithTransport:(DDRemoteSyslogTransport)transport port:(uint16_t)port NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly) DDRemoteSyslogTransport transport;
+
+/**
+ * The port listened on, once listening.
+ **/
+@property (readonly) uint16_t port;
+
+/**
+ * Set before starting. Without a handler, messages are only counted.
+ **/
+@property (nonatomic, copy) void (^messageHandler)(NSData *message);
+
+/**
+ *  @return NO, with the POSIX error, if the socket couldn't be opened
+ */
+- (BOOL)startListening:(NSError **)error;
+
+/**
+ *  Closes the socket and all connections.
+ */
+- (void)stopListening;
+
+@property (readonly) uint64_t receivedMessageCount;
+@property (readonly) uint64_t receivedByteCount;
+
+/**
+ * The number of TCP connections closed because they didn't send octet-counted messages.
+ **/
+@property (readonly) uint64_t invalidFrameCount;
+
+@end
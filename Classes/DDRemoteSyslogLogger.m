@@ -0,0 +1,905 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDRemoteSyslogLogger.h"
+#import "DDLogClock.h"
+
+#import <unistd.h>
+#import <fcntl.h>
+#import <netdb.h>
+#import <poll.h>
+#import <time.h>
+#import <sys/socket.h>
+#import <sys/uio.h>
+#import <netinet/in.h>
+#import <libkern/OSAtomic.h>
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+// The most messages handed to a single writev (or sent in a row)
+#define DD_REMOTE_SYSLOG_BATCH_SIZE 64
+
+// Longer octet counts aren't accepted by the loopback server
+#define DD_REMOTE_SYSLOG_MAX_OCTET_COUNT_DIGITS 9
+
+static void DDRemoteSyslogIgnoreSigPipe(int fd) {
+    #ifdef SO_NOSIGPIPE
+    int noSigPipe = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+    #else
+    (void)fd;
+    #endif
+}
+
+/**
+ * A header field of RFC 5424: printable US-ASCII without spaces, at most `maximumLength` characters, "-" if empty.
+ **/
+static NSString * DDRemoteSyslogHeaderField(NSString *value, NSUInteger maximumLength) {
+    NSData *data = [value dataUsingEncoding:NSASCIIStringEncoding allowLossyConversion:YES];
+    NSUInteger length = MIN(data.length, maximumLength);
+
+    if (length == 0) {
+        return @"-";
+    }
+
+    char field[length];
+    memcpy(field, data.bytes, length);
+
+    for (NSUInteger i = 0; i < length; i++) {
+        if (field[i] < 33 || field[i] > 126) {
+            field[i] = '_';
+        }
+    }
+
+    return [[NSString alloc] initWithBytes:field length:length encoding:NSASCIIStringEncoding];
+}
+
+static uint8_t DDRemoteSyslogSeverity(DDLogFlag flag) {
+    if (flag & DDLogFlagError) {
+        return 3;
+    }
+
+    if (flag & DDLogFlagWarning) {
+        return 4;
+    }
+
+    if (flag & DDLogFlagInfo) {
+        return 6;
+    }
+
+    return 7;
+}
+
+@interface DDRemoteSyslogLogger () {
+    // " HOSTNAME APP-NAME PROCID - - ", built with the first message
+    NSData *_headerFields;
+
+    // Only used on the logger queue
+    NSMutableArray *_frames;
+    NSUInteger _bufferedBytes;
+    NSUInteger _sentOffset; // Bytes of the first frame already sent (TCP)
+    int _socket;
+    BOOL _connecting;
+    dispatch_source_t _writeSource;
+    BOOL _writeSourceSuspended;
+    id <DDLogClockTimer> _reconnectTimer;
+    NSTimeInterval _reconnectDelay; // 0 until a connection fails
+
+    volatile int32_t _connected;
+    volatile int64_t _sentMessageCount;
+    volatile int64_t _droppedMessageCount;
+}
+
+@end
+
+@implementation DDRemoteSyslogLogger
+
+- (instancetype)initWithHost:(NSString *)host port:(uint16_t)port transport:(DDRemoteSyslogTransport)transport {
+    if ((self = [super init])) {
+        _host = [host copy];
+        _port = port;
+        _transport = transport;
+
+        char hostName[256] = "";
+        gethostname(hostName, sizeof(hostName) - 1);
+
+        _hostName = @(hostName);
+        _appName = [[NSProcessInfo processInfo] processName];
+        _facility = 1;
+
+        _maximumMessageSize = 2048;
+        _retryBufferSize = 1024 * 1024;
+        _minimumReconnectDelay = 0.5;
+        _maximumReconnectDelay = 60.0;
+        _flushTimeout = 1.0;
+
+        _frames = [NSMutableArray array];
+        _socket = -1;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [_reconnectTimer cancel];
+
+    // The handler only holds a weak reference, so nothing else can be using the source anymore
+    [self lt_disconnect];
+}
+
+- (NSString *)loggerName {
+    return @"cocoa.lumberjack.remoteSyslogLogger";
+}
+
+- (void)setHostName:(NSString *)hostName {
+    _hostName = [hostName copy];
+    _headerFields = nil;
+}
+
+- (void)setAppName:(NSString *)appName {
+    _appName = [appName copy];
+    _headerFields = nil;
+}
+
+- (BOOL)isConnected {
+    return _connected != 0;
+}
+
+- (uint64_t)sentMessageCount {
+    return (uint64_t)_sentMessageCount;
+}
+
+- (uint64_t)droppedMessageCount {
+    return (uint64_t)_droppedMessageCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Framing
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (NSData *)syslogMessageForLogMessage:(DDLogMessage *)logMessage {
+    NSString *text = _logFormatter ? [_logFormatter formatLogMessage:logMessage] : logMessage->_message;
+
+    if (text == nil) {
+        return nil;
+    }
+
+    if (_headerFields == nil) {
+        NSString *fields = [NSString stringWithFormat:@" %@ %@ %d - - ",
+                            DDRemoteSyslogHeaderField(_hostName, 255),
+                            DDRemoteSyslogHeaderField(_appName, 48),
+                            (int)getpid()];
+        _headerFields = [fields dataUsingEncoding:NSASCIIStringEncoding];
+    }
+
+    NSTimeInterval epoch = [logMessage->_timestamp timeIntervalSince1970];
+    time_t seconds = (time_t)floor(epoch);
+    int microseconds = MIN((int)((epoch - floor(epoch)) * 1000000.0), 999999);
+    struct tm components;
+
+    gmtime_r(&seconds, &components);
+
+    // <PRI>1 TIMESTAMP
+    char prefix[64];
+    int prefixLength = snprintf(prefix, sizeof(prefix), "<%u>1 %04d-%02d-%02dT%02d:%02d:%02d.%06dZ",
+                                (unsigned)(MIN(_facility, 23u) * 8 + DDRemoteSyslogSeverity(logMessage->_flag)),
+                                components.tm_year + 1900, components.tm_mon + 1, components.tm_mday,
+                                components.tm_hour, components.tm_min, components.tm_sec, microseconds);
+
+    NSUInteger textLength = [text lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *message = [NSMutableData dataWithCapacity:(NSUInteger)prefixLength + _headerFields.length + textLength];
+
+    [message appendBytes:prefix length:(NSUInteger)prefixLength];
+    [message appendData:_headerFields];
+    [message appendBytes:[text UTF8String] length:textLength];
+
+    return message;
+}
+
+/**
+ * Adds the framing of the transport: an octet count for TCP, truncation to a datagram for UDP.
+ **/
+- (NSData *)lt_frameForMessage:(NSData *)message {
+    if (_transport == DDRemoteSyslogTransportTCP) {
+        char count[16];
+        int countLength = snprintf(count, sizeof(count), "%lu ", (unsigned long)message.length);
+        NSMutableData *frame = [NSMutableData dataWithCapacity:(NSUInteger)countLength + message.length];
+
+        [frame appendBytes:count length:(NSUInteger)countLength];
+        [frame appendData:message];
+
+        return frame;
+    }
+
+    NSUInteger maximumLength = MAX(self.maximumMessageSize, 480u);
+
+    if (message.length <= maximumLength) {
+        return message;
+    }
+
+    // Don't cut a UTF-8 sequence in half
+    const uint8_t *bytes = message.bytes;
+    NSUInteger length = maximumLength;
+
+    while (length > 0 && (bytes[length] & 0xC0) == 0x80) {
+        length--;
+    }
+
+    return [message subdataWithRange:NSMakeRange(0, length)];
+}
+
+- (void)lt_enqueueFrame:(NSData *)frame {
+    [_frames addObject:frame];
+    _bufferedBytes += frame.length;
+
+    NSUInteger limit = self.retryBufferSize;
+
+    while (_bufferedBytes > limit) {
+        // A partly sent frame has to be completed, and the newest message is always kept
+        NSUInteger index = (_sentOffset > 0) ? 1 : 0;
+
+        if (index + 1 >= _frames.count) {
+            break;
+        }
+
+        _bufferedBytes -= [_frames[index] length];
+        [_frames removeObjectAtIndex:index];
+
+        OSAtomicIncrement64Barrier(&_droppedMessageCount);
+    }
+}
+
+/**
+ * Removes the first `count` frames, which have been sent.
+ **/
+- (void)lt_removeSentFrames:(NSUInteger)count {
+    for (NSUInteger i = 0; i < count; i++) {
+        _bufferedBytes -= [_frames[i] length];
+    }
+
+    [_frames removeObjectsInRange:NSMakeRange(0, count)];
+    _sentOffset = 0;
+
+    OSAtomicAdd64Barrier((int64_t)count, &_sentMessageCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Connection
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (BOOL)lt_connect {
+    struct addrinfo hints;
+    struct addrinfo *addresses = NULL;
+    char service[8];
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = (_transport == DDRemoteSyslogTransportTCP) ? SOCK_STREAM : SOCK_DGRAM;
+    snprintf(service, sizeof(service), "%u", (unsigned)_port);
+
+    if (getaddrinfo([_host UTF8String], service, &hints, &addresses) != 0) {
+        return NO;
+    }
+
+    int fd = -1;
+    BOOL connecting = NO;
+
+    for (struct addrinfo *address = addresses; address != NULL && fd < 0; address = address->ai_next) {
+        fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+
+        if (fd < 0) {
+            continue;
+        }
+
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        DDRemoteSyslogIgnoreSigPipe(fd);
+
+        if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            connecting = NO;
+        } else if (errno == EINPROGRESS) {
+            connecting = YES;
+        } else {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    freeaddrinfo(addresses);
+
+    if (fd < 0) {
+        return NO;
+    }
+
+    __weak DDRemoteSyslogLogger *weakSelf = self;
+
+    _socket = fd;
+    _connecting = connecting;
+
+    // Resumed only while there's something to send (or a connection to complete)
+    _writeSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_WRITE, (uintptr_t)fd, 0, _loggerQueue);
+    dispatch_source_set_event_handler(_writeSource, ^{ @autoreleasepool {
+        [weakSelf lt_sendFrames];
+    } });
+    dispatch_source_set_cancel_handler(_writeSource, ^{
+        close(fd);
+    });
+    _writeSourceSuspended = YES;
+
+    if (!connecting) {
+        _connected = 1;
+        OSMemoryBarrier();
+    }
+
+    [self lt_updateWriteSource];
+
+    return YES;
+}
+
+- (void)lt_disconnect {
+    if (_writeSource == NULL) {
+        return;
+    }
+
+    // A suspended source doesn't run its cancel handler
+    if (_writeSourceSuspended) {
+        dispatch_resume(_writeSource);
+        _writeSourceSuspended = NO;
+    }
+
+    dispatch_source_cancel(_writeSource);
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_release(_writeSource);
+    #endif
+    _writeSource = NULL;
+
+    _socket = -1;
+    _connecting = NO;
+    _connected = 0;
+    OSMemoryBarrier();
+
+    // The server dropped a partly received frame with the connection
+    _sentOffset = 0;
+}
+
+- (void)lt_connectionFailed {
+    [self lt_disconnect];
+    [self lt_scheduleReconnect];
+}
+
+- (void)lt_scheduleReconnect {
+    if (_reconnectTimer) {
+        return;
+    }
+
+    NSTimeInterval delay = MAX(_reconnectDelay, self.minimumReconnectDelay);
+    _reconnectDelay = MIN(delay * 2, self.maximumReconnectDelay);
+
+    __weak DDRemoteSyslogLogger *weakSelf = self;
+
+    _reconnectTimer = [[DDLog clock] scheduleTimerWithDelay:delay
+                                                   interval:0
+                                                      queue:_loggerQueue
+                                                    handler:^{ @autoreleasepool {
+        [weakSelf lt_reconnect];
+    } }];
+}
+
+- (void)lt_reconnect {
+    _reconnectTimer = nil;
+
+    // Without anything to send, the next message connects
+    if (_socket >= 0 || _frames.count == 0) {
+        return;
+    }
+
+    if (![self lt_connect]) {
+        [self lt_scheduleReconnect];
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Sending
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)lt_updateWriteSource {
+    if (_writeSource == NULL) {
+        return;
+    }
+
+    // The write source fires once the current block is done,
+    // so the messages logged in between go out together
+    BOOL needed = _connecting || _frames.count > 0;
+
+    if (needed && _writeSourceSuspended) {
+        _writeSourceSuspended = NO;
+        dispatch_resume(_writeSource);
+    } else if (!needed && !_writeSourceSuspended) {
+        _writeSourceSuspended = YES;
+        dispatch_suspend(_writeSource);
+    }
+}
+
+- (void)lt_sendFrames {
+    if (_socket < 0) {
+        return;
+    }
+
+    if (_connecting) {
+        int error = 0;
+        socklen_t errorLength = sizeof(error);
+
+        if (getsockopt(_socket, SOL_SOCKET, SO_ERROR, &error, &errorLength) != 0 || error != 0) {
+            [self lt_connectionFailed];
+            return;
+        }
+
+        _connecting = NO;
+        _connected = 1;
+        OSMemoryBarrier();
+    }
+
+    BOOL sent = (_transport == DDRemoteSyslogTransportTCP) ? [self lt_sendStream] : [self lt_sendDatagrams];
+
+    if (!sent) {
+        [self lt_connectionFailed];
+        return;
+    }
+
+    [self lt_updateWriteSource];
+}
+
+/**
+ * Returns NO if the connection failed.
+ **/
+- (BOOL)lt_sendStream {
+    while (_frames.count > 0) {
+        struct iovec iov[DD_REMOTE_SYSLOG_BATCH_SIZE];
+        NSUInteger count = MIN(_frames.count, (NSUInteger)DD_REMOTE_SYSLOG_BATCH_SIZE);
+        size_t total = 0;
+
+        for (NSUInteger i = 0; i < count; i++) {
+            NSData *frame = _frames[i];
+            NSUInteger offset = (i == 0) ? _sentOffset : 0;
+
+            iov[i].iov_base = (uint8_t *)frame.bytes + offset;
+            iov[i].iov_len = frame.length - offset;
+            total += iov[i].iov_len;
+        }
+
+        ssize_t written = writev(_socket, iov, (int)count);
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno == EAGAIN;
+        }
+
+        // Whole frames sent, and how far into the next one
+        NSUInteger remaining = (NSUInteger)written;
+        NSUInteger completed = 0;
+
+        while (completed < count && remaining >= iov[completed].iov_len) {
+            remaining -= iov[completed].iov_len;
+            completed++;
+        }
+
+        if (completed > 0) {
+            [self lt_removeSentFrames:completed];
+        }
+
+        _sentOffset += remaining;
+        _reconnectDelay = 0;
+
+        if ((size_t)written < total) {
+            // The socket is full; the write source tells when it can take more
+            return YES;
+        }
+    }
+
+    return YES;
+}
+
+/**
+ * Returns NO if the connection failed.
+ **/
+- (BOOL)lt_sendDatagrams {
+    while (_frames.count > 0) {
+        NSUInteger count = MIN(_frames.count, (NSUInteger)DD_REMOTE_SYSLOG_BATCH_SIZE);
+
+        // Darwin has no sendmmsg: one datagram per system call, but without going back to the queue in between
+        ssize_t sent = 0;
+
+        while ((NSUInteger)sent < count) {
+            NSData *frame = _frames[(NSUInteger)sent];
+
+            if (send(_socket, frame.bytes, frame.length, 0) < 0) {
+                break;
+            }
+
+            sent++;
+        }
+
+        if (sent == 0) {
+            sent = -1;
+        }
+
+        if (sent > 0) {
+            [self lt_removeSentFrames:(NSUInteger)sent];
+            _reconnectDelay = 0;
+            continue;
+        }
+
+        if (errno == EINTR) {
+            continue;
+        }
+
+        if (errno == EMSGSIZE) {
+            // Smaller than maximumMessageSize, but still too large for the path
+            _bufferedBytes -= [_frames[0] length];
+            [_frames removeObjectAtIndex:0];
+            OSAtomicIncrement64Barrier(&_droppedMessageCount);
+            continue;
+        }
+
+        // ENOBUFS: the interface queue is full, try again when the socket is writable
+        return errno == EAGAIN || errno == ENOBUFS;
+    }
+
+    return YES;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark DDLogger Protocol
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)logMessage:(DDLogMessage *)logMessage {
+    NSData *message = [self syslogMessageForLogMessage:logMessage];
+
+    if (message == nil) {
+        return;
+    }
+
+    [self lt_enqueueFrame:[self lt_frameForMessage:message]];
+
+    if (_socket >= 0) {
+        [self lt_updateWriteSource];
+    } else if (_reconnectTimer == nil && ![self lt_connect]) {
+        [self lt_scheduleReconnect];
+    }
+}
+
+- (void)flush {
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:self.flushTimeout];
+
+    // Without a connection, the messages wait for the next attempt
+    while (_socket >= 0 && (_connecting || _frames.count > 0)) {
+        int timeout = (int)ceil([deadline timeIntervalSinceNow] * 1000.0);
+
+        if (timeout <= 0) {
+            break;
+        }
+
+        struct pollfd descriptor = { _socket, POLLOUT, 0 };
+        int ready = poll(&descriptor, 1, timeout);
+
+        if (ready > 0) {
+            [self lt_sendFrames];
+        } else if (ready == 0 || errno != EINTR) {
+            break;
+        }
+    }
+}
+
+- (void)willRemoveLogger {
+    [self flush];
+
+    [_reconnectTimer cancel];
+    _reconnectTimer = nil;
+
+    [self lt_disconnect];
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A TCP connection to a DDLoopbackSyslogServer. Only used on the server queue.
+ **/
+@interface DDLoopbackSyslogConnection : NSObject
+{
+    @public
+    int _fd;
+    dispatch_source_t _readSource;
+    NSMutableData *_buffer;
+}
+
+@end
+
+@implementation DDLoopbackSyslogConnection
+
+@end
+
+
+@interface DDLoopbackSyslogServer () {
+    uint16_t _requestedPort;
+    dispatch_queue_t _queue;
+
+    // Only used on the server queue
+    int _listenFD;
+    dispatch_source_t _listenSource;
+    NSMutableArray *_connections;
+
+    volatile int64_t _receivedMessageCount;
+    volatile int64_t _receivedByteCount;
+    volatile int64_t _invalidFrameCount;
+}
+
+@property (readwrite) uint16_t port;
+
+@end
+
+@implementation DDLoopbackSyslogServer
+
+- (instancetype)initWithTransport:(DDRemoteSyslogTransport)transport port:(uint16_t)port {
+    if ((self = [super init])) {
+        _transport = transport;
+        _requestedPort = port;
+        _queue = dispatch_queue_create("cocoa.lumberjack.loopbackSyslogServer", DISPATCH_QUEUE_SERIAL);
+        _listenFD = -1;
+        _connections = [NSMutableArray array];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    // The handlers only hold weak references, so nothing else can be using the sources anymore
+    [self q_stopListening];
+
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_release(_queue);
+    #endif
+}
+
+- (uint64_t)receivedMessageCount {
+    return (uint64_t)_receivedMessageCount;
+}
+
+- (uint64_t)receivedByteCount {
+    return (uint64_t)_receivedByteCount;
+}
+
+- (uint64_t)invalidFrameCount {
+    return (uint64_t)_invalidFrameCount;
+}
+
+- (BOOL)startListening:(NSError **)error {
+    __block int errorCode = 0;
+
+    dispatch_sync(_queue, ^{
+        if (_listenSource == NULL) {
+            errorCode = [self q_startListening];
+        }
+    });
+
+    if (errorCode != 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errorCode userInfo:nil];
+        }
+
+        return NO;
+    }
+
+    return YES;
+}
+
+- (int)q_startListening {
+    BOOL stream = (_transport == DDRemoteSyslogTransportTCP);
+    struct sockaddr_in address;
+    socklen_t addressLength = sizeof(address);
+    int reuse = 1;
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(_requestedPort);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int fd = socket(AF_INET, stream ? SOCK_STREAM : SOCK_DGRAM, 0);
+
+    if (fd < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        getsockname(fd, (struct sockaddr *)&address, &addressLength) != 0 ||
+        (stream && listen(fd, 16) != 0) ||
+        fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+        int errorCode = errno;
+
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        return errorCode;
+    }
+
+    self.port = ntohs(address.sin_port);
+
+    __weak DDLoopbackSyslogServer *weakSelf = self;
+
+    _listenFD = fd;
+    _listenSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _queue);
+
+    dispatch_source_set_event_handler(_listenSource, ^{ @autoreleasepool {
+        if (stream) {
+            [weakSelf q_acceptConnections];
+        } else {
+            [weakSelf q_receiveDatagrams];
+        }
+    } });
+
+    dispatch_source_set_cancel_handler(_listenSource, ^{
+        close(fd);
+    });
+
+    dispatch_resume(_listenSource);
+
+    return 0;
+}
+
+- (void)stopListening {
+    dispatch_sync(_queue, ^{
+        [self q_stopListening];
+    });
+}
+
+- (void)q_stopListening {
+    if (_listenSource) {
+        dispatch_source_cancel(_listenSource);
+        #if !OS_OBJECT_USE_OBJC
+        dispatch_release(_listenSource);
+        #endif
+        _listenSource = NULL;
+        _listenFD = -1;
+    }
+
+    for (DDLoopbackSyslogConnection *connection in [_connections copy]) {
+        [self q_closeConnection:connection];
+    }
+}
+
+- (void)q_deliverMessage:(const uint8_t *)bytes length:(NSUInteger)length {
+    OSAtomicIncrement64Barrier(&_receivedMessageCount);
+    OSAtomicAdd64Barrier((int64_t)length, &_receivedByteCount);
+
+    void (^handler)(NSData *) = self.messageHandler;
+
+    if (handler) {
+        handler([NSData dataWithBytes:bytes length:length]);
+    }
+}
+
+- (void)q_receiveDatagrams {
+    uint8_t buffer[65536];
+    ssize_t length;
+
+    while ((length = recv(_listenFD, buffer, sizeof(buffer), 0)) >= 0) {
+        [self q_deliverMessage:buffer length:(NSUInteger)length];
+    }
+}
+
+- (void)q_acceptConnections {
+    int fd;
+
+    while ((fd = accept(_listenFD, NULL, NULL)) >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+
+        DDLoopbackSyslogConnection *connection = [[DDLoopbackSyslogConnection alloc] init];
+        connection->_fd = fd;
+        connection->_buffer = [NSMutableData data];
+        connection->_readSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _queue);
+
+        __weak DDLoopbackSyslogServer *weakSelf = self;
+        __weak DDLoopbackSyslogConnection *weakConnection = connection;
+
+        dispatch_source_set_event_handler(connection->_readSource, ^{ @autoreleasepool {
+            [weakSelf q_readFromConnection:weakConnection];
+        } });
+
+        dispatch_source_set_cancel_handler(connection->_readSource, ^{
+            close(fd);
+        });
+
+        [_connections addObject:connection];
+
+        dispatch_resume(connection->_readSource);
+    }
+}
+
+- (void)q_closeConnection:(DDLoopbackSyslogConnection *)connection {
+    if (connection == nil || connection->_readSource == NULL) {
+        return;
+    }
+
+    dispatch_source_cancel(connection->_readSource);
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_release(connection->_readSource);
+    #endif
+    connection->_readSource = NULL;
+
+    [_connections removeObjectIdenticalTo:connection];
+}
+
+- (void)q_readFromConnection:(DDLoopbackSyslogConnection *)connection {
+    if (connection == nil || connection->_readSource == NULL) {
+        return;
+    }
+
+    NSMutableData *buffer = connection->_buffer;
+    NSUInteger previousLength = buffer.length;
+    const NSUInteger chunkSize = 64 * 1024;
+
+    [buffer increaseLengthBy:chunkSize];
+
+    ssize_t length = read(connection->_fd, (uint8_t *)buffer.mutableBytes + previousLength, chunkSize);
+
+    buffer.length = previousLength + (NSUInteger)MAX(length, 0);
+
+    if (length == 0 || (length < 0 && errno != EAGAIN && errno != EINTR)) {
+        [self q_closeConnection:connection];
+        return;
+    }
+
+    // MSG-LEN SP SYSLOG-MSG
+    const uint8_t *bytes = buffer.bytes;
+    NSUInteger offset = 0;
+
+    while (offset < buffer.length) {
+        NSUInteger messageLength = 0;
+        NSUInteger digits = 0;
+
+        while (offset + digits < buffer.length && bytes[offset + digits] >= '0' && bytes[offset + digits] <= '9') {
+            messageLength = messageLength * 10 + (NSUInteger)(bytes[offset + digits] - '0');
+            digits++;
+        }
+
+        if (offset + digits == buffer.length && digits <= DD_REMOTE_SYSLOG_MAX_OCTET_COUNT_DIGITS) {
+            break;
+        }
+
+        if (digits == 0 || digits > DD_REMOTE_SYSLOG_MAX_OCTET_COUNT_DIGITS || bytes[offset + digits] != ' ') {
+            OSAtomicIncrement64Barrier(&_invalidFrameCount);
+            [self q_closeConnection:connection];
+            return;
+        }
+
+        if (buffer.length - offset - digits - 1 < messageLength) {
+            break;
+        }
+
+        [self q_deliverMessage:bytes + offset + digits + 1 length:messageLength];
+
+        offset += digits + 1 + messageLength;
+    }
+
+    [buffer replaceBytesInRange:NSMakeRange(0, offset) withBytes:NULL length:0];
+}
+
+@end
@@ -0,0 +1,134 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+@class DDCollectedLogMessage;
+
+/**
+ * Default size (in bytes) of the ring used by `DDSharedMemoryLogger`.
+ **/
+extern NSUInteger const kDDDefaultSharedMemoryRingCapacity;
+
+/**
+ * Cross-process logging through shared memory, for processes that log too much for a socket (see DDLogCollector.h).
+ *
+ * Each client process writes its messages into a ring of its own: a file in a shared directory,
+ * mapped with `MAP_SHARED` by the client and by the collector (place the directory on a RAM backed file system,
+ * such as `/dev/shm` or a RAM disk, to avoid any disk writes). The client is the only writer and the collector
+ * the only reader, so the ring needs no locks, just the two positions.
+ *
+ * A named pipe next to the ring wakes the collector, but only when it went to sleep on an empty ring.
+ * A busy process (the collector always has something to read) therefore logs without any system call.
+ *
+ * Registration is by creating the ring in the directory, which the collector watches. Once the process that owns
+ * a ring has exited and the ring is read completely, the collector removes it.
+ *
+ * The messages use the encoding of DDLogMessageBatch. A message that doesn't fit in the ring is dropped
+ * (the client never waits for the collector), and counted in the ring.
+ **/
+@interface DDSharedMemoryLogger : DDAbstractLogger <DDLogger>
+
+/**
+ *  Creates the ring (`<process name>.<pid>.<instance>.ddring`, numbered per logger) in the directory, with the default capacity.
+ */
+- (instancetype)initWithDirectory:(NSString *)directory;
+
+/**
+ *  Designated initializer
+ *
+ *  @param directory the directory the collector watches
+ *  @param capacity  the size of the ring in bytes, rounded up to a power of 2
+ */
+- (instancetype)initWithDirectory:(NSString *)directory capacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * The ring file, nil if it couldn't be created (the logger then drops all messages).
+ **/
+@property (nonatomic, readonly, copy) NSString *ringPath;
+
+@property (nonatomic, readonly) NSUInteger capacity;
+
+/**
+ * The number of messages dropped because the ring was full.
+ **/
+@property (readonly) uint64_t droppedMessageCount;
+
+/**
+ * The number of times the collector had to be woken up.
+ **/
+@property (readonly) uint64_t wakeupCount;
+
+@end
+
+
+/**
+ * Reads the rings of DDSharedMemoryLoggers in a directory, and logs the messages to a DDLog instance.
+ **/
+@interface DDSharedMemoryLogCollector : NSObject
+
+/**
+ *  Designated initializer
+ *
+ *  @param directory the directory the clients create their rings in
+ *  @param log       the DDLog instance the messages are logged to, with the loggers that write them
+ */
+- (instancetype)initWithDirectory:(NSString *)directory log:(DDLog *)log NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly, copy) NSString *directory;
+@property (nonatomic, readonly, strong) DDLog *log;
+
+/**
+ * How often to look for rings of exited processes, to remove them. Defaults to 5 seconds; timer from `+[DDLog clock]`.
+ **/
+@property (nonatomic, assign) NSTimeInterval cleanupInterval;
+
+/**
+ *  Starts watching the directory (creating it if needed), and reads the rings already in it.
+ *
+ *  @return NO, with the error, if the directory couldn't be watched
+ */
+- (BOOL)start:(NSError **)error;
+
+/**
+ *  Stops reading. The rings are left in place.
+ */
+- (void)stop;
+
+/**
+ * The number of rings being read.
+ **/
+@property (readonly) NSUInteger ringCount;
+
+/**
+ * The number of messages read so far.
+ **/
+@property (readonly) uint64_t receivedMessageCount;
+
+/**
+ * The number of messages the clients dropped because their ring was full, over all rings read so far.
+ **/
+@property (readonly) uint64_t droppedMessageCount;
+
+@end
@@ -0,0 +1,676 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDSharedMemoryLogger.h"
+#import "DDLogCollector.h"
+#import "DDLogClock.h"
+
+#import <unistd.h>
+#import <fcntl.h>
+#import <signal.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <libkern/OSAtomic.h>
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+// We probably shouldn't be using DDLog() statements within the DDLog implementation.
+// But we still want to leave our log statements for any future debugging,
+// and to allow other developers to trace the implementation (which is a great learning tool).
+//
+// So we use primitive logging macros around NSLog.
+// We maintain the NS prefix on the macros to be explicit about the fact that we're using NSLog.
+
+#ifndef DD_NSLOG_LEVEL
+    #define DD_NSLOG_LEVEL 2
+#endif
+
+#define NSLogError(frmt, ...)    do{ if(DD_NSLOG_LEVEL >= 1) NSLog((frmt), ##__VA_ARGS__); } while(0)
+
+NSUInteger const kDDDefaultSharedMemoryRingCapacity = 4 * 1024 * 1024;
+
+static NSUInteger const kDDSharedMemoryRingMinCapacity = 4096;
+static uint32_t const kDDSharedMemoryRingMagic = 0x44445247; // "DDRG"
+static uint32_t const kDDSharedMemoryRingVersion = 1;
+
+// A record length that means "continue at the start of the ring"
+static uint32_t const kDDSharedMemoryRingWrap = UINT32_MAX;
+
+static NSString * const kDDSharedMemoryRingExtension = @"ddring";
+static NSString * const kDDSharedMemoryWakeExtension = @"ddwake";
+
+/**
+ * The start of a ring file, shared by the client and the collector.
+ *
+ * Positions count bytes from the creation of the ring (they don't wrap); the offset in the data is the position
+ * modulo the capacity. Records are a 32 bit length followed by the message, padded to 8 bytes, and never wrap:
+ * a record that doesn't fit at the end of the data starts at the beginning, after a kDDSharedMemoryRingWrap length.
+ *
+ * The client only writes `tail` (and the data before it), the collector only writes `head`;
+ * both are on their own cache line. `consumerWaiting` is set by the collector before it sleeps,
+ * and cleared by whoever wakes it.
+ **/
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t processID;
+    uint32_t capacity;
+    char processName[240];
+
+    volatile uint64_t head __attribute__((aligned(64)));
+    volatile int32_t consumerWaiting;
+
+    volatile uint64_t tail __attribute__((aligned(64)));
+    volatile int64_t droppedRecords;
+} DDSharedMemoryRingHeader;
+
+#define DD_SHARED_MEMORY_DATA_OFFSET ((sizeof(DDSharedMemoryRingHeader) + 63) & ~(size_t)63)
+
+static inline NSUInteger DDSharedMemoryRecordSize(NSUInteger messageLength) {
+    return (sizeof(uint32_t) + messageLength + 7) & ~(NSUInteger)7;
+}
+
+static BOOL DDSharedMemoryHeaderIsValid(const DDSharedMemoryRingHeader *header, size_t fileLength) {
+    return header->magic == kDDSharedMemoryRingMagic &&
+           header->version == kDDSharedMemoryRingVersion &&
+           header->capacity >= kDDSharedMemoryRingMinCapacity &&
+           (header->capacity & (header->capacity - 1)) == 0 &&
+           DD_SHARED_MEMORY_DATA_OFFSET + header->capacity <= fileLength;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface DDSharedMemoryLogger () {
+    // Only used on the logger queue
+    DDSharedMemoryRingHeader *_header;
+    uint8_t *_data;
+    size_t _mappedLength;
+    NSString *_wakePath;
+    int _wakeFD;
+    NSMutableData *_record;
+
+    volatile int64_t _droppedMessageCount;
+    volatile int64_t _wakeupCount;
+}
+
+@end
+
+@implementation DDSharedMemoryLogger
+
+- (instancetype)initWithDirectory:(NSString *)directory {
+    return [self initWithDirectory:directory capacity:kDDDefaultSharedMemoryRingCapacity];
+}
+
+- (instancetype)initWithDirectory:(NSString *)directory capacity:(NSUInteger)capacity {
+    if ((self = [super init])) {
+        _capacity = kDDSharedMemoryRingMinCapacity;
+
+        while (_capacity < capacity && _capacity < UINT32_MAX / 2) {
+            _capacity *= 2;
+        }
+
+        _wakeFD = -1;
+        _record = [NSMutableData dataWithCapacity:1024];
+
+        [self createRingInDirectory:directory];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    if (_header) {
+        munmap(_header, _mappedLength);
+    }
+
+    if (_wakeFD >= 0) {
+        close(_wakeFD);
+    }
+}
+
+- (NSString *)loggerName {
+    return @"cocoa.lumberjack.sharedMemoryLogger";
+}
+
+- (uint64_t)droppedMessageCount {
+    return (uint64_t)_droppedMessageCount;
+}
+
+- (uint64_t)wakeupCount {
+    return (uint64_t)_wakeupCount;
+}
+
+- (void)createRingInDirectory:(NSString *)directory {
+    // Numbered per instance, so that loggers of the same process don't share a ring
+    static volatile int32_t instanceCount = 0;
+    int32_t instance = OSAtomicIncrement32(&instanceCount);
+
+    NSString *processName = [[NSProcessInfo processInfo] processName];
+    NSString *baseName = [NSString stringWithFormat:@"%@.%d.%d", processName, getpid(), instance];
+    NSString *ringPath = [directory stringByAppendingPathComponent:[baseName stringByAppendingPathExtension:kDDSharedMemoryRingExtension]];
+    NSString *wakePath = [directory stringByAppendingPathComponent:[baseName stringByAppendingPathExtension:kDDSharedMemoryWakeExtension]];
+    NSString *temporaryPath = [ringPath stringByAppendingString:@".tmp"];
+
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+
+    // The pipe first: once the ring appears, the collector expects it
+    unlink([wakePath fileSystemRepresentation]);
+
+    if (mkfifo([wakePath fileSystemRepresentation], 0600) != 0) {
+        NSLogError(@"DDSharedMemoryLogger: Error creating %@: %s", wakePath, strerror(errno));
+        return;
+    }
+
+    size_t mappedLength = DD_SHARED_MEMORY_DATA_OFFSET + _capacity;
+    int fd = open([temporaryPath fileSystemRepresentation], O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+    if (fd < 0 || ftruncate(fd, (off_t)mappedLength) != 0) {
+        NSLogError(@"DDSharedMemoryLogger: Error creating %@: %s", temporaryPath, strerror(errno));
+
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        return;
+    }
+
+    void *base = mmap(NULL, mappedLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED) {
+        NSLogError(@"DDSharedMemoryLogger: Error mapping %@: %s", temporaryPath, strerror(errno));
+        unlink([temporaryPath fileSystemRepresentation]);
+        return;
+    }
+
+    DDSharedMemoryRingHeader *header = base;
+
+    header->version = kDDSharedMemoryRingVersion;
+    header->processID = (uint32_t)getpid();
+    header->capacity = (uint32_t)_capacity;
+    strlcpy(header->processName, [processName UTF8String], sizeof(header->processName));
+    OSMemoryBarrier();
+    header->magic = kDDSharedMemoryRingMagic;
+
+    // Appears complete to the collector
+    if (rename([temporaryPath fileSystemRepresentation], [ringPath fileSystemRepresentation]) != 0) {
+        NSLogError(@"DDSharedMemoryLogger: Error creating %@: %s", ringPath, strerror(errno));
+        munmap(base, mappedLength);
+        unlink([temporaryPath fileSystemRepresentation]);
+        return;
+    }
+
+    _header = header;
+    _data = (uint8_t *)base + DD_SHARED_MEMORY_DATA_OFFSET;
+    _mappedLength = mappedLength;
+    _ringPath = [ringPath copy];
+    _wakePath = [wakePath copy];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark DDLogger Protocol
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)logMessage:(DDLogMessage *)logMessage {
+    if (_header == NULL) {
+        OSAtomicIncrement64Barrier(&_droppedMessageCount);
+        return;
+    }
+
+    _record.length = 0;
+    [DDLogMessageBatch appendMessage:logMessage toData:_record];
+
+    NSUInteger capacity = _capacity;
+    NSUInteger recordSize = DDSharedMemoryRecordSize(_record.length);
+    uint64_t tail = _header->tail;
+    uint64_t head = _header->head;
+
+    // The collector is done with everything before head
+    OSMemoryBarrier();
+
+    NSUInteger offset = (NSUInteger)(tail & (capacity - 1));
+    NSUInteger skip = (capacity - offset < recordSize) ? capacity - offset : 0;
+
+    if (recordSize > capacity || (tail - head) + skip + recordSize > capacity) {
+        OSAtomicIncrement64Barrier(&_header->droppedRecords);
+        OSAtomicIncrement64Barrier(&_droppedMessageCount);
+        return;
+    }
+
+    if (skip > 0) {
+        memcpy(_data + offset, &kDDSharedMemoryRingWrap, sizeof(uint32_t));
+        offset = 0;
+    }
+
+    uint32_t length = (uint32_t)_record.length;
+
+    memcpy(_data + offset, &length, sizeof(length));
+    memcpy(_data + offset + sizeof(length), _record.bytes, length);
+
+    // Publish the record
+    OSMemoryBarrier();
+    _header->tail = tail + skip + recordSize;
+    OSMemoryBarrier();
+
+    // Only a sleeping collector needs a system call, i.e. after the ring went from empty to non empty
+    if (_header->consumerWaiting && OSAtomicCompareAndSwap32Barrier(1, 0, &_header->consumerWaiting)) {
+        [self lt_wakeCollector];
+    }
+}
+
+- (void)lt_wakeCollector {
+    if (_wakeFD < 0) {
+        // Fails until the collector has opened the pipe, but then it reads the ring without being woken
+        _wakeFD = open([_wakePath fileSystemRepresentation], O_WRONLY | O_NONBLOCK);
+    }
+
+    if (_wakeFD >= 0) {
+        char byte = 1;
+
+        // A full pipe already holds plenty of wakeups
+        if (write(_wakeFD, &byte, 1) < 0 && errno != EAGAIN) {
+            close(_wakeFD);
+            _wakeFD = -1;
+        }
+
+        OSAtomicIncrement64Barrier(&_wakeupCount);
+    }
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A ring being read by a DDSharedMemoryLogCollector. Only used on the collector queue.
+ **/
+@interface DDSharedMemoryRing : NSObject
+{
+    @public
+    NSString *_path;
+    NSString *_wakePath;
+    DDSharedMemoryRingHeader *_header;
+    uint8_t *_data;
+    size_t _mappedLength;
+    NSString *_processName;
+    int _wakeFD;
+    dispatch_source_t _wakeSource;
+}
+
+@end
+
+@implementation DDSharedMemoryRing
+
+- (void)dealloc {
+    if (_header) {
+        munmap(_header, _mappedLength);
+    }
+}
+
+@end
+
+
+@interface DDSharedMemoryLogCollector () {
+    dispatch_queue_t _queue;
+
+    // Only used on the collector queue
+    int _directoryFD;
+    dispatch_source_t _directorySource;
+    id <DDLogClockTimer> _cleanupTimer;
+    NSMutableDictionary *_rings; // By path
+    int64_t _droppedByRemovedRings;
+
+    volatile int32_t _ringCount;
+    volatile int64_t _receivedMessageCount;
+}
+
+@end
+
+@implementation DDSharedMemoryLogCollector
+
+- (instancetype)initWithDirectory:(NSString *)directory log:(DDLog *)log {
+    if ((self = [super init])) {
+        _directory = [directory copy];
+        _log = log;
+        _queue = dispatch_queue_create("cocoa.lumberjack.sharedMemoryCollector", DISPATCH_QUEUE_SERIAL);
+        _directoryFD = -1;
+        _rings = [NSMutableDictionary dictionary];
+        _cleanupInterval = 5.0;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    // The handlers only hold weak references, so nothing else can be using the sources anymore
+    [self q_stop];
+
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_release(_queue);
+    #endif
+}
+
+- (NSUInteger)ringCount {
+    return (NSUInteger)_ringCount;
+}
+
+- (uint64_t)receivedMessageCount {
+    return (uint64_t)_receivedMessageCount;
+}
+
+- (uint64_t)droppedMessageCount {
+    __block int64_t dropped;
+
+    dispatch_sync(_queue, ^{
+        dropped = _droppedByRemovedRings;
+
+        for (DDSharedMemoryRing *ring in [_rings objectEnumerator]) {
+            dropped += ring->_header->droppedRecords;
+        }
+    });
+
+    return (uint64_t)dropped;
+}
+
+- (BOOL)start:(NSError **)error {
+    __block NSError *startError = nil;
+
+    dispatch_sync(_queue, ^{
+        if (_directorySource == NULL) {
+            startError = [self q_start];
+        }
+    });
+
+    if (startError) {
+        if (error) {
+            *error = startError;
+        }
+
+        return NO;
+    }
+
+    return YES;
+}
+
+- (NSError *)q_start {
+    NSError *error = nil;
+
+    if (![[NSFileManager defaultManager] createDirectoryAtPath:_directory
+                                   withIntermediateDirectories:YES
+                                                    attributes:nil
+                                                         error:&error]) {
+        return error;
+    }
+
+    #ifdef O_EVTONLY
+    int fd = open([_directory fileSystemRepresentation], O_EVTONLY);
+    #else
+    int fd = open([_directory fileSystemRepresentation], O_RDONLY);
+    #endif
+
+    if (fd < 0) {
+        return [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+    }
+
+    __weak DDSharedMemoryLogCollector *weakSelf = self;
+
+    // New rings show up as changes of the directory
+    _directoryFD = fd;
+    _directorySource = dispatch_source_create(DISPATCH_SOURCE_TYPE_VNODE, (uintptr_t)fd, DISPATCH_VNODE_WRITE, _queue);
+
+    dispatch_source_set_event_handler(_directorySource, ^{ @autoreleasepool {
+        [weakSelf q_scanDirectory];
+    } });
+
+    dispatch_source_set_cancel_handler(_directorySource, ^{
+        close(fd);
+    });
+
+    dispatch_resume(_directorySource);
+
+    _cleanupTimer = [[DDLog clock] scheduleTimerWithDelay:self.cleanupInterval
+                                                 interval:self.cleanupInterval
+                                                    queue:_queue
+                                                  handler:^{ @autoreleasepool {
+        [weakSelf q_removeRingsOfExitedProcesses];
+    } }];
+
+    [self q_scanDirectory];
+
+    return nil;
+}
+
+- (void)stop {
+    dispatch_sync(_queue, ^{
+        [self q_stop];
+    });
+}
+
+- (void)q_stop {
+    [_cleanupTimer cancel];
+    _cleanupTimer = nil;
+
+    if (_directorySource) {
+        dispatch_source_cancel(_directorySource);
+        #if !OS_OBJECT_USE_OBJC
+        dispatch_release(_directorySource);
+        #endif
+        _directorySource = NULL;
+        _directoryFD = -1;
+    }
+
+    for (DDSharedMemoryRing *ring in [[_rings allValues] copy]) {
+        [self q_closeRing:ring];
+    }
+}
+
+- (void)q_scanDirectory {
+    NSArray *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:_directory error:nil];
+
+    for (NSString *fileName in fileNames) {
+        if (![[fileName pathExtension] isEqualToString:kDDSharedMemoryRingExtension]) {
+            continue;
+        }
+
+        NSString *path = [_directory stringByAppendingPathComponent:fileName];
+
+        if (_rings[path] == nil) {
+            [self q_openRingAtPath:path];
+        }
+    }
+}
+
+- (void)q_openRingAtPath:(NSString *)path {
+    int fd = open([path fileSystemRepresentation], O_RDWR);
+    struct stat fileInfo;
+
+    if (fd < 0 || fstat(fd, &fileInfo) != 0 || (size_t)fileInfo.st_size < DD_SHARED_MEMORY_DATA_OFFSET) {
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        return;
+    }
+
+    size_t mappedLength = (size_t)fileInfo.st_size;
+    void *base = mmap(NULL, mappedLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED) {
+        return;
+    }
+
+    DDSharedMemoryRing *ring = [[DDSharedMemoryRing alloc] init];
+    ring->_path = path;
+    ring->_wakePath = [[path stringByDeletingPathExtension] stringByAppendingPathExtension:kDDSharedMemoryWakeExtension];
+    ring->_header = base;
+    ring->_data = (uint8_t *)base + DD_SHARED_MEMORY_DATA_OFFSET;
+    ring->_mappedLength = mappedLength;
+    ring->_wakeFD = -1;
+
+    if (!DDSharedMemoryHeaderIsValid(ring->_header, mappedLength)) {
+        NSLogError(@"DDSharedMemoryLogCollector: Ignoring invalid ring %@", path);
+        return;
+    }
+
+    ring->_header->processName[sizeof(ring->_header->processName) - 1] = '\0';
+    ring->_processName = @(ring->_header->processName);
+
+    // Opened for writing too, so the pipe never reports end of file when a client closes it
+    ring->_wakeFD = open([ring->_wakePath fileSystemRepresentation], O_RDWR | O_NONBLOCK);
+
+    if (ring->_wakeFD < 0) {
+        NSLogError(@"DDSharedMemoryLogCollector: Error opening %@: %s", ring->_wakePath, strerror(errno));
+        return;
+    }
+
+    __weak DDSharedMemoryLogCollector *weakSelf = self;
+    __weak DDSharedMemoryRing *weakRing = ring;
+    int wakeFD = ring->_wakeFD;
+
+    ring->_wakeSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)wakeFD, 0, _queue);
+
+    dispatch_source_set_event_handler(ring->_wakeSource, ^{ @autoreleasepool {
+        char bytes[256];
+
+        while (read(wakeFD, bytes, sizeof(bytes)) > 0) {
+        }
+
+        [weakSelf q_readRing:weakRing];
+    } });
+
+    dispatch_source_set_cancel_handler(ring->_wakeSource, ^{
+        close(wakeFD);
+    });
+
+    _rings[path] = ring;
+    _ringCount = (int32_t)_rings.count;
+    OSMemoryBarrier();
+
+    dispatch_resume(ring->_wakeSource);
+
+    // Whatever the client wrote before the pipe was open
+    [self q_readRing:ring];
+}
+
+- (void)q_closeRing:(DDSharedMemoryRing *)ring {
+    if (ring->_wakeSource) {
+        dispatch_source_cancel(ring->_wakeSource);
+        #if !OS_OBJECT_USE_OBJC
+        dispatch_release(ring->_wakeSource);
+        #endif
+        ring->_wakeSource = NULL;
+    }
+
+    _droppedByRemovedRings += ring->_header->droppedRecords;
+
+    [_rings removeObjectForKey:ring->_path];
+    _ringCount = (int32_t)_rings.count;
+    OSMemoryBarrier();
+}
+
+/**
+ * Reads until the ring is empty, then asks to be woken up.
+ **/
+- (void)q_readRing:(DDSharedMemoryRing *)ring {
+    if (ring == nil || ring->_wakeSource == NULL) {
+        return;
+    }
+
+    DDSharedMemoryRingHeader *header = ring->_header;
+    NSUInteger capacity = header->capacity;
+
+    for (;;) {
+        uint64_t head = header->head;
+        uint64_t tail = header->tail;
+        NSUInteger count = 0;
+
+        // The records before tail are complete
+        OSMemoryBarrier();
+
+        while (head != tail) {
+            NSUInteger offset = (NSUInteger)(head & (capacity - 1));
+            uint32_t length;
+
+            memcpy(&length, ring->_data + offset, sizeof(length));
+
+            if (length == kDDSharedMemoryRingWrap) {
+                head += capacity - offset;
+                continue;
+            }
+
+            if (offset + DDSharedMemoryRecordSize(length) > capacity) {
+                NSLogError(@"DDSharedMemoryLogCollector: Corrupt ring %@", ring->_path);
+                [self q_closeRing:ring];
+                return;
+            }
+
+            DDCollectedLogMessage *message = [DDLogMessageBatch messageWithBytes:ring->_data + offset + sizeof(length)
+                                                                          length:length
+                                                                     processName:ring->_processName
+                                                                       processID:(int)header->processID];
+
+            if (message) {
+                [_log log:YES message:message];
+                count++;
+            }
+
+            head += DDSharedMemoryRecordSize(length);
+        }
+
+        // Done with everything before head
+        OSMemoryBarrier();
+        header->head = head;
+
+        OSAtomicAdd64Barrier((int64_t)count, &_receivedMessageCount);
+
+        // Sleep, unless a record came in meanwhile (the client may not have seen the flag)
+        header->consumerWaiting = 1;
+        OSMemoryBarrier();
+
+        if (header->tail == head) {
+            return;
+        }
+
+        OSAtomicCompareAndSwap32Barrier(1, 0, &header->consumerWaiting);
+    }
+}
+
+- (void)q_removeRingsOfExitedProcesses {
+    for (DDSharedMemoryRing *ring in [[_rings allValues] copy]) {
+        pid_t processID = (pid_t)ring->_header->processID;
+
+        if (kill(processID, 0) == 0 || errno != ESRCH) {
+            continue;
+        }
+
+        [self q_readRing:ring];
+
+        if (ring->_wakeSource && ring->_header->head == ring->_header->tail) {
+            [self q_closeRing:ring];
+
+            unlink([ring->_path fileSystemRepresentation]);
+            unlink([ring->_wakePath fileSystemRepresentation]);
+        }
+    }
+}
+
+@end
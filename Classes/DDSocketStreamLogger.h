@@ -0,0 +1,125 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Disable legacy macros
+#ifndef DD_LEGACY_MACROS
+    #define DD_LEGACY_MACROS 0
+#endif
+
+#import "DDLog.h"
+
+/**
+ * What happens to a subscriber that doesn't keep up.
+ **/
+typedef NS_ENUM(NSUInteger, DDSocketStreamOverflowPolicy) {
+    /**
+     * Messages that don't fit in the subscriber's buffer are dropped.
+     * Once there is room again, the subscriber is told how many.
+     **/
+    DDSocketStreamOverflowPolicyDrop,
+    /**
+     * Like DDSocketStreamOverflowPolicyDrop, but once the buffer is half full, only one in `downsampleRate`
+     * messages below the warning level is kept, so errors and warnings are more likely to get through.
+     **/
+    DDSocketStreamOverflowPolicyDownsample,
+    /**
+     * The subscriber is disconnected as soon as a message doesn't fit.
+     **/
+    DDSocketStreamOverflowPolicyDisconnect
+};
+
+/**
+ * A logger for live tailing: streams the log to any number of subscribers connected to a local socket
+ * (a Unix domain socket, or TCP on the loopback interface).
+ *
+ * DDSocketStreamLogger *streamLogger = [[DDSocketStreamLogger alloc] initWithUnixSocketPath:@"/tmp/myapp.log.sock"];
+ * [streamLogger startListening:NULL];
+ * [DDLog addLogger:streamLogger];
+ *
+ * $ nc -U /tmp/myapp.log.sock
+ *
+ * The stream is the formatted messages, one per line. A message is formatted once, however many subscribers get it.
+ *
+ * Tailing never slows down the logging process: each subscriber has a bounded buffer, the sockets are non blocking,
+ * and whatever accumulated in a buffer is sent with a single `writev` when the socket can take it.
+ * A subscriber that doesn't keep up loses messages (see DDSocketStreamOverflowPolicy), never the application.
+ *
+ * Subscribers can narrow down what they get by sending commands, one per line. Each is answered with "OK" or "ERROR":
+ *
+ * - `LEVEL <error|warning|info|debug|verbose|all|off>`: the most verbose level to send (default: all)
+ * - `CONTEXT <context>[,<context>...]`: only send messages with one of these contexts
+ * - `CONTEXT *`: send messages of any context (the default)
+ **/
+@interface DDSocketStreamLogger : DDAbstractLogger <DDLogger>
+
+/**
+ *  Streams to subscribers of a Unix domain socket. A socket file left at `path` by an earlier run is replaced.
+ */
+- (instancetype)initWithUnixSocketPath:(NSString *)path;
+
+/**
+ *  Streams to subscribers of a TCP socket on the loopback interface. Port 0 picks a free port (see `listeningPort`).
+ */
+- (instancetype)initWithTCPPort:(uint16_t)port;
+
+/**
+ *  Opens the socket. Subscribers can connect before the logger is added to DDLog.
+ *
+ *  @return NO, with the POSIX error, if the socket couldn't be opened
+ */
+- (BOOL)startListening:(NSError **)error;
+
+/**
+ *  Disconnects all subscribers and closes the socket. Also done when the logger is removed from DDLog.
+ */
+- (void)stopListening;
+
+/**
+ * The TCP port listened on, 0 for a Unix domain socket or before listening.
+ **/
+@property (readonly) uint16_t listeningPort;
+
+/**
+ * The size of the buffer of each subscriber, in bytes. Defaults to 256 KB.
+ * Takes effect for subscribers connecting afterwards.
+ **/
+@property (assign) NSUInteger subscriberBufferSize;
+
+/**
+ * Defaults to DDSocketStreamOverflowPolicyDrop.
+ **/
+@property (assign) DDSocketStreamOverflowPolicy overflowPolicy;
+
+/**
+ * For DDSocketStreamOverflowPolicyDownsample, defaults to 8.
+ **/
+@property (assign) NSUInteger downsampleRate;
+
+/**
+ * The maximum number of subscribers; further connections are closed right away. Defaults to 16.
+ **/
+@property (assign) NSUInteger maximumSubscriberCount;
+
+/**
+ * The number of connected subscribers.
+ **/
+@property (readonly) NSUInteger subscriberCount;
+
+/**
+ * The number of messages not sent to a subscriber because its buffer was full (or downsampled), over all subscribers.
+ **/
+@property (readonly) uint64_t droppedMessageCount;
+
+@end
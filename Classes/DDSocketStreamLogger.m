@@ -0,0 +1,661 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+#import "DDSocketStreamLogger.h"
+
+#import <unistd.h>
+#import <fcntl.h>
+#import <sys/socket.h>
+#import <sys/stat.h>
+#import <sys/uio.h>
+#import <sys/un.h>
+#import <netinet/in.h>
+#import <libkern/OSAtomic.h>
+
+#if !__has_feature(objc_arc)
+#error This file must be compiled with ARC. Use -fobjc-arc flag (or convert project to ARC).
+#endif
+
+// A subscriber sending a longer line without a newline is disconnected
+#define DD_SOCKET_STREAM_MAX_COMMAND_LENGTH 1024
+
+/**
+ * A connected subscriber. Only used on the logger queue.
+ *
+ * The buffer is a ring of bytes not sent yet, from _head on (wrapping around), _length bytes long.
+ **/
+@interface DDSocketStreamSubscriber : NSObject
+{
+    // Direct accessors to be used only for performance
+    @public
+    int _fd;
+    dispatch_source_t _readSource;
+    dispatch_source_t _writeSource;
+    BOOL _writeSourceSuspended;
+    BOOL _disconnected;
+
+    uint8_t *_buffer;
+    NSUInteger _capacity;
+    NSUInteger _head;
+    NSUInteger _length;
+
+    DDLogLevel _level;
+    NSSet *_contexts; // Nil for all contexts
+    NSUInteger _droppedMessages; // Since the subscriber was last told
+    NSUInteger _sampleCounter;
+    NSMutableData *_commandBuffer;
+}
+
+- (instancetype)initWithFileDescriptor:(int)fd capacity:(NSUInteger)capacity;
+
+/**
+ * Adds the bytes to the buffer, if they fit.
+ **/
+- (BOOL)appendBytes:(const void *)bytes length:(NSUInteger)length;
+
+/**
+ * Sends as much of the buffer as the socket takes, with a single writev.
+ **/
+- (ssize_t)sendBuffer;
+
+@end
+
+@implementation DDSocketStreamSubscriber
+
+- (instancetype)initWithFileDescriptor:(int)fd capacity:(NSUInteger)capacity {
+    if ((self = [super init])) {
+        _fd = fd;
+        _capacity = MAX(capacity, 1024u);
+        _buffer = malloc(_capacity);
+        _level = DDLogLevelAll;
+        _commandBuffer = [NSMutableData data];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    free(_buffer);
+}
+
+- (BOOL)appendBytes:(const void *)bytes length:(NSUInteger)length {
+    if (length > _capacity - _length) {
+        return NO;
+    }
+
+    NSUInteger tail = (_head + _length) % _capacity;
+    NSUInteger firstPart = MIN(length, _capacity - tail);
+
+    memcpy(_buffer + tail, bytes, firstPart);
+    memcpy(_buffer, (const uint8_t *)bytes + firstPart, length - firstPart);
+
+    _length += length;
+
+    return YES;
+}
+
+- (ssize_t)sendBuffer {
+    struct iovec iov[2];
+    int iovcnt = 1;
+    NSUInteger firstPart = MIN(_length, _capacity - _head);
+
+    iov[0].iov_base = _buffer + _head;
+    iov[0].iov_len = firstPart;
+
+    if (_length > firstPart) {
+        iov[1].iov_base = _buffer;
+        iov[1].iov_len = _length - firstPart;
+        iovcnt = 2;
+    }
+
+    ssize_t written = writev(_fd, iov, iovcnt);
+
+    if (written > 0) {
+        _head = (_head + (NSUInteger)written) % _capacity;
+        _length -= (NSUInteger)written;
+
+        if (_length == 0) {
+            _head = 0;
+        }
+    }
+
+    return written;
+}
+
+@end
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+@interface DDSocketStreamLogger () {
+    NSString *_unixSocketPath;
+    uint16_t _requestedPort;
+
+    // Only used on the logger queue
+    int _listenFD;
+    dispatch_source_t _listenSource;
+    NSMutableArray *_subscribers;
+
+    volatile int32_t _subscriberCount;
+    volatile int64_t _droppedMessageCount;
+}
+
+@property (readwrite) uint16_t listeningPort;
+
+@end
+
+@implementation DDSocketStreamLogger
+
+- (instancetype)initWithUnixSocketPath:(NSString *)path {
+    if ((self = [self initWithTCPPort:0])) {
+        _unixSocketPath = [path copy];
+    }
+
+    return self;
+}
+
+- (instancetype)initWithTCPPort:(uint16_t)port {
+    if ((self = [super init])) {
+        _requestedPort = port;
+        _listenFD = -1;
+        _subscribers = [NSMutableArray array];
+
+        _subscriberBufferSize = 256 * 1024;
+        _overflowPolicy = DDSocketStreamOverflowPolicyDrop;
+        _downsampleRate = 8;
+        _maximumSubscriberCount = 16;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    // The handlers only hold weak references, so nothing else can be using the sources anymore
+    [self lt_stopListening];
+}
+
+- (NSString *)loggerName {
+    return @"cocoa.lumberjack.socketStreamLogger";
+}
+
+- (void)onLoggerQueue:(dispatch_block_t)block {
+    if ([self isOnInternalLoggerQueue]) {
+        block();
+    } else {
+        dispatch_sync(_loggerQueue, block);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Listening
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (BOOL)startListening:(NSError **)error {
+    __block int errorCode = 0;
+
+    [self onLoggerQueue:^{
+        if (_listenSource == NULL) {
+            errorCode = [self lt_startListening];
+        }
+    }];
+
+    if (errorCode != 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errorCode userInfo:nil];
+        }
+
+        return NO;
+    }
+
+    return YES;
+}
+
+- (int)lt_startListening {
+    int fd;
+
+    if (_unixSocketPath) {
+        struct sockaddr_un address;
+        const char *path = [_unixSocketPath fileSystemRepresentation];
+
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+
+        if (strlen(path) >= sizeof(address.sun_path)) {
+            return ENAMETOOLONG;
+        }
+
+        strlcpy(address.sun_path, path, sizeof(address.sun_path));
+
+        // Replace a socket left behind by an earlier run, but nothing else
+        struct stat fileInfo;
+
+        if (lstat(path, &fileInfo) == 0 && S_ISSOCK(fileInfo.st_mode)) {
+            unlink(path);
+        }
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+            int errorCode = errno;
+
+            if (fd >= 0) {
+                close(fd);
+            }
+
+            return errorCode;
+        }
+    } else {
+        struct sockaddr_in address;
+        socklen_t addressLength = sizeof(address);
+        int reuse = 1;
+
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(_requestedPort);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+
+        if (fd < 0 ||
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+            bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+            getsockname(fd, (struct sockaddr *)&address, &addressLength) != 0) {
+            int errorCode = errno;
+
+            if (fd >= 0) {
+                close(fd);
+            }
+
+            return errorCode;
+        }
+
+        self.listeningPort = ntohs(address.sin_port);
+    }
+
+    if (listen(fd, 16) != 0 || fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+        int errorCode = errno;
+
+        close(fd);
+
+        return errorCode;
+    }
+
+    __weak DDSocketStreamLogger *weakSelf = self;
+    NSString *unixSocketPath = _unixSocketPath;
+
+    _listenFD = fd;
+    _listenSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _loggerQueue);
+
+    dispatch_source_set_event_handler(_listenSource, ^{ @autoreleasepool {
+        [weakSelf lt_acceptSubscribers];
+    } });
+
+    dispatch_source_set_cancel_handler(_listenSource, ^{
+        close(fd);
+
+        if (unixSocketPath) {
+            unlink([unixSocketPath fileSystemRepresentation]);
+        }
+    });
+
+    dispatch_resume(_listenSource);
+
+    return 0;
+}
+
+- (void)stopListening {
+    [self onLoggerQueue:^{
+        [self lt_stopListening];
+    }];
+}
+
+- (void)lt_stopListening {
+    if (_listenSource) {
+        dispatch_source_cancel(_listenSource);
+        #if !OS_OBJECT_USE_OBJC
+        dispatch_release(_listenSource);
+        #endif
+        _listenSource = NULL;
+        _listenFD = -1;
+    }
+
+    for (DDSocketStreamSubscriber *subscriber in [_subscribers copy]) {
+        [self lt_disconnectSubscriber:subscriber];
+    }
+
+    self.listeningPort = 0;
+}
+
+- (void)willRemoveLogger {
+    [self lt_stopListening];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Subscribers
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (NSUInteger)subscriberCount {
+    return (NSUInteger)_subscriberCount;
+}
+
+- (uint64_t)droppedMessageCount {
+    return (uint64_t)_droppedMessageCount;
+}
+
+- (void)lt_acceptSubscribers {
+    int fd;
+
+    while ((fd = accept(_listenFD, NULL, NULL)) >= 0) {
+        if (_subscribers.count >= self.maximumSubscriberCount) {
+            close(fd);
+            continue;
+        }
+
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+
+        #ifdef SO_NOSIGPIPE
+        int noSigPipe = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+        #endif
+
+        DDSocketStreamSubscriber *subscriber = [[DDSocketStreamSubscriber alloc] initWithFileDescriptor:fd
+                                                                                               capacity:self.subscriberBufferSize];
+
+        __weak DDSocketStreamLogger *weakSelf = self;
+        __weak DDSocketStreamSubscriber *weakSubscriber = subscriber;
+
+        // The descriptor is closed once both sources are cancelled (the cancel handlers run on the logger queue)
+        __block int openSources = 2;
+        dispatch_block_t cancelHandler = ^{
+            if (--openSources == 0) {
+                close(fd);
+            }
+        };
+
+        subscriber->_readSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _loggerQueue);
+        dispatch_source_set_event_handler(subscriber->_readSource, ^{ @autoreleasepool {
+            [weakSelf lt_readFromSubscriber:weakSubscriber];
+        } });
+        dispatch_source_set_cancel_handler(subscriber->_readSource, cancelHandler);
+
+        // Resumed only while there's something to send
+        subscriber->_writeSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_WRITE, (uintptr_t)fd, 0, _loggerQueue);
+        dispatch_source_set_event_handler(subscriber->_writeSource, ^{ @autoreleasepool {
+            [weakSelf lt_writeToSubscriber:weakSubscriber];
+        } });
+        dispatch_source_set_cancel_handler(subscriber->_writeSource, cancelHandler);
+        subscriber->_writeSourceSuspended = YES;
+
+        [_subscribers addObject:subscriber];
+        _subscriberCount = (int32_t)_subscribers.count;
+        OSMemoryBarrier();
+
+        dispatch_resume(subscriber->_readSource);
+    }
+}
+
+- (void)lt_disconnectSubscriber:(DDSocketStreamSubscriber *)subscriber {
+    if (subscriber == nil || subscriber->_disconnected) {
+        return;
+    }
+
+    subscriber->_disconnected = YES;
+
+    // A suspended source doesn't run its cancel handler
+    if (subscriber->_writeSourceSuspended) {
+        dispatch_resume(subscriber->_writeSource);
+        subscriber->_writeSourceSuspended = NO;
+    }
+
+    dispatch_source_cancel(subscriber->_writeSource);
+    dispatch_source_cancel(subscriber->_readSource);
+
+    #if !OS_OBJECT_USE_OBJC
+    dispatch_release(subscriber->_writeSource);
+    dispatch_release(subscriber->_readSource);
+    #endif
+    subscriber->_writeSource = NULL;
+    subscriber->_readSource = NULL;
+
+    [_subscribers removeObjectIdenticalTo:subscriber];
+    _subscriberCount = (int32_t)_subscribers.count;
+    OSMemoryBarrier();
+}
+
+- (void)lt_scheduleWriteToSubscriber:(DDSocketStreamSubscriber *)subscriber {
+    // The write source fires once the current block is done,
+    // so the messages logged in between go out in the same writev
+    if (subscriber->_writeSourceSuspended) {
+        subscriber->_writeSourceSuspended = NO;
+        dispatch_resume(subscriber->_writeSource);
+    }
+}
+
+- (void)lt_writeToSubscriber:(DDSocketStreamSubscriber *)subscriber {
+    if (subscriber == nil || subscriber->_disconnected) {
+        return;
+    }
+
+    if (subscriber->_length > 0) {
+        ssize_t written = [subscriber sendBuffer];
+
+        if (written < 0 && errno != EAGAIN && errno != EINTR) {
+            [self lt_disconnectSubscriber:subscriber];
+            return;
+        }
+    }
+
+    if (subscriber->_length == 0) {
+        subscriber->_writeSourceSuspended = YES;
+        dispatch_suspend(subscriber->_writeSource);
+    }
+}
+
+- (void)lt_readFromSubscriber:(DDSocketStreamSubscriber *)subscriber {
+    if (subscriber == nil || subscriber->_disconnected) {
+        return;
+    }
+
+    char buffer[512];
+    ssize_t length = read(subscriber->_fd, buffer, sizeof(buffer));
+
+    if (length == 0 || (length < 0 && errno != EAGAIN && errno != EINTR)) {
+        [self lt_disconnectSubscriber:subscriber];
+        return;
+    }
+
+    if (length < 0) {
+        return;
+    }
+
+    NSMutableData *commandBuffer = subscriber->_commandBuffer;
+    [commandBuffer appendBytes:buffer length:(NSUInteger)length];
+
+    const char *bytes;
+    const char *newline;
+
+    while ((newline = memchr((bytes = commandBuffer.bytes), '\n', commandBuffer.length))) {
+        NSUInteger lineLength = (NSUInteger)(newline - bytes);
+        NSString *command = [[NSString alloc] initWithBytes:bytes length:lineLength encoding:NSUTF8StringEncoding];
+
+        [commandBuffer replaceBytesInRange:NSMakeRange(0, lineLength + 1) withBytes:NULL length:0];
+
+        const char *reply = [self lt_applyCommand:command toSubscriber:subscriber] ? "OK\n" : "ERROR\n";
+
+        if ([subscriber appendBytes:reply length:strlen(reply)]) {
+            [self lt_scheduleWriteToSubscriber:subscriber];
+        }
+    }
+
+    if (commandBuffer.length > DD_SOCKET_STREAM_MAX_COMMAND_LENGTH) {
+        [self lt_disconnectSubscriber:subscriber];
+    }
+}
+
+- (BOOL)lt_applyCommand:(NSString *)command toSubscriber:(DDSocketStreamSubscriber *)subscriber {
+    NSCharacterSet *whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+    NSArray *words = [[command stringByTrimmingCharactersInSet:whitespace] componentsSeparatedByCharactersInSet:whitespace];
+
+    if (words.count != 2) {
+        return NO;
+    }
+
+    NSString *name = [words[0] uppercaseString];
+    NSString *argument = [words[1] lowercaseString];
+
+    if ([name isEqualToString:@"LEVEL"]) {
+        NSDictionary *levels = @{ @"off": @(DDLogLevelOff),
+                                  @"error": @(DDLogLevelError),
+                                  @"warning": @(DDLogLevelWarning),
+                                  @"info": @(DDLogLevelInfo),
+                                  @"debug": @(DDLogLevelDebug),
+                                  @"verbose": @(DDLogLevelVerbose),
+                                  @"all": @(DDLogLevelAll) };
+        NSNumber *level = levels[argument];
+
+        if (level == nil) {
+            return NO;
+        }
+
+        subscriber->_level = (DDLogLevel)level.unsignedIntegerValue;
+
+        return YES;
+    }
+
+    if ([name isEqualToString:@"CONTEXT"]) {
+        if ([argument isEqualToString:@"*"]) {
+            subscriber->_contexts = nil;
+            return YES;
+        }
+
+        NSMutableSet *contexts = [NSMutableSet set];
+
+        for (NSString *part in [argument componentsSeparatedByString:@","]) {
+            NSScanner *scanner = [NSScanner scannerWithString:part];
+            NSInteger context;
+
+            if (![scanner scanInteger:&context] || !scanner.isAtEnd) {
+                return NO;
+            }
+
+            [contexts addObject:@(context)];
+        }
+
+        subscriber->_contexts = contexts;
+
+        return YES;
+    }
+
+    return NO;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark DDLogger Protocol
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+- (void)logMessage:(DDLogMessage *)logMessage {
+    if (_subscriberCount == 0) {
+        return;
+    }
+
+    NSData *line = nil;
+    NSMutableArray *overflowedSubscribers = nil;
+    DDSocketStreamOverflowPolicy policy = self.overflowPolicy;
+
+    for (DDSocketStreamSubscriber *subscriber in _subscribers) {
+        if (!(logMessage->_flag & subscriber->_level)) {
+            continue;
+        }
+
+        if (subscriber->_contexts && ![subscriber->_contexts containsObject:@(logMessage->_context)]) {
+            continue;
+        }
+
+        if (line == nil) {
+            // Formatted once, for all subscribers
+            NSString *message = _logFormatter ? [_logFormatter formatLogMessage:logMessage] : logMessage->_message;
+
+            if (message == nil) {
+                return;
+            }
+
+            if (![message hasSuffix:@"\n"]) {
+                message = [message stringByAppendingString:@"\n"];
+            }
+
+            line = [message dataUsingEncoding:NSUTF8StringEncoding];
+        }
+
+        if (![self lt_appendLine:line flag:logMessage->_flag toSubscriber:subscriber policy:policy]) {
+            if (overflowedSubscribers == nil) {
+                overflowedSubscribers = [NSMutableArray array];
+            }
+
+            [overflowedSubscribers addObject:subscriber];
+        }
+    }
+
+    for (DDSocketStreamSubscriber *subscriber in overflowedSubscribers) {
+        [self lt_disconnectSubscriber:subscriber];
+    }
+}
+
+/**
+ * Returns NO if the subscriber is to be disconnected.
+ **/
+- (BOOL)lt_appendLine:(NSData *)line
+                 flag:(DDLogFlag)flag
+         toSubscriber:(DDSocketStreamSubscriber *)subscriber
+               policy:(DDSocketStreamOverflowPolicy)policy {
+    if (policy == DDSocketStreamOverflowPolicyDownsample &&
+        subscriber->_length > subscriber->_capacity / 2 &&
+        !(flag & (DDLogFlagError | DDLogFlagWarning)) &&
+        (subscriber->_sampleCounter++ % MAX(self.downsampleRate, 1u)) != 0) {
+        [self lt_dropMessageForSubscriber:subscriber];
+        return YES;
+    }
+
+    if (subscriber->_droppedMessages > 0) {
+        NSString *notice = [NSString stringWithFormat:@"[%lu messages dropped]\n", (unsigned long)subscriber->_droppedMessages];
+        NSData *noticeData = [notice dataUsingEncoding:NSUTF8StringEncoding];
+
+        if (![subscriber appendBytes:noticeData.bytes length:noticeData.length]) {
+            [self lt_dropMessageForSubscriber:subscriber];
+            return YES;
+        }
+
+        subscriber->_droppedMessages = 0;
+    }
+
+    if (![subscriber appendBytes:line.bytes length:line.length]) {
+        if (policy == DDSocketStreamOverflowPolicyDisconnect) {
+            return NO;
+        }
+
+        [self lt_dropMessageForSubscriber:subscriber];
+    }
+
+    [self lt_scheduleWriteToSubscriber:subscriber];
+
+    return YES;
+}
+
+- (void)lt_dropMessageForSubscriber:(DDSocketStreamSubscriber *)subscriber {
+    subscriber->_droppedMessages++;
+    OSAtomicIncrement64Barrier(&_droppedMessageCount);
+}
+
+@end
@@ -14,6 +14,8 @@
 //   prior written permission of Deusty, LLC.
 
 #import "DDTTYLogger.h"
+#import "DDLogTrace.h"
+#import "DDLogNumberFormatting.h"
 
 #import <unistd.h>
 #import <sys/uio.h>
@@ -1165,6 +1167,8 @@ static DDTTYLogger *sharedInstance;
         isFormatted = logMsg != logMessage->_message;
     }
 
+    DDLogTraceMark(DDLogTraceStageFormatted);
+
     if (logMsg) {
         // Search for a color profile associated with the log message
 
@@ -1273,15 +1277,25 @@ static DDTTYLogger *sharedInstance;
                 NSTimeInterval epoch = [logMessage->_timestamp timeIntervalSinceReferenceDate];
                 int milliseconds = (int)((epoch - floor(epoch)) * 1000);
 
-                len = snprintf(ts, 24, "%04ld-%02ld-%02ld %02ld:%02ld:%02ld:%03d", // yyyy-MM-dd HH:mm:ss:SSS
-                               (long)components.year,
-                               (long)components.month,
-                               (long)components.day,
-                               (long)components.hour,
-                               (long)components.minute,
-                               (long)components.second, milliseconds);
+                // yyyy-MM-dd HH:mm:ss:SSS, without going through snprintf's format parser
+                NSInteger fields[7] = { components.year, components.month, components.day,
+                                        components.hour, components.minute, components.second, milliseconds };
+                static const NSUInteger widths[7] = { 4, 2, 2, 2, 2, 2, 3 };
+                static const char separators[7] = { '-', '-', ' ', ':', ':', ':', '\0' };
+
+                char buffer[7 * (DD_LOG_INTEGER_MAX_LENGTH + 1)];
+                size_t bufferLen = 0;
+
+                for (NSUInteger i = 0; i < 7; i++) {
+                    bufferLen += DDLogFormatUnsignedIntegerWithWidth(buffer + bufferLen, (uint64_t)MAX(fields[i], 0), widths[i]);
+
+                    if (separators[i]) {
+                        buffer[bufferLen++] = separators[i];
+                    }
+                }
 
-                tsLen = (NSUInteger)MAX(MIN(24 - 1, len), 0);
+                tsLen = MIN(sizeof(ts) - 1, bufferLen);
+                memcpy(ts, buffer, tsLen);
             }
 
             // Calculate thread ID
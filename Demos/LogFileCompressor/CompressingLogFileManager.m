@@ -96,6 +96,17 @@
         return;
     }
     
+    // Report the files still to be compressed (including the next one) to the logging metrics
+    NSUInteger backlog = 0;
+    for (DDLogFileInfo *logFileInfo in sortedLogFileInfos)
+    {
+        if (logFileInfo.isArchived && !logFileInfo.isCompressed)
+        {
+            backlog++;
+        }
+    }
+    DDLogMetricsSet(DDLogMetricsCounterCompressionBacklog, (int64_t)backlog);
+    
     NSUInteger i = count;
     while (i > 0)
     {
@@ -25,9 +25,22 @@ FOUNDATION_EXPORT const unsigned char CocoaLumberjackVersionString[];
 
 // Core
 #import <CocoaLumberjack/DDLog.h>
+#import <CocoaLumberjack/DDLogClock.h>
 
 // Main macros
 #import <CocoaLumberjack/DDLogMacros.h>
+#import <CocoaLumberjack/DDLogScope.h>
+#import <CocoaLumberjack/DDLogTrace.h>
+#import <CocoaLumberjack/DDLogCallSiteProfiler.h>
+#import <CocoaLumberjack/DDLogWatchdog.h>
+#import <CocoaLumberjack/DDLogMetrics.h>
+#import <CocoaLumberjack/DDSocketStreamLogger.h>
+#import <CocoaLumberjack/DDLogCollector.h>
+#import <CocoaLumberjack/DDSharedMemoryLogger.h>
+#import <CocoaLumberjack/DDRemoteSyslogLogger.h>
+#import <CocoaLumberjack/DDLogNumberFormatting.h>
+#import <CocoaLumberjack/DDLogFormatCache.h>
+#import <CocoaLumberjack/DDLogStringTable.h>
 #import <CocoaLumberjack/DDAssertMacros.h>
 
 // Capture ASL
@@ -37,3 +50,6 @@ FOUNDATION_EXPORT const unsigned char CocoaLumberjackVersionString[];
 #import <CocoaLumberjack/DDTTYLogger.h>
 #import <CocoaLumberjack/DDASLLogger.h>
 #import <CocoaLumberjack/DDFileLogger.h>
+#import <CocoaLumberjack/DDFlightRecorderLogger.h>
+#import <CocoaLumberjack/DDEmergencyLog.h>
+#import <CocoaLumberjack/DDMemoryLogger.h>
@@ -17,6 +17,12 @@ class AppDelegate: NSObject, NSApplicationDelegate {
 	@IBOutlet weak var window: NSWindow!
     
 	func applicationDidFinishLaunching(_ aNotification: Notification) {
+		if CommandLine.arguments.contains("-benchmark") {
+			runInterpolationBenchmark()
+			NSApp.terminate(nil)
+			return
+		}
+
         DDLog.add(DDTTYLogger.sharedInstance())
 		
         defaultDebugLevel = .warning
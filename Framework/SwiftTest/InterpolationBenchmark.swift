@@ -0,0 +1,88 @@
+//
+//  InterpolationBenchmark.swift
+//  SwiftTest
+//
+//  Compares the cost of a log statement with an interpolated message, on the calling thread
+//  and until the logging queue is drained, between the String path (`DDLogInfo("...")`, the string
+//  is built by the caller) and the deferred path (`DDLogInfo(deferred: "...")`, built on the logging queue).
+//
+//  Run with: SwiftTest.app/Contents/MacOS/SwiftTest -benchmark
+//
+
+import Foundation
+import CocoaLumberjack
+import CocoaLumberjackSwift
+
+/// A logger that drops every message, so only the framework is measured.
+private class NullLogger: DDAbstractLogger {
+	override func log(message logMessage: DDLogMessage) {
+		// Intentionally empty
+	}
+}
+
+private struct User: CustomStringConvertible {
+	let name: String
+	let identifier: Int
+
+	var description: String {
+		return "User(\(name), #\(identifier))"
+	}
+}
+
+private func nanoseconds(_ block: () -> Void) -> UInt64 {
+	let start = DispatchTime.now().uptimeNanoseconds
+	block()
+	return DispatchTime.now().uptimeNanoseconds - start
+}
+
+func runInterpolationBenchmark(statements: Int = 200_000, repetitions: Int = 5) {
+	let ddlog = DDLog()
+	ddlog.add(NullLogger(), with: .info)
+
+	let user = User(name: "Jane Appleseed", identifier: 4711)
+	let amount = 129.95
+	let items = 3
+
+	let cases: [(String, (Int) -> Void)] = [
+		("string", { i in
+			DDLogInfo("\(user) bought \(items) items for \(amount) (order \(i))", ddlog: ddlog)
+		}),
+		("deferred", { i in
+			DDLogInfo(deferred: "\(user) bought \(items) items for \(amount) (order \(i))", ddlog: ddlog)
+		}),
+		("deferred+private", { i in
+			DDLogInfo(deferred: "\(DDPrivate(user)) bought \(items) items for \(amount) (order \(i))", ddlog: ddlog)
+		}),
+		("string, filtered", { i in
+			DDLogDebug("\(user) bought \(items) items for \(amount) (order \(i))", ddlog: ddlog)
+		}),
+		("deferred, filtered", { i in
+			DDLogDebug(deferred: "\(user) bought \(items) items for \(amount) (order \(i))", ddlog: ddlog)
+		})
+	]
+
+	print("case,caller_ns_per_statement,total_ns_per_statement")
+
+	for (name, statement) in cases {
+		var callerTimes: [UInt64] = []
+		var totalTimes: [UInt64] = []
+
+		for _ in 0..<repetitions {
+			var callerTime: UInt64 = 0
+			let totalTime = nanoseconds {
+				callerTime = nanoseconds {
+					for i in 0..<statements {
+						statement(i)
+					}
+				}
+				ddlog.flushLog()
+			}
+
+			callerTimes.append(callerTime / UInt64(statements))
+			totalTimes.append(totalTime / UInt64(statements))
+		}
+
+		// Medians
+		print("\(name),\(callerTimes.sorted()[repetitions / 2]),\(totalTimes.sorted()[repetitions / 2])")
+	}
+}
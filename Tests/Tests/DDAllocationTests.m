@@ -0,0 +1,108 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+#import "DDAllocationCounter.h"
+
+static const DDLogLevel ddLogLevel = DDLogLevelInfo;
+
+static NSUInteger const kStatementCount = 1000;
+
+// Heap allocations per log statement. A failure means a change added allocations to the hot path:
+// either remove them, or raise the budget deliberately (see `lumberjack-bench alloc` for the breakdown).
+static double const kCallerAllocationBudget = 16.0;
+static double const kLoggingThreadAllocationBudget = 8.0;
+
+@interface DDAllocationTestLogger : DDAbstractLogger <DDLogger>
+@end
+
+@implementation DDAllocationTestLogger
+
+- (void)logMessage:(DDLogMessage *)logMessage {
+    // Intentionally empty, only the framework's allocations are counted
+}
+
+@end
+
+
+@interface DDAllocationTests : XCTestCase
+@end
+
+@implementation DDAllocationTests
+
+- (void)setUp {
+    [super setUp];
+    [DDLog removeAllLoggers];
+    [DDLog addLogger:[[DDAllocationTestLogger alloc] init]];
+}
+
+- (void)tearDown {
+    [DDLog removeAllLoggers];
+    [super tearDown];
+}
+
+- (void)logStatements:(NSUInteger)count async:(BOOL)async {
+    @autoreleasepool {
+        for (NSUInteger i = 0; i < count; i++) {
+            LOG_MAYBE(async, ddLogLevel, DDLogFlagInfo, 0, nil, __PRETTY_FUNCTION__, @"Statement %lu", (unsigned long)i);
+        }
+    }
+}
+
+- (void)measureAsync:(BOOL)async caller:(DDAllocationCount *)caller other:(DDAllocationCount *)other {
+    // Warm up, so that lazily created state isn't counted
+    [self logStatements:100 async:async];
+    [DDLog flushLog];
+
+    DDAllocationCounterStart();
+    [self logStatements:kStatementCount async:async];
+    DDAllocationCounterRead(caller, NULL);
+    [DDLog flushLog];
+    DDAllocationCounterStop(NULL, other);
+}
+
+- (void)testAsyncLogStatementAllocationBudget {
+    DDAllocationCount caller, other;
+    [self measureAsync:YES caller:&caller other:&other];
+
+    expect(caller.allocations).to.beGreaterThan(0);
+    expect((double)caller.allocations / kStatementCount).to.beLessThanOrEqualTo(kCallerAllocationBudget);
+    expect((double)other.allocations / kStatementCount).to.beLessThanOrEqualTo(kLoggingThreadAllocationBudget);
+}
+
+- (void)testSyncLogStatementAllocationBudget {
+    DDAllocationCount caller, other;
+    [self measureAsync:NO caller:&caller other:&other];
+
+    // Synchronous statements do the loggers' work on the logging queue too, while the caller waits
+    double total = (double)(caller.allocations + other.allocations) / kStatementCount;
+    expect(total).to.beLessThanOrEqualTo(kCallerAllocationBudget + kLoggingThreadAllocationBudget);
+}
+
+- (void)testFilteredLogStatementDoesNotAllocate {
+    DDAllocationCount caller;
+
+    DDAllocationCounterStart();
+    for (NSUInteger i = 0; i < kStatementCount; i++) {
+        LOG_MAYBE(YES, ddLogLevel, DDLogFlagVerbose, 0, nil, __PRETTY_FUNCTION__, @"Statement %lu", (unsigned long)i);
+    }
+    DDAllocationCounterStop(&caller, NULL);
+
+    expect(caller.allocations).to.equal(0);
+}
+
+@end
@@ -104,6 +104,31 @@ DDLogLevel ddLogLevel = DDLogLevelVerbose;
     }];
 }
 
+- (void)testMessageBlocksOnlyInvokedForAcceptedFlags {
+    self.expectation = [self expectationWithDescription:@"message blocks"];
+    self.logs = @[ @"Error", @"Warn" ];
+    
+    [DDLog removeAllLoggers];
+    [DDLog addLogger:self.logger withLevel:DDLogLevelWarning];
+    [DDLog flushLog];
+    
+    expect([DDLog loggersLevel]).to.equal(DDLogLevelWarning);
+    
+    __block NSUInteger noOfBlocksInvoked = 0;
+    
+    DDLogErrorBlock  (^{ noOfBlocksInvoked++; return @"Error"; });
+    DDLogWarnBlock   (^{ noOfBlocksInvoked++; return @"Warn"; });
+    DDLogInfoBlock   (^{ noOfBlocksInvoked++; return @"Info"; });
+    DDLogDebugBlock  (^{ noOfBlocksInvoked++; return @"Debug"; });
+    DDLogVerboseBlock(^{ noOfBlocksInvoked++; return @"Verbose"; });
+    
+    expect(noOfBlocksInvoked).to.equal(2);
+    
+    [self waitForExpectationsWithTimeout:kAsyncExpectationTimeout handler:^(NSError *timeoutError) {
+        expect(timeoutError).to.beNil();
+    }];
+}
+
 - (void)testX_ddLogLevel_async {
     self.expectation = [self expectationWithDescription:@"ddLogLevel"];
     self.logs = @[ @"Error", @"Warn", @"Info" ];
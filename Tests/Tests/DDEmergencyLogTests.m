@@ -0,0 +1,163 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+@interface DDEmergencyLogTests : XCTestCase
+
+@property (nonatomic, copy) NSString *logsDirectory;
+
+@end
+
+@implementation DDEmergencyLogTests {
+    int _pipe[2];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.logsDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+
+    pipe(_pipe);
+    fcntl(_pipe[0], F_SETFL, O_NONBLOCK);
+}
+
+- (void)tearDown {
+    DDEmergencyLogUnregisterFileDescriptor(_pipe[1]);
+    close(_pipe[0]);
+    close(_pipe[1]);
+
+    [DDLog removeAllLoggers];
+    [[NSFileManager defaultManager] removeItemAtPath:self.logsDirectory error:nil];
+
+    [super tearDown];
+}
+
+- (NSString *)readPipe {
+    char bytes[4 * DD_EMERGENCY_LOG_BUFFER_SIZE];
+    ssize_t length = read(_pipe[0], bytes, sizeof(bytes));
+
+    return [[NSString alloc] initWithBytes:bytes length:(NSUInteger)MAX(length, 0) encoding:NSUTF8StringEncoding];
+}
+
+- (void)testWritesToRegisteredFileDescriptor {
+    expect(DDEmergencyLogRegisterFileDescriptor(_pipe[1])).to.beTruthy();
+
+    expect(DDEmergencyLogBegin()).to.beTruthy();
+    DDEmergencyLogAppendString("Caught signal ");
+    DDEmergencyLogAppendInteger(-11);
+    DDEmergencyLogAppendString(" at ");
+    DDEmergencyLogAppendHex(0xdeadbeef);
+    DDEmergencyLogAppendString(", count ");
+    DDEmergencyLogAppendUnsignedInteger(ULLONG_MAX);
+    DDEmergencyLogEnd();
+
+    expect([self readPipe]).to.equal(@"Caught signal -11 at 0xdeadbeef, count 18446744073709551615\n");
+}
+
+- (void)testUnregisteredFileDescriptorIsNotWritten {
+    expect(DDEmergencyLogRegisterFileDescriptor(_pipe[1])).to.beTruthy();
+    DDEmergencyLogUnregisterFileDescriptor(_pipe[1]);
+
+    expect(DDEmergencyLog("Not for the pipe")).to.beTruthy();
+
+    expect([self readPipe]).to.equal(@"");
+    expect(DDEmergencyLogRegisterFileDescriptor(-1)).to.beFalsy();
+}
+
+- (void)testOnlyOneMessageAtATime {
+    expect(DDEmergencyLogBegin()).to.beTruthy();
+    expect(DDEmergencyLogBegin()).to.beFalsy();
+    expect(DDEmergencyLog("Busy")).to.beFalsy();
+    DDEmergencyLogEnd();
+
+    expect(DDEmergencyLog("Free again")).to.beTruthy();
+}
+
+- (void)testTruncatesAtBufferSize {
+    char longMessage[2 * DD_EMERGENCY_LOG_BUFFER_SIZE];
+    memset(longMessage, 'a', sizeof(longMessage) - 1);
+    longMessage[sizeof(longMessage) - 1] = '\0';
+
+    expect(DDEmergencyLogRegisterFileDescriptor(_pipe[1])).to.beTruthy();
+
+    expect(DDEmergencyLogBegin()).to.beTruthy();
+    DDEmergencyLogAppendString(longMessage);
+    DDEmergencyLogAppendInteger(42);
+    DDEmergencyLogAppendHex(0x42);
+    DDEmergencyLogEnd();
+
+    NSString *written = [self readPipe];
+
+    // The newline always fits, whatever was appended
+    expect(written.length).to.equal(DD_EMERGENCY_LOG_BUFFER_SIZE);
+    expect([written hasSuffix:@"a\n"]).to.beTruthy();
+    expect(written).toNot.contain(@"42");
+}
+
+- (void)testFileLoggerRegistersItsCurrentLogFile {
+    DDLogFileManagerDefault *logFileManager = [[DDLogFileManagerDefault alloc] initWithLogsDirectory:self.logsDirectory];
+    DDFileLogger *fileLogger = [[DDFileLogger alloc] initWithLogFileManager:logFileManager];
+    [DDLog addLogger:fileLogger];
+
+    DDLogInfo(@"Opens the log file");
+    [DDLog flushLog];
+
+    NSString *firstFile = logFileManager.sortedLogFilePaths.firstObject;
+
+    DDEmergencyLog("Emergency while open");
+
+    expect([NSString stringWithContentsOfFile:firstFile encoding:NSUTF8StringEncoding error:nil]).to.contain(@"Emergency while open\n");
+
+    // Rolling closes the file: its descriptor must be gone before it can be reused
+    dispatch_semaphore_t rolled = dispatch_semaphore_create(0);
+    [fileLogger rollLogFileWithCompletionBlock:^{
+        dispatch_semaphore_signal(rolled);
+    }];
+    dispatch_semaphore_wait(rolled, DISPATCH_TIME_FOREVER);
+
+    DDEmergencyLog("Emergency after rolling");
+
+    expect([NSString stringWithContentsOfFile:firstFile encoding:NSUTF8StringEncoding error:nil]).toNot.contain(@"Emergency after rolling");
+
+    // The next message opens a new file, which is registered in turn
+    DDLogInfo(@"Opens a new log file");
+    [DDLog flushLog];
+
+    NSString *secondFile = logFileManager.sortedLogFilePaths.firstObject;
+
+    expect(secondFile).toNot.equal(firstFile);
+
+    DDEmergencyLog("Emergency in the second file");
+
+    expect([NSString stringWithContentsOfFile:secondFile encoding:NSUTF8StringEncoding error:nil]).to.contain(@"Emergency in the second file\n");
+
+    // Removing the logger closes the file too
+    [DDLog removeLogger:fileLogger];
+    [DDLog flushLog];
+    dispatch_sync(fileLogger.loggerQueue, ^{});
+
+    DDEmergencyLog("Emergency after removal");
+
+    expect([NSString stringWithContentsOfFile:secondFile encoding:NSUTF8StringEncoding error:nil]).toNot.contain(@"Emergency after removal");
+}
+
+@end
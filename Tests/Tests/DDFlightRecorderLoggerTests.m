@@ -0,0 +1,102 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <Expecta.h>
+#import "DDFlightRecorderLogger.h"
+
+static NSUInteger const kTestCapacity = 4096;
+
+@interface DDFlightRecorderLoggerTests : XCTestCase
+
+@property (nonatomic, copy) NSString *path;
+
+@end
+
+@implementation DDFlightRecorderLoggerTests
+
+- (void)setUp {
+    [super setUp];
+    self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:nil];
+    [super tearDown];
+}
+
+- (DDLogMessage *)messageWithText:(NSString *)text {
+    return [[DDLogMessage alloc] initWithMessage:text
+                                           level:DDLogLevelVerbose
+                                            flag:DDLogFlagInfo
+                                         context:0
+                                            file:@(__FILE__)
+                                        function:@(__func__)
+                                            line:__LINE__
+                                             tag:NULL
+                                         options:(DDLogMessageOptions)0
+                                       timestamp:nil];
+}
+
+- (void)testRecordsSurviveReopening {
+    @autoreleasepool {
+        DDFlightRecorderLogger *logger = [[DDFlightRecorderLogger alloc] initWithPath:self.path capacity:kTestCapacity];
+        expect(logger.recoveredRecords).to.haveCountOf(0);
+
+        [logger logMessage:[self messageWithText:@"first"]];
+        [logger logMessage:[self messageWithText:@"second"]];
+    }
+
+    DDFlightRecorderLogger *logger = [[DDFlightRecorderLogger alloc] initWithPath:self.path capacity:kTestCapacity];
+    NSArray *messages = [logger.recoveredRecords valueForKey:@"message"];
+
+    expect(messages).to.equal(@[ @"first", @"second" ]);
+    expect([logger.recoveredRecords.firstObject flag]).to.equal(DDLogFlagInfo);
+}
+
+- (void)testWrappingKeepsOnlyIntactRecordsInOrder {
+    @autoreleasepool {
+        DDFlightRecorderLogger *logger = [[DDFlightRecorderLogger alloc] initWithPath:self.path capacity:kTestCapacity];
+
+        for (NSUInteger i = 0; i < 1000; i++) {
+            [logger logMessage:[self messageWithText:[NSString stringWithFormat:@"message %lu", (unsigned long)i]]];
+        }
+    }
+
+    NSArray *records = [DDFlightRecorderLogger recoverRecordsAtPath:self.path];
+
+    expect(records.count).to.beGreaterThan(0);
+    expect(records.count).to.beLessThan(1000);
+    expect([records.lastObject message]).to.equal(@"message 999");
+
+    for (NSUInteger i = 1; i < records.count; i++) {
+        expect([records[i] sequence]).to.equal([records[i - 1] sequence] + 1);
+    }
+}
+
+- (void)testAppendFromCFunction {
+    DDFlightRecorderLogger *logger = [[DDFlightRecorderLogger alloc] initWithPath:self.path capacity:kTestCapacity];
+    const char *text = "Fatal signal: SIGSEGV";
+
+    expect(DDFlightRecorderAppend((DDLogFlag)0, text, strlen(text))).to.beTruthy();
+    expect([[[DDFlightRecorderLogger recoverRecordsAtPath:logger.path] lastObject] message]).to.equal(@"Fatal signal: SIGSEGV");
+}
+
+- (void)testRecoverRejectsForeignFiles {
+    [[NSMutableData dataWithLength:kTestCapacity * 2] writeToFile:self.path atomically:YES];
+    expect([DDFlightRecorderLogger recoverRecordsAtPath:self.path]).to.beNil();
+}
+
+@end
@@ -0,0 +1,129 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+#import "DDLog+CXX.h"
+
+#include <string>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+static_assert(dd::log::detail::placeholder_count("x={} y={}") == 2, "");
+static_assert(dd::log::detail::placeholder_count("{{}} {}") == 1, "");
+static_assert(dd::log::detail::placeholder_count("{x}") == -1, "");
+
+enum DDLogCXXTestsColor : unsigned { DDLogCXXTestsColorBlue = 3 };
+
+@interface DDLogCXXTestsObject : NSObject
+
+@property (nonatomic, assign) NSUInteger descriptions;
+
+@end
+
+@implementation DDLogCXXTestsObject
+
+- (NSString *)description {
+    self.descriptions++;
+    return @"Ünïcode object";
+}
+
+@end
+
+@interface DDLogCXXTests : XCTestCase
+
+@property (nonatomic, strong) DDMemoryLogger *logger;
+
+@end
+
+@implementation DDLogCXXTests
+
+- (void)setUp {
+    [super setUp];
+    [DDLog removeAllLoggers];
+
+    self.logger = [[DDMemoryLogger alloc] init];
+    [DDLog addLogger:self.logger withLevel:DDLogLevelInfo];
+    [DDLog flushLog];
+}
+
+- (void)tearDown {
+    [DDLog removeAllLoggers];
+    [DDLog flushLog];
+    [super tearDown];
+}
+
+- (void)testFormatsArgumentsOnTheLoggingQueue {
+    const char *cString = "c string";
+    const char *nullString = NULL;
+    std::string string("std::string");
+    DDLogCXXTestsObject *object = [DDLogCXXTestsObject new];
+
+    DDLogInfoCXX("{} {} {} {} {} {} {} {} {{{}}} {}", 42, -7LL, 2.5, true, 'x', cString, nullString, string, object, DDLogCXXTestsColorBlue);
+    [DDLog flushLog];
+
+    DDLogMessage *message = self.logger.logMessages.lastObject;
+
+    expect(message.message).to.equal(@"42 -7 2.5 true x c string (null) std::string {Ünïcode object} 3");
+    expect(message.flag).to.equal(DDLogFlagInfo);
+    expect(message.fileName).to.equal(@"DDLogCXXTests");
+    expect(message.function).to.contain(@"testFormatsArgumentsOnTheLoggingQueue");
+    expect(message.line).to.beGreaterThan(0);
+    expect(message.queueLabel).to.equal(@(dispatch_queue_get_label(dispatch_get_main_queue())));
+    expect(object.descriptions).to.equal(1);
+}
+
+- (void)testKeepsTheShortestRoundTripOfDoubles {
+    DDLogInfoCXX("{} {} {}", 0.1, 1.0 / 3.0, 1e300);
+    [DDLog flushLog];
+
+    expect(self.logger.logMessages.lastObject.message).to.equal(@"0.1 0.3333333333333333 1e+300");
+}
+
+- (void)testLogsSynchronousStatements {
+    DDLogErrorCXX("Synchronous");
+
+    // No flush needed
+    expect(self.logger.logMessages.lastObject.message).to.equal(@"Synchronous");
+}
+
+- (void)testSkipsStatementsNoLoggerTakes {
+    DDLogCXXTestsObject *object = [DDLogCXXTestsObject new];
+    BOOL evaluated = NO;
+
+    DDLogDebugCXX("{} {}", object, (evaluated = YES));
+    [DDLog flushLog];
+
+    expect(self.logger.logMessages).to.haveCountOf(0);
+    expect(evaluated).to.beFalsy();
+    expect(object.descriptions).to.equal(0);
+}
+
+- (void)testReleasesObjectsOfDroppedStatements {
+    __weak DDLogCXXTestsObject *weakObject = nil;
+
+    @autoreleasepool {
+        DDLogCXXTestsObject *object = [DDLogCXXTestsObject new];
+        weakObject = object;
+
+        // Without the level checks of the macros, so DDLog gets (and drops) the statement
+        LOG_MACRO_CXX(NO, ddLogLevel, DDLogFlagVerbose, 0, "{}", object);
+    }
+
+    expect(weakObject).to.beNil();
+}
+
+@end
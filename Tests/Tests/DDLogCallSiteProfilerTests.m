@@ -0,0 +1,198 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+#import <pthread.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+static void *DDLogCallSiteProfilerTestsThreadMain(void *arg) {
+    @autoreleasepool {
+        DDLogInfo(@"From a thread");
+    }
+
+    return NULL;
+}
+
+@interface DDLogCallSiteProfilerTests : XCTestCase
+@end
+
+@implementation DDLogCallSiteProfilerTests
+
+- (void)setUp {
+    [super setUp];
+    [DDLog removeAllLoggers];
+    [DDLog addLogger:[[DDMemoryLogger alloc] initWithCapacity:1]];
+    [DDLogCallSiteProfiler reset];
+    [DDLogCallSiteProfiler setEnabled:YES];
+}
+
+- (void)tearDown {
+    [DDLogCallSiteProfiler setEnabled:NO];
+    [DDLogCallSiteProfiler stopPeriodicReports];
+    [DDLogCallSiteProfiler reset];
+    [DDLog removeAllLoggers];
+    [super tearDown];
+}
+
+- (void)testCountsMessagesAndBytesPerCallSite {
+    for (NSUInteger i = 0; i < 3; i++) {
+        DDLogInfo(@"%@", @"0123456789");
+    }
+    DDLogInfo(@"%@", @"a");
+
+    NSArray<DDLogCallSiteStatistics *> *sites = [DDLogCallSiteProfiler topCallSitesSortedBy:DDLogCallSiteSortKeyMessages limit:0];
+
+    expect(sites.count).to.equal(2);
+    expect(sites[0].messageCount).to.equal(3);
+    expect(sites[0].byteCount).to.equal(30);
+    expect(sites[1].messageCount).to.equal(1);
+    expect(sites[1].byteCount).to.equal(1);
+    expect(sites[0].line).to.beLessThan(sites[1].line);
+    expect([sites[0].file lastPathComponent]).to.equal(@"DDLogCallSiteProfilerTests.m");
+    expect(sites[0].nanoseconds).to.beGreaterThan(0);
+}
+
+- (void)testCountsStatementsWithStaticStrings {
+    [DDLog log:NO
+       message:@"Static"
+         level:DDLogLevelInfo
+          flag:DDLogFlagInfo
+       context:0
+    staticFile:"/path/to/Static.swift"
+staticFunction:"staticFunction()"
+          line:42
+           tag:nil];
+
+    NSArray<DDLogCallSiteStatistics *> *sites = [DDLogCallSiteProfiler topCallSitesSortedBy:DDLogCallSiteSortKeyMessages limit:0];
+
+    expect(sites.count).to.equal(1);
+    expect(sites[0].file).to.equal(@"/path/to/Static.swift");
+    expect(sites[0].function).to.equal(@"staticFunction()");
+    expect(sites[0].line).to.equal(42);
+    expect(sites[0].messageCount).to.equal(1);
+}
+
+- (void)testCopiesNonStaticStrings {
+    char file[64];
+    char function[64];
+
+    // Two call sites whose names occupy the same memory, one after the other
+    strlcpy(file, "/path/to/First.m", sizeof(file));
+    strlcpy(function, "-[First method]", sizeof(function));
+    [DDLog log:NO message:@"First" level:DDLogLevelInfo flag:DDLogFlagInfo context:0 file:file function:function line:7 tag:nil];
+    [DDLog log:NO message:@"First" level:DDLogLevelInfo flag:DDLogFlagInfo context:0 file:file function:function line:7 tag:nil];
+
+    strlcpy(file, "/path/to/Second.m", sizeof(file));
+    strlcpy(function, "-[Second method]", sizeof(function));
+    [DDLog log:NO message:@"Second" level:DDLogLevelInfo flag:DDLogFlagInfo context:0 file:file function:function line:7 tag:nil];
+
+    memset(file, 'x', sizeof(file) - 1);
+    memset(function, 'x', sizeof(function) - 1);
+
+    NSArray<DDLogCallSiteStatistics *> *sites = [DDLogCallSiteProfiler topCallSitesSortedBy:DDLogCallSiteSortKeyMessages limit:0];
+
+    expect(sites.count).to.equal(2);
+    expect(sites[0].file).to.equal(@"/path/to/First.m");
+    expect(sites[0].function).to.equal(@"-[First method]");
+    expect(sites[0].messageCount).to.equal(2);
+    expect(sites[1].file).to.equal(@"/path/to/Second.m");
+    expect(sites[1].function).to.equal(@"-[Second method]");
+    expect(sites[1].messageCount).to.equal(1);
+}
+
+- (void)testMessageBlockReturningNil {
+    [DDLog log:NO level:DDLogLevelInfo flag:DDLogFlagInfo context:0 file:__FILE__ function:__PRETTY_FUNCTION__ line:__LINE__ tag:nil messageBlock:^NSString *{
+        [NSThread sleepForTimeInterval:0.2];
+        return nil;
+    }];
+
+    expect([DDLogCallSiteProfiler topCallSitesSortedBy:DDLogCallSiteSortKeyMessages limit:0].count).to.equal(0);
+
+    DDLogInfo(@"After");
+
+    NSArray<DDLogCallSiteStatistics *> *sites = [DDLogCallSiteProfiler topCallSitesSortedBy:DDLogCallSiteSortKeyMessages limit:0];
+
+    // The time spent in the block isn't charged to the next statement
+    expect(sites.count).to.equal(1);
+    expect(sites[0].messageCount).to.equal(1);
+    expect(sites[0].nanoseconds).to.beLessThan(200 * NSEC_PER_MSEC);
+}
+
+- (void)testSortsByBytesAndLimits {
+    DDLogInfo(@"short");
+    DDLogInfo(@"short");
+    DDLogInfo(@"a considerably longer message");
+
+    NSArray<DDLogCallSiteStatistics *> *sites = [DDLogCallSiteProfiler topCallSitesSortedBy:DDLogCallSiteSortKeyBytes limit:1];
+
+    expect(sites.count).to.equal(1);
+    expect(sites[0].messageCount).to.equal(1);
+    expect(sites[0].byteCount).to.equal(29);
+}
+
+- (void)testKeepsCountsOfExitedThreads {
+    pthread_t threads[4];
+
+    for (NSUInteger i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, DDLogCallSiteProfilerTestsThreadMain, NULL);
+    }
+
+    for (NSUInteger i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    NSArray<DDLogCallSiteStatistics *> *sites = [DDLogCallSiteProfiler topCallSitesSortedBy:DDLogCallSiteSortKeyMessages limit:0];
+
+    expect(sites.count).to.equal(1);
+    expect(sites[0].messageCount).to.equal(4);
+}
+
+- (void)testDisabledAndReset {
+    DDLogInfo(@"Counted");
+
+    [DDLogCallSiteProfiler setEnabled:NO];
+    DDLogInfo(@"Not counted");
+
+    expect([DDLogCallSiteProfiler topCallSitesSortedBy:DDLogCallSiteSortKeyMessages limit:0].count).to.equal(1);
+
+    [DDLogCallSiteProfiler reset];
+
+    expect([DDLogCallSiteProfiler topCallSitesSortedBy:DDLogCallSiteSortKeyMessages limit:0].count).to.equal(0);
+    expect([DDLogCallSiteProfiler reportSortedBy:DDLogCallSiteSortKeyTime limit:10]).to.contain(@"Log call sites: 0");
+}
+
+- (void)testPeriodicReportsUseTheLogClock {
+    DDVirtualLogClock *clock = [[DDVirtualLogClock alloc] init];
+    [DDLog setClock:clock];
+
+    __block NSString *lastReport = nil;
+
+    [DDLogCallSiteProfiler startPeriodicReportsWithInterval:60 sortedBy:DDLogCallSiteSortKeyTime limit:5 handler:^(NSString *report) {
+        lastReport = report;
+    }];
+
+    DDLogInfo(@"Reported");
+    [clock advanceBy:60];
+
+    expect(lastReport).to.contain(@"DDLogCallSiteProfilerTests.m");
+
+    [DDLogCallSiteProfiler stopPeriodicReports];
+    [DDLog setClock:nil];
+}
+
+@end
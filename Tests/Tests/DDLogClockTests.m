@@ -0,0 +1,122 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+@interface DDLogClockTests : XCTestCase
+
+@property (nonatomic, strong) DDVirtualLogClock *clock;
+
+@end
+
+@implementation DDLogClockTests
+
+- (void)setUp {
+    [super setUp];
+    self.clock = [[DDVirtualLogClock alloc] initWithDate:[NSDate dateWithTimeIntervalSince1970:1000000]];
+    [DDLog removeAllLoggers];
+    [DDLog setClock:self.clock];
+}
+
+- (void)tearDown {
+    [DDLog removeAllLoggers];
+    [DDLog setClock:nil];
+    [super tearDown];
+}
+
+- (void)testMessageTimestampsComeFromTheClock {
+    DDMemoryLogger *logger = [[DDMemoryLogger alloc] init];
+    [DDLog addLogger:logger];
+
+    DDLogInfo(@"First");
+    [self.clock advanceBy:1.5];
+    DDLogInfo(@"Second");
+
+    NSArray<DDLogMessage *> *messages = logger.logMessages;
+
+    expect(messages.count).to.equal(2);
+    expect([messages[0].timestamp timeIntervalSince1970]).to.equal(1000000);
+    expect([messages[1].timestamp timeIntervalSince1970]).to.equal(1000001.5);
+}
+
+- (void)testVirtualTimersFireInOrderWhileAdvancing {
+    dispatch_queue_t queue = dispatch_queue_create("DDLogClockTests", DISPATCH_QUEUE_SERIAL);
+    NSMutableArray *fired = [NSMutableArray array];
+
+    id <DDLogClockTimer> repeating = [self.clock scheduleTimerWithDelay:10 interval:10 queue:queue handler:^{
+        [fired addObject:@"repeating"];
+    }];
+    [self.clock scheduleTimerWithDelay:15 interval:0 queue:queue handler:^{
+        [fired addObject:@"once"];
+    }];
+
+    [self.clock advanceBy:9];
+    expect(fired).to.equal(@[]);
+
+    [self.clock advanceBy:16];
+    expect(fired).to.equal((@[ @"repeating", @"once", @"repeating" ]));
+
+    [repeating cancel];
+    [self.clock advanceBy:100];
+    expect(fired.count).to.equal(3);
+    expect(self.clock.scheduledTimerCount).to.equal(0);
+}
+
+- (void)testFileLoggerRollsOnVirtualTime {
+    DDMemoryLogFileManager *logFileManager = [[DDMemoryLogFileManager alloc] init];
+    DDFileLogger *fileLogger = [[DDFileLogger alloc] initWithLogFileManager:logFileManager];
+    fileLogger.rollingFrequency = 60 * 60 * 24;
+    fileLogger.maximumFileSize = 0;
+    [DDLog addLogger:fileLogger];
+
+    DDLogInfo(@"Day 1");
+    [DDLog flushLog];
+
+    expect(logFileManager.unsortedLogFilePaths.count).to.equal(1);
+
+    // A day passes in no time, and the rolling timer runs before advanceBy: returns
+    [self.clock advanceBy:(60 * 60 * 24)];
+
+    DDLogInfo(@"Day 2");
+    [DDLog flushLog];
+
+    expect(logFileManager.unsortedLogFilePaths.count).to.equal(2);
+
+    [DDLog removeLogger:fileLogger];
+    [logFileManager removeLogsDirectory];
+}
+
+- (void)testMemoryLoggerKeepsTheMostRecentMessages {
+    DDMemoryLogger *logger = [[DDMemoryLogger alloc] initWithCapacity:3];
+    [DDLog addLogger:logger];
+
+    for (NSUInteger i = 0; i < 5; i++) {
+        DDLogInfo(@"%lu", (unsigned long)i);
+    }
+
+    NSArray *messages = [logger.logMessages valueForKey:@"message"];
+
+    expect(messages).to.equal((@[ @"2", @"3", @"4" ]));
+    expect(logger.totalMessageCount).to.equal(5);
+
+    [logger removeAllMessages];
+    expect(logger.logMessages.count).to.equal(0);
+}
+
+@end
@@ -0,0 +1,206 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+#import <sys/socket.h>
+#import <sys/un.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+@interface DDLogCollectorTests : XCTestCase
+
+@property (nonatomic, copy) NSString *socketPath;
+@property (nonatomic, copy) NSString *spoolDirectory;
+
+@property (nonatomic, strong) DDLog *collectedLog;
+@property (nonatomic, strong) DDMemoryLogger *collectedMessages;
+@property (nonatomic, strong) DDLogCollector *collector;
+
+@property (nonatomic, strong) DDLog *clientLog;
+@property (nonatomic, strong) DDLogCollectorClient *client;
+
+@end
+
+@implementation DDLogCollectorTests
+
+- (void)setUp {
+    [super setUp];
+
+    // Socket paths are limited to about 100 bytes, too short for the temporary directory on some systems
+    self.socketPath = [NSString stringWithFormat:@"/tmp/dd-collector-%d.sock", getpid()];
+    self.spoolDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+
+    self.collectedLog = [[DDLog alloc] init];
+    self.collectedMessages = [[DDMemoryLogger alloc] init];
+    [self.collectedLog addLogger:self.collectedMessages];
+    self.collector = [[DDLogCollector alloc] initWithSocketPath:self.socketPath log:self.collectedLog];
+
+    self.clientLog = [[DDLog alloc] init];
+    self.client = [[DDLogCollectorClient alloc] initWithSocketPath:self.socketPath spoolDirectory:self.spoolDirectory];
+    self.client.reconnectInterval = 0;
+    [self.clientLog addLogger:self.client];
+}
+
+- (void)tearDown {
+    [self.clientLog removeAllLoggers];
+    [self.collectedLog removeAllLoggers];
+    [self.clientLog flushLog];
+    [self.collector stopListening];
+    [[NSFileManager defaultManager] removeItemAtPath:self.spoolDirectory error:nil];
+    [super tearDown];
+}
+
+- (void)logToClient:(NSString *)message {
+    LOG_MAYBE_TO_DDLOG(self.clientLog, NO, ddLogLevel, DDLogFlagInfo, 7, nil, __PRETTY_FUNCTION__, @"%@", message);
+}
+
+- (NSArray *)collectedTexts {
+    return [self.collectedMessages.logMessages valueForKey:@"message"];
+}
+
+- (void)testBatchRoundTrip {
+    DDLogMessage *message = [[DDLogMessage alloc] initWithMessage:@"Ünïcode message"
+                                                            level:DDLogLevelWarning
+                                                             flag:DDLogFlagWarning
+                                                          context:-3
+                                                             file:@"/path/to/File.m"
+                                                         function:@"-[Class method]"
+                                                             line:1234
+                                                              tag:@"tag"
+                                                          options:0
+                                                        timestamp:[NSDate dateWithTimeIntervalSince1970:1234567890.125]];
+
+    NSData *data = [DDLogMessageBatch dataWithMessages:@[ message, message ]];
+    NSArray<DDCollectedLogMessage *> *decoded = [DDLogMessageBatch messagesWithData:data];
+
+    expect(decoded.count).to.equal(2);
+
+    DDCollectedLogMessage *copy = decoded.firstObject;
+
+    expect(copy.message).to.equal(message.message);
+    expect(copy.level).to.equal(message.level);
+    expect(copy.flag).to.equal(message.flag);
+    expect(copy.context).to.equal(-3);
+    expect(copy.file).to.equal(message.file);
+    expect(copy.fileName).to.equal(@"File");
+    expect(copy.function).to.equal(message.function);
+    expect(copy.line).to.equal(1234);
+    expect(copy.tag).to.equal(@"tag");
+    expect(copy.timestamp).to.equal(message.timestamp);
+    expect(copy.threadID).to.equal(message.threadID);
+    expect(copy.threadName).to.equal(message.threadName);
+    expect(copy.queueLabel).to.equal(message.queueLabel);
+    expect(copy.processName).to.equal([[NSProcessInfo processInfo] processName]);
+    expect(copy.processID).to.equal(getpid());
+
+    // Truncated or trailing data is rejected
+    expect([DDLogMessageBatch messagesWithData:[data subdataWithRange:NSMakeRange(0, data.length - 1)]]).to.beNil();
+
+    NSMutableData *longer = [data mutableCopy];
+    [longer appendBytes:"x" length:1];
+    expect([DDLogMessageBatch messagesWithData:longer]).to.beNil();
+}
+
+- (void)testBatchDecodingDoesNotInternStrings {
+    NSString *file = [NSString stringWithFormat:@"/peer/%@.m", [[NSUUID UUID] UUIDString]];
+    DDLogMessage *message = [[DDLogMessage alloc] initWithMessage:@"From a peer"
+                                                            level:DDLogLevelInfo
+                                                             flag:DDLogFlagInfo
+                                                          context:0
+                                                             file:file
+                                                         function:[[NSUUID UUID] UUIDString]
+                                                             line:1
+                                                              tag:nil
+                                                          options:0
+                                                        timestamp:nil];
+
+    NSData *data = [DDLogMessageBatch dataWithMessages:@[ message ]];
+    NSUInteger count = DDLogStringTableCount();
+
+    DDCollectedLogMessage *copy = [DDLogMessageBatch messagesWithData:data].firstObject;
+
+    expect(copy.file).to.equal(file);
+    expect(copy.fileID).to.equal(0);
+    expect(copy.functionID).to.equal(0);
+    expect(copy.threadNameID).to.equal(0);
+    expect(copy.queueLabelID).to.equal(0);
+    expect(DDLogStringTableCount()).to.equal(count);
+}
+
+- (void)testClientSendsBatchesToCollector {
+    expect([self.collector startListening:NULL]).to.beTruthy();
+
+    for (NSUInteger i = 0; i < 100; i++) {
+        [self logToClient:[NSString stringWithFormat:@"message %@", @(i)]];
+    }
+
+    [self.clientLog flushLog];
+
+    expect(self.collectedMessages.logMessages.count).will.equal(100);
+    expect(self.collector.receivedMessageCount).to.equal(100);
+    expect(self.client.isConnected).to.beTruthy();
+
+    DDLogMessage *first = self.collectedMessages.logMessages.firstObject;
+
+    expect(first).to.beKindOf([DDCollectedLogMessage class]);
+    expect(first.message).to.equal(@"message 0");
+    expect(first.context).to.equal(7);
+    expect(self.collectedMessages.logMessages.lastObject.message).to.equal(@"message 99");
+}
+
+- (void)testClientSpoolsWhileCollectorIsUnavailable {
+    [self logToClient:@"one"];
+    [self logToClient:@"two"];
+    [self.clientLog flushLog];
+
+    expect(self.client.isConnected).to.beFalsy();
+    expect([[NSFileManager defaultManager] fileExistsAtPath:self.client.spoolFilePath]).to.beTruthy();
+
+    [self logToClient:@"three"];
+    [self.clientLog flushLog];
+
+    expect([self.collector startListening:NULL]).to.beTruthy();
+
+    [self logToClient:@"four"];
+    [self.clientLog flushLog];
+
+    expect([self collectedTexts]).will.equal((@[ @"one", @"two", @"three", @"four" ]));
+    expect([[NSFileManager defaultManager] fileExistsAtPath:self.client.spoolFilePath]).to.beFalsy();
+    expect(self.client.droppedMessageCount).to.equal(0);
+}
+
+- (void)testCollectorRejectsInvalidData {
+    expect([self.collector startListening:NULL]).to.beTruthy();
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strlcpy(address.sun_path, [self.socketPath fileSystemRepresentation], sizeof(address.sun_path));
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    expect(connect(fd, (struct sockaddr *)&address, sizeof(address))).to.equal(0);
+
+    const char garbage[] = "\x08\x00\x00\x00NOTABATCH";
+    write(fd, garbage, sizeof(garbage) - 1);
+
+    expect(self.collector.invalidBatchCount).will.equal(1);
+    expect(self.collector.clientCount).will.equal(0);
+
+    close(fd);
+}
+
+@end
@@ -0,0 +1,90 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+static NSString * DDLogFormatCacheTestsFormat(NSString *format, ...) {
+    va_list args;
+    va_start(args, format);
+    NSString *message = DDLogFormatString(format, args);
+    va_end(args);
+
+    return message;
+}
+
+// Formats twice (parsing, then from the cache) and compares both with Foundation
+#define DDLogFormatCacheTestsExpectFoundation(frmt, ...) do {                                   \
+    NSString *foundation = [[NSString alloc] initWithFormat:frmt, ##__VA_ARGS__];              \
+    expect(DDLogFormatCacheTestsFormat(frmt, ##__VA_ARGS__)).to.equal(foundation);             \
+    expect(DDLogFormatCacheTestsFormat(frmt, ##__VA_ARGS__)).to.equal(foundation);             \
+} while (0)
+
+@interface DDLogFormatCacheTests : XCTestCase
+@end
+
+@implementation DDLogFormatCacheTests
+
+- (void)testFormatsLikeFoundation {
+    DDLogFormatCacheTestsExpectFoundation(@"Request %lu finished in %.3f ms (%d retries)", 42UL, 12.3456, -3);
+    DDLogFormatCacheTestsExpectFoundation(@"%s:%d: user %llu uploaded %zu bytes to %s in %.2f s", "main.m", 17, 123456789ULL, (size_t)4096, "bucket", 0.5);
+    DDLogFormatCacheTestsExpectFoundation(@"100%% done %5d|%-5d|%05d|%-05d|%05d", 42, 42, 42, 42, -42);
+    DDLogFormatCacheTestsExpectFoundation(@"%hhd %hd %hhu %hu %x %X %08lx", 300, 70000, 300, 70000, 0xbeefu, 0xbeefu, 0xdeadUL);
+    DDLogFormatCacheTestsExpectFoundation(@"%jd %td %qd %i %u %lld %llu", (intmax_t)-1, (ptrdiff_t)-2, -3LL, -4, 4000000000u, (long long)INT64_MIN, (unsigned long long)UINT64_MAX);
+    DDLogFormatCacheTestsExpectFoundation(@"%c%c %10s|%-10s|%s", 'o', 'k', "right", "left", (const char *)NULL);
+    DDLogFormatCacheTestsExpectFoundation(@"%g %g %g %.0f %f %12.4f|%-12.4f|%lf", 0.1, 1e100, 123456789.0, 2.5, -0.0, 3.14159, 3.14159, 1.5);
+    DDLogFormatCacheTestsExpectFoundation(@"%p %20p|", (void *)0x1234, (void *)0xabc);
+    DDLogFormatCacheTestsExpectFoundation(@"Ünïcödé %d €", 5);
+
+    expect(DDLogFormatIsPreparsed(@"Request %lu finished in %.3f ms (%d retries)")).to.beTruthy();
+    expect(DDLogFormatIsPreparsed(@"Ünïcödé %d €")).to.beTruthy();
+}
+
+- (void)testLeavesTheRestToFoundation {
+    DDLogFormatCacheTestsExpectFoundation(@"%@ has %d items", @[ @1 ], 1);
+    DDLogFormatCacheTestsExpectFoundation(@"%2$d %1$d", 1, 2);
+    DDLogFormatCacheTestsExpectFoundation(@"%*d|%+d|%.3d|%e|%#x", 5, 1, 1, 1, 1.0, 255u);
+
+    expect(DDLogFormatIsPreparsed(@"%@ has %d items")).to.beFalsy();
+    expect(DDLogFormatIsPreparsed(@"%2$d %1$d")).to.beFalsy();
+
+    // Preparsed, but non-ASCII C strings are decoded by Foundation
+    DDLogFormatCacheTestsExpectFoundation(@"C string: %s", "\xc3\xa9t\xc3\xa9");
+    expect(DDLogFormatIsPreparsed(@"C string: %s")).to.beTruthy();
+}
+
+- (void)testCachesConstantFormatsOnly {
+    NSString *format = [NSString stringWithFormat:@"%@ %%d", @"Dynamic"];
+
+    expect(DDLogFormatCacheTestsFormat(format, 3)).to.equal(@"Dynamic 3");
+    expect(DDLogFormatIsPreparsed(format)).to.beFalsy();
+}
+
+- (void)testFormatsLogStatements {
+    DDMemoryLogger *logger = [[DDMemoryLogger alloc] init];
+    [DDLog addLogger:logger];
+
+    DDLogInfo(@"%s took %.1f ms for %lu bytes", "Upload", 12.25, 4096UL);
+    [DDLog flushLog];
+
+    expect(logger.logMessages.lastObject.message).to.equal(@"Upload took 12.2 ms for 4096 bytes");
+
+    [DDLog removeLogger:logger];
+}
+
+@end
@@ -0,0 +1,146 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+#import <sys/socket.h>
+#import <sys/un.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+@interface DDLogMetricsTests : XCTestCase
+
+@property (nonatomic, strong) DDMemoryLogger *memoryLogger;
+@property (nonatomic, copy) NSString *directory;
+
+@end
+
+@implementation DDLogMetricsTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directory withIntermediateDirectories:YES attributes:nil error:nil];
+
+    self.memoryLogger = [[DDMemoryLogger alloc] init];
+
+    [DDLog removeAllLoggers];
+    [DDLog addLogger:self.memoryLogger];
+    [DDLog flushLog];
+
+    [DDLogMetrics reset];
+    [DDLogMetrics setEnabled:YES];
+}
+
+- (void)tearDown {
+    [DDLogMetrics stopExporting];
+    [DDLogMetrics setEnabled:NO];
+    [DDLogMetrics reset];
+    [DDLog removeAllLoggers];
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+- (void)testCountsMessagesAndLoggerWrites {
+    for (NSUInteger i = 0; i < 10; i++) {
+        DDLogInfo(@"message %@", @(i));
+    }
+
+    [DDLog flushLog];
+
+    NSString *text = [DDLogMetrics prometheusText];
+
+    expect(text).to.contain(@"# TYPE dd_log_messages_enqueued_total counter\n");
+    expect(text).to.contain(@"\ndd_log_messages_enqueued_total 10\n");
+    expect(text).to.contain(@"\ndd_log_messages_dequeued_total 10\n");
+    expect(text).to.contain(@"\ndd_log_queue_depth 0\n");
+    expect(text).to.contain(@"\ndd_log_messages_dropped_total 0\n");
+    expect(text).to.contain(@"dd_log_logger_write_seconds_bucket{logger=\"cocoa.lumberjack.memoryLogger\",le=\"+Inf\"} 10\n");
+    expect(text).to.contain(@"dd_log_logger_write_seconds_count{logger=\"cocoa.lumberjack.memoryLogger\"} 10\n");
+}
+
+- (void)testDisabledMetricsDontCount {
+    [DDLogMetrics setEnabled:NO];
+
+    DDLogInfo(@"not counted");
+    [DDLog flushLog];
+
+    expect([DDLogMetrics prometheusText]).to.contain(@"\ndd_log_messages_enqueued_total 0\n");
+}
+
+- (void)testGauges {
+    DDLogMetricsSet(DDLogMetricsCounterCompressionBacklog, 3);
+    DDLogMetricsSet(DDLogMetricsCounterCompressionBacklog, 2);
+
+    expect([DDLogMetrics prometheusText]).to.contain(@"\ndd_log_compression_backlog 2\n");
+}
+
+- (void)testWritesTextFile {
+    NSString *path = [self.directory stringByAppendingPathComponent:@"lumberjack.prom"];
+    DDVirtualLogClock *clock = [[DDVirtualLogClock alloc] init];
+
+    [DDLog setClock:clock];
+    [DDLogMetrics startWritingTextFileAtPath:path interval:15];
+
+    // Written right away
+    expect([NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:nil]).will.contain(@"\ndd_log_messages_enqueued_total 0\n");
+
+    DDLogInfo(@"counted");
+    [DDLog flushLog];
+    [clock advanceBy:15];
+
+    expect([NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:nil]).will.contain(@"\ndd_log_messages_enqueued_total 1\n");
+
+    [DDLogMetrics stopExporting];
+    [DDLog setClock:nil];
+}
+
+- (void)testServesUnixSocket {
+    // Socket paths are limited to about 100 bytes, too short for the temporary directory on some systems
+    NSString *path = [NSString stringWithFormat:@"/tmp/dd-metrics-%d.sock", getpid()];
+    NSError *error = nil;
+
+    expect([DDLogMetrics startServingOnUnixSocketAtPath:path error:&error]).to.beTruthy();
+    expect(error).to.beNil();
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strlcpy(address.sun_path, [path fileSystemRepresentation], sizeof(address.sun_path));
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    expect(connect(fd, (struct sockaddr *)&address, sizeof(address))).to.equal(0);
+
+    NSMutableData *received = [NSMutableData data];
+    char buffer[4096];
+    ssize_t length;
+
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+        [received appendBytes:buffer length:(NSUInteger)length];
+    }
+
+    close(fd);
+
+    NSString *text = [[NSString alloc] initWithData:received encoding:NSUTF8StringEncoding];
+    expect(text).to.contain(@"# TYPE dd_log_logger_write_seconds histogram\n");
+
+    [DDLogMetrics stopExporting];
+
+    expect([[NSFileManager defaultManager] fileExistsAtPath:path]).will.beFalsy();
+}
+
+@end
@@ -0,0 +1,136 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+
+static uint64_t DDLogNumberFormattingTestsState = 88172645463325252ULL;
+
+// xorshift64, so every run checks the same numbers
+static uint64_t DDLogNumberFormattingTestsRandom(void) {
+    uint64_t x = DDLogNumberFormattingTestsState;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return (DDLogNumberFormattingTestsState = x);
+}
+
+static NSString * DDLogNumberFormattingTestsString(const char *buffer, size_t length) {
+    return [[NSString alloc] initWithBytes:buffer length:length encoding:NSASCIIStringEncoding];
+}
+
+@interface DDLogNumberFormattingTests : XCTestCase
+@end
+
+@implementation DDLogNumberFormattingTests
+
+- (void)testFormatsIntegersLikePrintf {
+    int64_t values[] = { 0, 1, -1, 9, 10, 99, 100, -100, 12345, INT32_MAX, INT32_MIN, INT64_MAX, INT64_MIN };
+    char buffer[DD_LOG_INTEGER_MAX_LENGTH];
+    char expected[32];
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        snprintf(expected, sizeof(expected), "%lld", (long long)values[i]);
+        expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatInteger(buffer, values[i]))).to.equal(@(expected));
+    }
+
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatUnsignedInteger(buffer, UINT64_MAX))).to.equal(@"18446744073709551615");
+
+    for (NSUInteger i = 0; i < 10000; i++) {
+        uint64_t value = DDLogNumberFormattingTestsRandom() >> (DDLogNumberFormattingTestsRandom() % 64);
+
+        snprintf(expected, sizeof(expected), "%llu", (unsigned long long)value);
+        expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatUnsignedInteger(buffer, value))).to.equal(@(expected));
+
+        snprintf(expected, sizeof(expected), "%lld", -(long long)(value >> 1));
+        expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatInteger(buffer, -(int64_t)(value >> 1)))).to.equal(@(expected));
+    }
+}
+
+- (void)testPadsIntegersToWidth {
+    char buffer[DD_LOG_INTEGER_MAX_LENGTH];
+
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatUnsignedIntegerWithWidth(buffer, 7, 3))).to.equal(@"007");
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatUnsignedIntegerWithWidth(buffer, 2016, 4))).to.equal(@"2016");
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatUnsignedIntegerWithWidth(buffer, 12345, 2))).to.equal(@"12345");
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatUnsignedIntegerWithWidth(buffer, 0, 0))).to.equal(@"0");
+}
+
+- (void)testFormatsShortestRoundTripOfDoubles {
+    char buffer[DD_LOG_DOUBLE_MAX_LENGTH];
+
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatDouble(buffer, 0.1))).to.equal(@"0.1");
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatDouble(buffer, -0.0))).to.equal(@"-0");
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatDouble(buffer, 1.0 / 3.0))).to.equal(@"0.3333333333333333");
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatDouble(buffer, 1e17))).to.equal(@"1e+17");
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatDouble(buffer, 123456789.0))).to.equal(@"123456789");
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatDouble(buffer, 5e-324))).to.equal(@"5e-324");
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatDouble(buffer, DBL_MAX))).to.equal(@"1.7976931348623157e+308");
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatDouble(buffer, -INFINITY))).to.equal(@"-inf");
+    expect(DDLogNumberFormattingTestsString(buffer, DDLogFormatDouble(buffer, NAN))).to.equal(@"nan");
+
+    for (NSUInteger i = 0; i < 10000; i++) {
+        uint64_t bits = DDLogNumberFormattingTestsRandom();
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+
+        if (!isfinite(value)) {
+            continue;
+        }
+
+        size_t length = DDLogFormatDouble(buffer, value);
+        buffer[MIN(length, sizeof(buffer) - 1)] = '\0';
+
+        expect(length).to.beLessThan(DD_LOG_DOUBLE_MAX_LENGTH);
+        expect(strtod(buffer, NULL)).to.equal(value);
+    }
+}
+
+- (void)testFormatsDoublesLikePrintf {
+    double values[] = { 0, -0.0, 1, 0.5, 2.675, 0.1, 1e-5, 123456.789, 1e21, 5e-324, DBL_MAX, 4503599627370495.5, INFINITY, NAN };
+    int precisions[] = { -1, 0, 1, 2, 3, 6, 10, 15, 17, 20 };
+    char buffer[512];
+    char expected[512];
+
+    for (NSUInteger i = 0; i < sizeof(values) / sizeof(values[0]) + 2000; i++) {
+        double value;
+
+        if (i < sizeof(values) / sizeof(values[0])) {
+            value = values[i];
+        } else {
+            value = (double)(int64_t)(DDLogNumberFormattingTestsRandom() % 2000000) / 1000.0 - 1000.0;
+        }
+
+        for (size_t j = 0; j < sizeof(precisions) / sizeof(precisions[0]); j++) {
+            int length = DDLogFormatDoubleFixed(buffer, sizeof(buffer), value, precisions[j]);
+            int expectedLength = snprintf(expected, sizeof(expected), "%.*f", precisions[j], value);
+            expect(@(buffer)).to.equal(@(expected));
+            expect(length).to.equal(expectedLength);
+
+            length = DDLogFormatDoubleGeneral(buffer, sizeof(buffer), value, precisions[j]);
+            expectedLength = snprintf(expected, sizeof(expected), "%.*g", precisions[j], value);
+            expect(@(buffer)).to.equal(@(expected));
+            expect(length).to.equal(expectedLength);
+        }
+    }
+
+    // Truncated like snprintf
+    int length = DDLogFormatDoubleFixed(buffer, 4, 3.5, 6);
+    expect(@(buffer)).to.equal(@"3.5");
+    expect(length).to.equal(8);
+}
+
+@end
@@ -0,0 +1,113 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+@interface DDLogStringTableTests : XCTestCase
+@end
+
+@implementation DDLogStringTableTests
+
+- (void)tearDown {
+    [DDLog removeAllLoggers];
+    [super tearDown];
+}
+
+- (void)testInternsEqualStringsOnce {
+    const char *label = "com.example.queue.intern";
+    char copy[64];
+    strlcpy(copy, label, sizeof(copy));
+
+    DDLogStringID identifier = DDLogStringTableIntern(label, strlen(label));
+
+    expect(identifier).to.beGreaterThan(0);
+    expect(DDLogStringTableIntern(copy, strlen(copy))).to.equal(identifier);
+    expect(DDLogStringTableInternStatic(label)).to.equal(identifier);
+    expect(DDLogStringTableInternString(@"com.example.queue.intern")).to.equal(identifier);
+    expect(DDLogStringTableIntern(label, 3)).notTo.equal(identifier);
+
+    expect(DDLogStringTableString(identifier)).to.equal(@"com.example.queue.intern");
+    expect(DDLogStringTableString(identifier) == DDLogStringTableString(identifier)).to.beTruthy();
+
+    size_t length = 0;
+    expect(strcmp(DDLogStringTableUTF8(identifier, &length), label)).to.equal(0);
+    expect(length).to.equal(strlen(label));
+
+    expect(DDLogStringTableString(0)).to.beNil();
+    expect(DDLogStringTableUTF8(0, NULL) == NULL).to.beTruthy();
+    expect(DDLogStringTableIntern(NULL, 0)).to.equal(0);
+    expect(DDLogStringTableIntern("\xff", 1)).to.equal(0);
+}
+
+- (void)testInternsConcurrently {
+    NSUInteger countBefore = DDLogStringTableCount();
+    NSUInteger const strings = 500;
+    DDLogStringID *identifiers = calloc(8 * strings, sizeof(DDLogStringID));
+
+    dispatch_apply(8, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+        for (NSUInteger i = 0; i < strings; i++) {
+            NSUInteger index = (i * 7 + thread * 13) % strings;
+            NSString *string = [NSString stringWithFormat:@"DDLogStringTableTests %lu ünïcödé", (unsigned long)index];
+            identifiers[thread * strings + index] = DDLogStringTableInternString(string);
+        }
+    });
+
+    for (NSUInteger i = 0; i < strings; i++) {
+        NSString *string = [NSString stringWithFormat:@"DDLogStringTableTests %lu ünïcödé", (unsigned long)i];
+
+        expect(identifiers[i]).to.beGreaterThan(0);
+        expect(DDLogStringTableString(identifiers[i])).to.equal(string);
+
+        for (NSUInteger thread = 1; thread < 8; thread++) {
+            expect(identifiers[thread * strings + i]).to.equal(identifiers[i]);
+        }
+    }
+
+    expect(DDLogStringTableCount() - countBefore).to.beGreaterThanOrEqualTo(strings);
+
+    free(identifiers);
+}
+
+- (void)testMessagesShareInternedStrings {
+    DDMemoryLogger *logger = [[DDMemoryLogger alloc] init];
+    [DDLog addLogger:logger];
+
+    for (NSUInteger i = 0; i < 2; i++) {
+        DDLogInfo(@"Message %lu", (unsigned long)i);
+    }
+    [DDLog flushLog];
+
+    DDLogMessage *first = logger.logMessages[0];
+    DDLogMessage *second = logger.logMessages[1];
+
+    expect(first.fileID).to.beGreaterThan(0);
+    expect(first.fileID).to.equal(second.fileID);
+    expect(first.functionID).to.equal(second.functionID);
+    expect(first.queueLabelID).to.equal(second.queueLabelID);
+    expect(first.file == second.file).to.beTruthy();
+    expect(first.queueLabel == second.queueLabel).to.beTruthy();
+
+    expect(first.file).to.equal(@(__FILE__));
+    expect(first.fileName).to.equal(@"DDLogStringTableTests");
+    expect(first.function).to.equal(@(__PRETTY_FUNCTION__));
+    expect(first.queueLabel).to.equal(@"com.apple.main-thread");
+    expect(DDLogStringTableString(first.queueLabelID)).to.equal(first.queueLabel);
+}
+
+@end
@@ -0,0 +1,87 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+import XCTest
+import CocoaLumberjack
+
+class DDLogSwiftTests: XCTestCase {
+    var ddlog: DDLog!
+    var logger: DDMemoryLogger!
+
+    override func setUp() {
+        super.setUp()
+        ddlog = DDLog()
+        logger = DDMemoryLogger()
+        ddlog.add(logger, with: .info)
+    }
+
+    override func tearDown() {
+        ddlog.removeAllLoggers()
+        redactPrivateLogValues = true
+        super.tearDown()
+    }
+
+    var lastMessage: String? {
+        return logger.logMessages.last?.message
+    }
+
+    func testRendersDeferredMessage() {
+        let user = "Jane"
+        let items = 3
+        let amount = 129.95
+        let paid = true
+
+        DDLogInfo(deferred: "\(user) bought \(items) items for \(amount), paid: \(paid)", asynchronous: false, ddlog: ddlog)
+
+        XCTAssertEqual(lastMessage, "Jane bought 3 items for 129.95, paid: true")
+        XCTAssertEqual(logger.logMessages.last?.fileName, "DDLogSwiftTests")
+    }
+
+    func testRedactsPrivateValuesByDefault() {
+        let email = "jane@example.com"
+
+        DDLogInfo(deferred: "Signed in as \(DDPrivate(email))", asynchronous: false, ddlog: ddlog)
+        DDLogInfo(deferred: "Signed in as \(DDPrivate(email, placeholder: "<email>"))", asynchronous: false, ddlog: ddlog)
+
+        XCTAssertEqual(logger.logMessages.map { $0.message }, ["Signed in as <private>", "Signed in as <email>"])
+
+        redactPrivateLogValues = false
+        DDLogInfo(deferred: "Signed in as \(DDPrivate(email))", asynchronous: false, ddlog: ddlog)
+
+        XCTAssertEqual(lastMessage, "Signed in as jane@example.com")
+    }
+
+    func testDoesNotRenderFilteredMessages() {
+        var renderCount = 0
+
+        func rendered(_ message: String) -> String {
+            renderCount += 1
+            return message
+        }
+
+        // Not accepted by the logger
+        DDLogDebug(deferred: rendered("Filtered"), asynchronous: false, ddlog: ddlog)
+        // Not accepted by the level
+        DDLogInfo(deferred: rendered("Filtered"), level: .warning, asynchronous: false, ddlog: ddlog)
+
+        XCTAssertEqual(renderCount, 0)
+        XCTAssertEqual(logger.logMessages.count, 0)
+
+        DDLogInfo(deferred: rendered("Logged"), asynchronous: false, ddlog: ddlog)
+
+        XCTAssertEqual(renderCount, 1)
+        XCTAssertEqual(lastMessage, "Logged")
+    }
+}
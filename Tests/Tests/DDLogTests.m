@@ -19,6 +19,8 @@
 @import XCTest;
 #import <Expecta.h>
 #import "DDLog.h"
+#import "DDLogScope.h"
+#import "DDMemoryLogger.h"
 
 @interface DDTestLogger : NSObject <DDLogger>
 @end
@@ -92,4 +94,106 @@
     expect([[DDLog allLoggersWithLevel][2] level]).to.equal(DDLogLevelInfo);
 }
 
+
+#pragma mark - Scoped levels
+
+- (void)testScopeLevelOnlyAppliesInsideTheScope {
+    expect(DDLogScopeCurrentLevel()).to.equal(DDLogLevelOff);
+    
+    [DDLogScope performWithLevel:DDLogLevelVerbose context:42 block:^{
+        expect(DDLogScopeCurrentLevel()).to.equal(DDLogLevelVerbose);
+        expect(DDLogScopeCurrentContext()).to.equal(42);
+        
+        [DDLogScope performWithLevel:DDLogLevelInfo block:^{
+            expect(DDLogScopeCurrentLevel()).to.equal(DDLogLevelInfo);
+            expect(DDLogScopeCurrentContext()).to.equal(42);
+        }];
+        
+        expect(DDLogScopeCurrentLevel()).to.equal(DDLogLevelVerbose);
+    }];
+    
+    expect(DDLogScopeCurrentLevel()).to.equal(DDLogLevelOff);
+    expect(DDLogScopeCurrentContext()).to.equal(0);
+}
+
+- (void)testScopeIsPropagatedIntoWrappedBlocks {
+    dispatch_queue_t queue = dispatch_queue_create("DDLogTests.scope", NULL);
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block DDLogLevel levelOnQueue = DDLogLevelOff;
+    __block DDLogLevel levelOnQueueUnwrapped = DDLogLevelAll;
+    
+    // dispatch_async, as dispatch_sync may run the block on the calling thread
+    [DDLogScope performWithLevel:DDLogLevelDebug block:^{
+        DDLogScopeDispatchAsync(queue, ^{
+            levelOnQueue = DDLogScopeCurrentLevel();
+        });
+        dispatch_async(queue, ^{
+            levelOnQueueUnwrapped = DDLogScopeCurrentLevel();
+            dispatch_semaphore_signal(semaphore);
+        });
+    }];
+    
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    
+    expect(levelOnQueue).to.equal(DDLogLevelDebug);
+    expect(levelOnQueueUnwrapped).to.equal(DDLogLevelOff);
+}
+
+
+
+#pragma mark - Deferred messages
+
+- (void)testMessageRendererRunsOnTheLoggingQueue {
+    DDMemoryLogger *logger = [[DDMemoryLogger alloc] init];
+    [DDLog addLogger:logger withLevel:DDLogLevelInfo];
+
+    const char *loggingQueueLabel = dispatch_queue_get_label([DDLog loggingQueue]);
+    __block BOOL renderedOnLoggingQueue = NO;
+    __block NSUInteger renderCount = 0;
+
+    DDLogMessageBlock renderer = ^{
+        renderedOnLoggingQueue = strcmp(dispatch_queue_get_label(DISPATCH_CURRENT_QUEUE_LABEL), loggingQueueLabel) == 0;
+        renderCount++;
+        return @"Rendered";
+    };
+
+    [DDLog log:NO level:DDLogLevelAll flag:DDLogFlagInfo context:0 staticFile:__FILE__ staticFunction:__PRETTY_FUNCTION__ line:__LINE__ tag:nil messageRenderer:renderer];
+
+    // Not accepted by any logger: not even queued
+    [DDLog log:NO level:DDLogLevelAll flag:DDLogFlagDebug context:0 staticFile:__FILE__ staticFunction:__PRETTY_FUNCTION__ line:__LINE__ tag:nil messageRenderer:renderer];
+
+    [DDLog flushLog];
+
+    expect(renderCount).to.equal(1);
+    expect(renderedOnLoggingQueue).to.beTruthy();
+    expect(logger.logMessages).haveACountOf(1);
+    expect(logger.logMessages.firstObject.message).to.equal(@"Rendered");
+    expect(logger.logMessages.firstObject.fileName).to.equal(@"DDLogTests");
+}
+
+
+#pragma mark - Static call site strings
+
+- (void)testMessageFromStaticStrings {
+    DDMemoryLogger *logger = [[DDMemoryLogger alloc] init];
+    [DDLog addLogger:logger];
+
+    [DDLog log:NO
+       message:@"Static"
+         level:DDLogLevelInfo
+          flag:DDLogFlagInfo
+       context:0
+    staticFile:"/path/to/Static.swift"
+staticFunction:"staticFunction()"
+          line:42
+           tag:nil];
+
+    DDLogMessage *message = logger.logMessages.lastObject;
+
+    expect(message.file).to.equal(@"/path/to/Static.swift");
+    expect(message.fileName).to.equal(@"Static");
+    expect(message.function).to.equal(@"staticFunction()");
+    expect(message.line).to.equal(42);
+}
+
 @end
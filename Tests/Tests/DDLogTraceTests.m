@@ -0,0 +1,186 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+// Part of the "OS X Trace Tests" target only, which compiles the library with DD_LOG_TRACE_ENABLED=1
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+/**
+ * A logger with a name of its own, which optionally marks the formatted stage.
+ **/
+@interface DDLogTraceTestsLogger : DDAbstractLogger <DDLogger>
+
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic) BOOL marksFormatted;
+
+@end
+
+@implementation DDLogTraceTestsLogger
+
+- (void)logMessage:(DDLogMessage *)logMessage {
+    if (_marksFormatted) {
+        DDLogTraceMark(DDLogTraceStageFormatted);
+    }
+}
+
+- (NSString *)loggerName {
+    return _name;
+}
+
+@end
+
+@interface DDLogTraceTests : XCTestCase
+@end
+
+@implementation DDLogTraceTests
+
+- (void)setUp {
+    [super setUp];
+    [DDLog removeAllLoggers];
+    [DDLogTrace reset];
+}
+
+- (void)tearDown {
+    [DDLog removeAllLoggers];
+    [DDLogTrace reset];
+    [super tearDown];
+}
+
+- (DDLogTraceTestsLogger *)addLoggerNamed:(NSString *)name marksFormatted:(BOOL)marksFormatted {
+    DDLogTraceTestsLogger *logger = [[DDLogTraceTestsLogger alloc] init];
+    logger.name = name;
+    logger.marksFormatted = marksFormatted;
+
+    [DDLog addLogger:logger];
+
+    return logger;
+}
+
+- (NSArray<NSDictionary *> *)chromeTraceEvents {
+    NSDictionary *trace = [NSJSONSerialization JSONObjectWithData:[DDLogTrace chromeTraceData] options:0 error:nil];
+
+    return trace[@"traceEvents"];
+}
+
+- (NSDictionary *)eventNamed:(NSString *)name phase:(NSString *)phase tid:(NSNumber *)tid inEvents:(NSArray<NSDictionary *> *)events {
+    for (NSDictionary *event in events) {
+        if ([event[@"name"] isEqual:name] && [event[@"ph"] isEqual:phase] && (tid == nil || [event[@"tid"] isEqual:tid])) {
+            return event;
+        }
+    }
+
+    return nil;
+}
+
+- (void)testIsEnabled {
+    expect([DDLogTrace isEnabled]).to.beTruthy();
+}
+
+- (void)testStagesOfOneMessageAreInOrder {
+    [self addLoggerNamed:@"marking" marksFormatted:YES];
+
+    DDLogInfo(@"Traced");
+    [DDLog flushLog];
+
+    NSArray<DDLogTraceStatistics *> *statistics = [DDLogTrace statistics];
+
+    expect(statistics.count).to.equal(1);
+    expect(statistics[0].messageCount).to.equal(1);
+
+    for (DDLogTraceStage stage = DDLogTraceStageEnqueued; stage < DDLogTraceStageCount; stage++) {
+        expect([statistics[0] histogramForStage:stage].count).to.equal(1);
+    }
+
+    // The queue waits, then the work of the logger, one after the other
+    NSArray<NSDictionary *> *events = [self chromeTraceEvents];
+    NSDictionary *slotBegin = [self eventNamed:@"wait for queue slot" phase:@"b" tid:@0 inEvents:events];
+    NSDictionary *slotEnd = [self eventNamed:@"wait for queue slot" phase:@"e" tid:@0 inEvents:events];
+    NSDictionary *queuedBegin = [self eventNamed:@"queued" phase:@"b" tid:@0 inEvents:events];
+    NSDictionary *queuedEnd = [self eventNamed:@"queued" phase:@"e" tid:@0 inEvents:events];
+    NSDictionary *format = [self eventNamed:@"format" phase:@"X" tid:@1 inEvents:events];
+    NSDictionary *write = [self eventNamed:@"write" phase:@"X" tid:@1 inEvents:events];
+
+    expect(slotBegin).toNot.beNil();
+    expect(slotEnd).toNot.beNil();
+    expect(queuedBegin).toNot.beNil();
+    expect(queuedEnd).toNot.beNil();
+    expect(format).toNot.beNil();
+    expect(write).toNot.beNil();
+
+    // Microseconds as doubles: allow for rounding where an end is computed as start + duration
+    double epsilon = 0.001;
+    double created = [slotBegin[@"ts"] doubleValue];
+    double enqueued = [slotEnd[@"ts"] doubleValue];
+    double dequeued = [queuedEnd[@"ts"] doubleValue];
+    double handed = [format[@"ts"] doubleValue];
+    double formatted = handed + [format[@"dur"] doubleValue];
+    double written = [write[@"ts"] doubleValue] + [write[@"dur"] doubleValue];
+
+    expect(created).to.equal(0);
+    expect([queuedBegin[@"ts"] doubleValue]).to.equal(enqueued);
+    expect(enqueued).to.beGreaterThanOrEqualTo(created);
+    expect(dequeued).to.beGreaterThanOrEqualTo(enqueued);
+    expect(handed).to.beGreaterThanOrEqualTo(dequeued);
+    expect(formatted).to.beGreaterThanOrEqualTo(handed);
+    expect([write[@"ts"] doubleValue]).to.beCloseToWithin(formatted, epsilon);
+    expect(written).to.beGreaterThanOrEqualTo(formatted - epsilon);
+    expect([format[@"args"][@"sequence"] isEqual:write[@"args"][@"sequence"]]).to.beTruthy();
+}
+
+- (void)testRecordsEachLogger {
+    [self addLoggerNamed:@"first" marksFormatted:YES];
+    [self addLoggerNamed:@"second" marksFormatted:NO];
+
+    DDLogInfo(@"One");
+    DDLogInfo(@"Two");
+    [DDLog flushLog];
+
+    NSArray<DDLogTraceStatistics *> *statistics = [DDLogTrace statistics];
+    NSArray *names = [statistics valueForKey:@"loggerName"];
+
+    expect(statistics.count).to.equal(2);
+    expect([NSSet setWithArray:names]).to.equal([NSSet setWithArray:@[ @"first", @"second" ]]);
+
+    for (DDLogTraceStatistics *loggerStatistics in statistics) {
+        BOOL marks = [loggerStatistics.loggerName isEqualToString:@"first"];
+
+        // A begin and an end per message: handed and written are recorded by DDLog, formatted only by a logger that marks it
+        expect(loggerStatistics.messageCount).to.equal(2);
+        expect([loggerStatistics histogramForStage:DDLogTraceStageHanded].count).to.equal(2);
+        expect([loggerStatistics histogramForStage:DDLogTraceStageWritten].count).to.equal(2);
+        expect([loggerStatistics histogramForStage:DDLogTraceStageFormatted].count).to.equal(marks ? 2 : 0);
+        expect(loggerStatistics.totalHistogram.count).to.equal(2);
+    }
+
+    // A track per logger, with a write per message
+    NSArray<NSDictionary *> *events = [self chromeTraceEvents];
+
+    for (NSUInteger i = 0; i < 2; i++) {
+        NSNumber *tid = @(i + 1);
+        NSDictionary *track = [self eventNamed:@"thread_name" phase:@"M" tid:tid inEvents:events];
+
+        expect(track[@"args"][@"name"]).to.equal(names[i]);
+        expect([events filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"name == 'write' AND tid == %@", tid]].count).to.equal(2);
+    }
+
+    // The queue waits are shared by the loggers: once per message
+    expect([events filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"name == 'queued' AND ph == 'b'"]].count).to.equal(2);
+}
+
+@end
@@ -0,0 +1,151 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+/**
+ * Blocks in logMessage: on messages starting with "block", until released (or for `stallDuration`).
+ **/
+@interface DDStallingLogger : DDAbstractLogger <DDLogger>
+
+@property (nonatomic, strong) dispatch_semaphore_t releaseSemaphore;
+@property (nonatomic, assign) NSTimeInterval stallDuration;
+@property (atomic, strong) NSMutableArray *messages;
+
+@end
+
+@implementation DDStallingLogger
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        _releaseSemaphore = dispatch_semaphore_create(0);
+        _messages = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)logMessage:(DDLogMessage *)logMessage {
+    if ([logMessage->_message hasPrefix:@"block"]) {
+        if (self.stallDuration > 0) {
+            [NSThread sleepForTimeInterval:self.stallDuration];
+        } else {
+            dispatch_semaphore_wait(self.releaseSemaphore, DISPATCH_TIME_FOREVER);
+        }
+    }
+
+    @synchronized(self) {
+        [self.messages addObject:logMessage->_message];
+    }
+}
+
+@end
+
+
+@interface DDLogWatchdogTests : XCTestCase
+
+@property (nonatomic, strong) DDLogWatchdog *watchdog;
+@property (nonatomic, strong) DDStallingLogger *stallingLogger;
+@property (nonatomic, strong) DDMemoryLogger *memoryLogger;
+
+@end
+
+@implementation DDLogWatchdogTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.watchdog = [[DDLogWatchdog alloc] init];
+    self.watchdog.stallThreshold = 0.05;
+
+    self.stallingLogger = [[DDStallingLogger alloc] init];
+    self.memoryLogger = [[DDMemoryLogger alloc] init];
+
+    [DDLog removeAllLoggers];
+    [DDLog addLogger:self.stallingLogger];
+    [DDLog addLogger:self.memoryLogger];
+}
+
+- (void)tearDown {
+    dispatch_semaphore_signal(self.stallingLogger.releaseSemaphore);
+    [DDLog setWatchdog:nil];
+    [DDLog removeAllLoggers];
+    [DDLog flushLog];
+    [super tearDown];
+}
+
+- (void)testQuarantinesAndReattachesStalledLogger {
+    __block NSTimeInterval stallDuration = 0;
+    __block NSUInteger droppedMessages = NSNotFound;
+
+    self.watchdog.quarantinesStalledLoggers = YES;
+    self.watchdog.stallHandler = ^(id <DDLogger> logger, NSTimeInterval duration) {
+        stallDuration = duration;
+    };
+    self.watchdog.recoveryHandler = ^(id <DDLogger> logger, NSUInteger dropped) {
+        droppedMessages = dropped;
+    };
+    [DDLog setWatchdog:self.watchdog];
+
+    DDLogInfo(@"block");
+    DDLogInfo(@"after 1");
+    DDLogInfo(@"after 2");
+    DDLogInfo(@"after 3");
+
+    // Doesn't hang: the stalled logger is left behind
+    [DDLog flushLog];
+
+    expect(self.memoryLogger.logMessages.count).to.equal(4);
+    expect(self.watchdog.stallCount).to.equal(1);
+    expect(self.watchdog.quarantinedLoggers).to.equal(@[ self.stallingLogger ]);
+    expect(stallDuration).will.beGreaterThanOrEqualTo(0.05);
+
+    dispatch_semaphore_signal(self.stallingLogger.releaseSemaphore);
+    expect(self.stallingLogger.messages).will.equal(@[ @"block" ]);
+
+    DDLogInfo(@"recovered");
+    [DDLog flushLog];
+
+    expect(self.stallingLogger.messages).to.equal((@[ @"block", @"recovered" ]));
+    expect(self.watchdog.droppedMessageCount).to.equal(3);
+    expect(self.watchdog.quarantinedLoggers.count).to.equal(0);
+    expect(droppedMessages).will.equal(3);
+}
+
+- (void)testReportsWithoutQuarantine {
+    __block NSUInteger stalls = 0;
+
+    self.stallingLogger.stallDuration = 0.2;
+    self.watchdog.stallHandler = ^(id <DDLogger> logger, NSTimeInterval duration) {
+        stalls++;
+    };
+    [DDLog setWatchdog:self.watchdog];
+
+    DDLogInfo(@"block");
+    DDLogInfo(@"after");
+    [DDLog flushLog];
+
+    // Every logger got every message, in order
+    expect(self.stallingLogger.messages).to.equal((@[ @"block", @"after" ]));
+    expect(self.memoryLogger.logMessages.count).to.equal(2);
+    expect(self.watchdog.stallCount).to.equal(1);
+    expect(self.watchdog.quarantinedLoggers.count).to.equal(0);
+    expect(stalls).will.equal(1);
+}
+
+@end
@@ -0,0 +1,140 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+#import <objc/runtime.h>
+
+@interface DDLog (RegisteredDynamicLoggingTests)
+
+// The scan every call of registeredClasses used to make
++ (NSArray *)registeredClassesByScanningAllClasses;
+
+@end
+
+static DDLogLevel ddRegisteredLogLevel = DDLogLevelWarning;
+
+@interface DDRegisteredDynamicLoggingTestsClass : NSObject <DDRegisteredDynamicLogging>
+@end
+
+@implementation DDRegisteredDynamicLoggingTestsClass
+
++ (DDLogLevel)ddLogLevel {
+    return ddRegisteredLogLevel;
+}
+
++ (void)ddSetLogLevel:(DDLogLevel)level {
+    ddRegisteredLogLevel = level;
+}
+
+@end
+
+@interface DDRegisteredDynamicLoggingTests : XCTestCase
+@end
+
+@implementation DDRegisteredDynamicLoggingTests
+
+- (void)tearDown {
+    ddRegisteredLogLevel = DDLogLevelWarning;
+    [super tearDown];
+}
+
+- (void)expectRegistryToMatchFullScan {
+    NSArray *scanned = [DDLog registeredClassesByScanningAllClasses];
+    NSMutableSet *scannedNames = [NSMutableSet set];
+
+    for (Class class in scanned) {
+        [scannedNames addObject:NSStringFromClass(class)];
+    }
+
+    expect([NSSet setWithArray:[DDLog registeredClasses]]).to.equal([NSSet setWithArray:scanned]);
+    expect([NSSet setWithArray:[DDLog registeredClassNames]]).to.equal(scannedNames);
+}
+
+- (void)testRegisteredClassesMatchFullScan {
+    [self expectRegistryToMatchFullScan];
+
+    expect([DDLog registeredClasses]).to.contain([DDRegisteredDynamicLoggingTestsClass class]);
+    expect([DDLog registeredClassNames]).to.contain(@"DDRegisteredDynamicLoggingTestsClass");
+    expect([DDLog registeredClassNames]).toNot.contain(@"DDRegisteredDynamicLoggingTests");
+}
+
+- (void)testLevelsByClassName {
+    expect([DDLog levelForClassWithName:@"DDRegisteredDynamicLoggingTestsClass"]).to.equal(DDLogLevelWarning);
+
+    [DDLog setLevel:DDLogLevelVerbose forClassWithName:@"DDRegisteredDynamicLoggingTestsClass"];
+
+    expect(ddRegisteredLogLevel).to.equal(DDLogLevelVerbose);
+    expect([DDLog levelForClass:[DDRegisteredDynamicLoggingTestsClass class]]).to.equal(DDLogLevelVerbose);
+    expect([DDLog levelForClassWithName:@"DDRegisteredDynamicLoggingTests"]).to.equal((DDLogLevel)-1);
+    expect([DDLog levelForClassWithName:@"NoSuchClass"]).to.equal((DDLogLevel)-1);
+}
+
+- (NSString *)uniqueClassNameWithPrefix:(NSString *)prefix {
+    return [prefix stringByAppendingString:[[[NSUUID UUID] UUIDString] stringByReplacingOccurrencesOfString:@"-" withString:@""]];
+}
+
+- (void)testPicksUpClassesCreatedLater {
+    // Builds the registry first, so the new class has to be added to it
+    [self expectRegistryToMatchFullScan];
+
+    NSString *name = [self uniqueClassNameWithPrefix:@"DDRuntimeLoggingClass_"];
+    Class class = objc_allocateClassPair([NSObject class], name.UTF8String, 0);
+    Class metaClass = object_getClass(class);
+
+    __block DDLogLevel level = DDLogLevelError;
+
+    class_addMethod(metaClass, @selector(ddLogLevel), imp_implementationWithBlock(^DDLogLevel(id self) {
+        return level;
+    }), [[NSString stringWithFormat:@"%s@:", @encode(DDLogLevel)] UTF8String]);
+
+    class_addMethod(metaClass, @selector(ddSetLogLevel:), imp_implementationWithBlock(^(id self, DDLogLevel newLevel) {
+        level = newLevel;
+    }), [[NSString stringWithFormat:@"v@:%s", @encode(DDLogLevel)] UTF8String]);
+
+    objc_registerClassPair(class);
+
+    // Never disposed of: the registry may hold on to it for the rest of the run
+
+    expect([DDLog registeredClassNames]).to.contain(name);
+    expect([DDLog registeredClasses]).to.contain(class);
+    [self expectRegistryToMatchFullScan];
+
+    expect([DDLog levelForClassWithName:name]).to.equal(DDLogLevelError);
+
+    [DDLog setLevel:DDLogLevelInfo forClassWithName:name];
+
+    expect(level).to.equal(DDLogLevelInfo);
+}
+
+- (void)testRuntimeClassesWithoutLoggingAreLeftOut {
+    [self expectRegistryToMatchFullScan];
+
+    // Like the subclasses KVO creates: new classes, but none of them registered
+    NSString *name = [self uniqueClassNameWithPrefix:@"DDRuntimePlainClass_"];
+    Class class = objc_allocateClassPair([NSObject class], name.UTF8String, 0);
+    objc_registerClassPair(class);
+
+    NSObject *observed = [[NSObject alloc] init];
+    [observed addObserver:self forKeyPath:@"description" options:0 context:NULL];
+
+    expect([DDLog registeredClassNames]).toNot.contain(name);
+    [self expectRegistryToMatchFullScan];
+
+    [observed removeObserver:self forKeyPath:@"description"];
+}
+
+@end
@@ -0,0 +1,217 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+@interface DDRemoteSyslogLoggerTests : XCTestCase
+
+@property (nonatomic, strong) DDLog *log;
+@property (nonatomic, strong) DDLoopbackSyslogServer *server;
+@property (nonatomic, strong) NSMutableArray<NSString *> *received;
+
+@end
+
+@implementation DDRemoteSyslogLoggerTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.log = [[DDLog alloc] init];
+    self.received = [NSMutableArray array];
+}
+
+- (void)tearDown {
+    [self.log removeAllLoggers];
+    [self.log flushLog];
+    [self.server stopListening];
+    [super tearDown];
+}
+
+- (void)startServerWithTransport:(DDRemoteSyslogTransport)transport port:(uint16_t)port {
+    NSMutableArray *received = self.received;
+
+    self.server = [[DDLoopbackSyslogServer alloc] initWithTransport:transport port:port];
+    self.server.messageHandler = ^(NSData *message) {
+        NSString *text = [[NSString alloc] initWithData:message encoding:NSUTF8StringEncoding];
+
+        @synchronized(received) {
+            [received addObject:text];
+        }
+    };
+
+    expect([self.server startListening:NULL]).to.beTruthy();
+}
+
+- (DDRemoteSyslogLogger *)addLoggerWithTransport:(DDRemoteSyslogTransport)transport port:(uint16_t)port {
+    DDRemoteSyslogLogger *logger = [[DDRemoteSyslogLogger alloc] initWithHost:@"127.0.0.1" port:port transport:transport];
+    logger.minimumReconnectDelay = 0.05;
+
+    [self.log addLogger:logger];
+
+    return logger;
+}
+
+- (void)logMessage:(NSString *)message {
+    LOG_MAYBE_TO_DDLOG(self.log, NO, ddLogLevel, DDLogFlagInfo, 0, nil, __PRETTY_FUNCTION__, @"%@", message);
+}
+
+/**
+ *  The message texts received by the server, without the syslog header.
+ */
+- (NSArray<NSString *> *)receivedTexts {
+    NSMutableArray *texts = [NSMutableArray array];
+
+    @synchronized(self.received) {
+        for (NSString *message in self.received) {
+            NSRange header = [message rangeOfString:@" - - "];
+            [texts addObject:(header.location == NSNotFound) ? message : [message substringFromIndex:NSMaxRange(header)]];
+        }
+    }
+
+    return texts;
+}
+
+- (void)testMessageFormat {
+    DDRemoteSyslogLogger *logger = [[DDRemoteSyslogLogger alloc] initWithHost:@"localhost"
+                                                                          port:514
+                                                                     transport:DDRemoteSyslogTransportUDP];
+    logger.hostName = @"my host";
+    logger.appName = @"App";
+
+    DDLogMessage *message = [[DDLogMessage alloc] initWithMessage:@"Ünïcode message"
+                                                            level:DDLogLevelWarning
+                                                             flag:DDLogFlagWarning
+                                                          context:0
+                                                             file:@"File.m"
+                                                         function:@"-[Class method]"
+                                                             line:1
+                                                              tag:nil
+                                                          options:0
+                                                        timestamp:[NSDate dateWithTimeIntervalSince1970:1234567890.125]];
+
+    NSString *text = [[NSString alloc] initWithData:[logger syslogMessageForLogMessage:message] encoding:NSUTF8StringEncoding];
+    NSString *expected = [NSString stringWithFormat:@"<12>1 2009-02-13T23:31:30.125000Z my_host App %d - - Ünïcode message", getpid()];
+
+    expect(text).to.equal(expected);
+
+    // Facility local0 (16), error
+    logger.facility = 16;
+    message = [[DDLogMessage alloc] initWithMessage:@"x"
+                                              level:DDLogLevelError
+                                               flag:DDLogFlagError
+                                            context:0
+                                               file:@"File.m"
+                                           function:nil
+                                               line:1
+                                                tag:nil
+                                            options:0
+                                          timestamp:nil];
+    text = [[NSString alloc] initWithData:[logger syslogMessageForLogMessage:message] encoding:NSUTF8StringEncoding];
+
+    expect([text hasPrefix:@"<131>1 "]).to.beTruthy();
+}
+
+- (void)testTCPSendsOctetCountedMessages {
+    [self startServerWithTransport:DDRemoteSyslogTransportTCP port:0];
+    DDRemoteSyslogLogger *logger = [self addLoggerWithTransport:DDRemoteSyslogTransportTCP port:self.server.port];
+
+    for (NSUInteger i = 0; i < 100; i++) {
+        [self logMessage:[NSString stringWithFormat:@"message %@", @(i)]];
+    }
+
+    // Octet counting keeps messages with line breaks in one piece
+    [self logMessage:@"line one\nline two"];
+    [self.log flushLog];
+
+    expect(self.server.receivedMessageCount).will.equal(101);
+    expect(self.server.invalidFrameCount).to.equal(0);
+    expect(logger.isConnected).to.beTruthy();
+    expect(logger.sentMessageCount).to.equal(101);
+
+    NSArray *texts = [self receivedTexts];
+
+    expect(texts.firstObject).to.equal(@"message 0");
+    expect(texts[99]).to.equal(@"message 99");
+    expect(texts.lastObject).to.equal(@"line one\nline two");
+}
+
+- (void)testUDPTruncatesDatagrams {
+    [self startServerWithTransport:DDRemoteSyslogTransportUDP port:0];
+    DDRemoteSyslogLogger *logger = [self addLoggerWithTransport:DDRemoteSyslogTransportUDP port:self.server.port];
+    logger.maximumMessageSize = 480;
+
+    [self logMessage:@"short"];
+    [self logMessage:[@"" stringByPaddingToLength:1000 withString:@"x" startingAtIndex:0]];
+    [self.log flushLog];
+
+    expect(self.server.receivedMessageCount).will.equal(2);
+    expect([self receivedTexts].firstObject).to.equal(@"short");
+
+    @synchronized(self.received) {
+        expect([self.received.lastObject lengthOfBytesUsingEncoding:NSUTF8StringEncoding]).to.equal(480);
+    }
+}
+
+- (void)testReconnectsAndSendsBufferedMessages {
+    // A port nobody listens on (for now)
+    [self startServerWithTransport:DDRemoteSyslogTransportTCP port:0];
+    uint16_t port = self.server.port;
+    [self.server stopListening];
+
+    DDRemoteSyslogLogger *logger = [self addLoggerWithTransport:DDRemoteSyslogTransportTCP port:port];
+
+    [self logMessage:@"one"];
+    [self logMessage:@"two"];
+    [self.log flushLog];
+
+    expect(logger.isConnected).will.beFalsy();
+    expect(logger.sentMessageCount).to.equal(0);
+
+    [self startServerWithTransport:DDRemoteSyslogTransportTCP port:port];
+
+    [self logMessage:@"three"];
+
+    expect([self receivedTexts]).will.equal((@[ @"one", @"two", @"three" ]));
+    expect(logger.droppedMessageCount).to.equal(0);
+}
+
+- (void)testRetryBufferDropsOldestMessages {
+    [self startServerWithTransport:DDRemoteSyslogTransportTCP port:0];
+    uint16_t port = self.server.port;
+    [self.server stopListening];
+
+    DDRemoteSyslogLogger *logger = [self addLoggerWithTransport:DDRemoteSyslogTransportTCP port:port];
+    logger.retryBufferSize = 256;
+
+    for (NSUInteger i = 0; i < 20; i++) {
+        [self logMessage:[NSString stringWithFormat:@"message %@", @(i)]];
+    }
+
+    [self.log flushLog];
+
+    expect(logger.droppedMessageCount).to.beGreaterThan(0);
+
+    [self startServerWithTransport:DDRemoteSyslogTransportTCP port:port];
+
+    expect([self receivedTexts].lastObject).will.equal(@"message 19");
+    expect([self receivedTexts]).notTo.contain(@"message 0");
+    expect(self.server.receivedMessageCount + logger.droppedMessageCount).to.equal(20);
+}
+
+@end
@@ -0,0 +1,166 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+@interface DDSharedMemoryLoggerTests : XCTestCase
+
+@property (nonatomic, copy) NSString *directory;
+
+@property (nonatomic, strong) DDLog *collectedLog;
+@property (nonatomic, strong) DDMemoryLogger *collectedMessages;
+@property (nonatomic, strong) DDSharedMemoryLogCollector *collector;
+
+@property (nonatomic, strong) DDLog *clientLog;
+
+@end
+
+@implementation DDSharedMemoryLoggerTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+
+    self.collectedLog = [[DDLog alloc] init];
+    self.collectedMessages = [[DDMemoryLogger alloc] init];
+    [self.collectedLog addLogger:self.collectedMessages];
+    self.collector = [[DDSharedMemoryLogCollector alloc] initWithDirectory:self.directory log:self.collectedLog];
+
+    self.clientLog = [[DDLog alloc] init];
+}
+
+- (void)tearDown {
+    [self.collector stop];
+    [self.clientLog removeAllLoggers];
+    [self.collectedLog removeAllLoggers];
+    [self.clientLog flushLog];
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+- (void)logToClient:(NSString *)message {
+    LOG_MAYBE_TO_DDLOG(self.clientLog, NO, ddLogLevel, DDLogFlagInfo, 0, nil, __PRETTY_FUNCTION__, @"%@", message);
+}
+
+- (NSArray *)collectedTexts {
+    return [self.collectedMessages.logMessages valueForKey:@"message"];
+}
+
+- (void)testCollectsMessages {
+    expect([self.collector start:NULL]).to.beTruthy();
+
+    DDSharedMemoryLogger *logger = [[DDSharedMemoryLogger alloc] initWithDirectory:self.directory];
+    [self.clientLog addLogger:logger];
+
+    expect(logger.ringPath).notTo.beNil();
+    expect(self.collector.ringCount).will.equal(1);
+
+    for (NSUInteger i = 0; i < 1000; i++) {
+        [self logToClient:[NSString stringWithFormat:@"message %@", @(i)]];
+    }
+
+    [self.clientLog flushLog];
+
+    expect(self.collectedMessages.logMessages.count).will.equal(1000);
+    expect(self.collectedTexts.firstObject).to.equal(@"message 0");
+    expect(self.collectedTexts.lastObject).to.equal(@"message 999");
+    expect(self.collectedMessages.logMessages.firstObject).to.beKindOf([DDCollectedLogMessage class]);
+    expect(logger.droppedMessageCount).to.equal(0);
+
+    // The collector sleeps on the empty ring, and is woken by the next message
+    [NSThread sleepForTimeInterval:0.1];
+    uint64_t wakeups = logger.wakeupCount;
+
+    [self logToClient:@"after a pause"];
+    [self.clientLog flushLog];
+
+    expect(self.collectedTexts.lastObject).will.equal(@"after a pause");
+    expect(logger.wakeupCount).to.equal(wakeups + 1);
+}
+
+- (void)testLoggersOfOneProcessHaveTheirOwnRings {
+    DDSharedMemoryLogger *first = [[DDSharedMemoryLogger alloc] initWithDirectory:self.directory];
+    DDSharedMemoryLogger *second = [[DDSharedMemoryLogger alloc] initWithDirectory:self.directory];
+    DDLog *secondLog = [[DDLog alloc] init];
+
+    [self.clientLog addLogger:first];
+    [secondLog addLogger:second];
+
+    expect(second.ringPath).notTo.equal(first.ringPath);
+
+    [self logToClient:@"first"];
+    [self.clientLog flushLog];
+    LOG_MAYBE_TO_DDLOG(secondLog, NO, ddLogLevel, DDLogFlagInfo, 0, nil, __PRETTY_FUNCTION__, @"%@", @"second");
+    [secondLog flushLog];
+
+    expect([self.collector start:NULL]).to.beTruthy();
+    expect(self.collector.ringCount).will.equal(2);
+    expect([NSSet setWithArray:self.collectedTexts]).will.equal([NSSet setWithArray:@[ @"first", @"second" ]]);
+
+    [secondLog removeAllLoggers];
+    [secondLog flushLog];
+}
+
+- (void)testReadsRingWrittenBeforeCollectorStarted {
+    DDSharedMemoryLogger *logger = [[DDSharedMemoryLogger alloc] initWithDirectory:self.directory];
+    [self.clientLog addLogger:logger];
+
+    [self logToClient:@"early"];
+    [self.clientLog flushLog];
+
+    expect([self.collector start:NULL]).to.beTruthy();
+    expect(self.collectedTexts).will.equal(@[ @"early" ]);
+
+    [self logToClient:@"late"];
+    [self.clientLog flushLog];
+
+    expect(self.collectedTexts).will.equal((@[ @"early", @"late" ]));
+}
+
+- (void)testWrapsAroundAndDropsWhenFull {
+    DDSharedMemoryLogger *logger = [[DDSharedMemoryLogger alloc] initWithDirectory:self.directory capacity:4096];
+    [self.clientLog addLogger:logger];
+
+    // Nobody reads: the ring fills up
+    for (NSUInteger i = 0; i < 100; i++) {
+        [self logToClient:[NSString stringWithFormat:@"message %@", @(i)]];
+    }
+
+    [self.clientLog flushLog];
+
+    uint64_t dropped = logger.droppedMessageCount;
+    expect(dropped).to.beGreaterThan(0);
+
+    expect([self.collector start:NULL]).to.beTruthy();
+    expect(self.collectedMessages.logMessages.count).will.equal(100 - dropped);
+
+    // Records now wrap around the end of the ring
+    for (NSUInteger i = 0; i < 100; i++) {
+        [self logToClient:[NSString stringWithFormat:@"again %@", @(i)]];
+        [self.clientLog flushLog];
+
+        expect(self.collectedTexts.lastObject).will.equal(([NSString stringWithFormat:@"again %@", @(i)]));
+    }
+
+    expect(logger.droppedMessageCount).to.equal(dropped);
+    expect(self.collector.droppedMessageCount).to.equal(dropped);
+}
+
+@end
@@ -0,0 +1,172 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2010-2016, Deusty, LLC
+// All rights reserved.
+//
+// Redistribution and use of this software in source and binary forms,
+// with or without modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Neither the name of Deusty nor the names of its contributors may be used
+//   to endorse or promote products derived from this software without specific
+//   prior written permission of Deusty, LLC.
+
+@import XCTest;
+#import <CocoaLumberjack.h>
+#import <Expecta.h>
+#import <sys/socket.h>
+#import <netinet/in.h>
+
+static const DDLogLevel ddLogLevel = DDLogLevelVerbose;
+
+@interface DDSocketStreamLoggerTests : XCTestCase
+
+@property (nonatomic, strong) DDSocketStreamLogger *logger;
+
+@end
+
+@implementation DDSocketStreamLoggerTests
+
+- (void)setUp {
+    [super setUp];
+
+    self.logger = [[DDSocketStreamLogger alloc] initWithTCPPort:0];
+    expect([self.logger startListening:NULL]).to.beTruthy();
+    expect(self.logger.listeningPort).to.beGreaterThan(0);
+
+    [DDLog removeAllLoggers];
+    [DDLog addLogger:self.logger];
+}
+
+- (void)tearDown {
+    [DDLog removeAllLoggers];
+    [DDLog flushLog];
+    self.logger = nil;
+    [super tearDown];
+}
+
+- (int)connectSubscriber {
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(self.logger.listeningPort);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    expect(connect(fd, (struct sockaddr *)&address, sizeof(address))).to.equal(0);
+
+    struct timeval timeout = { 5, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    expect(self.logger.subscriberCount).will.beGreaterThan(0);
+
+    return fd;
+}
+
+- (void)send:(NSString *)command to:(int)fd {
+    const char *bytes = [command UTF8String];
+    write(fd, bytes, strlen(bytes));
+}
+
+/**
+ * Reads until the received text contains `marker` (or the read times out).
+ **/
+- (NSString *)readFrom:(int)fd until:(NSString *)marker {
+    NSMutableString *received = [NSMutableString string];
+    char buffer[4096];
+    ssize_t length;
+
+    while ([received rangeOfString:marker].location == NSNotFound && (length = read(fd, buffer, sizeof(buffer))) > 0) {
+        [received appendString:[[NSString alloc] initWithBytes:buffer length:(NSUInteger)length encoding:NSUTF8StringEncoding]];
+    }
+
+    return received;
+}
+
+- (void)testStreamsMessages {
+    int fd = [self connectSubscriber];
+
+    DDLogInfo(@"first");
+    DDLogError(@"second");
+
+    expect([self readFrom:fd until:@"second\n"]).to.equal(@"first\nsecond\n");
+
+    close(fd);
+    expect(self.logger.subscriberCount).will.equal(0);
+}
+
+- (void)testFiltersPerSubscriber {
+    int warningsOnly = [self connectSubscriber];
+    int context42 = [self connectSubscriber];
+    expect(self.logger.subscriberCount).will.equal(2);
+
+    [self send:@"LEVEL warning\n" to:warningsOnly];
+    expect([self readFrom:warningsOnly until:@"\n"]).to.equal(@"OK\n");
+
+    [self send:@"CONTEXT 42,43\n" to:context42];
+    expect([self readFrom:context42 until:@"\n"]).to.equal(@"OK\n");
+
+    [self send:@"LEVEL loud\n" to:context42];
+    expect([self readFrom:context42 until:@"\n"]).to.equal(@"ERROR\n");
+
+    DDLogInfo(@"info");
+    LOG_MAYBE(NO, ddLogLevel, DDLogFlagInfo, 42, nil, __PRETTY_FUNCTION__, @"context info");
+    DDLogWarn(@"warning");
+    LOG_MAYBE(NO, ddLogLevel, DDLogFlagError, 42, nil, __PRETTY_FUNCTION__, @"context error");
+
+    expect([self readFrom:warningsOnly until:@"context error\n"]).to.equal(@"warning\ncontext error\n");
+    expect([self readFrom:context42 until:@"context error\n"]).to.equal(@"context info\ncontext error\n");
+
+    close(warningsOnly);
+    close(context42);
+}
+
+- (void)testDropsForSlowSubscriber {
+    self.logger.subscriberBufferSize = 4096;
+
+    int fd = [self connectSubscriber];
+
+    // Not reading: the socket buffers fill up, then the subscriber's buffer
+    NSString *padding = [@"" stringByPaddingToLength:200 withString:@"x" startingAtIndex:0];
+
+    for (NSUInteger i = 0; i < 20000; i++) {
+        DDLogInfo(@"%@ %@", padding, @(i));
+    }
+
+    [DDLog flushLog];
+
+    expect(self.logger.droppedMessageCount).to.beGreaterThan(0);
+
+    // Logged once the subscriber caught up, after telling it what it missed
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)), dispatch_get_global_queue(0, 0), ^{
+        DDLogInfo(@"last");
+    });
+
+    NSString *received = [self readFrom:fd until:@"last\n"];
+
+    expect(received).to.contain(@" messages dropped]\nlast\n");
+
+    close(fd);
+}
+
+- (void)testDisconnectsSlowSubscriber {
+    self.logger.subscriberBufferSize = 4096;
+    self.logger.overflowPolicy = DDSocketStreamOverflowPolicyDisconnect;
+
+    int fd = [self connectSubscriber];
+    NSString *padding = [@"" stringByPaddingToLength:200 withString:@"x" startingAtIndex:0];
+
+    for (NSUInteger i = 0; i < 20000 && self.logger.subscriberCount > 0; i++) {
+        DDLogInfo(@"%@ %@", padding, @(i));
+    }
+
+    [DDLog flushLog];
+
+    expect(self.logger.subscriberCount).to.equal(0);
+
+    close(fd);
+}
+
+@end